@@ -23,6 +23,9 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include <stdlib.h>
 #include <stdio.h>
 #include <fcntl.h>
@@ -40,9 +43,14 @@
 #include "main/menums.h"
 #include "builtin_functions.h"
 #include "loop_analysis.h"
+#include "ir_ssa.h"
+#include "ir_def_use.h"
+#include "ir_value_range.h"
+#include "util/hash_table.h"
 
 #include "ir_print_ir_visitor.h"
 #include "ir_print_glsl_visitor.h"
+#include "ShaderInclude.h"
 #include "ir_builder_print_visitor.h"
 
 #include "string_to_uint_map.h"
@@ -59,7 +67,8 @@ GlslConvert::GlslConvert()
 
 GlslConvert::~GlslConvert()
 {
-
+	ClearLoopState();
+	ClearDefUse();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -163,7 +172,26 @@ std::string GlslConvert::Optimize(
 	OptimizationStruct vOptimizationStruct)
 {
 	std::string res;
+	m_LastOptimizeSucceeded = false;
+	m_LastBudgetExhausted = false;
+	m_Stats = Stats();
+	m_Preshader = Preshader();
+	ClearLoopState();
+	ClearDefUse();
 	if (vShaderSource.empty()) return res;
+
+	m_HasDeadline = vOptimizationStruct.budgetOptions.timeMs > 0;
+	if (m_HasDeadline)
+		m_Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(vOptimizationStruct.budgetOptions.timeMs);
+
+	OptimizationPipeline::Item pipeline;
+	std::string pipelineError;
+	if (!OptimizationPipeline::Parse(vOptimizationStruct.pipelineOptions.pipeline, &pipeline, &pipelineError))
+		return "pipeline error : " + pipelineError + "\n";
+
+	const bool memoryStatsWasEnabled = ralloc_stats_enabled();
+	if (vOptimizationStruct.memoryStats)
+		ralloc_stats_enable(true);
 	
 	struct gl_shader *shader = rzalloc(NULL, struct gl_shader);
 
@@ -215,6 +243,18 @@ std::string GlslConvert::Optimize(
 
 	struct gl_shader_program *program = 0;
 
+	// the long variable names share the storage of the identifiers, until the end of this optimize
+	ir_variable::name_interner = state->interner;
+
+	// #include, resolved by glcpp via _mesa_lookup_shader_include
+	m_Dependencies.clear();
+	m_MinifiedNames.clear();
+	ctx->Shared = rzalloc(shader, struct gl_shared_state);
+	ctx->Shared->ShaderIncludes = ShaderInclude::Instance()->CreateIncludes(shader,
+		vOptimizationStruct.includeOptions.includePaths, vOptimizationStruct.shaderPath);
+	if (vOptimizationStruct.includeOptions.implicit_extension)
+		state->ARB_shading_language_include_enable = true;
+
 	// si le format d'entr est un ir
 	//shader->ir = new(shader) exec_list;
 	//_mesa_glsl_initialize_types(state);
@@ -225,14 +265,35 @@ std::string GlslConvert::Optimize(
 
 	if (!(vOptimizationStruct.controlFlags & ControlFlags::CONTROL_SKIP_PREPROCESSING))
 	{
+		BeginMemoryPhase();
 		state->error = glcpp_preprocess(state, &source, &state->info_log, add_builtin_defines, state, ctx) != 0;
+		EndMemoryPhase("preprocess");
+
+		for (auto &dep : ctx->Shared->ShaderIncludes->dependencies)
+		{
+			Dependency d;
+			d.path = dep.path;
+			d.hash = dep.hash;
+			m_Dependencies.push_back(d);
+		}
 	}
+	ShaderInclude::Instance()->DestroyIncludes(ctx->Shared->ShaderIncludes);
+	ctx->Shared->ShaderIncludes = 0;
 
 	if (!state->error)
 	{
+		BeginMemoryPhase();
 		_mesa_glsl_lexer_ctor(state, source);
 		_mesa_glsl_parse(state);
 		_mesa_glsl_lexer_dtor(state);
+		EndMemoryPhase("parse");
+
+		// the preprocessed text is only read by the lexer
+		if (source != shader->Source)
+		{
+			ralloc_free((void*)source);
+			source = 0;
+		}
 	
 		if (vLanguageTarget == LanguageTarget::LANGUAGE_TARGET_AST)
 		{
@@ -272,14 +333,20 @@ std::string GlslConvert::Optimize(
 				delete[] buffer;
 				fclose(fp);
 			}
+
+			m_LastOptimizeSucceeded = !state->error;
 		}
 		else
 		{
 			exec_list* ir = new (shader) exec_list();
 			shader->ir = ir;
 
+			BeginMemoryPhase();
 			if (!state->translation_unit.is_empty())
 				_mesa_ast_to_hir(ir, state);
+			EndMemoryPhase("hir");
+
+			FreeAst(state);
 
 			if (!state->error)
 			{
@@ -287,6 +354,7 @@ std::string GlslConvert::Optimize(
 				shader->symbols = state->symbols;
 
 				program = GetProgramFromShader(ctx, shader);
+				bool linkFailed = false;
 
 				if (program)
 				{
@@ -298,6 +366,7 @@ std::string GlslConvert::Optimize(
 
 						bool _allowMissingMain = true;
 						program->data->LinkStatus = LINKING_SUCCESS;
+						BeginMemoryPhase();
 						program->_LinkedShaders[stage] =
 							link_intrastage_shaders(
 								program /* mem_ctx */,
@@ -306,6 +375,7 @@ std::string GlslConvert::Optimize(
 								program->Shaders,
 								program->NumShaders,
 								_allowMissingMain);
+						EndMemoryPhase("link");
 
 						if (program->_LinkedShaders[stage])
 						{
@@ -315,23 +385,56 @@ std::string GlslConvert::Optimize(
 								&ctx->Const.ShaderCompilerOptions[stage];
 
 							ir = program->_LinkedShaders[stage]->ir;
+
+							// the linker has cloned what it need, the unlinked hir is not used anymore
+							FreeIr(shader);
 						}
 						else
 						{
 							linked = false;
+							linkFailed = true;
 
 							res = program->data->InfoLog;
 						}
 					}
 
+					if (vOptimizationStruct.perFunctionOptions.enabled)
+					{
+						BeginMemoryPhase();
+						DO_PerFunction_Optimization_Pass(
+							ir,
+							&compileOptions,
+							&vOptimizationStruct);
+						EndMemoryPhase("per_function");
+					}
+
+					if (vOptimizationStruct.validationOptions.level == ValidationLevel::VALIDATION_CHANGED)
+						m_ValidationFingerprints = _mesa_pointer_hash_table_create(NULL);
+
 					// Do optimization post-link
 					DO_Optimization_Pass(
 						ir,
 						linked,
 						&compileOptions,
-						&vOptimizationStruct);
+						&vOptimizationStruct,
+						pipeline);
 
-					validate_ir_tree(ir);
+					// the ir is printed without the versions
+					ClearSsa(ir);
+
+					if (vOptimizationStruct.preshaderOptions.enabled)
+					{
+						BeginMemoryPhase();
+						ExtractPreshader(ir, linked, state, &vOptimizationStruct);
+						EndMemoryPhase("preshader");
+					}
+
+					BeginMemoryPhase();
+					ValidateIr(ir, vOptimizationStruct.validationOptions.level, true);
+					EndMemoryPhase("validate_ir_tree");
+
+					_mesa_hash_table_destroy(m_ValidationFingerprints, NULL);
+					m_ValidationFingerprints = nullptr;
 
 					/*if (vLanguageTarget == LanguageTarget::LANGUAGE_TARGET_IR_BUILDER)
 					{
@@ -360,6 +463,9 @@ std::string GlslConvert::Optimize(
 					}*/
 				}
 
+				m_LastOptimizeSucceeded = !linkFailed;
+
+				BeginMemoryPhase();
 				if (vLanguageTarget == LanguageTarget::LANGUAGE_TARGET_IR)
 				{
 					/* Print out the initial IR */
@@ -368,7 +474,8 @@ std::string GlslConvert::Optimize(
 				else if (vLanguageTarget == LanguageTarget::LANGUAGE_TARGET_GLSL)
 				{
 					/* Print out the initial GLSL */
-					res = IR_TO_GLSL::Convert(ir, state, ralloc_strdup(shader, ""));
+					res = IR_TO_GLSL::Convert(ir, state, ralloc_strdup(shader, ""),
+						vOptimizationStruct.printOptions.minify, &m_MinifiedNames, m_LoopState);
 				}
 				/*else if (vLanguageTarget == LanguageTarget::LANGUAGE_TARGET_HLSL)
 				{
@@ -378,6 +485,7 @@ std::string GlslConvert::Optimize(
 				{
 
 				}*/
+				EndMemoryPhase("print");
 			}
 			else
 			{
@@ -391,6 +499,16 @@ std::string GlslConvert::Optimize(
 		res = state->info_log;
 	}
 	
+	ClearLoopState();
+	ClearDefUse();
+	delete m_Ssa;
+	m_Ssa = nullptr;
+	ir_variable::name_interner = 0;
+
+	AddMemoryRoot("shader", shader);
+	AddMemoryRoot("program", program);
+	AddMemoryTotal();
+
 	// free
 	if (program)
 	{
@@ -402,6 +520,8 @@ std::string GlslConvert::Optimize(
 
 	ClearContext(ctx);
 
+	ralloc_stats_enable(memoryStatsWasEnabled);
+
 	return res;
 }
 
@@ -410,145 +530,477 @@ std::string GlslConvert::Optimize(
 ///////////////////////////////////////////////////////////////////////////////
 
 void GlslConvert::DO_Optimization_Pass(
+	struct exec_list *vIr,
+	bool linked,
+	gl_shader_compiler_options *vCompilerFlags,
+	OptimizationStruct *vOptimizationStruct,
+	const OptimizationPipeline::Item& vPipeline)
+{
+	if (vCompilerFlags && vOptimizationStruct)
+	{
+		RunPipelineItem(vPipeline, vIr, linked, vCompilerFlags, vOptimizationStruct);
+	}
+}
+
+// a group or a pass, run once or while progress
+bool GlslConvert::RunPipelineItem(
+	const OptimizationPipeline::Item& vItem,
+	struct exec_list *vIr,
+	bool linked,
+	gl_shader_compiler_options *vCompilerFlags,
+	OptimizationStruct *vOptimizationStruct)
+{
+	int maxIterations = 1;
+	if (vItem.repeat)
+		maxIterations = vItem.maxIterations > 0 ? vItem.maxIterations : vOptimizationStruct->maxCountPasses;
+
+	bool anyProgress = false;
+	bool progress = false;
+	int passes = 0;
+	do {
+		progress = false;
+		++passes;
+
+		if (vItem.pass != OptimizationPipeline::PASS_NONE)
+		{
+			if (!IsBudgetExhausted())
+				progress = RunPass(vItem.pass, vIr, linked, vCompilerFlags, vOptimizationStruct);
+		}
+		else
+		{
+			for (auto &item : vItem.items)
+			{
+				if (m_LastBudgetExhausted) break;
+				progress |= RunPipelineItem(item, vIr, linked, vCompilerFlags, vOptimizationStruct);
+			}
+		}
+
+		anyProgress |= progress;
+	} while (progress && passes < maxIterations && !m_LastBudgetExhausted);
+
+	return anyProgress;
+}
+
+// the loops not unrolled are analyzed again at each pass, with the same result
+static void ReportUnrollDecision(const loop_unroll_decision *vDecision, void *vStats)
+{
+	GlslConvert::UnrollStats unroll;
+	unroll.function = vDecision->function;
+	unroll.iterations = vDecision->iterations;
+	unroll.bodyCost = vDecision->body_cost;
+	unroll.factor = vDecision->factor;
+	unroll.decision = vDecision->decision;
+
+	auto &decisions = ((GlslConvert::Stats*)vStats)->unrollDecisions;
+	for (auto &it : decisions)
+	{
+		if (it.function == unroll.function &&
+			it.iterations == unroll.iterations &&
+			it.bodyCost == unroll.bodyCost &&
+			it.factor == unroll.factor &&
+			it.decision == unroll.decision)
+			return;
+	}
+
+	decisions.push_back(unroll);
+}
+
+// the passes and their conditions, as they were in the historical DO_Optimization_Pass
+bool GlslConvert::RunPass(
+	OptimizationPipeline::PassId vPass,
 	struct exec_list *vIr,
 	bool linked,
 	gl_shader_compiler_options *vCompilerFlags,
 	OptimizationStruct *vOptimizationStruct)
 {
 #define OPT(FLAG, PASS, ...) do {																	\
-	if ((vOptimizationStruct->optimizationFlags & OptimizationFlags::FLAG))	\
+	if ((vOptimizationStruct->optimizationFlags & OptimizationFlags::FLAG))	{						\
+	BeginMemoryPhase();																				\
 	progress |= PASS(__VA_ARGS__);																	\
+	EndMemoryPhase(#PASS); }																		\
 	} while(false)																					\
 
 #define OPT_BIS(FLAG, PASS, ...) do {																	\
-	if ((vOptimizationStruct->optimizationFlags_Bis & OptimizationFlags_Bis::FLAG))	\
+	if ((vOptimizationStruct->optimizationFlags_Bis & OptimizationFlags_Bis::FLAG))	{					\
+	BeginMemoryPhase();																				\
 	progress |= PASS(__VA_ARGS__);																	\
+	EndMemoryPhase(#PASS); }																		\
 	} while(false)																					\
 
 	bool progress = false;
-	int passes = 0;
-	do {
-		progress = false;
-		++passes;
-		
-		if (vCompilerFlags && vOptimizationStruct)
+	bool defUseKept = false; // the pass updated m_DefUse
+
+	switch (vPass)
+	{
+	case OptimizationPipeline::PASS_lower_instructions:
+		OPT(OPT_lower_instructions, lower_instructions, 
+			vIr, vOptimizationStruct->instructionToLowerFlags);
+		break;
+	case OptimizationPipeline::PASS_function_inlining:
+		if (linked)
+			OPT(OPT_function_inlining, do_function_inlining, vIr);
+		break;
+	case OptimizationPipeline::PASS_dead_functions:
+		if (linked)
+			OPT(OPT_dead_functions, do_dead_functions, vIr, 
+				vOptimizationStruct->deadFunctionOptions.entryFunc.c_str());
+		break;
+	case OptimizationPipeline::PASS_structure_splitting:
+		if (linked)
+			OPT(OPT_structure_splitting, do_structure_splitting, vIr);
+		break;
+	case OptimizationPipeline::PASS_propagate_invariance:
+		propagate_invariance(vIr);
+		break;
+	case OptimizationPipeline::PASS_if_simplification:
+		OPT(OPT_if_simplification, do_if_simplification, vIr);
+		break;
+	case OptimizationPipeline::PASS_flatten_nested_if_blocks:
+		OPT(OPT_flatten_nested_if_blocks, opt_flatten_nested_if_blocks, vIr);
+		break;
+	case OptimizationPipeline::PASS_conditional_discard:
+		OPT(OPT_conditional_discard, opt_conditional_discard, vIr);
+		break;
+	case OptimizationPipeline::PASS_copy_propagation_elements:
+		OPT(OPT_copy_propagation_elements, do_copy_propagation_elements, vIr);
+		break;
+	case OptimizationPipeline::PASS_flip_matrices:
+		if (vCompilerFlags->OptimizeForAOS && !linked)
+			OPT(OPT_flip_matrices, opt_flip_matrices, vIr);
+		break;
+	case OptimizationPipeline::PASS_vectorize:
+		if (linked && vCompilerFlags->OptimizeForAOS)
+			OPT(OPT_vectorize, do_vectorize, vIr);
+		break;
+	case OptimizationPipeline::PASS_dead_code:
+		if (linked)
 		{
-			OPT(OPT_lower_instructions, lower_instructions, 
-				vIr, vOptimizationStruct->instructionToLowerFlags);
-			if (linked)
-			{
-				OPT(OPT_function_inlining, do_function_inlining, vIr);
-				OPT(OPT_dead_functions, do_dead_functions, vIr, 
-					vOptimizationStruct->deadFunctionOptions.entryFunc.c_str());
-				OPT(OPT_structure_splitting, do_structure_splitting, vIr);
-			}
-			propagate_invariance(vIr);
-			OPT(OPT_if_simplification, do_if_simplification, vIr);
-			OPT(OPT_flatten_nested_if_blocks, opt_flatten_nested_if_blocks, vIr);
-			OPT(OPT_conditional_discard, opt_conditional_discard, vIr);
-			OPT(OPT_copy_propagation_elements, do_copy_propagation_elements, vIr);
-			if (vCompilerFlags->OptimizeForAOS && !linked)
-				OPT(OPT_flip_matrices, opt_flip_matrices, vIr);
-			if (linked && vCompilerFlags->OptimizeForAOS)
-			{
-				OPT(OPT_vectorize, do_vectorize, vIr);
-			}
-			if (linked)
-				OPT(OPT_dead_code, do_dead_code, vIr,
-					!vOptimizationStruct->deadCodeOptions.keep_only_assigned_uniforms);
-			else
-				OPT(OPT_dead_code_unlinked, do_dead_code_unlinked, vIr);
-			OPT(OPT_dead_code_local, do_dead_code_local, vIr);
-			OPT(OPT_tree_grafting, do_tree_grafting, vIr);
-			OPT(OPT_constant_propagation, do_constant_propagation, vIr);
-			if (linked)
-				OPT(OPT_constant_variable, do_constant_variable, vIr);
-			else
-				OPT(OPT_constant_variable_unlinked, do_constant_variable_unlinked, vIr);
-			OPT(OPT_constant_folding, do_constant_folding, vIr);
-			OPT_BIS(OPT_minmax_prune, do_minmax_prune, vIr);
-			OPT_BIS(OPT_rebalance_tree, do_rebalance_tree, vIr);
-			OPT(OPT_algebraic, do_algebraic, vIr,
-				vOptimizationStruct->algebraicOptions.native_integers, vCompilerFlags);
-			OPT(OPT_lower_jumps, do_lower_jumps, vIr,
-				vOptimizationStruct->lowerJumpsOptions.pull_out_jumps,
-				vOptimizationStruct->lowerJumpsOptions.lower_sub_return,
-				vOptimizationStruct->lowerJumpsOptions.lower_main_return,
-				vOptimizationStruct->lowerJumpsOptions.lower_continue,
-				vOptimizationStruct->lowerJumpsOptions.lower_break);
-			OPT(OPT_vec_index_to_swizzle, do_vec_index_to_swizzle, vIr);
-			OPT_BIS(OPT_lower_vector_insert, lower_vector_insert, vIr,
-				vOptimizationStruct->lowerVectorInsertOptions.lower_nonconstant_index);
-			OPT(OPT_optimize_swizzles, optimize_swizzles, vIr);
-			OPT_BIS(OPT_optimize_split_arrays, optimize_split_arrays, vIr, linked);
-			OPT(OPT_optimize_redundant_jumps, optimize_redundant_jumps, vIr);
-			if (OPT_BIS_FLAGS(vOptimizationStruct->optimizationFlags_Bis, OPT_set_unroll_Loops))
+			OPT(OPT_dead_code, do_dead_code, vIr,
+				!vOptimizationStruct->deadCodeOptions.keep_only_assigned_uniforms, GetDefUse(vIr));
+			defUseKept = true;
+		}
+		else
+			OPT(OPT_dead_code_unlinked, do_dead_code_unlinked, vIr);
+		break;
+	case OptimizationPipeline::PASS_dead_code_local:
+		OPT(OPT_dead_code_local, do_dead_code_local, vIr, m_DefUse); // updated only if already built
+		defUseKept = true;
+		break;
+	case OptimizationPipeline::PASS_dead_store:
+		OPT_BIS(OPT_dead_store, do_dead_store_elimination, vIr);
+		break;
+	case OptimizationPipeline::PASS_tree_grafting:
+		OPT(OPT_tree_grafting, do_tree_grafting, vIr, GetDefUse(vIr));
+		defUseKept = true;
+		break;
+	case OptimizationPipeline::PASS_constant_propagation:
+		OPT(OPT_constant_propagation, do_constant_propagation, vIr);
+		break;
+	case OptimizationPipeline::PASS_constant_variable:
+		if (linked)
+			OPT(OPT_constant_variable, do_constant_variable, vIr);
+		else
+			OPT(OPT_constant_variable_unlinked, do_constant_variable_unlinked, vIr);
+		break;
+	case OptimizationPipeline::PASS_constant_folding:
+		OPT(OPT_constant_folding, do_constant_folding, vIr);
+		break;
+	case OptimizationPipeline::PASS_minmax_prune:
+		OPT_BIS(OPT_minmax_prune, do_minmax_prune, vIr, GetValueRange(vIr, vOptimizationStruct));
+		break;
+	case OptimizationPipeline::PASS_rebalance_tree:
+		OPT_BIS(OPT_rebalance_tree, do_rebalance_tree, vIr);
+		break;
+	case OptimizationPipeline::PASS_algebraic:
+		OPT(OPT_algebraic, do_algebraic, vIr,
+			vOptimizationStruct->algebraicOptions.native_integers, vCompilerFlags,
+			GetValueRange(vIr, vOptimizationStruct), GetAlgebraicRules(vOptimizationStruct),
+			vOptimizationStruct->algebraicOptions.fast_math);
+		break;
+	case OptimizationPipeline::PASS_lower_jumps:
+		OPT(OPT_lower_jumps, do_lower_jumps, vIr,
+			vOptimizationStruct->lowerJumpsOptions.pull_out_jumps,
+			vOptimizationStruct->lowerJumpsOptions.lower_sub_return,
+			vOptimizationStruct->lowerJumpsOptions.lower_main_return,
+			vOptimizationStruct->lowerJumpsOptions.lower_continue,
+			vOptimizationStruct->lowerJumpsOptions.lower_break);
+		break;
+	case OptimizationPipeline::PASS_vec_index_to_swizzle:
+		OPT(OPT_vec_index_to_swizzle, do_vec_index_to_swizzle, vIr);
+		break;
+	case OptimizationPipeline::PASS_lower_vector_insert:
+		OPT_BIS(OPT_lower_vector_insert, lower_vector_insert, vIr,
+			vOptimizationStruct->lowerVectorInsertOptions.lower_nonconstant_index);
+		break;
+	case OptimizationPipeline::PASS_optimize_swizzles:
+		OPT(OPT_optimize_swizzles, optimize_swizzles, vIr);
+		break;
+	case OptimizationPipeline::PASS_optimize_split_arrays:
+		OPT_BIS(OPT_optimize_split_arrays, optimize_split_arrays, vIr, linked);
+		break;
+	case OptimizationPipeline::PASS_optimize_redundant_jumps:
+		OPT(OPT_optimize_redundant_jumps, optimize_redundant_jumps, vIr);
+		break;
+	case OptimizationPipeline::PASS_unroll_loops:
+		if (OPT_BIS_FLAGS(vOptimizationStruct->optimizationFlags_Bis, OPT_set_unroll_Loops))
+		{
+			if (vCompilerFlags->MaxUnrollIterations)
 			{
-				if (vCompilerFlags->MaxUnrollIterations)
+				BeginMemoryPhase();
+				loop_state *ls = analyze_loop_variables(vIr);
+				bool unrolled = false;
+				if (ls->loop_found)
 				{
-					loop_state *ls = analyze_loop_variables(vIr);
-					if (ls->loop_found)
+					bool loop_progress = unroll_loops(vIr, ls, vCompilerFlags, &ReportUnrollDecision, &m_Stats);
+					unrolled = loop_progress;
+					while (loop_progress)
 					{
-						bool loop_progress = unroll_loops(vIr, ls, vCompilerFlags);
-						while (loop_progress)
-						{
-							loop_progress = false;
-							loop_progress |= do_constant_propagation(vIr);
-							loop_progress |= do_if_simplification(vIr);
-
-							/* Some drivers only call do_common_optimization() once rather
-							 * than in a loop. So we must call do_lower_jumps() after
-							 * unrolling a loop because for drivers that use LLVM validation
-							 * will fail if a jump is not the last instruction in the block.
-							 * For example the following will fail LLVM validation:
-							 *
-							 *   (loop (
-							 *      ...
-							 *   break
-							 *   (assign  (x) (var_ref v124)  (expression int + (var_ref v124)
-							 *      (constant int (1)) ) )
-							 *   ))
-							 */
-							loop_progress |= do_lower_jumps(vIr, 
-								true, 
-								true,
-								vCompilerFlags->EmitNoMainReturn,
-								vCompilerFlags->EmitNoCont,
-								vCompilerFlags->EmitNoLoops);
-						}
-						progress |= loop_progress;
+						loop_progress = false;
+						loop_progress |= do_constant_propagation(vIr);
+						loop_progress |= do_if_simplification(vIr);
+
+						/* Some drivers only call do_common_optimization() once rather
+						 * than in a loop. So we must call do_lower_jumps() after
+						 * unrolling a loop because for drivers that use LLVM validation
+						 * will fail if a jump is not the last instruction in the block.
+						 * For example the following will fail LLVM validation:
+						 *
+						 *   (loop (
+						 *      ...
+						 *   break
+						 *   (assign  (x) (var_ref v124)  (expression int + (var_ref v124)
+						 *      (constant int (1)) ) )
+						 *   ))
+						 */
+						loop_progress |= do_lower_jumps(vIr, 
+							true, 
+							true,
+							vCompilerFlags->EmitNoMainReturn,
+							vCompilerFlags->EmitNoCont,
+							vCompilerFlags->EmitNoLoops);
 					}
-					delete ls;
+					// the bodies are cloned and the loops removed, the def-use index is dropped at the end
+					progress |= unrolled;
 				}
+
+				// nothing unrolled, the analysis is still the one of the ir, the printer will reuse it
+				ClearLoopState();
+				if (unrolled)
+					delete ls;
+				else
+					m_LoopState = ls;
+				EndMemoryPhase("unroll_loops");
 			}
-			OPT(OPT_lower_texture_projection, do_lower_texture_projection, vIr);
-			if (OPT_FLAGS(vOptimizationStruct->optimizationFlags, OPT_lower_if_to_cond_assign))
-			{
-				gl_shader_stage stage = (gl_shader_stage)vOptimizationStruct->stage;
-				progress |= lower_if_to_cond_assign(stage, vIr, 
-					vOptimizationStruct->lowerIfToCondAssignOptions.max_depth, 
-					vOptimizationStruct->lowerIfToCondAssignOptions.min_branch_cost);
-			}
-			OPT(OPT_mat_op_to_vec, do_mat_op_to_vec, vIr);
-			OPT(OPT_vec_index_to_cond_assign, do_vec_index_to_cond_assign, vIr);
-			OPT(OPT_lower_discard, lower_discard, vIr);
-			OPT(OPT_lower_noise, lower_noise, vIr);
-			if (OPT_FLAGS(vOptimizationStruct->optimizationFlags, OPT_lower_variable_index_to_cond_assign))
+		}
+		break;
+	case OptimizationPipeline::PASS_lower_texture_projection:
+		OPT(OPT_lower_texture_projection, do_lower_texture_projection, vIr);
+		break;
+	case OptimizationPipeline::PASS_lower_if_to_cond_assign:
+		if (OPT_FLAGS(vOptimizationStruct->optimizationFlags, OPT_lower_if_to_cond_assign))
+		{
+			gl_shader_stage stage = (gl_shader_stage)vOptimizationStruct->stage;
+			BeginMemoryPhase();
+			progress |= lower_if_to_cond_assign(stage, vIr, 
+				vOptimizationStruct->lowerIfToCondAssignOptions.max_depth, 
+				vOptimizationStruct->lowerIfToCondAssignOptions.min_branch_cost,
+				vOptimizationStruct->lowerIfToCondAssignOptions.branch_cost);
+			EndMemoryPhase("lower_if_to_cond_assign");
+		}
+		break;
+	case OptimizationPipeline::PASS_mat_op_to_vec:
+		OPT(OPT_mat_op_to_vec, do_mat_op_to_vec, vIr);
+		break;
+	case OptimizationPipeline::PASS_vec_index_to_cond_assign:
+		OPT(OPT_vec_index_to_cond_assign, do_vec_index_to_cond_assign, vIr);
+		break;
+	case OptimizationPipeline::PASS_lower_discard:
+		OPT(OPT_lower_discard, lower_discard, vIr);
+		break;
+	case OptimizationPipeline::PASS_lower_noise:
+		OPT(OPT_lower_noise, lower_noise, vIr);
+		break;
+	case OptimizationPipeline::PASS_lower_variable_index_to_cond_assign:
+		if (OPT_FLAGS(vOptimizationStruct->optimizationFlags, OPT_lower_variable_index_to_cond_assign))
+		{
+			gl_shader_stage stage = (gl_shader_stage)vOptimizationStruct->stage;
+			BeginMemoryPhase();
+			progress |= lower_variable_index_to_cond_assign(
+				stage, vIr,
+				vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_input, 
+				vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_output,
+				vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_temp, 
+				vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_uniform,
+				(unsigned)MAX2(vOptimizationStruct->lowerVariableIndexToCondAssignOptions.linear_max_length, 1),
+				(unsigned)MAX2(vOptimizationStruct->lowerVariableIndexToCondAssignOptions.max_length, 0));
+			EndMemoryPhase("lower_variable_index_to_cond_assign");
+		}
+		break;
+	case OptimizationPipeline::PASS_lower_quadop_vector:
+		OPT(OPT_lower_quadop_vector, lower_quadop_vector, vIr, vOptimizationStruct->lowerQuadopVector.dont_lower_swz);
+		break;
+	case OptimizationPipeline::PASS_into_ssa:
+		BeginMemoryPhase();
+		if (!m_Ssa)
+			m_Ssa = new ir_ssa();
+		// the same ir in an other form, not a progress for the loops of the pipeline
+		if (m_Ssa->build(vIr))
+		{
+			ClearLoopState();
+			ClearDefUse();
+		}
+		EndMemoryPhase("into_ssa");
+		break;
+	case OptimizationPipeline::PASS_out_of_ssa:
+		BeginMemoryPhase();
+		ClearSsa(vIr);
+		EndMemoryPhase("out_of_ssa");
+		break;
+	case OptimizationPipeline::PASS_validate_ir_tree:
+		BeginMemoryPhase();
+		ValidateIr(vIr, vOptimizationStruct->validationOptions.level, false);
+		EndMemoryPhase("validate_ir_tree");
+		break;
+	default:
+		break;
+	}
+
+	if (progress)
+	{
+		ClearLoopState();
+		if (!defUseKept)
+			ClearDefUse();
+	}
+
+	return progress;
+#undef OPT
+#undef OPT_BIS
+}
+
+// before the inlining, the body of each function is independent of the others,
+// so they are optimized alone, with the intra-procedural passes, on a pool of threads.
+// each body is moved under his own ralloc context during the work, so the threads dont share any allocator.
+// the builtins are left to the global pipeline since their bodies are read by the constant folding of the calls
+void GlslConvert::DO_PerFunction_Optimization_Pass(
+	struct exec_list *vIr,
+	gl_shader_compiler_options *vCompilerFlags,
+	OptimizationStruct *vOptimizationStruct)
+{
+	if (!vIr || !vCompilerFlags || !vOptimizationStruct) return;
+
+	std::vector<ir_function_signature*> signatures;
+	foreach_in_list(ir_instruction, node, vIr)
+	{
+		ir_function *f = node->as_function();
+		if (f)
+		{
+			foreach_in_list(ir_function_signature, sig, &f->signatures)
 			{
-				gl_shader_stage stage = (gl_shader_stage)vOptimizationStruct->stage;
-				progress |= lower_variable_index_to_cond_assign(
-					stage, vIr,
-					vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_input, 
-					vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_output,
-					vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_temp, 
-					vOptimizationStruct->lowerVariableIndexToCondAssignOptions.lower_uniform);
+				if (sig->is_defined && !sig->is_builtin() && !sig->is_intrinsic())
+					signatures.push_back(sig);
 			}
-			OPT(OPT_lower_quadop_vector, lower_quadop_vector, vIr, vOptimizationStruct->lowerQuadopVector.dont_lower_swz);
-
-			validate_ir_tree(vIr);
 		}
+	}
+
+	if (signatures.empty()) return;
+
+	std::vector<void*> contexts(signatures.size());
+	for (size_t i = 0; i < signatures.size(); ++i)
+	{
+		contexts[i] = ralloc_context(NULL);
+		reparent_ir(&signatures[i]->parameters, contexts[i]);
+		reparent_ir(&signatures[i]->body, contexts[i]);
+	}
+
+	size_t countThreads = (size_t)vOptimizationStruct->perFunctionOptions.threads;
+	if (countThreads == 0)
+		countThreads = (size_t)std::thread::hardware_concurrency();
+	if (countThreads > signatures.size())
+		countThreads = signatures.size();
+	if (ralloc_stats_used()) // the ralloc accounting is global
+		countThreads = 1;
+
+	const std::chrono::steady_clock::time_point *deadline = m_HasDeadline ? &m_Deadline : nullptr;
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		size_t i;
+		while ((i = next++) < signatures.size())
+			OptimizeFunctionBody(&signatures[i]->body, vCompilerFlags, vOptimizationStruct, deadline);
+	};
+
+	if (countThreads > 1)
+	{
+		std::vector<std::thread> pool;
+		for (size_t t = 1; t < countThreads; ++t)
+			pool.emplace_back(worker);
+		worker();
+		for (auto &thread : pool)
+			thread.join();
+	}
+	else
+	{
+		worker();
+	}
+
+	// back under the signature, what was removed by the passes is freed with the context
+	for (size_t i = 0; i < signatures.size(); ++i)
+	{
+		void *sigCtx = ralloc_parent(signatures[i]);
+		reparent_ir(&signatures[i]->parameters, sigCtx);
+		reparent_ir(&signatures[i]->body, sigCtx);
+		ralloc_free(contexts[i]);
+	}
+
+	IsBudgetExhausted(); // the bodies not reached are left as they are
+}
+
+// only passes who touch nothing outside of the body,
+// the variables declared outside (globals, parameters) are never removed nor modified by them
+void GlslConvert::OptimizeFunctionBody(
+	struct exec_list *vBody,
+	gl_shader_compiler_options *vCompilerFlags,
+	OptimizationStruct *vOptimizationStruct,
+	const std::chrono::steady_clock::time_point *vDeadline)
+{
+#define OPT_FUNC(FLAG, PASS, ...) do {																\
+	if ((vOptimizationStruct->optimizationFlags & OptimizationFlags::FLAG))							\
+		progress |= PASS(__VA_ARGS__);																\
+	} while(false)																					\
+
+	bool progress = false;
+	int passes = 0;
+	do {
+		// read only, the threads just stop, the flag is set after the join
+		if (vDeadline && std::chrono::steady_clock::now() >= *vDeadline)
+			break;
+
+		progress = false;
+		++passes;
+
+		OPT_FUNC(OPT_if_simplification, do_if_simplification, vBody);
+		OPT_FUNC(OPT_flatten_nested_if_blocks, opt_flatten_nested_if_blocks, vBody);
+		OPT_FUNC(OPT_copy_propagation_elements, do_copy_propagation_elements, vBody);
+		OPT_FUNC(OPT_dead_code, do_dead_code, vBody, false);
+		OPT_FUNC(OPT_dead_code_local, do_dead_code_local, vBody);
+		if ((vOptimizationStruct->optimizationFlags_Bis & OptimizationFlags_Bis::OPT_dead_store))
+			progress |= do_dead_store_elimination(vBody);
+		OPT_FUNC(OPT_tree_grafting, do_tree_grafting, vBody);
+		OPT_FUNC(OPT_constant_propagation, do_constant_propagation, vBody);
+		OPT_FUNC(OPT_constant_variable, do_constant_variable, vBody);
+		OPT_FUNC(OPT_constant_folding, do_constant_folding, vBody);
+		if ((vOptimizationStruct->optimizationFlags_Bis & OptimizationFlags_Bis::OPT_minmax_prune))
+			progress |= do_minmax_prune(vBody);
+		// no fast math before the inlining and propagate_invariance, a tree can still reach an invariant or precise output.
+		// it's done by the algebraic of the pipeline
+		OPT_FUNC(OPT_algebraic, do_algebraic, vBody,
+			vOptimizationStruct->algebraicOptions.native_integers, vCompilerFlags,
+			nullptr, GetAlgebraicRules(vOptimizationStruct), false);
+		OPT_FUNC(OPT_vec_index_to_swizzle, do_vec_index_to_swizzle, vBody);
+		OPT_FUNC(OPT_optimize_swizzles, optimize_swizzles, vBody);
 	} while (progress && passes < vOptimizationStruct->maxCountPasses);
-#undef OPT
+#undef OPT_FUNC
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -583,6 +1035,508 @@ static struct gl_program* new_program(UNUSED struct gl_context *ctx, GLenum targ
 	}
 }
 
+bool GlslConvert::AddNamedString(const std::string& vName, const std::string& vSource)
+{
+	return ShaderInclude::Instance()->AddNamedString(vName, vSource);
+}
+
+bool GlslConvert::RemoveNamedString(const std::string& vName)
+{
+	return ShaderInclude::Instance()->RemoveNamedString(vName);
+}
+
+void GlslConvert::ClearNamedStrings()
+{
+	ShaderInclude::Instance()->ClearNamedStrings();
+}
+
+void GlslConvert::ClearIncludeCache()
+{
+	ShaderInclude::Instance()->ClearCache();
+}
+
+const std::vector<GlslConvert::Dependency>& GlslConvert::GetDependencies() const
+{
+	return m_Dependencies;
+}
+
+// make / ninja depfile syntax : "target: dep0 dep1 ..."
+std::string GlslConvert::GetMakeDependencies(const std::string& vTarget) const
+{
+	std::string res = vTarget + ":";
+	for (auto &dep : m_Dependencies)
+	{
+		res += " \\\n ";
+		for (auto c : dep.path)
+		{
+			if (c == ' ') res += "\\";
+			res += c;
+		}
+	}
+	res += "\n";
+	return res;
+}
+
+const std::map<std::string, std::string>& GlslConvert::GetMinifiedNames() const
+{
+	return m_MinifiedNames;
+}
+
+bool GlslConvert::IsLastOptimizeSucceeded() const
+{
+	return m_LastOptimizeSucceeded;
+}
+
+// the value ranges are from the same ir, and can use the loop analysis
+void GlslConvert::ClearLoopState()
+{
+	delete m_ValueRange;
+	m_ValueRange = nullptr;
+	delete m_LoopState;
+	m_LoopState = nullptr;
+}
+
+// built on the first pass who uses it, the others dont walk the ir to count the references
+ir_def_use* GlslConvert::GetDefUse(struct exec_list *vIr)
+{
+	if (!m_DefUse)
+		m_DefUse = new ir_def_use(vIr);
+#ifdef DEBUG
+	else
+		assert(m_DefUse->check(vIr));
+#endif
+	return m_DefUse;
+}
+
+void GlslConvert::ClearDefUse()
+{
+	delete m_DefUse;
+	m_DefUse = nullptr;
+}
+
+// NULL if the analysis is disabled, else done on the first query of a pass
+ir_value_range* GlslConvert::GetValueRange(struct exec_list *vIr, OptimizationStruct *vOptimizationStruct)
+{
+	if (!(vOptimizationStruct->optimizationFlags_Bis & OptimizationFlags_Bis::OPT_value_range))
+		return nullptr;
+	if (!m_ValueRange)
+		m_ValueRange = new ir_value_range(vIr, m_LoopState,
+			vOptimizationStruct->valueRangeOptions.normalized_textures);
+	return m_ValueRange;
+}
+
+// groups of rules of the table of algebraic enabled for the target
+unsigned GlslConvert::GetAlgebraicRules(OptimizationStruct *vOptimizationStruct)
+{
+	unsigned rules = 0;
+	if (vOptimizationStruct->algebraicOptions.rules_basic) rules |= ALGEBRAIC_RULES_BASIC;
+	if (vOptimizationStruct->algebraicOptions.rules_pow) rules |= ALGEBRAIC_RULES_POW;
+	if (vOptimizationStruct->algebraicOptions.rules_length) rules |= ALGEBRAIC_RULES_LENGTH;
+	if (vOptimizationStruct->algebraicOptions.rules_trig) rules |= ALGEBRAIC_RULES_TRIG;
+	if (vOptimizationStruct->algebraicOptions.rules_mad) rules |= ALGEBRAIC_RULES_MAD;
+	return rules;
+}
+
+// rename back the versions of into_ssa
+void GlslConvert::ClearSsa(struct exec_list *vIr)
+{
+	if (m_Ssa)
+	{
+		if (m_Ssa->destroy(vIr))
+		{
+			ClearLoopState();
+			ClearDefUse();
+		}
+		delete m_Ssa;
+		m_Ssa = nullptr;
+	}
+}
+
+// the validate_ir_tree of the pipeline are only done from VALIDATION_CHANGED,
+// the final one from VALIDATION_FINAL
+void GlslConvert::ValidateIr(struct exec_list *vIr, ValidationLevel vLevel, bool vFinal)
+{
+	switch (vLevel)
+	{
+	case ValidationLevel::VALIDATION_FINAL:
+		if (vFinal)
+			validate_ir_tree(vIr);
+		break;
+	case ValidationLevel::VALIDATION_CHANGED:
+		if (m_ValidationFingerprints)
+			validate_ir_tree_changed(vIr, m_ValidationFingerprints);
+		else
+			validate_ir_tree(vIr);
+		break;
+	case ValidationLevel::VALIDATION_FULL:
+		validate_ir_tree(vIr);
+		break;
+	default:
+		break;
+	}
+}
+
+bool GlslConvert::IsLastBudgetExhausted() const
+{
+	return m_LastBudgetExhausted;
+}
+
+// once reached, stay reached until the next Optimize.
+// each pass leave a valid ir, so stopping between two passes give the best ir reached so far
+bool GlslConvert::IsBudgetExhausted()
+{
+	if (!m_LastBudgetExhausted && m_HasDeadline && std::chrono::steady_clock::now() >= m_Deadline)
+		m_LastBudgetExhausted = true;
+	return m_LastBudgetExhausted;
+}
+
+const GlslConvert::Stats& GlslConvert::GetStats() const
+{
+	return m_Stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// PRESHADER ////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// name of the uniform value read by a dereference, like lights[2].color
+static std::string GetPreshaderInputName(ir_rvalue *vIr)
+{
+	if (vIr->ir_type == ir_type_dereference_variable)
+	{
+		return ((ir_dereference_variable*)vIr)->var->name;
+	}
+	else if (vIr->ir_type == ir_type_dereference_record)
+	{
+		ir_dereference_record *deref = (ir_dereference_record*)vIr;
+		return GetPreshaderInputName(deref->record) + "." +
+			deref->record->type->fields.structure[deref->field_idx].name;
+	}
+	else if (vIr->ir_type == ir_type_dereference_array)
+	{
+		ir_dereference_array *deref = (ir_dereference_array*)vIr;
+		return GetPreshaderInputName(deref->array) + "[" +
+			std::to_string(deref->array_index->as_constant()->get_int_component(0)) + "]";
+	}
+	return std::string();
+}
+
+// add the ops computing vIr to the program, return the register of his value.
+// do_extract_preshader has checked the rvalue, only constant indexes and value types
+static int AddPreshaderOp(ir_rvalue *vIr, GlslConvert::Preshader *vPreshader)
+{
+	GlslConvert::PreshaderOp op;
+	op.baseType = (int)vIr->type->base_type;
+	op.vectorElements = (int)vIr->type->vector_elements;
+	op.matrixColumns = (int)vIr->type->matrix_columns;
+
+	if (vIr->ir_type == ir_type_constant)
+	{
+		ir_constant *c = (ir_constant*)vIr;
+		op.kind = GlslConvert::PRESHADER_CONSTANT;
+		for (unsigned i = 0; i < vIr->type->components(); i++)
+			op.values.push_back(c->get_double_component(i));
+	}
+	else if (vIr->ir_type == ir_type_swizzle)
+	{
+		ir_swizzle *swz = (ir_swizzle*)vIr;
+		op.kind = GlslConvert::PRESHADER_SWIZZLE;
+		op.operands.push_back(AddPreshaderOp(swz->val, vPreshader));
+		const unsigned comps[4] = { swz->mask.x, swz->mask.y, swz->mask.z, swz->mask.w };
+		for (unsigned i = 0; i < swz->mask.num_components; i++)
+			op.values.push_back(comps[i]);
+	}
+	else if (vIr->ir_type == ir_type_expression)
+	{
+		ir_expression *expr = (ir_expression*)vIr;
+		op.kind = GlslConvert::PRESHADER_EXPRESSION;
+		op.operation = (int)expr->operation;
+		for (unsigned i = 0; i < expr->num_operands; i++)
+			op.operands.push_back(AddPreshaderOp(expr->operands[i], vPreshader));
+	}
+	else if (vIr->ir_type == ir_type_dereference_array &&
+		!((ir_dereference_array*)vIr)->array->type->is_array())
+	{
+		ir_dereference_array *deref = (ir_dereference_array*)vIr;
+		op.kind = GlslConvert::PRESHADER_INDEX;
+		op.operands.push_back(AddPreshaderOp(deref->array, vPreshader));
+		op.operands.push_back(AddPreshaderOp(deref->array_index, vPreshader));
+	}
+	else
+	{
+		op.kind = GlslConvert::PRESHADER_UNIFORM;
+		op.name = GetPreshaderInputName(vIr);
+
+		// one read of each input
+		for (size_t i = 0; i < vPreshader->program.size(); i++)
+		{
+			const GlslConvert::PreshaderOp& other = vPreshader->program[i];
+			if (other.kind == GlslConvert::PRESHADER_UNIFORM && other.name == op.name)
+				return (int)i;
+		}
+		vPreshader->inputs.push_back(op.name);
+	}
+
+	vPreshader->program.push_back(op);
+	return (int)vPreshader->program.size() - 1;
+}
+
+// the uniform-only expressions of the optimized ir are moved to the preshader,
+// and the uniforms they were reading are removed if not used anymore
+void GlslConvert::ExtractPreshader(
+	struct exec_list *vIr,
+	bool linked,
+	struct _mesa_glsl_parse_state *vState,
+	OptimizationStruct *vOptimizationStruct)
+{
+	exec_list preshader;
+	if (!do_extract_preshader(vIr, &preshader))
+		return;
+
+	if (linked)
+	{
+		if (vOptimizationStruct->optimizationFlags & OptimizationFlags::OPT_dead_code)
+			do_dead_code(vIr, !vOptimizationStruct->deadCodeOptions.keep_only_assigned_uniforms);
+	}
+	else if (vOptimizationStruct->optimizationFlags & OptimizationFlags::OPT_dead_code_unlinked)
+	{
+		do_dead_code_unlinked(vIr);
+	}
+	ClearLoopState();
+	ClearDefUse();
+
+	IR_TO_GLSL::global_print_tracker global;
+	m_Preshader.source = "// the preshader, once per draw, from the values of the uniforms\nvoid preshader()\n{\n";
+	foreach_in_list(ir_assignment, assign, &preshader)
+	{
+		PreshaderUniform uni;
+		uni.name = assign->lhs->variable_referenced()->name;
+		uni.type = assign->rhs->type->name;
+		
+		sbuffer str(vState);
+		IR_TO_GLSL v(str, &global, vState);
+		assign->rhs->accept(&v);
+
+		// on one line, the printer can break the lines inside an expression
+		for (const char *c = str.c_str(); *c; c++)
+		{
+			if (*c == '\n')
+				while (c[1] == ' ') c++;
+			else
+				uni.expression += *c;
+		}
+
+		uni.reg = AddPreshaderOp(assign->rhs, &m_Preshader);
+		m_Preshader.uniforms.push_back(uni);
+
+		m_Preshader.source += "\t" + uni.name + " = " + uni.expression + ";\n";
+	}
+	m_Preshader.source += "}\n";
+}
+
+const GlslConvert::Preshader& GlslConvert::GetPreshader() const
+{
+	return m_Preshader;
+}
+
+// a constant of the type from the values, in the component order
+static ir_constant* MakePreshaderConstant(void *vMemCtx, const glsl_type *vType, const double *vValues)
+{
+	ir_constant_data data;
+	memset(&data, 0, sizeof(data));
+	for (unsigned i = 0; i < vType->components(); i++)
+	{
+		switch (vType->base_type)
+		{
+		case GLSL_TYPE_FLOAT: data.f[i] = (float)vValues[i]; break;
+		case GLSL_TYPE_DOUBLE: data.d[i] = vValues[i]; break;
+		case GLSL_TYPE_INT: data.i[i] = (int)vValues[i]; break;
+		case GLSL_TYPE_UINT: data.u[i] = (unsigned)(int64_t)vValues[i]; break;
+		case GLSL_TYPE_BOOL: data.b[i] = vValues[i] != 0.0; break;
+		case GLSL_TYPE_INT64: data.i64[i] = (int64_t)vValues[i]; break;
+		case GLSL_TYPE_UINT64: data.u64[i] = (uint64_t)vValues[i]; break;
+		default: return nullptr;
+		}
+	}
+	return new(vMemCtx) ir_constant(vType, &data);
+}
+
+// each op of the program is folded by ir_constant_expression, like the constant expressions of the shader
+bool GlslConvert::EvaluatePreshader(
+	const std::map<std::string, std::vector<double>>& vInputs,
+	std::map<std::string, std::vector<double>>* vOutputs) const
+{
+	if (!vOutputs)
+		return false;
+
+	void *mem_ctx = ralloc_context(NULL);
+	std::vector<ir_constant*> regs;
+	bool res = true;
+
+	for (const auto& op : m_Preshader.program)
+	{
+		const glsl_type *type = glsl_type::get_instance(
+			op.baseType, op.vectorElements, op.matrixColumns);
+		ir_constant *value = nullptr;
+
+		switch (op.kind)
+		{
+		case PRESHADER_UNIFORM:
+		{
+			const auto it = vInputs.find(op.name);
+			if (it != vInputs.end() && it->second.size() == type->components())
+				value = MakePreshaderConstant(mem_ctx, type, it->second.data());
+			break;
+		}
+		case PRESHADER_CONSTANT:
+			if (op.values.size() == type->components())
+				value = MakePreshaderConstant(mem_ctx, type, op.values.data());
+			break;
+		case PRESHADER_EXPRESSION:
+		{
+			ir_rvalue *operands[4] = { nullptr, nullptr, nullptr, nullptr };
+			for (size_t i = 0; i < op.operands.size() && i < 4; i++)
+				operands[i] = regs[op.operands[i]];
+			ir_expression *expr = new(mem_ctx) ir_expression(op.operation, type,
+				operands[0], operands[1], operands[2], operands[3]);
+			value = expr->constant_expression_value(mem_ctx);
+			break;
+		}
+		case PRESHADER_SWIZZLE:
+		{
+			unsigned comps[4] = { 0, 0, 0, 0 };
+			for (size_t i = 0; i < op.values.size() && i < 4; i++)
+				comps[i] = (unsigned)op.values[i];
+			ir_swizzle *swz = new(mem_ctx) ir_swizzle(regs[op.operands[0]],
+				comps[0], comps[1], comps[2], comps[3], (unsigned)op.values.size());
+			value = swz->constant_expression_value(mem_ctx);
+			break;
+		}
+		case PRESHADER_INDEX:
+		{
+			ir_dereference_array *deref = new(mem_ctx) ir_dereference_array(
+				regs[op.operands[0]], regs[op.operands[1]]);
+			value = deref->constant_expression_value(mem_ctx);
+			break;
+		}
+		default:
+			break;
+		}
+
+		if (!value)
+		{
+			res = false;
+			break;
+		}
+		regs.push_back(value);
+	}
+
+	if (res)
+	{
+		vOutputs->clear();
+		for (const auto& uni : m_Preshader.uniforms)
+		{
+			ir_constant *value = regs[uni.reg];
+			std::vector<double>& values = (*vOutputs)[uni.name];
+			for (unsigned i = 0; i < value->type->components(); i++)
+				values.push_back(value->get_double_component(i));
+		}
+	}
+
+	ralloc_free(mem_ctx);
+
+	return res;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// MEMORY STATS /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void GlslConvert::BeginMemoryPhase()
+{
+	if (!ralloc_stats_enabled()) return;
+
+	struct ralloc_stats stats;
+	ralloc_stats_get(&stats);
+	m_PhaseStartAllocCount = stats.alloc_count;
+	ralloc_stats_reset_peak();
+}
+
+// the phases with the same name are merged (passes run many times)
+void GlslConvert::EndMemoryPhase(const char* vName)
+{
+	if (!ralloc_stats_enabled()) return;
+
+	struct ralloc_stats stats;
+	ralloc_stats_get(&stats);
+
+	MemoryStats* phase = 0;
+	for (auto &it : m_Stats.memoryPhases)
+	{
+		if (it.name == vName)
+		{
+			phase = &it;
+			break;
+		}
+	}
+	if (!phase)
+	{
+		m_Stats.memoryPhases.push_back(MemoryStats());
+		phase = &m_Stats.memoryPhases.back();
+		phase->name = vName;
+	}
+
+	phase->calls++;
+	phase->allocCount += stats.alloc_count - m_PhaseStartAllocCount;
+	if (stats.peak_bytes > phase->peakBytes)
+		phase->peakBytes = stats.peak_bytes;
+	phase->liveBytes = stats.live_bytes;
+	phase->liveCount = stats.live_count;
+}
+
+void GlslConvert::AddMemoryRoot(const char* vName, const void* vMemCtx)
+{
+	if (!ralloc_stats_enabled() || !vMemCtx) return;
+
+	struct ralloc_stats stats;
+	if (!ralloc_stats_get_root(vMemCtx, &stats))
+		return;
+
+	MemoryStats root;
+	root.name = vName;
+	root.calls = 1;
+	root.allocCount = stats.alloc_count;
+	root.peakBytes = stats.peak_bytes;
+	root.liveBytes = stats.live_bytes;
+	root.liveCount = stats.live_count;
+	m_Stats.memoryRoots.push_back(root);
+}
+
+// all the roots, the peak is the max of the phases since the global peak is reset by each phase
+void GlslConvert::AddMemoryTotal()
+{
+	if (!ralloc_stats_enabled()) return;
+
+	struct ralloc_stats stats;
+	ralloc_stats_get(&stats);
+
+	MemoryStats total;
+	total.name = "total";
+	total.calls = 1;
+	total.allocCount = stats.alloc_count;
+	total.peakBytes = stats.peak_bytes;
+	for (auto &phase : m_Stats.memoryPhases)
+		if (phase.peakBytes > total.peakBytes)
+			total.peakBytes = phase.peakBytes;
+	total.liveBytes = stats.live_bytes;
+	total.liveCount = stats.live_count;
+	m_Stats.memoryRoots.push_back(total);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void GlslConvert::InitContext(struct gl_context *ctx, ApiTarget api, int vGlslVersion)
 {
 	gl_api glApi;
@@ -809,11 +1763,47 @@ void GlslConvert::InitContext(struct gl_context *ctx, ApiTarget api, int vGlslVe
 	//ctx->Driver.DeleteProgram = 0;
 }
 
+// the ast and the lexer strings are in the linear allocator of the state,
+// nothing in the hir point to them (the names are copied by ir_variable and ir_function)
+void GlslConvert::FreeAst(struct _mesa_glsl_parse_state *state)
+{
+	if (!state) return;
+
+	state->translation_unit.make_empty();
+	linear_free_parent(state->linalloc);
+	state->linalloc = linear_alloc_parent(state, 0);
+}
+
+// the hir is allocated in the state context, mixed with the symbols,
+// so it is moved under the ir list for be freed alone, like mesa do before free the state
+void GlslConvert::FreeIr(struct gl_shader *shader)
+{
+	if (!shader || !shader->ir) return;
+
+	reparent_ir(shader->ir, shader->ir);
+	ralloc_free(shader->ir);
+	shader->ir = 0;
+	shader->symbols = 0;
+}
+
 void GlslConvert::ClearContext(struct gl_context *ctx)
 {
 	_mesa_glsl_builtin_functions_decref();
 }
 
+// the refs are counted, InitContext and ClearContext then only change the counts
+void GlslConvert::RetainSharedState()
+{
+	glsl_type_singleton_init_or_ref();
+	_mesa_glsl_builtin_functions_init_or_ref();
+}
+
+void GlslConvert::ReleaseSharedState()
+{
+	_mesa_glsl_builtin_functions_decref();
+	glsl_type_singleton_decref();
+}
+
 struct gl_shader_program* GlslConvert::GetProgramFromShader(struct gl_context *ctx, struct gl_shader *shader)
 {
 	struct gl_shader_program *whole_program = 0;
@@ -866,6 +1856,8 @@ void GlslConvert::FillCompilerOptions(gl_shader_compiler_options *vCompileOption
 		vCompileOptions->EmitNoIndirectSampler = COND(COMPILER_EmitNoIndirectSampler);
 		vCompileOptions->MaxIfDepth = vOptimizationStruct->instructionToLower.MaxIfDepth;
 		vCompileOptions->MaxUnrollIterations = vOptimizationStruct->instructionToLower.MaxUnrollIterations;
+		vCompileOptions->MaxUnrollInstructions = vOptimizationStruct->instructionToLower.MaxUnrollInstructions;
+		vCompileOptions->UnrollPartial = vOptimizationStruct->instructionToLower.PartialUnroll;
 		vCompileOptions->OptimizeForAOS = COND(COMPILER_OptimizeForAOS);
 		vCompileOptions->LowerBufferInterfaceBlocks = COND(COMPILER_LowerBufferInterfaceBlocks);
 		vCompileOptions->ClampBlockIndicesToArrayBounds = COND(COMPILER_ClampBlockIndicesToArrayBounds);
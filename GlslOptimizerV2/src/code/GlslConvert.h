@@ -17,14 +17,22 @@
 #pragma once;
 
 #include "compiler/shader_enums.h"
+#include "OptimizationPipeline.h"
 #include <string>
 #include <map>
+#include <vector>
+#include <chrono>
 #include <functional>
 
 struct exec_list;
 struct gl_context;
 struct gl_shader_compiler_options;
 struct _mesa_glsl_parse_state;
+struct hash_table;
+class loop_state;
+class ir_ssa;
+class ir_def_use;
+class ir_value_range;
 class GlslConvert
 {
 public:
@@ -64,6 +72,15 @@ public:
 		CONTROL_DO_PARTIAL_SHADER = (1 << 1) // Passed shader is not the full shader source. This makes some optimizations weaker.
 	};
 
+	// validate_ir_tree, only done in the DEBUG builds of mesa
+	enum ValidationLevel
+	{
+		VALIDATION_OFF = 0,	// never
+		VALIDATION_FINAL,	// once, after the passes
+		VALIDATION_CHANGED,	// at each validate_ir_tree of the pipeline and after the passes, only the functions changed since the previous one. the change is found by a walk of all the ir
+		VALIDATION_FULL		// at each validate_ir_tree of the pipeline and after the passes, the whole ir
+	};
+
 	enum CompilerFlags
 	{
 		COMPILER_EmitNoLoops					= (1 << 0),
@@ -157,6 +174,8 @@ public:
 		OPT_lower_vector_insert = (1 << 2),
 		OPT_optimize_split_arrays = (1 << 3),
 		OPT_set_unroll_Loops = (1 << 4),
+		OPT_dead_store = (1 << 5),
+		OPT_value_range = (1 << 6),
 	};
 
 	struct OptimizationStruct
@@ -164,6 +183,8 @@ public:
 		// dont save
 		int maxCountPasses = 1000;
 		ShaderStage stage = ShaderStage::MESA_SHADER_FRAGMENT;
+		std::string shaderPath; // dir of the shader file, for resolve the relative #include
+		bool memoryStats = false; // ralloc accounting per phase and per pass, see GetStats()
 
 		// the rest is to save
 		CompilerFlags compilerFlags = (GlslConvert::CompilerFlags)0;
@@ -175,6 +196,12 @@ public:
 		struct AlgebraicOptions
 		{
 			bool native_integers = true;
+			bool rules_basic = true; // inverse and repeated ops, like rcp(rcp(x)) => x
+			bool rules_pow = true; // pow with a small constant exponent, like pow(x, 3.0) => x * x * x
+			bool rules_length = true; // length and normalize, like length(x) < r => dot(x, x) < r * r
+			bool rules_trig = false; // sin and cos of the same angle, like sin(x) * cos(x) * 2.0 => sin(x * 2.0). change the float results
+			bool rules_mad = false; // multiply-add forms, like (x + 1.0) * 0.5 => x * 0.5 + 0.5. change the rounding
+			bool fast_math = false; // reassociate the float add and mul chains, change the rounding. never for precise and invariant
 		} algebraicOptions;
 
 		struct LowerJumpsOptions
@@ -189,7 +216,8 @@ public:
 		struct LowerIfToCondAssignOptions
 		{
 			int max_depth = 10;
-			int min_branch_cost = 1;
+			int min_branch_cost = 1; // an if whose blocks have less expressions than this is flattened, 0 for never
+			int branch_cost = 0; // cost of a branch in alu ops, an if on a non uniform condition is flattened if cheaper, 0 for never
 		} lowerIfToCondAssignOptions;
 
 		struct LowerVariableIndexToCondAssignOptions
@@ -198,6 +226,8 @@ public:
 			bool lower_output = true;
 			bool lower_temp = true;
 			bool lower_uniform = true;
+			int linear_max_length = 4; // arrays up to this length are a chain of cond assign, the longer ones a tree of if
+			int max_length = 0; // arrays longer than this keep the indirect addressing, 0 for no limit
 		} lowerVariableIndexToCondAssignOptions;
 
 		struct DeadCodeOptions
@@ -215,6 +245,11 @@ public:
 			bool lower_nonconstant_index = false;
 		} lowerVectorInsertOptions;
 
+		struct ValueRangeOptions
+		{
+			bool normalized_textures = false; // the float samplers all read unorm formats, so [0,1]
+		} valueRangeOptions;
+
 		struct LowerQuadopVector
 		{
 			bool dont_lower_swz = true;
@@ -224,7 +259,116 @@ public:
 		{
 			int MaxIfDepth = 10;
 			int MaxUnrollIterations = 10;
+			int MaxUnrollInstructions = 0; // budget of the body cost times the copies, 0 => MaxUnrollIterations * 5 assignments and expressions, as before
+			bool PartialUnroll = false; // over budget, unroll by a factor of the trip count
 		} instructionToLower;
+
+		struct IncludeOptions
+		{
+			std::string includePaths; // separated by ';'
+			bool implicit_extension = true; // #include allowed without #extension GL_ARB_shading_language_include
+		} includeOptions;
+
+		struct PrintOptions
+		{
+			bool minify = false; // glsl target : short names, no spaces, shortest floats
+		} printOptions;
+
+		struct PipelineOptions
+		{
+			std::string pipeline; // order of the passes, empty => OptimizationPipeline::GetDefaultPipeline()
+		} pipelineOptions;
+
+		struct PerFunctionOptions
+		{
+			bool enabled = false; // optimize each function body alone before the inlining
+			int threads = 0; // 0 => hardware concurrency, 1 => serial. same result in any case
+		} perFunctionOptions;
+
+		struct BudgetOptions
+		{
+			int timeMs = 0; // wall-clock budget from the call of Optimize, checked between the passes. 0 => no limit
+		} budgetOptions;
+
+		struct ValidationOptions
+		{
+			ValidationLevel level = ValidationLevel::VALIDATION_FINAL;
+		} validationOptions;
+
+		struct PreshaderOptions
+		{
+			bool enabled = false; // move the expressions of the uniforms alone to new uniforms, computed once per draw, see GetPreshader()
+		} preshaderOptions;
+	};
+
+	struct Dependency
+	{
+		std::string path;
+		std::string hash; // sha1 of the content
+	};
+
+	struct MemoryStats
+	{
+		std::string name;
+		size_t calls = 0;		// runs of the phase, the passes run at each iteration
+		size_t allocCount = 0;	// allocations and resizes
+		size_t peakBytes = 0;	// high-water mark of the live bytes
+		size_t liveBytes = 0;	// live bytes at the end
+		size_t liveCount = 0;	// live blocks at the end
+	};
+
+	struct UnrollStats
+	{
+		std::string function;
+		int iterations = -1;	// trip count, -1 if unknown
+		int bodyCost = 0;		// estimated instructions of one iteration
+		int factor = 0;			// copies of the body, 0 => kept rolled
+		std::string decision;
+	};
+
+	enum PreshaderOpKind
+	{
+		PRESHADER_UNIFORM = 0,	// the value of the input name
+		PRESHADER_CONSTANT,		// values
+		PRESHADER_EXPRESSION,	// operation of the operands, an ir_expression_operation
+		PRESHADER_SWIZZLE,		// components values of the operand
+		PRESHADER_INDEX			// column of a matrix or component of a vector, operands are the value and the index
+	};
+
+	// one op of the preshader program, who set the register of his index in the program
+	struct PreshaderOp
+	{
+		int kind = PRESHADER_CONSTANT;
+		int operation = 0;
+		int baseType = 0;		// glsl_base_type of the result
+		int vectorElements = 1;
+		int matrixColumns = 1;
+		std::vector<int> operands; // registers of previous ops
+		std::vector<double> values;
+		std::string name;
+	};
+
+	struct PreshaderUniform
+	{
+		std::string name;		// preshader_0, preshader_1...
+		std::string type;		// glsl type, like vec3
+		std::string expression;	// glsl of the value, from the inputs
+		int reg = -1;			// register of the value in the program
+	};
+
+	struct Preshader
+	{
+		std::vector<std::string> inputs;		// the uniforms read, like exposure or lights[2].color
+		std::vector<PreshaderUniform> uniforms;	// to set on the optimized shader
+		std::vector<PreshaderOp> program;
+		std::string source;						// the same as a glsl like function
+	};
+
+	struct Stats
+	{
+		std::vector<MemoryStats> memoryPhases;	// preprocess, parse, hir, link, each pass, print
+		std::vector<MemoryStats> memoryRoots;	// shader, program and total, just before the final free
+		std::vector<UnrollStats> unrollDecisions;	// in order, a decision taken again at the next pass is not repeated
 	};
 
 public:
@@ -261,12 +405,99 @@ private:
 		struct exec_list *vIr, 
 		bool linked,
 		gl_shader_compiler_options *vCompilerFlags,
+		OptimizationStruct *vOptimisationStruct,
+		const OptimizationPipeline::Item& vPipeline);
+	bool RunPipelineItem(
+		const OptimizationPipeline::Item& vItem,
+		struct exec_list *vIr,
+		bool linked,
+		gl_shader_compiler_options *vCompilerFlags,
 		OptimizationStruct *vOptimisationStruct);
+	bool RunPass(
+		OptimizationPipeline::PassId vPass,
+		struct exec_list *vIr,
+		bool linked,
+		gl_shader_compiler_options *vCompilerFlags,
+		OptimizationStruct *vOptimisationStruct);
+	void DO_PerFunction_Optimization_Pass(
+		struct exec_list *vIr,
+		gl_shader_compiler_options *vCompilerFlags,
+		OptimizationStruct *vOptimisationStruct);
+	static void OptimizeFunctionBody(
+		struct exec_list *vBody,
+		gl_shader_compiler_options *vCompilerFlags,
+		OptimizationStruct *vOptimisationStruct,
+		const std::chrono::steady_clock::time_point *vDeadline);
+	bool IsBudgetExhausted();
+	void ClearLoopState();
+	void ClearSsa(struct exec_list *vIr);
+	ir_def_use* GetDefUse(struct exec_list *vIr);
+	void ClearDefUse();
+	ir_value_range* GetValueRange(struct exec_list *vIr, OptimizationStruct *vOptimizationStruct);
+	static unsigned GetAlgebraicRules(OptimizationStruct *vOptimizationStruct);
+	void ValidateIr(struct exec_list *vIr, ValidationLevel vLevel, bool vFinal);
+	void ExtractPreshader(
+		struct exec_list *vIr,
+		bool linked,
+		struct _mesa_glsl_parse_state *vState,
+		OptimizationStruct *vOptimizationStruct);
+
+public: // #include
+	bool AddNamedString(const std::string& vName, const std::string& vSource);
+	bool RemoveNamedString(const std::string& vName);
+	void ClearNamedStrings();
+	void ClearIncludeCache();
+	const std::vector<Dependency>& GetDependencies() const;
+	std::string GetMakeDependencies(const std::string& vTarget) const;
+
+public: // minify
+	const std::map<std::string, std::string>& GetMinifiedNames() const;
+
+public: // preshader
+	const Preshader& GetPreshader() const; // of the last Optimize, empty if disabled or nothing to move
+	// the uniforms of the preshader from the values of his inputs, in the component order of the uniform, matrices by column.
+	// false if an input is missing or of a bad size
+	bool EvaluatePreshader(
+		const std::map<std::string, std::vector<double>>& vInputs,
+		std::map<std::string, std::vector<double>>* vOutputs) const;
+
+public:
+	bool IsLastOptimizeSucceeded() const; // false if the last Optimize returned an info log
+	bool IsLastBudgetExhausted() const; // true if the last Optimize stopped the passes at the time budget
+	const Stats& GetStats() const; // of the last Optimize
+
+private:
+	std::vector<Dependency> m_Dependencies; // files included by the last Optimize
+	std::map<std::string, std::string> m_MinifiedNames; // short name => original name, of the last minified Optimize
+	Preshader m_Preshader; // of the last Optimize, plain data since the ir is freed at his end
+	bool m_LastOptimizeSucceeded = false;
+	bool m_LastBudgetExhausted = false;
+	bool m_HasDeadline = false;
+	std::chrono::steady_clock::time_point m_Deadline;
+	loop_state* m_LoopState = nullptr; // loop analysis of the current ir, kept for the printer while the passes change nothing
+	ir_def_use* m_DefUse = nullptr; // references of the variables, kept while the passes who dont update it make no progress
+	ir_value_range* m_ValueRange = nullptr; // ranges of the values for minmax_prune and algebraic, kept like m_LoopState
+	ir_ssa* m_Ssa = nullptr; // from into_ssa to out_of_ssa, or to the end of the passes
+	struct hash_table* m_ValidationFingerprints = nullptr; // ir_function => fingerprint at his last validation, for VALIDATION_CHANGED
+	Stats m_Stats;
+	size_t m_PhaseStartAllocCount = 0;
 
 public:
 	static void InitContext(struct gl_context *ctx, ApiTarget api, int vGlslVersion);
 	static void ClearContext(struct gl_context *ctx);
+	// for a long lived process (the server), the builtin functions and the glsl types are kept between the Optimize calls
+	// instead of being rebuilt by each of them, from RetainSharedState to ReleaseSharedState
+	static void RetainSharedState();
+	static void ReleaseSharedState();
 	static struct gl_shader_program* GetProgramFromShader(struct gl_context *ctx, struct gl_shader *shader);
+	static void FreeAst(struct _mesa_glsl_parse_state *state);
+	static void FreeIr(struct gl_shader *shader);
+
+private: // memory stats
+	void BeginMemoryPhase();
+	void EndMemoryPhase(const char* vName);
+	void AddMemoryRoot(const char* vName, const void* vMemCtx);
+	void AddMemoryTotal();
 
 private:
 	void FillCompilerOptions(gl_shader_compiler_options *vCompileOptions, OptimizationStruct *vOptimizationStruct);
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OptimizationPipeline.h"
+
+#include <cctype>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// same names as the optimization flags, without OPT_
+static const char* s_PassNames[OptimizationPipeline::PASS_Count] =
+{
+	"",
+	"lower_instructions",
+	"function_inlining",
+	"dead_functions",
+	"structure_splitting",
+	"propagate_invariance",
+	"if_simplification",
+	"flatten_nested_if_blocks",
+	"conditional_discard",
+	"copy_propagation_elements",
+	"flip_matrices",
+	"vectorize",
+	"dead_code",
+	"dead_code_local",
+	"dead_store",
+	"tree_grafting",
+	"constant_propagation",
+	"constant_variable",
+	"constant_folding",
+	"minmax_prune",
+	"rebalance_tree",
+	"algebraic",
+	"lower_jumps",
+	"vec_index_to_swizzle",
+	"lower_vector_insert",
+	"optimize_swizzles",
+	"optimize_split_arrays",
+	"optimize_redundant_jumps",
+	"unroll_loops",
+	"lower_texture_projection",
+	"lower_if_to_cond_assign",
+	"mat_op_to_vec",
+	"vec_index_to_cond_assign",
+	"lower_discard",
+	"lower_noise",
+	"lower_variable_index_to_cond_assign",
+	"lower_quadop_vector",
+	"into_ssa",
+	"out_of_ssa",
+	"validate_ir_tree",
+};
+
+struct PassAlias
+{
+	const char* alias;
+	OptimizationPipeline::PassId pass;
+};
+
+static const PassAlias s_PassAliases[] =
+{
+	{ "inline", OptimizationPipeline::PASS_function_inlining },
+	{ "dce", OptimizationPipeline::PASS_dead_code },
+	{ "dce_local", OptimizationPipeline::PASS_dead_code_local },
+	{ "dse", OptimizationPipeline::PASS_dead_store },
+	{ "copyprop", OptimizationPipeline::PASS_copy_propagation_elements },
+	{ "cprop", OptimizationPipeline::PASS_constant_propagation },
+	{ "cfold", OptimizationPipeline::PASS_constant_folding },
+	{ "graft", OptimizationPipeline::PASS_tree_grafting },
+	{ "unroll", OptimizationPipeline::PASS_unroll_loops },
+	{ "validate", OptimizationPipeline::PASS_validate_ir_tree },
+};
+
+// the historical order, the whole list run while progress
+static const char* s_DefaultPipeline =
+	"(lower_instructions,function_inlining,dead_functions,structure_splitting,propagate_invariance,"
+	"if_simplification,flatten_nested_if_blocks,conditional_discard,copy_propagation_elements,"
+	"flip_matrices,vectorize,dead_code,dead_code_local,dead_store,tree_grafting,constant_propagation,"
+	"constant_variable,constant_folding,minmax_prune,rebalance_tree,algebraic,lower_jumps,"
+	"vec_index_to_swizzle,lower_vector_insert,optimize_swizzles,optimize_split_arrays,"
+	"optimize_redundant_jumps,unroll_loops,lower_texture_projection,lower_if_to_cond_assign,"
+	"mat_op_to_vec,vec_index_to_cond_assign,lower_discard,lower_noise,"
+	"lower_variable_index_to_cond_assign,lower_quadop_vector,validate_ir_tree)*";
+
+///////////////////////////////////////////////////////////////////////////////
+//// PARSER ///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+class PipelineParser
+{
+private:
+	const std::string& m_Str;
+	size_t m_Pos = 0;
+	std::string m_Error;
+
+public:
+	explicit PipelineParser(const std::string& vStr) : m_Str(vStr) {}
+
+	bool Parse(OptimizationPipeline::Item* vRoot, std::string* vError)
+	{
+		vRoot->pass = OptimizationPipeline::PASS_NONE;
+		vRoot->items.clear();
+		vRoot->repeat = false;
+		vRoot->maxIterations = 0;
+
+		bool ok = ParseList(&vRoot->items);
+		if (ok)
+		{
+			SkipSpaces();
+			if (m_Pos < m_Str.size())
+				ok = Fail(m_Str[m_Pos] == ')' ? "unbalanced ')'" : "',' expected");
+		}
+
+		if (!ok && vError)
+			*vError = m_Error;
+
+		return ok;
+	}
+
+private:
+	bool Fail(const std::string& vMsg)
+	{
+		if (m_Error.empty())
+			m_Error = vMsg + " at " + std::to_string(m_Pos);
+		return false;
+	}
+
+	void SkipSpaces()
+	{
+		while (m_Pos < m_Str.size() && isspace((unsigned char)m_Str[m_Pos]))
+			++m_Pos;
+	}
+
+	bool ParseList(std::vector<OptimizationPipeline::Item>* vItems)
+	{
+		while (true)
+		{
+			OptimizationPipeline::Item item;
+			if (!ParseItem(&item))
+				return false;
+			vItems->push_back(item);
+
+			SkipSpaces();
+			if (m_Pos >= m_Str.size() || m_Str[m_Pos] != ',')
+				return true;
+			++m_Pos;
+		}
+	}
+
+	bool ParseItem(OptimizationPipeline::Item* vItem)
+	{
+		SkipSpaces();
+		if (m_Pos >= m_Str.size())
+			return Fail("pass expected");
+
+		if (m_Str[m_Pos] == '(')
+		{
+			++m_Pos;
+			if (!ParseList(&vItem->items))
+				return false;
+			SkipSpaces();
+			if (m_Pos >= m_Str.size() || m_Str[m_Pos] != ')')
+				return Fail("')' expected");
+			++m_Pos;
+		}
+		else
+		{
+			size_t start = m_Pos;
+			while (m_Pos < m_Str.size() && (isalnum((unsigned char)m_Str[m_Pos]) || m_Str[m_Pos] == '_'))
+				++m_Pos;
+			if (m_Pos == start)
+				return Fail("pass expected");
+
+			std::string name = m_Str.substr(start, m_Pos - start);
+			vItem->pass = OptimizationPipeline::GetPassId(name);
+			if (vItem->pass == OptimizationPipeline::PASS_NONE)
+			{
+				m_Pos = start;
+				return Fail("unknown pass '" + name + "'");
+			}
+		}
+
+		SkipSpaces();
+		if (m_Pos < m_Str.size() && m_Str[m_Pos] == '*')
+		{
+			++m_Pos;
+			vItem->repeat = true;
+			SkipSpaces();
+			size_t start = m_Pos;
+			while (m_Pos < m_Str.size() && isdigit((unsigned char)m_Str[m_Pos]))
+				++m_Pos;
+			if (m_Pos > start)
+			{
+				if (m_Pos - start > 6)
+					return Fail("iteration limit too big");
+				vItem->maxIterations = std::stoi(m_Str.substr(start, m_Pos - start));
+				if (vItem->maxIterations < 1)
+					return Fail("iteration limit must be >= 1");
+			}
+		}
+
+		return true;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool OptimizationPipeline::Parse(const std::string& vPipeline, Item* vRoot, std::string* vError)
+{
+	if (!vRoot) return false;
+
+	std::string pipeline = vPipeline;
+	if (pipeline.find_first_not_of(" \t\r\n") == std::string::npos)
+		pipeline = s_DefaultPipeline;
+
+	PipelineParser parser(pipeline);
+	return parser.Parse(vRoot, vError);
+}
+
+std::string OptimizationPipeline::ToString(const Item& vItem)
+{
+	std::string res;
+
+	if (vItem.pass != PASS_NONE)
+	{
+		res = GetPassName(vItem.pass);
+	}
+	else
+	{
+		for (size_t i = 0; i < vItem.items.size(); ++i)
+		{
+			if (i) res += ",";
+			res += ToString(vItem.items[i]);
+		}
+	}
+
+	if (vItem.repeat)
+	{
+		if (vItem.pass == PASS_NONE)
+			res = "(" + res + ")";
+		res += "*";
+		if (vItem.maxIterations > 0)
+			res += std::to_string(vItem.maxIterations);
+	}
+
+	return res;
+}
+
+const char* OptimizationPipeline::GetDefaultPipeline()
+{
+	return s_DefaultPipeline;
+}
+
+const char* OptimizationPipeline::GetPassName(PassId vPass)
+{
+	if (vPass > PASS_NONE && vPass < PASS_Count)
+		return s_PassNames[vPass];
+	return "";
+}
+
+OptimizationPipeline::PassId OptimizationPipeline::GetPassId(const std::string& vName)
+{
+	for (int i = PASS_NONE + 1; i < PASS_Count; ++i)
+		if (vName == s_PassNames[i])
+			return (PassId)i;
+
+	for (auto &alias : s_PassAliases)
+		if (vName == alias.alias)
+			return alias.pass;
+
+	return PASS_NONE;
+}
+
+std::string OptimizationPipeline::GetPassNames()
+{
+	std::string res;
+
+	for (int i = PASS_NONE + 1; i < PASS_Count; ++i)
+	{
+		if (!res.empty()) res += ", ";
+		res += s_PassNames[i];
+	}
+
+	for (auto &alias : s_PassAliases)
+	{
+		res += ", ";
+		res += alias.alias;
+		res += " (";
+		res += s_PassNames[alias.pass];
+		res += ")";
+	}
+
+	return res;
+}
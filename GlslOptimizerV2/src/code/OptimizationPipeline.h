@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * pass order of GlslConvert::DO_Optimization_Pass, as a string
+ *
+ * pipeline := item (',' item)*
+ * item     := pass [repeat] | '(' pipeline ')' [repeat]
+ * repeat   := '*' [count]
+ *
+ * - a pass or a group without repeat is run once
+ * - with '*', it is run again while it make progress (fixpoint), at most maxCountPasses times
+ * - with '*N', at most N times
+ *
+ * ex : "inline,dce,cprop*,(cfold,algebraic)*8,unroll"
+ *
+ * the passes are still subject to the optimization flags, a disabled pass is just skipped.
+ * an empty pipeline mean the default one, who is the historical order of DO_Optimization_Pass
+ */
+
+class OptimizationPipeline
+{
+public:
+	enum PassId
+	{
+		PASS_NONE = 0, // a group
+		PASS_lower_instructions,
+		PASS_function_inlining,
+		PASS_dead_functions,
+		PASS_structure_splitting,
+		PASS_propagate_invariance,
+		PASS_if_simplification,
+		PASS_flatten_nested_if_blocks,
+		PASS_conditional_discard,
+		PASS_copy_propagation_elements,
+		PASS_flip_matrices,
+		PASS_vectorize,
+		PASS_dead_code,
+		PASS_dead_code_local,
+		PASS_dead_store,
+		PASS_tree_grafting,
+		PASS_constant_propagation,
+		PASS_constant_variable,
+		PASS_constant_folding,
+		PASS_minmax_prune,
+		PASS_rebalance_tree,
+		PASS_algebraic,
+		PASS_lower_jumps,
+		PASS_vec_index_to_swizzle,
+		PASS_lower_vector_insert,
+		PASS_optimize_swizzles,
+		PASS_optimize_split_arrays,
+		PASS_optimize_redundant_jumps,
+		PASS_unroll_loops,
+		PASS_lower_texture_projection,
+		PASS_lower_if_to_cond_assign,
+		PASS_mat_op_to_vec,
+		PASS_vec_index_to_cond_assign,
+		PASS_lower_discard,
+		PASS_lower_noise,
+		PASS_lower_variable_index_to_cond_assign,
+		PASS_lower_quadop_vector,
+		PASS_into_ssa,
+		PASS_out_of_ssa,
+		PASS_validate_ir_tree,
+		PASS_Count
+	};
+
+	struct Item
+	{
+		PassId pass = PassId::PASS_NONE;
+		std::vector<Item> items; // content of a group
+		bool repeat = false; // run while progress
+		int maxIterations = 0; // with repeat, 0 mean maxCountPasses
+	};
+
+public:
+	static bool Parse(const std::string& vPipeline, Item* vRoot, std::string* vError);
+	static std::string ToString(const Item& vItem);
+	static const char* GetDefaultPipeline();
+	static const char* GetPassName(PassId vPass);
+	static PassId GetPassId(const std::string& vName); // name or alias, PASS_NONE if unknown
+	static std::string GetPassNames(); // for the help, separated by ", "
+};
@@ -0,0 +1,348 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShaderInclude.h"
+
+#include <fstream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "main/mtypes.h"
+#include "util/ralloc.h"
+#include "util/mesa-sha1.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static bool GetFileStat(const std::string& vPath, long long* vMTime, long long* vSize)
+{
+#ifdef _MSC_VER
+	struct _stat64 st;
+	if (_stat64(vPath.c_str(), &st) != 0) return false;
+	if ((st.st_mode & _S_IFMT) != _S_IFREG) return false;
+#else
+	struct stat st;
+	if (stat(vPath.c_str(), &st) != 0) return false;
+	if ((st.st_mode & S_IFMT) != S_IFREG) return false;
+#endif
+	*vMTime = (long long)st.st_mtime;
+	*vSize = (long long)st.st_size;
+	return true;
+}
+
+static bool IsAbsolutePath(const std::string& vPath)
+{
+	if (vPath.empty()) return false;
+	if (vPath[0] == '/') return true;
+	if (vPath.size() > 1 && vPath[1] == ':') return true; // C:/...
+	return false;
+}
+
+static std::string JoinPath(const std::string& vDir, const std::string& vPath)
+{
+	if (vDir.empty()) return vPath;
+	if (vDir[vDir.size() - 1] == '/') return ShaderInclude::NormalizePath(vDir + vPath);
+	return ShaderInclude::NormalizePath(vDir + "/" + vPath);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+ShaderInclude::ShaderInclude()
+{
+
+}
+
+ShaderInclude::~ShaderInclude()
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// NAMED STRINGS ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// like glNamedStringARB, the name must be a full path starting with '/'
+bool ShaderInclude::AddNamedString(const std::string& vName, const std::string& vSource)
+{
+	std::string name = NormalizePath(vName);
+	if (name.empty() || name[0] != '/') return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CacheEntry& entry = m_NamedStrings[name];
+	entry.source = vSource;
+	entry.hash = ComputeHash(vSource);
+	entry.size = (long long)vSource.size();
+
+	return true;
+}
+
+bool ShaderInclude::RemoveNamedString(const std::string& vName)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_NamedStrings.erase(NormalizePath(vName)) > 0;
+}
+
+void ShaderInclude::ClearNamedStrings()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_NamedStrings.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// CACHE ////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void ShaderInclude::ClearCache()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_FileCache.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// COMPILE //////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// vIncludePaths is a list of paths separated by ';'
+// vShaderPath is the dir of the main shader file, can be empty
+// the sources given to glcpp are allocated under vMemCtx
+shader_includes* ShaderInclude::CreateIncludes(void* vMemCtx, const std::string& vIncludePaths, const std::string& vShaderPath)
+{
+	shader_includes* includes = new shader_includes();
+	includes->mem_ctx = ralloc_context(vMemCtx);
+
+	std::stringstream ss(vIncludePaths);
+	std::string path;
+	while (std::getline(ss, path, ';'))
+	{
+		path = NormalizePath(path);
+		if (!path.empty())
+			includes->includePaths.push_back(path);
+	}
+
+	if (!vShaderPath.empty())
+	{
+		shader_includes::Frame frame;
+		frame.dir = NormalizePath(vShaderPath);
+		frame.parent = 0;
+		includes->frames.push_back(frame);
+		includes->cursor = includes->frames.size();
+	}
+
+	return includes;
+}
+
+void ShaderInclude::DestroyIncludes(shader_includes* vIncludes)
+{
+	if (vIncludes)
+	{
+		ralloc_free(vIncludes->mem_ctx);
+		delete vIncludes;
+	}
+}
+
+// search order :
+// - absolute path : named string then file
+// - relative path : relative to the including file (cursor), then each include path
+const char* ShaderInclude::Lookup(shader_includes* vIncludes, const char* vPath)
+{
+	if (!vIncludes || !vPath) return 0;
+
+	std::string path = NormalizePath(vPath);
+	if (path.empty()) return 0;
+
+	std::vector<std::string> candidates;
+	if (IsAbsolutePath(path))
+	{
+		candidates.push_back(path);
+	}
+	else
+	{
+		if (vIncludes->cursor > 0 && vIncludes->cursor <= vIncludes->frames.size())
+			candidates.push_back(JoinPath(vIncludes->frames[vIncludes->cursor - 1].dir, path));
+		for (auto &dir : vIncludes->includePaths)
+			candidates.push_back(JoinPath(dir, path));
+	}
+
+	for (auto &candidate : candidates)
+	{
+		std::string hash;
+		const char* source = 0;
+		if (FindNamedString(candidate, &hash, &source, vIncludes->mem_ctx) ||
+			FindFile(candidate, &hash, &source, vIncludes->mem_ctx))
+		{
+			if (vIncludes->dependenciesSet.find(candidate) == vIncludes->dependenciesSet.end())
+			{
+				vIncludes->dependenciesSet.emplace(candidate);
+				shader_includes::Dependency dep;
+				dep.path = candidate;
+				dep.hash = hash;
+				vIncludes->dependencies.push_back(dep);
+			}
+
+			// the nested includes will be resolved relatively to this one
+			// glcpp restore the cursor after the parsing of this file
+			shader_includes::Frame frame;
+			frame.dir = GetDirectory(candidate);
+			frame.parent = vIncludes->cursor;
+			vIncludes->frames.push_back(frame);
+			vIncludes->cursor = vIncludes->frames.size();
+
+			return source;
+		}
+	}
+
+	return 0;
+}
+
+bool ShaderInclude::FindNamedString(const std::string& vPath, std::string* vHash, const char** vSource, void* vMemCtx)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto it = m_NamedStrings.find(vPath);
+	if (it == m_NamedStrings.end()) return false;
+
+	*vHash = it->second.hash;
+	*vSource = ralloc_strdup(vMemCtx, it->second.source.c_str());
+
+	return true;
+}
+
+// the file is read again only if his size or modification time has changed
+bool ShaderInclude::FindFile(const std::string& vPath, std::string* vHash, const char** vSource, void* vMemCtx)
+{
+	long long mtime = 0, size = 0;
+	if (!GetFileStat(vPath, &mtime, &size)) return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	CacheEntry& entry = m_FileCache[vPath];
+	if (entry.hash.empty() || entry.mtime != mtime || entry.size != size)
+	{
+		std::ifstream file(vPath, std::ios::in | std::ios::binary);
+		if (!file.is_open())
+		{
+			m_FileCache.erase(vPath);
+			return false;
+		}
+
+		std::stringstream ss;
+		ss << file.rdbuf();
+
+		entry.source = ss.str();
+		entry.hash = ComputeHash(entry.source);
+		entry.mtime = mtime;
+		entry.size = size;
+	}
+
+	*vHash = entry.hash;
+	*vSource = ralloc_strdup(vMemCtx, entry.source.c_str());
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// STATIC ///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// '\\' to '/', remove "./" and resolve "../" when possible
+std::string ShaderInclude::NormalizePath(const std::string& vPath)
+{
+	std::string path = vPath;
+	for (auto &c : path)
+		if (c == '\\') c = '/';
+
+	// trim spaces
+	size_t first = path.find_first_not_of(" \t");
+	if (first == std::string::npos) return "";
+	size_t last = path.find_last_not_of(" \t");
+	path = path.substr(first, last - first + 1);
+
+	bool absolute = (path[0] == '/');
+
+	std::vector<std::string> parts;
+	std::stringstream ss(path);
+	std::string part;
+	while (std::getline(ss, part, '/'))
+	{
+		if (part.empty() || part == ".") continue;
+		if (part == ".." && !parts.empty() && parts.back() != "..")
+		{
+			parts.pop_back();
+			continue;
+		}
+		if (part == ".." && absolute) continue; // cant go upper than root
+		parts.push_back(part);
+	}
+
+	std::string res = absolute ? "/" : "";
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		if (i) res += "/";
+		res += parts[i];
+	}
+
+	return res;
+}
+
+std::string ShaderInclude::GetDirectory(const std::string& vFilePathName)
+{
+	size_t p = vFilePathName.find_last_of('/');
+	if (p == std::string::npos) return "";
+	if (p == 0) return "/";
+	return vFilePathName.substr(0, p);
+}
+
+std::string ShaderInclude::ComputeHash(const std::string& vSource)
+{
+	unsigned char sha1[20];
+	char buf[41];
+	_mesa_sha1_compute(vSource.c_str(), vSource.size(), sha1);
+	_mesa_sha1_format(buf, sha1);
+	return std::string(buf);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//// GLCPP ENTRY POINTS ///////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+/* called by glcpp-parse.y for each #include directive */
+
+extern "C" const char *
+_mesa_lookup_shader_include(struct gl_context *ctx, char *path, bool error_check)
+{
+	(void)error_check;
+
+	if (!ctx || !ctx->Shared) return 0;
+	return ShaderInclude::Instance()->Lookup(ctx->Shared->ShaderIncludes, path);
+}
+
+extern "C" size_t
+_mesa_get_shader_include_cursor(struct gl_shared_state *shared)
+{
+	if (!shared || !shared->ShaderIncludes) return 0;
+	return shared->ShaderIncludes->cursor;
+}
+
+extern "C" void
+_mesa_set_shader_include_cursor(struct gl_shared_state *shared, size_t cursor)
+{
+	if (!shared || !shared->ShaderIncludes) return;
+	shared->ShaderIncludes->cursor = cursor;
+}
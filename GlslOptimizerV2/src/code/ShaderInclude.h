@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+
+/*
+ * #include resolution for glcpp
+ *
+ * glcpp-parse.y already handle the #include directive, but ask the outside world for the source
+ * of the included file via _mesa_lookup_shader_include. This module implement it for the optimizer :
+ * - named strings (GL_ARB_shading_language_include virtual paths, like "/lib/noise.glsl")
+ * - files on disk, searched relatively to the including file (only for "" form) then in the include paths
+ *
+ * headers are kept in a process wide cache, keyed by the resolved path and the hash of the content,
+ * so the next compiles of the same shader family dont hit the disk again.
+ * the resolved headers of a compile are kept for emit the dependency list
+ */
+
+struct shader_includes
+{
+	struct Frame
+	{
+		std::string dir;	// dir of the included file, used for resolve the "" includes it contain
+		size_t parent = 0;	// cursor of the including file
+	};
+
+	struct Dependency
+	{
+		std::string path;
+		std::string hash;	// sha1 of the content
+	};
+
+	void* mem_ctx = 0;						// owner of the sources given to glcpp
+	std::vector<std::string> includePaths;
+	std::vector<Frame> frames;				// frames[cursor - 1] is the current file, 0 mean no current file
+	size_t cursor = 0;
+	std::vector<Dependency> dependencies;	// in order of first inclusion
+	std::set<std::string> dependenciesSet;
+};
+
+class ShaderInclude
+{
+private:
+	struct CacheEntry
+	{
+		long long mtime = 0;
+		long long size = 0;
+		std::string hash;
+		std::string source;
+	};
+
+private:
+	std::mutex m_Mutex;
+	std::map<std::string, CacheEntry> m_NamedStrings;	// GL_ARB_shading_language_include virtual tree
+	std::map<std::string, CacheEntry> m_FileCache;		// disk headers
+
+public:
+	static ShaderInclude* Instance()
+	{
+		static ShaderInclude *_instance = new ShaderInclude();
+		return _instance;
+	}
+
+protected:
+	ShaderInclude(); // Prevent construction
+	ShaderInclude(const ShaderInclude&) {}; // Prevent construction by copying
+	ShaderInclude& operator =(const ShaderInclude&) { return *this; }; // Prevent assignment
+	~ShaderInclude(); // Prevent unwanted destruction
+
+public: // named strings
+	bool AddNamedString(const std::string& vName, const std::string& vSource);
+	bool RemoveNamedString(const std::string& vName);
+	void ClearNamedStrings();
+
+public: // cache
+	void ClearCache();
+
+public: // compile
+	shader_includes* CreateIncludes(void* vMemCtx, const std::string& vIncludePaths, const std::string& vShaderPath);
+	void DestroyIncludes(shader_includes* vIncludes);
+	const char* Lookup(shader_includes* vIncludes, const char* vPath);
+
+public:
+	static std::string NormalizePath(const std::string& vPath);
+	static std::string GetDirectory(const std::string& vFilePathName);
+	static std::string ComputeHash(const std::string& vSource);
+
+private:
+	bool FindNamedString(const std::string& vPath, std::string* vHash, const char** vSource, void* vMemCtx);
+	bool FindFile(const std::string& vPath, std::string* vHash, const char** vSource, void* vMemCtx);
+};
@@ -1,6 +1,10 @@
 #include <inttypes.h>
+#include <vector>
+#include <set>
+#include <algorithm>
 #include "ir_print_glsl_visitor.h"
 #include "ir_visitor.h"
+#include "ir_hierarchical_visitor.h"
 #include "glsl_types.h"
 #include "loop_analysis.h"
 #include "compiler/glsl_types.h"
@@ -8,6 +12,7 @@
 #include "main/macros.h"
 #include "util/hash_table.h"
 #include "util/u_string.h"
+#include "util/dtoa.h"
 
 struct ga_entry : public exec_node
 {
@@ -25,11 +30,14 @@ IR_TO_GLSL::global_print_tracker::global_print_tracker()
 	var_counter = 0;
 	var_hash = _mesa_pointer_hash_table_create(NULL);
 	main_function_done = false;
+	minify = false;
+	minified_names = _mesa_pointer_hash_table_create(NULL);
 }
 
 IR_TO_GLSL::global_print_tracker::~global_print_tracker()
 {
 	_mesa_hash_table_destroy(var_hash, NULL);
+	_mesa_hash_table_destroy(minified_names, NULL);
 	ralloc_free(mem_ctx);
 }
 
@@ -126,7 +134,10 @@ void IR_TO_GLSL::print_type_post(sbuffer& str, const glsl_type *t, bool arraySiz
 std::string IR_TO_GLSL::Convert(
 	exec_list *instructions, 
 	struct _mesa_glsl_parse_state *state, 
-	char* generated_source)
+	char* generated_source,
+	bool vMinify,
+	std::map<std::string, std::string>* vMinifiedNames,
+	loop_state* vLoopState)
 {
 	sbuffer res(generated_source);
 
@@ -178,11 +189,21 @@ std::string IR_TO_GLSL::Convert(
 	}
 
 	global_print_tracker global;
+	if (vMinify)
+	{
+		global.minify = true;
+		minify_names(instructions, state, &global, vMinifiedNames);
+	}
+
 	int uses_texlod_impl = 0;
 	int uses_texlodproj_impl = 0;
-	loop_state* ls = analyze_loop_variables(instructions);
+	loop_state* ls = vLoopState ? vLoopState : analyze_loop_variables(instructions);
 	if (ls)
 	{
+		// one visitor for all the top level instructions, they are printed each with a clean line state
+		IR_TO_GLSL v(res, &global, state);
+		v.loopstate = ls;
+
 		foreach_in_list(ir_instruction, ir, instructions)
 		{
 			if (ir->ir_type == ir_type_variable)
@@ -193,27 +214,306 @@ std::string IR_TO_GLSL::Convert(
 					continue;
 			}
 
-			ir_instruction *deconsted = const_cast<ir_instruction *>(ir);
-
-			IR_TO_GLSL v(res, &global, state);
-			v.loopstate = ls;
+			v.skipped_this_ir = false;
+			v.previous_skipped = false;
 
 			ir->accept(&v);
 			if (ir->ir_type != ir_type_function && !v.skipped_this_ir)
 				res.append(";\n"); // uniforms
-
-			uses_texlod_impl |= v.uses_texlod_impl;
-			uses_texlodproj_impl |= v.uses_texlodproj_impl;
 		}
 
-		delete ls;
+		uses_texlod_impl = v.uses_texlod_impl;
+		uses_texlodproj_impl = v.uses_texlodproj_impl;
+
+		if (ls != vLoopState)
+			delete ls;
 	}
 	
 	print_texlod_workarounds(uses_texlod_impl, uses_texlodproj_impl, res);
 
+	if (vMinify)
+		return minify_whitespaces(res.c_str());
+
 	return std::string(res.c_str());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//// MINIFY ///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// keywords, reserved words, types and builtin functions of any glsl version
+// the short names must never collide with them
+static const char* minify_reserved_words[] = {
+	"attribute", "const", "uniform", "varying", "buffer", "shared", "coherent", "volatile", "restrict",
+	"readonly", "writeonly", "atomic_uint", "layout", "centroid", "flat", "smooth", "noperspective",
+	"patch", "sample", "break", "continue", "do", "for", "while", "switch", "case", "default", "if",
+	"else", "subroutine", "in", "out", "inout", "float", "double", "int", "void", "bool", "true", "false",
+	"invariant", "precise", "discard", "return", "lowp", "mediump", "highp", "precision", "struct",
+	"uint", "common", "partition", "active", "asm", "class", "union", "enum", "typedef", "template",
+	"this", "resource", "goto", "inline", "noinline", "public", "static", "extern", "external",
+	"interface", "long", "short", "half", "fixed", "unsigned", "superp", "input", "output", "filter",
+	"sizeof", "cast", "namespace", "using", "demote", "not", "and", "or", "xor",
+	"vec2", "vec3", "vec4", "ivec2", "ivec3", "ivec4", "bvec2", "bvec3", "bvec4", "uvec2", "uvec3", "uvec4",
+	"dvec2", "dvec3", "dvec4", "hvec2", "hvec3", "hvec4", "fvec2", "fvec3", "fvec4",
+	"mat2", "mat3", "mat4", "dmat2", "dmat3", "dmat4",
+	"radians", "degrees", "sin", "cos", "tan", "asin", "acos", "atan", "sinh", "cosh", "tanh", "asinh",
+	"acosh", "atanh", "pow", "exp", "log", "exp2", "log2", "sqrt", "inversesqrt", "abs", "sign", "floor",
+	"trunc", "round", "roundEven", "ceil", "fract", "mod", "modf", "min", "max", "clamp", "mix", "step",
+	"smoothstep", "isnan", "isinf", "fma", "frexp", "ldexp", "length", "distance", "dot", "cross",
+	"normalize", "ftransform", "faceforward", "reflect", "refract", "matrixCompMult", "outerProduct",
+	"transpose", "determinant", "inverse", "lessThan", "lessThanEqual", "greaterThan",
+	"greaterThanEqual", "equal", "notEqual", "any", "all", "uaddCarry", "usubBorrow", "umulExtended",
+	"imulExtended", "bitfieldExtract", "bitfieldInsert", "bitfieldReverse", "bitCount", "findLSB",
+	"findMSB", "texture", "textureSize", "textureLod", "textureProj", "textureGrad", "textureOffset",
+	"texelFetch", "textureGather", "dFdx", "dFdy", "fwidth", "noise1", "noise2", "noise3", "noise4",
+	"barrier", "main",
+};
+
+static bool is_minifiable(ir_variable* var)
+{
+	if (var->name && is_gl_identifier(var->name))
+		return false;
+
+	switch (var->data.mode)
+	{
+	case ir_var_auto:
+	case ir_var_temporary:
+	case ir_var_function_in:
+	case ir_var_function_out:
+	case ir_var_function_inout:
+	case ir_var_const_in:
+		return true;
+	default: // uniforms, in, out, buffers, shared, system values are the shader interface
+		return false;
+	}
+}
+
+// collect the renamable variables and functions with their use count,
+// so the most used get the shortest names
+class minify_names_visitor : public ir_hierarchical_visitor
+{
+public:
+	struct candidate
+	{
+		void* ir = 0;
+		const char* name = 0;
+		unsigned uses = 0;
+	};
+
+	std::vector<candidate> candidates; // in order of first appearance
+	hash_table* index; // ir => candidates index + 1
+	std::set<std::string> kept; // names not renamed, the short names must not collide with them
+
+	minify_names_visitor()
+	{
+		index = _mesa_pointer_hash_table_create(NULL);
+	}
+
+	~minify_names_visitor()
+	{
+		_mesa_hash_table_destroy(index, NULL);
+	}
+
+	void add(void* ir, const char* name, bool renamable, unsigned uses)
+	{
+		if (!renamable)
+		{
+			if (name)
+				kept.insert(name);
+			return;
+		}
+
+		hash_entry* entry = _mesa_hash_table_search(index, ir);
+		if (entry)
+		{
+			candidates[(size_t)entry->data - 1].uses += uses;
+			return;
+		}
+
+		candidate c;
+		c.ir = ir;
+		c.name = name;
+		c.uses = uses;
+		candidates.push_back(c);
+		_mesa_hash_table_insert(index, ir, (void*)candidates.size());
+	}
+
+	static bool is_user_function(ir_function* f)
+	{
+		if (strcmp(f->name, "main") == 0)
+			return false;
+		foreach_in_list(ir_function_signature, sig, &f->signatures)
+		{
+			if (!sig->is_builtin())
+				return true;
+		}
+		return false;
+	}
+
+	virtual ir_visitor_status visit(ir_variable* ir)
+	{
+		add(ir, ir->name, is_minifiable(ir), 1);
+		if (ir->get_interface_type())
+			kept.insert(ir->get_interface_type()->name);
+		return visit_continue;
+	}
+
+	virtual ir_visitor_status visit(ir_dereference_variable* ir)
+	{
+		add(ir->var, ir->var->name, is_minifiable(ir->var), 1);
+		return visit_continue;
+	}
+
+	virtual ir_visitor_status visit_enter(ir_function* ir)
+	{
+		add(ir, ir->name, is_user_function(ir), 1);
+		return visit_continue;
+	}
+
+	virtual ir_visitor_status visit_enter(ir_call* ir)
+	{
+		ir_function* f = const_cast<ir_function*>(ir->callee->function());
+		add(f, f->name, is_user_function(f), 1);
+		return visit_continue;
+	}
+};
+
+// a, b, .., Z, aa, ba, .., Z9, aaa, ...
+static std::string minify_short_name(size_t vIndex)
+{
+	static const char first_chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static const char next_chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+	const size_t first_count = sizeof(first_chars) - 1;
+	const size_t next_count = sizeof(next_chars) - 1;
+
+	std::string res(1, first_chars[vIndex % first_count]);
+	vIndex /= first_count;
+	while (vIndex > 0)
+	{
+		--vIndex;
+		res += next_chars[vIndex % next_count];
+		vIndex /= next_count;
+	}
+	return res;
+}
+
+void IR_TO_GLSL::minify_names(
+	exec_list *instructions,
+	struct _mesa_glsl_parse_state *state,
+	global_print_tracker* vGlobals,
+	std::map<std::string, std::string>* vMinifiedNames)
+{
+	minify_names_visitor v;
+	v.run(instructions);
+
+	std::set<std::string> reserved(v.kept);
+	for (size_t i = 0; i < ARRAY_SIZE(minify_reserved_words); ++i)
+		reserved.insert(minify_reserved_words[i]);
+	if (state)
+	{
+		for (unsigned i = 0; i < state->num_user_structures; i++)
+			reserved.insert(state->user_structures[i]->name);
+	}
+
+	std::stable_sort(v.candidates.begin(), v.candidates.end(),
+		[](const minify_names_visitor::candidate& a, const minify_names_visitor::candidate& b)
+		{
+			return a.uses > b.uses;
+		});
+
+	size_t nameIndex = 0;
+	for (auto &c : v.candidates)
+	{
+		std::string name;
+		do
+		{
+			name = minify_short_name(nameIndex++);
+		} while (reserved.find(name) != reserved.end());
+
+		_mesa_hash_table_insert(vGlobals->minified_names, c.ir,
+			ralloc_strdup(vGlobals->mem_ctx, name.c_str()));
+		if (vMinifiedNames)
+			(*vMinifiedNames)[name] = c.name ? c.name : "";
+	}
+}
+
+static bool is_identifier_char(char c)
+{
+	// the '.' is here for not glue a keyword with a float like "return .5"
+	return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+// true if the two chars would be read as one token (++, -=, &&, //, ...)
+static bool is_glued_operator(char prev, char c)
+{
+	if (!strchr("+-*/%<>=!&|^", prev))
+		return false;
+	if (c == '=')
+		return true;
+	if (prev == c && strchr("+-<>=&|^", c))
+		return true;
+	return prev == '/' && (c == '/' || c == '*');
+}
+
+// remove the comments and the useless spaces and line breaks
+// the preprocessor lines are kept on their own line
+std::string IR_TO_GLSL::minify_whitespaces(const char* vSource)
+{
+	std::string res;
+	res.reserve(strlen(vSource));
+
+	bool line_start = true;
+	bool pending_space = false;
+	const char* p = vSource;
+	while (*p)
+	{
+		const char c = *p;
+		if (c == '\n' || c == '\r' || c == ' ' || c == '\t')
+		{
+			if (c == '\n')
+				line_start = true;
+			pending_space = true;
+			++p;
+		}
+		else if (c == '/' && p[1] == '/')
+		{
+			while (*p && *p != '\n')
+				++p;
+		}
+		else if (c == '/' && p[1] == '*')
+		{
+			const char* end = strstr(p + 2, "*/");
+			p = end ? end + 2 : p + strlen(p);
+			pending_space = true;
+		}
+		else if (c == '#' && line_start)
+		{
+			if (!res.empty() && res.back() != '\n')
+				res += '\n';
+			while (*p && *p != '\n')
+				res += *p++;
+			res += '\n';
+			pending_space = false;
+		}
+		else
+		{
+			if (pending_space && !res.empty())
+			{
+				const char prev = res.back();
+				if ((is_identifier_char(prev) && is_identifier_char(c)) ||
+					is_glued_operator(prev, c))
+					res += ' ';
+			}
+			res += c;
+			pending_space = false;
+			line_start = false;
+			++p;
+		}
+	}
+
+	return res;
+}
+
 IR_TO_GLSL::IR_TO_GLSL(
 	sbuffer& str,
 	global_print_tracker* vGlobals,
@@ -276,6 +576,16 @@ IR_TO_GLSL::newline_deindent()
 void 
 IR_TO_GLSL::print_var_name(ir_variable* v)
 {
+	if (global->minify)
+	{
+		hash_entry *minified = _mesa_hash_table_search(global->minified_names, v);
+		if (minified)
+		{
+			generated_source.append("%s", (const char*)minified->data);
+			return;
+		}
+	}
+
 	hash_entry *entry = _mesa_hash_table_search(global->var_hash, v);
 	if (entry)
 	{
@@ -303,6 +613,18 @@ IR_TO_GLSL::print_var_name(ir_variable* v)
 	}
 }
 
+const char *
+IR_TO_GLSL::function_name(const ir_function* f)
+{
+	if (global->minify)
+	{
+		hash_entry *minified = _mesa_hash_table_search(global->minified_names, f);
+		if (minified)
+			return (const char*)minified->data;
+	}
+	return f->name;
+}
+
 const char *
 IR_TO_GLSL::unique_name(ir_variable *v)
 {
@@ -465,7 +787,8 @@ IR_TO_GLSL::visit(ir_variable *ir)
 		samp, patc, inv, explicit_inv, prec, precision[ir->data.precision],
 		mode[decormode][ir->data.mode], stream, interp[ir->data.interpolation]);
 
-	print_type(generated_source, ir->type, true);
+	// the size of the outer array goes after the name
+	print_type(generated_source, ir->type, false);
 	generated_source.append(" ");
 	print_var_name(ir);
 	print_type_post(generated_source, ir->type, false);
@@ -489,7 +812,7 @@ IR_TO_GLSL::visit(ir_function_signature *ir)
    _mesa_symbol_table_push_scope(symbols);
 
    print_type(generated_source, ir->return_type, true);
-   generated_source.append(" %s(", ir->function_name());
+   generated_source.append(" %s(", function_name(ir->function()));
    
    if (!ir->parameters.is_empty())
    {
@@ -973,10 +1296,9 @@ const char *const operator_glsl_enum_strs[] = {
 };
 */
 
+// in the order of ir_binop_less .. ir_binop_nequal
 static const char *const operator_vec_glsl_strs[] = {
 	"lessThan",
-	"greaterThan",
-	"lessThanEqual",
 	"greaterThanEqual",
 	"equal",
 	"notEqual",
@@ -984,9 +1306,7 @@ static const char *const operator_vec_glsl_strs[] = {
 
 static bool is_binop_func_like(ir_expression_operation op, const glsl_type* type)
 {
-	if (op == ir_binop_equal ||
-		op == ir_binop_nequal ||
-		op == ir_binop_mod ||
+	if (op == ir_binop_mod ||
 		(op >= ir_binop_dot && op <= ir_binop_pow))
 		return true;
 	if (type->is_vector() && (op >= ir_binop_less && op <= ir_binop_nequal))
@@ -1243,6 +1563,8 @@ IR_TO_GLSL::visit(ir_texture *ir)
 		generated_source.append(", ");
 		ir->lod_info.bias->accept(this);
 	}
+
+	generated_source.append(")");
 }
 
 void 
@@ -1549,23 +1871,51 @@ IR_TO_GLSL::visit(ir_assignment *ir)
 
 #define fpcheck(x) (isnan(x) || isinf(x))
 
+// "0.5" => ".5", "1e+07" => "1e7", "2.5e-05" => "2.5e-5"
+static void
+shorten_float(char* tmp)
+{
+	std::string s = tmp;
+
+	size_t posE = s.find_first_of("eE");
+	if (posE != std::string::npos)
+	{
+		std::string mantissa = s.substr(0, posE);
+		std::string exponent = s.substr(posE + 1);
+		bool negative = false;
+		if (!exponent.empty() && (exponent[0] == '+' || exponent[0] == '-'))
+		{
+			negative = (exponent[0] == '-');
+			exponent = exponent.substr(1);
+		}
+		size_t firstDigit = exponent.find_first_not_of('0');
+		exponent = (firstDigit == std::string::npos) ? "0" : exponent.substr(firstDigit);
+		s = mantissa + "e" + (negative ? "-" : "") + exponent;
+	}
+
+	if (s.compare(0, 2, "0.") == 0)
+		s = s.substr(1);
+	else if (s.compare(0, 3, "-0.") == 0)
+		s = "-" + s.substr(2);
+
+	strcpy(tmp, s.c_str());
+}
+
 void 
-print_float(sbuffer& str, float f)
+print_float(sbuffer& str, float f, bool shortest = false)
 {
-	// Kind of roundabout way, but this is to satisfy two things:
-	// * MSVC and gcc-based compilers differ a bit in how they treat float
-	//   widht/precision specifiers. Want to match for tests.
-	// * GLSL (early version at least) require floats to have ".0" or
-	//   exponential notation.
+	// GLSL (early version at least) require floats to have ".0" or
+	// exponential notation.
+	// the digits are always the shortest that read back to the same float,
+	// the notation is the one of %.7g, or of the shortest %g if shortest
 	char tmp[64];
-	snprintf(tmp, 64, "%.7g", f);
+	util_dtoa_float(f, shortest ? 0 : 7, tmp);
 
 	char* posE = NULL;
 	posE = strchr(tmp, 'e');
 	if (!posE)
 		posE = strchr(tmp, 'E');
 
-	// snprintf formats infinity as inf.0 or -inf.0, which isn't useful here.
 	// GLSL has no infinity constant so print an equivalent expression instead.
 	if (f == HUGE_VALF)
 		strcpy(tmp, "(1.0/0.0)");
@@ -1577,29 +1927,40 @@ print_float(sbuffer& str, float f)
 	if (f != f)
 		strcpy(tmp, "(0.0/0.0)");
 
-#if _MSC_VER
-	// While gcc would print something like 1.0e+07, MSVC will print 1.0e+007 -
-	// only for exponential notation, it seems, will add one extra useless zero. Let's try to remove
-	// that so compiler output matches.
-	if (posE != NULL)
+	if (shortest && !fpcheck(f))
 	{
-		if ((posE[1] == '+' || posE[1] == '-') && posE[2] == '0')
-		{
-			char* p = posE + 2;
-			while (p[0])
-			{
-				p[0] = p[1];
-				++p;
-			}
-		}
+		shorten_float(tmp);
+		posE = strchr(tmp, 'e');
 	}
-#endif
 
 	str.append("%s", tmp);
 
 	// need to append ".0"?
 	if (!strchr(tmp, '.') && (posE == NULL))
-		str.append(".0");
+		str.append(shortest ? "." : ".0");
+}
+
+void 
+print_double(sbuffer& str, double d, bool shortest = false)
+{
+	if (fpcheck(d))
+	{
+		if (d != d)
+			str.append("(0.0lf/0.0lf)");
+		else
+			str.append(d > 0.0 ? "(1.0lf/0.0lf)" : "(-1.0lf/0.0lf)");
+		return;
+	}
+
+	char tmp[64];
+	util_dtoa_double(d, shortest ? 0 : 7, tmp);
+	if (shortest)
+		shorten_float(tmp);
+
+	str.append("%s", tmp);
+	if (!strchr(tmp, '.') && !strchr(tmp, 'e'))
+		str.append(shortest ? "." : ".0");
+	str.append("lf");
 }
 
 void 
@@ -1620,7 +1981,7 @@ IR_TO_GLSL::visit(ir_constant *ir)
 				return;
 			}
 		}
-		print_float(generated_source, ir->value.f[0]);
+		print_float(generated_source, ir->value.f[0], global->minify);
 		return;
 	}
 	else if (type == glsl_type::int_type)
@@ -1702,7 +2063,8 @@ IR_TO_GLSL::visit(ir_constant *ir)
 					generated_source.append("%d", ir->value.i[i]);
 				break;
 			}
-			case GLSL_TYPE_FLOAT: print_float(generated_source, ir->value.f[i]); break;
+			case GLSL_TYPE_FLOAT: print_float(generated_source, ir->value.f[i], global->minify); break;
+			case GLSL_TYPE_DOUBLE: print_double(generated_source, ir->value.d[i], global->minify); break;
 			case GLSL_TYPE_BOOL:  generated_source.append("%d", ir->value.b[i]); break;
 			default: assert(0);
 			}
@@ -1729,7 +2091,7 @@ IR_TO_GLSL::visit(ir_call *ir)
 		generated_source.append(" = ");
 	}
 
-	generated_source.append("%s (", ir->callee_name());
+	generated_source.append("%s (", function_name(ir->callee->function()));
 	bool first = true;
 	foreach_in_list(ir_instruction, inst, &ir->actual_parameters)
 	{
@@ -29,6 +29,7 @@
 #include "ir_visitor.h"
 #include "program/symbol_table.h"
 #include <string>
+#include <map>
 #include "st_printf.h"
 
 class loop_state;
@@ -46,13 +47,24 @@ public:
 		exec_list	global_assignements;
 		void* mem_ctx;
 		bool	main_function_done;
+		bool	minify;
+		hash_table*	minified_names; // ir_variable* or ir_function* => short name
 	};
 
 public:
 	static std::string Convert(
 		exec_list *instructions,
 		struct _mesa_glsl_parse_state *state,
-		char* buffer);
+		char* buffer,
+		bool vMinify = false,
+		std::map<std::string, std::string>* vMinifiedNames = 0, // short name => original name
+		loop_state* vLoopState = 0); // analysis of the loops of instructions if already done, not deleted
+	static void minify_names(
+		exec_list *instructions,
+		struct _mesa_glsl_parse_state *state,
+		global_print_tracker* vGlobals,
+		std::map<std::string, std::string>* vMinifiedNames);
+	static std::string minify_whitespaces(const char* vSource);
 	static void print_type(sbuffer& str, const glsl_type *t, bool arraySize);
 	static void print_type_post(sbuffer& str, const glsl_type *t, bool arraySize);
 
@@ -68,6 +80,7 @@ public:
    void newline_indent();
    void newline_deindent();
    void print_var_name(ir_variable* v);
+   const char *function_name(const ir_function* f);
    const char *unique_name(ir_variable *var);
    void emit_assignment_part(ir_dereference* lhs, ir_rvalue* rhs, unsigned write_mask, ir_rvalue* dstIndex);
    bool can_emit_canonical_for(loop_variable_state *ls);
@@ -5,6 +5,7 @@
 #include "main/macros.h"
 #include "util/hash_table.h"
 #include "util/u_string.h"
+#include "util/dtoa.h"
 
 void IR_TO_IR::print_type(sbuffer& str, const glsl_type *t)
 {
@@ -437,6 +438,7 @@ void IR_TO_IR::visit(ir_constant *ir)
 	 generated_source.append(")");
       }
    } else {
+      char num[UTIL_DTOA_BUFFER_SIZE];
       for (unsigned i = 0; i < ir->type->components(); i++) {
 	 if (i != 0)
 	    generated_source.append(" ");
@@ -444,15 +446,9 @@ void IR_TO_IR::visit(ir_constant *ir)
 	 case GLSL_TYPE_UINT:  generated_source.append("%u", ir->value.u[i]); break;
 	 case GLSL_TYPE_INT:   generated_source.append("%d", ir->value.i[i]); break;
 	 case GLSL_TYPE_FLOAT:
-            if (ir->value.f[i] == 0.0f)
-               /* 0.0 == -0.0, so print with %f to get the proper sign. */
-               generated_source.append("%f", ir->value.f[i]);
-            else if (fabs(ir->value.f[i]) < 0.000001f)
-               generated_source.append("%a", ir->value.f[i]);
-            else if (fabs(ir->value.f[i]) > 1000000.0f)
-               generated_source.append("%e", ir->value.f[i]);
-            else
-               generated_source.append("%f", ir->value.f[i]);
+            /* shortest text that read back to the same bits, -0 keep his sign */
+            util_dtoa_float(ir->value.f[i], 7, num);
+            generated_source.append("%s", num);
             break;
 	 case GLSL_TYPE_SAMPLER:
 	 case GLSL_TYPE_IMAGE:
@@ -462,15 +458,8 @@ void IR_TO_IR::visit(ir_constant *ir)
 	 case GLSL_TYPE_INT64: generated_source.append("%" PRIi64, ir->value.i64[i]); break;
 	 case GLSL_TYPE_BOOL:  generated_source.append("%d", ir->value.b[i]); break;
 	 case GLSL_TYPE_DOUBLE:
-            if (ir->value.d[i] == 0.0)
-               /* 0.0 == -0.0, so print with %f to get the proper sign. */
-               generated_source.append("%.1f", ir->value.d[i]);
-            else if (fabs(ir->value.d[i]) < 0.000001)
-               generated_source.append("%a", ir->value.d[i]);
-            else if (fabs(ir->value.d[i]) > 1000000.0)
-               generated_source.append("%e", ir->value.d[i]);
-            else
-               generated_source.append("%f", ir->value.d[i]);
+            util_dtoa_double(ir->value.d[i], 7, num);
+            generated_source.append("%s", num);
             break;
 	 default:
             unreachable("Invalid constant type");
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the rules of algebraic who change the float results are only done when asked
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <string>
+
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform float c;\n"
+	"uniform vec4 a;\n"
+	"uniform vec4 b;\n"
+	"out vec4 o;\n"
+	"out vec4 p;\n"
+	"void main()\n"
+	"{\n"
+	"	o = vec4(sin(c) * cos(c) * 2.0);\n"
+	"	p = a * (1.0 - c) + b * c;\n"
+	"}\n";
+
+static std::string Optimize(bool vInexactRules)
+{
+	GlslConvert::OptimizationStruct optimization;
+	if (vInexactRules)
+	{
+		optimization.algebraicOptions.rules_trig = true;
+		optimization.algebraicOptions.rules_mad = true;
+	}
+	return GlslConvert::Instance()->Optimize(s_Shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+}
+
+int main()
+{
+	bool ok = true;
+
+	const std::string def = Optimize(false);
+	printf("%s\n", def.c_str());
+	if (def.find("cos") == std::string::npos || def.find("mix") != std::string::npos)
+	{
+		printf("FAIL : the default options rewrote sin * cos or the lerp\n");
+		ok = false;
+	}
+
+	const std::string asked = Optimize(true);
+	printf("%s\n", asked.c_str());
+	if (asked.find("cos") != std::string::npos || asked.find("mix") == std::string::npos)
+	{
+		printf("FAIL : rules_trig and rules_mad did not rewrite sin * cos and the lerp\n");
+		ok = false;
+	}
+
+	return ok ? 0 : 1;
+}
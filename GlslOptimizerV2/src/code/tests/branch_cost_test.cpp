@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// lower_if_to_cond_assign with the default options : the ifs who only move values are flattened, the others are kept
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+static std::string Optimize(const char* vBody)
+{
+	const std::string shader = std::string(
+		"#version 330\n"
+		"uniform float c;\n"
+		"uniform vec4 a;\n"
+		"out vec4 r;\n"
+		"void main()\n"
+		"{\n"
+		"	r = vec4(0.0);\n") + vBody + "}\n";
+
+	GlslConvert::OptimizationStruct optimization;
+	return GlslConvert::Instance()->Optimize(shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+}
+
+// a kept if is printed with its block, a conditional assignment on one line
+static bool HasBranch(const std::string& vCode)
+{
+	std::istringstream lines(vCode);
+	std::string line;
+	bool afterIf = false;
+	while (std::getline(lines, line))
+	{
+		const size_t start = line.find_first_not_of(" \t");
+		const std::string text = start == std::string::npos ? "" : line.substr(start);
+		if (afterIf && text == "{")
+			return true;
+		afterIf = text.compare(0, 4, "if (") == 0 && text.back() == ')';
+	}
+	return false;
+}
+
+static bool Check(const char* vBody, bool vFlattened)
+{
+	const std::string res = Optimize(vBody);
+	printf("%s\n", res.c_str());
+
+	if (res.find("main") == std::string::npos)
+	{
+		printf("FAIL : the shader was not optimized\n");
+		return false;
+	}
+	if (HasBranch(res) == vFlattened)
+	{
+		printf("FAIL : the if of \"%s\" is %s\n", vBody, vFlattened ? "kept" : "flattened");
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	bool ok = true;
+	ok &= Check("	if (0.5 < c) r = a;\n", true); // a move only
+	ok &= Check("	if (0.5 < c) r = a * c;\n", false);
+	return ok ? 0 : 1;
+}
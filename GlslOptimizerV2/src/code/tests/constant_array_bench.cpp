@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// a shader with a const float[65536], without the optimization passes (pipeline "validate") :
+// the parsing of his literals and the printing of his constants dominate.
+// checks that the printed constants read back to the same floats, minified or not
+
+#include "code/GlslConvert.h"
+#include "util/dtoa.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define COUNT_VALUES 65536
+#define COUNT_RUNS 3
+
+static uint32_t NextRandom(uint32_t *vState)
+{
+	uint32_t x = *vState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *vState = x;
+}
+
+// the constants of the first array constructor of the code
+static bool ReadArray(const std::string& vCode, std::vector<float> *vValues)
+{
+	size_t pos = vCode.find("float[");
+	if (pos == std::string::npos) return false;
+	pos = vCode.find('(', pos);
+	if (pos == std::string::npos) return false;
+
+	const char* p = vCode.c_str() + pos + 1;
+	while (*p && *p != ')')
+	{
+		char* end = nullptr;
+		vValues->push_back(strtof(p, &end));
+		if (end == p) return false;
+		p = end;
+		while (*p == ',' || *p == ' ' || *p == '\n') ++p;
+	}
+	return true;
+}
+
+static bool Bench(const char* vName, const std::string& vSource, const std::vector<float>& vValues, bool vMinify)
+{
+	GlslConvert::OptimizationStruct optimization;
+	optimization.pipelineOptions.pipeline = "validate";
+	optimization.printOptions.minify = vMinify;
+
+	std::string code;
+	double best = 1e30;
+	for (int run = 0; run < COUNT_RUNS; ++run)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		code = GlslConvert::Instance()->Optimize(vSource,
+			GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+			GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (ms < best) best = ms;
+	}
+	printf("%-10s %8.2f ms, %zu bytes\n", vName, best, code.size());
+
+	std::vector<float> printed;
+	if (!GlslConvert::Instance()->IsLastOptimizeSucceeded() || !ReadArray(code, &printed) || printed.size() != vValues.size())
+	{
+		printf("FAIL : %s, the array is not in the output\n", vName);
+		return false;
+	}
+	for (size_t i = 0; i < vValues.size(); ++i)
+	{
+		if (memcmp(&printed[i], &vValues[i], sizeof(float)) != 0)
+		{
+			printf("FAIL : %s, %.9g printed as %.9g\n", vName, vValues[i], printed[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	// exponents from 2^-31 to 2^32, written with 17 digits like a generated table
+	std::vector<float> values(COUNT_VALUES);
+	std::string source = "#version 330\nuniform int idx;\nout vec4 c;\nconst float lut[65536] = float[](";
+	uint32_t state = 0x2545F491;
+	char literal[32];
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		const uint32_t bits = (NextRandom(&state) & 0x3FFFFFFF) | 0x30000000;
+		memcpy(&values[i], &bits, sizeof(bits));
+		snprintf(literal, sizeof(literal), i ? ",%.17g" : "%.17g", (double)values[i]);
+		source += literal;
+	}
+	source += ");\nvoid main() { c = vec4(lut[idx]); }\n";
+
+	printf("%d constants, best of %d runs\n", COUNT_VALUES, COUNT_RUNS);
+	bool ok = Bench("default", source, values, false);
+	ok = Bench("minified", source, values, true) && ok;
+
+	return ok ? 0 : 1;
+}
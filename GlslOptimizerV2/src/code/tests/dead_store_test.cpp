@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// dead_store : the stores of the locals initialized with a constant expression are removed like the others
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <string>
+
+// v.z is never read after the store
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform float c;\n"
+	"out vec4 o;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 v = vec4(1.0);\n"
+	"	v.x = c;\n"
+	"	v.z = 5.0 * c;\n"
+	"	o = vec4(v.xyw, c);\n"
+	"}\n";
+
+int main()
+{
+	GlslConvert::OptimizationStruct optimization;
+	optimization.pipelineOptions.pipeline = "dead_store";
+	const std::string res = GlslConvert::Instance()->Optimize(s_Shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+
+	printf("%s\n", res.c_str());
+
+	if (res.find("main") == std::string::npos)
+	{
+		printf("FAIL : the shader was not optimized\n");
+		return 1;
+	}
+	if (res.find("5.0") != std::string::npos)
+	{
+		printf("FAIL : the dead store of v.z is kept\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// fast_math never reassociates the trees of an invariant output, also when the functions are optimized alone
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <string>
+
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform vec4 a;\n"
+	"uniform vec4 b;\n"
+	"uniform vec4 c;\n"
+	"%s"
+	"vec4 f()\n"
+	"{\n"
+	"	return a * b + a * c;\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 t = a * b + a * c;\n"
+	"	gl_Position = t + f();\n"
+	"}\n";
+
+static bool Check(bool vPerFunction, bool vInvariant)
+{
+	char shader[1024];
+	snprintf(shader, sizeof(shader), s_Shader, vInvariant ? "invariant gl_Position;\n" : "");
+
+	GlslConvert::OptimizationStruct optimization;
+	optimization.algebraicOptions.fast_math = true;
+	optimization.perFunctionOptions.enabled = vPerFunction;
+	const std::string res = GlslConvert::Instance()->Optimize(shader,
+		GlslConvert::MESA_SHADER_VERTEX, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+	printf("perFunction %s, %s\n%s\n", vPerFunction ? "on" : "off", vInvariant ? "invariant" : "variant", res.c_str());
+
+	if (res.find("main") == std::string::npos)
+	{
+		printf("FAIL : the shader was not optimized\n");
+		return false;
+	}
+	const bool factored = res.find("(b + c)") != std::string::npos || res.find("(c + b)") != std::string::npos;
+	if (factored && vInvariant)
+	{
+		printf("FAIL : a * b + a * c was factored for an invariant output\n");
+		return false;
+	}
+	if (!factored && !vInvariant)
+	{
+		printf("FAIL : a * b + a * c was not factored by fast_math\n");
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	bool ok = true;
+	ok &= Check(false, true);
+	ok &= Check(true, true);
+	ok &= Check(false, false);
+	ok &= Check(true, false);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the server session : with RetainSharedState, the requests dont rebuild the builtin functions
+
+#include "code/GlslConvert.h"
+#include "util/ralloc.h"
+
+#include <chrono>
+#include <cstdio>
+
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform vec4 c;\n"
+	"out vec4 o;\n"
+	"void main()\n"
+	"{\n"
+	"	o = sin(c) * clamp(c.x, 0.0, 1.0);\n"
+	"}\n";
+
+struct Request
+{
+	size_t allocCount = 0;
+	double ms = 0.0;
+};
+
+static Request Optimize()
+{
+	Request res;
+
+	struct ralloc_stats stats;
+	ralloc_stats_get(&stats);
+	const size_t start = stats.alloc_count;
+	const auto startTime = std::chrono::steady_clock::now();
+
+	GlslConvert::OptimizationStruct optimization;
+	GlslConvert::Instance()->Optimize(s_Shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+
+	res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	ralloc_stats_get(&stats);
+	res.allocCount = stats.alloc_count - start;
+	return res;
+}
+
+int main()
+{
+	ralloc_stats_enable(true);
+	if (!ralloc_stats_enabled())
+	{
+		printf("SKIP : built without USE_RALLOC_STATS\n");
+		return 77;
+	}
+
+	const Request cold = Optimize(); // builtins built and freed by the request
+
+	struct ralloc_stats stats;
+	ralloc_stats_get(&stats);
+	const size_t beforeRetain = stats.alloc_count;
+	GlslConvert::RetainSharedState();
+	ralloc_stats_get(&stats);
+	const size_t builtinsAllocCount = stats.alloc_count - beforeRetain;
+
+	const Request first = Optimize();
+	const Request second = Optimize();
+
+	GlslConvert::ReleaseSharedState();
+
+	const Request coldAgain = Optimize();
+
+	printf("builtins : %zu allocs\n", builtinsAllocCount);
+	printf("cold request : %zu allocs, %.2f ms\n", cold.allocCount, cold.ms);
+	printf("session, first request : %zu allocs, %.2f ms\n", first.allocCount, first.ms);
+	printf("session, second request : %zu allocs, %.2f ms\n", second.allocCount, second.ms);
+	printf("cold request after release : %zu allocs, %.2f ms\n", coldAgain.allocCount, coldAgain.ms);
+
+	// a request who build the builtins make at least their allocations
+	bool ok = true;
+	if (builtinsAllocCount == 0 || cold.allocCount < builtinsAllocCount)
+	{
+		printf("FAIL : the cold request did not build the builtins\n");
+		ok = false;
+	}
+	if (first.allocCount >= builtinsAllocCount || second.allocCount >= builtinsAllocCount)
+	{
+		printf("FAIL : a request of the session rebuilt the builtins\n");
+		ok = false;
+	}
+	if (coldAgain.allocCount < builtinsAllocCount)
+	{
+		printf("FAIL : ReleaseSharedState did not free the builtins\n");
+		ok = false;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the cost of the loop bodies for the unroll : the assignments and the expressions against MaxUnrollIterations * 5 by default,
+// the texture lookups, the calls and the matrix columns too against a MaxUnrollInstructions budget
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <string>
+
+// the default pipeline without lower_jumps, who would hide the trip count behind a flag
+static const char* s_Pipeline =
+	"(lower_instructions,function_inlining,dead_functions,structure_splitting,propagate_invariance,"
+	"if_simplification,flatten_nested_if_blocks,conditional_discard,copy_propagation_elements,"
+	"dead_code,dead_code_local,tree_grafting,constant_propagation,constant_variable,constant_folding,"
+	"algebraic,unroll_loops)";
+
+// 4 iterations, the texture lookup is only counted with a budget
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform sampler2D t;\n"
+	"uniform mat4 m;\n"
+	"uniform vec2 uv;\n"
+	"out vec4 o;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 s = vec4(0.0);\n"
+	"	for (int i = 0; i < 4; i++)\n"
+	"		s += m * texture(t, uv * float(i));\n"
+	"	o = s;\n"
+	"}\n";
+
+static bool Optimize(int vMaxUnrollInstructions, GlslConvert::UnrollStats *vDecision)
+{
+	GlslConvert::OptimizationStruct optimization;
+	optimization.pipelineOptions.pipeline = s_Pipeline;
+	optimization.instructionToLower.MaxUnrollInstructions = vMaxUnrollInstructions;
+	GlslConvert::Instance()->Optimize(s_Shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+
+	// the first decision, the loop is gone once unrolled
+	const auto &decisions = GlslConvert::Instance()->GetStats().unrollDecisions;
+	if (decisions.empty())
+	{
+		printf("FAIL : no unroll decision with MaxUnrollInstructions %i\n", vMaxUnrollInstructions);
+		return false;
+	}
+	*vDecision = decisions.front();
+	printf("MaxUnrollInstructions %i : %i iterations, body cost %i, %s\n", vMaxUnrollInstructions,
+		vDecision->iterations, vDecision->bodyCost, vDecision->decision.c_str());
+	return true;
+}
+
+int main()
+{
+	GlslConvert::UnrollStats byNodes, fit, over;
+	if (!Optimize(0, &byNodes))
+		return 1;
+	if (byNodes.iterations != 4 || byNodes.decision != "full")
+	{
+		printf("FAIL : the loop is not fully unrolled with the default budget\n");
+		return 1;
+	}
+
+	// a budget of exactly the weighted cost of the copies, then just under it
+	const int weightedCost = byNodes.bodyCost + 1;
+	if (!Optimize(weightedCost * 4, &fit) || !Optimize(weightedCost * 4 - 1, &over))
+		return 1;
+
+	bool ok = true;
+	if (fit.bodyCost != weightedCost || over.bodyCost != weightedCost)
+	{
+		printf("FAIL : the texture lookup is counted by default or not with a budget\n");
+		ok = false;
+	}
+	if (fit.decision != "full" || over.decision != "kept, over budget")
+	{
+		printf("FAIL : the budget of MaxUnrollInstructions is not respected\n");
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// unroll_loops between the passes who share the def-use index : the index of the unrolled ir is rebuilt
+
+#include "code/GlslConvert.h"
+
+#include <cstdio>
+#include <regex>
+#include <string>
+
+static const char* s_Shader =
+	"#version 330\n"
+	"uniform vec4 u[4];\n"
+	"uniform float k;\n"
+	"out vec4 o;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 s = vec4(0.0);\n"
+	"	for (int i = 0; i < 4; i++)\n"
+	"	{\n"
+	"		float f = float(i) * k;\n"
+	"		s += u[i] * f;\n"
+	"	}\n"
+	"	o = s;\n"
+	"}\n";
+
+// a local assigned and never read, only seen in his declaration and his assignments
+static bool HasDeadStore(const std::string& vCode)
+{
+	static const std::regex assignment("\\n\\s*([A-Za-z_][A-Za-z_0-9]*) = ");
+	for (std::sregex_iterator it(vCode.begin(), vCode.end(), assignment), end; it != end; ++it)
+	{
+		const std::string name = (*it)[1];
+		if (name == "o")
+			continue;
+		const std::regex uses("\\b" + name + "\\b");
+		const std::regex defs("([A-Za-z_0-9]+ " + name + ";)|(\\b" + name + " = )");
+		const ptrdiff_t countUses = std::distance(std::sregex_iterator(vCode.begin(), vCode.end(), uses), std::sregex_iterator());
+		const ptrdiff_t countDefs = std::distance(std::sregex_iterator(vCode.begin(), vCode.end(), defs), std::sregex_iterator());
+		if (countUses == countDefs)
+		{
+			printf("dead store of %s\n", name.c_str());
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool Check(const char* vPipeline)
+{
+	GlslConvert::OptimizationStruct optimization;
+	optimization.pipelineOptions.pipeline = vPipeline;
+	const std::string res = GlslConvert::Instance()->Optimize(s_Shader,
+		GlslConvert::MESA_SHADER_FRAGMENT, GlslConvert::API_OPENGL_CORE,
+		GlslConvert::LANGUAGE_TARGET_GLSL, 330, optimization);
+	printf("%s\n%s\n", vPipeline, res.c_str());
+
+	if (res.find("main") == std::string::npos)
+	{
+		printf("FAIL : the shader was not optimized\n");
+		return false;
+	}
+	if (res.find("for (") != std::string::npos || res.find("while (") != std::string::npos)
+	{
+		printf("FAIL : the loop was not unrolled\n");
+		return false;
+	}
+	if (HasDeadStore(res))
+	{
+		printf("FAIL : dead_code used the def-use index of the ir before unroll_loops\n");
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	// the last dead_code removes the counter, whose reads were the copies removed by the first one
+	bool ok = true;
+	ok &= Check("algebraic,tree_grafting,unroll_loops,dead_code,dead_code");
+	ok &= Check("algebraic,tree_grafting,dead_code,unroll_loops,dead_code,tree_grafting,dead_code");
+	return ok ? 0 : 1;
+}
@@ -2188,20 +2188,18 @@ case 22:
 YY_RULE_SETUP
 #line 373 "../src/compiler/glsl/glsl_lexer.ll"
 {
-				   /* We're not doing linear_strdup here, to avoid an implicit call
-				    * on strlen() for the length of the string, as this is already
-				    * found by flex and stored in yyleng
+				   /* The length is already found by flex and stored in
+				    * yyleng, so the interner don't call strlen()
 				    */
-                                    void *mem_ctx = yyextra->linalloc;
-                                    char *id = (char *) linear_alloc_child(mem_ctx, yyleng + 1);
-                                    memcpy(id, yytext, yyleng + 1);
-                                    yylval->identifier = id;
+                                    yylval->identifier =
+                                       string_interner_intern_len(yyextra->interner,
+                                                                  yytext, yyleng);
 				   return IDENTIFIER;
 				}
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 384 "../src/compiler/glsl/glsl_lexer.ll"
+#line 382 "../src/compiler/glsl/glsl_lexer.ll"
 {
 				    yylval->n = strtol(yytext, NULL, 10);
 				    return INTCONSTANT;
@@ -2209,7 +2207,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 388 "../src/compiler/glsl/glsl_lexer.ll"
+#line 386 "../src/compiler/glsl/glsl_lexer.ll"
 {
 				    yylval->n = 0;
 				    return INTCONSTANT;
@@ -2218,393 +2216,393 @@ YY_RULE_SETUP
 case 25:
 /* rule 25 can match eol */
 YY_RULE_SETUP
-#line 392 "../src/compiler/glsl/glsl_lexer.ll"
+#line 390 "../src/compiler/glsl/glsl_lexer.ll"
 { BEGIN 0; yylineno++; yycolumn = 0; return EOL; }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 393 "../src/compiler/glsl/glsl_lexer.ll"
+#line 391 "../src/compiler/glsl/glsl_lexer.ll"
 { return yytext[0]; }
 	YY_BREAK
 case 27:
 /* rule 27 can match eol */
 YY_RULE_SETUP
-#line 395 "../src/compiler/glsl/glsl_lexer.ll"
+#line 393 "../src/compiler/glsl/glsl_lexer.ll"
 { yylineno++; yycolumn = 0; }
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 397 "../src/compiler/glsl/glsl_lexer.ll"
+#line 395 "../src/compiler/glsl/glsl_lexer.ll"
 DEPRECATED_ES_KEYWORD(ATTRIBUTE);
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 398 "../src/compiler/glsl/glsl_lexer.ll"
+#line 396 "../src/compiler/glsl/glsl_lexer.ll"
 return CONST_TOK;
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 399 "../src/compiler/glsl/glsl_lexer.ll"
+#line 397 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::bool_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 400 "../src/compiler/glsl/glsl_lexer.ll"
+#line 398 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::float_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 401 "../src/compiler/glsl/glsl_lexer.ll"
+#line 399 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::int_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 402 "../src/compiler/glsl/glsl_lexer.ll"
+#line 400 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(130, 300, 130, 300, glsl_type::uint_type);
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 404 "../src/compiler/glsl/glsl_lexer.ll"
+#line 402 "../src/compiler/glsl/glsl_lexer.ll"
 return BREAK;
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 405 "../src/compiler/glsl/glsl_lexer.ll"
+#line 403 "../src/compiler/glsl/glsl_lexer.ll"
 return CONTINUE;
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 406 "../src/compiler/glsl/glsl_lexer.ll"
+#line 404 "../src/compiler/glsl/glsl_lexer.ll"
 return DO;
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 407 "../src/compiler/glsl/glsl_lexer.ll"
+#line 405 "../src/compiler/glsl/glsl_lexer.ll"
 return WHILE;
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 408 "../src/compiler/glsl/glsl_lexer.ll"
+#line 406 "../src/compiler/glsl/glsl_lexer.ll"
 return ELSE;
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 409 "../src/compiler/glsl/glsl_lexer.ll"
+#line 407 "../src/compiler/glsl/glsl_lexer.ll"
 return FOR;
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 410 "../src/compiler/glsl/glsl_lexer.ll"
+#line 408 "../src/compiler/glsl/glsl_lexer.ll"
 return IF;
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 411 "../src/compiler/glsl/glsl_lexer.ll"
+#line 409 "../src/compiler/glsl/glsl_lexer.ll"
 return DISCARD;
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 412 "../src/compiler/glsl/glsl_lexer.ll"
+#line 410 "../src/compiler/glsl/glsl_lexer.ll"
 return RETURN;
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 413 "../src/compiler/glsl/glsl_lexer.ll"
+#line 411 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(0, 0, 0, 0, yyextra->EXT_demote_to_helper_invocation_enable, DEMOTE);
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 415 "../src/compiler/glsl/glsl_lexer.ll"
+#line 413 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::bvec2_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 416 "../src/compiler/glsl/glsl_lexer.ll"
+#line 414 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::bvec3_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 417 "../src/compiler/glsl/glsl_lexer.ll"
+#line 415 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::bvec4_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 418 "../src/compiler/glsl/glsl_lexer.ll"
+#line 416 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::ivec2_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 48:
 YY_RULE_SETUP
-#line 419 "../src/compiler/glsl/glsl_lexer.ll"
+#line 417 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::ivec3_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 420 "../src/compiler/glsl/glsl_lexer.ll"
+#line 418 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::ivec4_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 50:
 YY_RULE_SETUP
-#line 421 "../src/compiler/glsl/glsl_lexer.ll"
+#line 419 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable, glsl_type::uvec2_type);
 	YY_BREAK
 case 51:
 YY_RULE_SETUP
-#line 422 "../src/compiler/glsl/glsl_lexer.ll"
+#line 420 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable, glsl_type::uvec3_type);
 	YY_BREAK
 case 52:
 YY_RULE_SETUP
-#line 423 "../src/compiler/glsl/glsl_lexer.ll"
+#line 421 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable, glsl_type::uvec4_type);
 	YY_BREAK
 case 53:
 YY_RULE_SETUP
-#line 424 "../src/compiler/glsl/glsl_lexer.ll"
+#line 422 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::vec2_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 54:
 YY_RULE_SETUP
-#line 425 "../src/compiler/glsl/glsl_lexer.ll"
+#line 423 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::vec3_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 55:
 YY_RULE_SETUP
-#line 426 "../src/compiler/glsl/glsl_lexer.ll"
+#line 424 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::vec4_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 56:
 YY_RULE_SETUP
-#line 427 "../src/compiler/glsl/glsl_lexer.ll"
+#line 425 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::mat2_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 57:
 YY_RULE_SETUP
-#line 428 "../src/compiler/glsl/glsl_lexer.ll"
+#line 426 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::mat3_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 58:
 YY_RULE_SETUP
-#line 429 "../src/compiler/glsl/glsl_lexer.ll"
+#line 427 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::mat4_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 59:
 YY_RULE_SETUP
-#line 430 "../src/compiler/glsl/glsl_lexer.ll"
+#line 428 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat2_type);
 	YY_BREAK
 case 60:
 YY_RULE_SETUP
-#line 431 "../src/compiler/glsl/glsl_lexer.ll"
+#line 429 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat2x3_type);
 	YY_BREAK
 case 61:
 YY_RULE_SETUP
-#line 432 "../src/compiler/glsl/glsl_lexer.ll"
+#line 430 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat2x4_type);
 	YY_BREAK
 case 62:
 YY_RULE_SETUP
-#line 433 "../src/compiler/glsl/glsl_lexer.ll"
+#line 431 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat3x2_type);
 	YY_BREAK
 case 63:
 YY_RULE_SETUP
-#line 434 "../src/compiler/glsl/glsl_lexer.ll"
+#line 432 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat3_type);
 	YY_BREAK
 case 64:
 YY_RULE_SETUP
-#line 435 "../src/compiler/glsl/glsl_lexer.ll"
+#line 433 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat3x4_type);
 	YY_BREAK
 case 65:
 YY_RULE_SETUP
-#line 436 "../src/compiler/glsl/glsl_lexer.ll"
+#line 434 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat4x2_type);
 	YY_BREAK
 case 66:
 YY_RULE_SETUP
-#line 437 "../src/compiler/glsl/glsl_lexer.ll"
+#line 435 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat4x3_type);
 	YY_BREAK
 case 67:
 YY_RULE_SETUP
-#line 438 "../src/compiler/glsl/glsl_lexer.ll"
+#line 436 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE(120, 300, 120, 300, glsl_type::mat4_type);
 	YY_BREAK
 case 68:
 YY_RULE_SETUP
-#line 440 "../src/compiler/glsl/glsl_lexer.ll"
+#line 438 "../src/compiler/glsl/glsl_lexer.ll"
 return IN_TOK;
 	YY_BREAK
 case 69:
 YY_RULE_SETUP
-#line 441 "../src/compiler/glsl/glsl_lexer.ll"
+#line 439 "../src/compiler/glsl/glsl_lexer.ll"
 return OUT_TOK;
 	YY_BREAK
 case 70:
 YY_RULE_SETUP
-#line 442 "../src/compiler/glsl/glsl_lexer.ll"
+#line 440 "../src/compiler/glsl/glsl_lexer.ll"
 return INOUT_TOK;
 	YY_BREAK
 case 71:
 YY_RULE_SETUP
-#line 443 "../src/compiler/glsl/glsl_lexer.ll"
+#line 441 "../src/compiler/glsl/glsl_lexer.ll"
 return UNIFORM;
 	YY_BREAK
 case 72:
 YY_RULE_SETUP
-#line 444 "../src/compiler/glsl/glsl_lexer.ll"
+#line 442 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(0, 0, 430, 310, yyextra->ARB_shader_storage_buffer_object_enable, BUFFER);
 	YY_BREAK
 case 73:
 YY_RULE_SETUP
-#line 445 "../src/compiler/glsl/glsl_lexer.ll"
+#line 443 "../src/compiler/glsl/glsl_lexer.ll"
 DEPRECATED_ES_KEYWORD(VARYING);
 	YY_BREAK
 case 74:
 YY_RULE_SETUP
-#line 446 "../src/compiler/glsl/glsl_lexer.ll"
+#line 444 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(120, 300, 120, 300, yyextra->EXT_gpu_shader4_enable, CENTROID);
 	YY_BREAK
 case 75:
 YY_RULE_SETUP
-#line 447 "../src/compiler/glsl/glsl_lexer.ll"
+#line 445 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(120, 100, 120, 100, INVARIANT);
 	YY_BREAK
 case 76:
 YY_RULE_SETUP
-#line 448 "../src/compiler/glsl/glsl_lexer.ll"
+#line 446 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(130, 100, 130, 300, yyextra->EXT_gpu_shader4_enable, FLAT);
 	YY_BREAK
 case 77:
 YY_RULE_SETUP
-#line 449 "../src/compiler/glsl/glsl_lexer.ll"
+#line 447 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 130, 300, SMOOTH);
 	YY_BREAK
 case 78:
 YY_RULE_SETUP
-#line 450 "../src/compiler/glsl/glsl_lexer.ll"
+#line 448 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(130, 300, 130, 0, yyextra->EXT_gpu_shader4_enable, NOPERSPECTIVE);
 	YY_BREAK
 case 79:
 YY_RULE_SETUP
-#line 451 "../src/compiler/glsl/glsl_lexer.ll"
+#line 449 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(0, 300, 400, 320, yyextra->has_tessellation_shader(), PATCH);
 	YY_BREAK
 case 80:
 YY_RULE_SETUP
-#line 453 "../src/compiler/glsl/glsl_lexer.ll"
+#line 451 "../src/compiler/glsl/glsl_lexer.ll"
 DEPRECATED_ES_TYPE(glsl_type::sampler1D_type);
 	YY_BREAK
 case 81:
 YY_RULE_SETUP
-#line 454 "../src/compiler/glsl/glsl_lexer.ll"
+#line 452 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::sampler2D_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 82:
 YY_RULE_SETUP
-#line 455 "../src/compiler/glsl/glsl_lexer.ll"
+#line 453 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::sampler3D_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 83:
 YY_RULE_SETUP
-#line 456 "../src/compiler/glsl/glsl_lexer.ll"
+#line 454 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::samplerCube_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 84:
 YY_RULE_SETUP
-#line 457 "../src/compiler/glsl/glsl_lexer.ll"
+#line 455 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::sampler1DArray_type);
 	YY_BREAK
 case 85:
 YY_RULE_SETUP
-#line 458 "../src/compiler/glsl/glsl_lexer.ll"
+#line 456 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::sampler2DArray_type);
 	YY_BREAK
 case 86:
 YY_RULE_SETUP
-#line 459 "../src/compiler/glsl/glsl_lexer.ll"
+#line 457 "../src/compiler/glsl/glsl_lexer.ll"
 DEPRECATED_ES_TYPE(glsl_type::sampler1DShadow_type);
 	YY_BREAK
 case 87:
 YY_RULE_SETUP
-#line 460 "../src/compiler/glsl/glsl_lexer.ll"
+#line 458 "../src/compiler/glsl/glsl_lexer.ll"
 { yylval->type = glsl_type::sampler2DShadow_type; return BASIC_TYPE_TOK; }
 	YY_BREAK
 case 88:
 YY_RULE_SETUP
-#line 461 "../src/compiler/glsl/glsl_lexer.ll"
+#line 459 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable, glsl_type::samplerCubeShadow_type);
 	YY_BREAK
 case 89:
 YY_RULE_SETUP
-#line 462 "../src/compiler/glsl/glsl_lexer.ll"
+#line 460 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::sampler1DArrayShadow_type);
 	YY_BREAK
 case 90:
 YY_RULE_SETUP
-#line 463 "../src/compiler/glsl/glsl_lexer.ll"
+#line 461 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::sampler2DArrayShadow_type);
 	YY_BREAK
 case 91:
 YY_RULE_SETUP
-#line 464 "../src/compiler/glsl/glsl_lexer.ll"
+#line 462 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::isampler1D_type);
 	YY_BREAK
 case 92:
 YY_RULE_SETUP
-#line 465 "../src/compiler/glsl/glsl_lexer.ll"
+#line 463 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::isampler2D_type);
 	YY_BREAK
 case 93:
 YY_RULE_SETUP
-#line 466 "../src/compiler/glsl/glsl_lexer.ll"
+#line 464 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::isampler3D_type);
 	YY_BREAK
 case 94:
 YY_RULE_SETUP
-#line 467 "../src/compiler/glsl/glsl_lexer.ll"
+#line 465 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::isamplerCube_type);
 	YY_BREAK
 case 95:
 YY_RULE_SETUP
-#line 468 "../src/compiler/glsl/glsl_lexer.ll"
+#line 466 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::isampler1DArray_type);
 	YY_BREAK
 case 96:
 YY_RULE_SETUP
-#line 469 "../src/compiler/glsl/glsl_lexer.ll"
+#line 467 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::isampler2DArray_type);
 	YY_BREAK
 case 97:
 YY_RULE_SETUP
-#line 470 "../src/compiler/glsl/glsl_lexer.ll"
+#line 468 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::usampler1D_type);
 	YY_BREAK
 case 98:
 YY_RULE_SETUP
-#line 471 "../src/compiler/glsl/glsl_lexer.ll"
+#line 469 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::usampler2D_type);
 	YY_BREAK
 case 99:
 YY_RULE_SETUP
-#line 472 "../src/compiler/glsl/glsl_lexer.ll"
+#line 470 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::usampler3D_type);
 	YY_BREAK
 case 100:
 YY_RULE_SETUP
-#line 473 "../src/compiler/glsl/glsl_lexer.ll"
+#line 471 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::usamplerCube_type);
 	YY_BREAK
 case 101:
 YY_RULE_SETUP
-#line 474 "../src/compiler/glsl/glsl_lexer.ll"
+#line 472 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 0,   yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::usampler1DArray_type);
 	YY_BREAK
 case 102:
 YY_RULE_SETUP
-#line 475 "../src/compiler/glsl/glsl_lexer.ll"
+#line 473 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_integer && yyextra->ctx->Extensions.EXT_texture_array, glsl_type::usampler2DArray_type);
 	YY_BREAK
 /* additional keywords in ARB_texture_multisample, included in GLSL 1.50 */
@@ -2612,58 +2610,58 @@ TYPE_WITH_ALT(130, 300, 130, 300, yyextra->EXT_gpu_shader4_enable && yyextra->ct
 /* [iu]sampler2DMS are defined in GLSL ES 3.10 */
 case 103:
 YY_RULE_SETUP
-#line 480 "../src/compiler/glsl/glsl_lexer.ll"
+#line 478 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 310, yyextra->ARB_texture_multisample_enable, glsl_type::sampler2DMS_type);
 	YY_BREAK
 case 104:
 YY_RULE_SETUP
-#line 481 "../src/compiler/glsl/glsl_lexer.ll"
+#line 479 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 310, yyextra->ARB_texture_multisample_enable, glsl_type::isampler2DMS_type);
 	YY_BREAK
 case 105:
 YY_RULE_SETUP
-#line 482 "../src/compiler/glsl/glsl_lexer.ll"
+#line 480 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 310, yyextra->ARB_texture_multisample_enable, glsl_type::usampler2DMS_type);
 	YY_BREAK
 case 106:
 YY_RULE_SETUP
-#line 483 "../src/compiler/glsl/glsl_lexer.ll"
+#line 481 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 320, yyextra->ARB_texture_multisample_enable || yyextra->OES_texture_storage_multisample_2d_array_enable, glsl_type::sampler2DMSArray_type);
 	YY_BREAK
 case 107:
 YY_RULE_SETUP
-#line 484 "../src/compiler/glsl/glsl_lexer.ll"
+#line 482 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 320, yyextra->ARB_texture_multisample_enable || yyextra->OES_texture_storage_multisample_2d_array_enable, glsl_type::isampler2DMSArray_type);
 	YY_BREAK
 case 108:
 YY_RULE_SETUP
-#line 485 "../src/compiler/glsl/glsl_lexer.ll"
+#line 483 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(150, 300, 150, 320, yyextra->ARB_texture_multisample_enable || yyextra->OES_texture_storage_multisample_2d_array_enable, glsl_type::usampler2DMSArray_type);
 	YY_BREAK
 /* keywords available with ARB_texture_cube_map_array_enable extension on desktop GLSL */
 case 109:
 YY_RULE_SETUP
-#line 488 "../src/compiler/glsl/glsl_lexer.ll"
+#line 486 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(400, 310, 400, 320, yyextra->ARB_texture_cube_map_array_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::samplerCubeArray_type);
 	YY_BREAK
 case 110:
 YY_RULE_SETUP
-#line 489 "../src/compiler/glsl/glsl_lexer.ll"
+#line 487 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(400, 310, 400, 320, yyextra->ARB_texture_cube_map_array_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::isamplerCubeArray_type);
 	YY_BREAK
 case 111:
 YY_RULE_SETUP
-#line 490 "../src/compiler/glsl/glsl_lexer.ll"
+#line 488 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(400, 310, 400, 320, yyextra->ARB_texture_cube_map_array_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::usamplerCubeArray_type);
 	YY_BREAK
 case 112:
 YY_RULE_SETUP
-#line 491 "../src/compiler/glsl/glsl_lexer.ll"
+#line 489 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(400, 310, 400, 320, yyextra->ARB_texture_cube_map_array_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::samplerCubeArrayShadow_type);
 	YY_BREAK
 case 113:
 YY_RULE_SETUP
-#line 493 "../src/compiler/glsl/glsl_lexer.ll"
+#line 491 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			  if (yyextra->OES_EGL_image_external_enable || yyextra->OES_EGL_image_external_essl3_enable) {
 			     yylval->type = glsl_type::samplerExternalOES_type;
@@ -2675,243 +2673,243 @@ YY_RULE_SETUP
 /* keywords available with ARB_gpu_shader5 */
 case 114:
 YY_RULE_SETUP
-#line 502 "../src/compiler/glsl/glsl_lexer.ll"
+#line 500 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(400, 310, 400, 320, yyextra->ARB_gpu_shader5_enable || yyextra->EXT_gpu_shader5_enable || yyextra->OES_gpu_shader5_enable, PRECISE);
 	YY_BREAK
 /* keywords available with ARB_shader_image_load_store */
 case 115:
 YY_RULE_SETUP
-#line 505 "../src/compiler/glsl/glsl_lexer.ll"
+#line 503 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image1D_type);
 	YY_BREAK
 case 116:
 YY_RULE_SETUP
-#line 506 "../src/compiler/glsl/glsl_lexer.ll"
+#line 504 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image2D_type);
 	YY_BREAK
 case 117:
 YY_RULE_SETUP
-#line 507 "../src/compiler/glsl/glsl_lexer.ll"
+#line 505 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image3D_type);
 	YY_BREAK
 case 118:
 YY_RULE_SETUP
-#line 508 "../src/compiler/glsl/glsl_lexer.ll"
+#line 506 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image2DRect_type);
 	YY_BREAK
 case 119:
 YY_RULE_SETUP
-#line 509 "../src/compiler/glsl/glsl_lexer.ll"
+#line 507 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::imageCube_type);
 	YY_BREAK
 case 120:
 YY_RULE_SETUP
-#line 510 "../src/compiler/glsl/glsl_lexer.ll"
+#line 508 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable, glsl_type::imageBuffer_type);
 	YY_BREAK
 case 121:
 YY_RULE_SETUP
-#line 511 "../src/compiler/glsl/glsl_lexer.ll"
+#line 509 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image1DArray_type);
 	YY_BREAK
 case 122:
 YY_RULE_SETUP
-#line 512 "../src/compiler/glsl/glsl_lexer.ll"
+#line 510 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image2DArray_type);
 	YY_BREAK
 case 123:
 YY_RULE_SETUP
-#line 513 "../src/compiler/glsl/glsl_lexer.ll"
+#line 511 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::imageCubeArray_type);
 	YY_BREAK
 case 124:
 YY_RULE_SETUP
-#line 514 "../src/compiler/glsl/glsl_lexer.ll"
+#line 512 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image2DMS_type);
 	YY_BREAK
 case 125:
 YY_RULE_SETUP
-#line 515 "../src/compiler/glsl/glsl_lexer.ll"
+#line 513 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::image2DMSArray_type);
 	YY_BREAK
 case 126:
 YY_RULE_SETUP
-#line 516 "../src/compiler/glsl/glsl_lexer.ll"
+#line 514 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage1D_type);
 	YY_BREAK
 case 127:
 YY_RULE_SETUP
-#line 517 "../src/compiler/glsl/glsl_lexer.ll"
+#line 515 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage2D_type);
 	YY_BREAK
 case 128:
 YY_RULE_SETUP
-#line 518 "../src/compiler/glsl/glsl_lexer.ll"
+#line 516 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage3D_type);
 	YY_BREAK
 case 129:
 YY_RULE_SETUP
-#line 519 "../src/compiler/glsl/glsl_lexer.ll"
+#line 517 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage2DRect_type);
 	YY_BREAK
 case 130:
 YY_RULE_SETUP
-#line 520 "../src/compiler/glsl/glsl_lexer.ll"
+#line 518 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimageCube_type);
 	YY_BREAK
 case 131:
 YY_RULE_SETUP
-#line 521 "../src/compiler/glsl/glsl_lexer.ll"
+#line 519 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable, glsl_type::iimageBuffer_type);
 	YY_BREAK
 case 132:
 YY_RULE_SETUP
-#line 522 "../src/compiler/glsl/glsl_lexer.ll"
+#line 520 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage1DArray_type);
 	YY_BREAK
 case 133:
 YY_RULE_SETUP
-#line 523 "../src/compiler/glsl/glsl_lexer.ll"
+#line 521 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage2DArray_type);
 	YY_BREAK
 case 134:
 YY_RULE_SETUP
-#line 524 "../src/compiler/glsl/glsl_lexer.ll"
+#line 522 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::iimageCubeArray_type);
 	YY_BREAK
 case 135:
 YY_RULE_SETUP
-#line 525 "../src/compiler/glsl/glsl_lexer.ll"
+#line 523 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage2DMS_type);
 	YY_BREAK
 case 136:
 YY_RULE_SETUP
-#line 526 "../src/compiler/glsl/glsl_lexer.ll"
+#line 524 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::iimage2DMSArray_type);
 	YY_BREAK
 case 137:
 YY_RULE_SETUP
-#line 527 "../src/compiler/glsl/glsl_lexer.ll"
+#line 525 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage1D_type);
 	YY_BREAK
 case 138:
 YY_RULE_SETUP
-#line 528 "../src/compiler/glsl/glsl_lexer.ll"
+#line 526 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage2D_type);
 	YY_BREAK
 case 139:
 YY_RULE_SETUP
-#line 529 "../src/compiler/glsl/glsl_lexer.ll"
+#line 527 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage3D_type);
 	YY_BREAK
 case 140:
 YY_RULE_SETUP
-#line 530 "../src/compiler/glsl/glsl_lexer.ll"
+#line 528 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage2DRect_type);
 	YY_BREAK
 case 141:
 YY_RULE_SETUP
-#line 531 "../src/compiler/glsl/glsl_lexer.ll"
+#line 529 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimageCube_type);
 	YY_BREAK
 case 142:
 YY_RULE_SETUP
-#line 532 "../src/compiler/glsl/glsl_lexer.ll"
+#line 530 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable, glsl_type::uimageBuffer_type);
 	YY_BREAK
 case 143:
 YY_RULE_SETUP
-#line 533 "../src/compiler/glsl/glsl_lexer.ll"
+#line 531 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage1DArray_type);
 	YY_BREAK
 case 144:
 YY_RULE_SETUP
-#line 534 "../src/compiler/glsl/glsl_lexer.ll"
+#line 532 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage2DArray_type);
 	YY_BREAK
 case 145:
 YY_RULE_SETUP
-#line 535 "../src/compiler/glsl/glsl_lexer.ll"
+#line 533 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 320, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->OES_texture_cube_map_array_enable || yyextra->EXT_texture_cube_map_array_enable, glsl_type::uimageCubeArray_type);
 	YY_BREAK
 case 146:
 YY_RULE_SETUP
-#line 536 "../src/compiler/glsl/glsl_lexer.ll"
+#line 534 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage2DMS_type);
 	YY_BREAK
 case 147:
 YY_RULE_SETUP
-#line 537 "../src/compiler/glsl/glsl_lexer.ll"
+#line 535 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 420, 0, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable, glsl_type::uimage2DMSArray_type);
 	YY_BREAK
 case 148:
 YY_RULE_SETUP
-#line 538 "../src/compiler/glsl/glsl_lexer.ll"
+#line 536 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, IMAGE1DSHADOW);
 	YY_BREAK
 case 149:
 YY_RULE_SETUP
-#line 539 "../src/compiler/glsl/glsl_lexer.ll"
+#line 537 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, IMAGE2DSHADOW);
 	YY_BREAK
 case 150:
 YY_RULE_SETUP
-#line 540 "../src/compiler/glsl/glsl_lexer.ll"
+#line 538 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, IMAGE1DARRAYSHADOW);
 	YY_BREAK
 case 151:
 YY_RULE_SETUP
-#line 541 "../src/compiler/glsl/glsl_lexer.ll"
+#line 539 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, IMAGE2DARRAYSHADOW);
 	YY_BREAK
 case 152:
 YY_RULE_SETUP
-#line 543 "../src/compiler/glsl/glsl_lexer.ll"
+#line 541 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(420, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->ARB_shader_storage_buffer_object_enable, COHERENT);
 	YY_BREAK
 case 153:
 YY_RULE_SETUP
-#line 544 "../src/compiler/glsl/glsl_lexer.ll"
+#line 542 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(110, 100, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->ARB_shader_storage_buffer_object_enable, VOLATILE);
 	YY_BREAK
 case 154:
 YY_RULE_SETUP
-#line 545 "../src/compiler/glsl/glsl_lexer.ll"
+#line 543 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(420, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->EXT_shader_image_load_store_enable || yyextra->ARB_shader_storage_buffer_object_enable, RESTRICT);
 	YY_BREAK
 case 155:
 YY_RULE_SETUP
-#line 546 "../src/compiler/glsl/glsl_lexer.ll"
+#line 544 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(420, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->ARB_shader_storage_buffer_object_enable, READONLY);
 	YY_BREAK
 case 156:
 YY_RULE_SETUP
-#line 547 "../src/compiler/glsl/glsl_lexer.ll"
+#line 545 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(420, 300, 420, 310, yyextra->ARB_shader_image_load_store_enable || yyextra->ARB_shader_storage_buffer_object_enable, WRITEONLY);
 	YY_BREAK
 case 157:
 YY_RULE_SETUP
-#line 549 "../src/compiler/glsl/glsl_lexer.ll"
+#line 547 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(420, 300, 420, 310, yyextra->ARB_shader_atomic_counters_enable, glsl_type::atomic_uint_type);
 	YY_BREAK
 case 158:
 YY_RULE_SETUP
-#line 551 "../src/compiler/glsl/glsl_lexer.ll"
+#line 549 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(430, 310, 430, 310, yyextra->ARB_compute_shader_enable, SHARED);
 	YY_BREAK
 case 159:
 YY_RULE_SETUP
-#line 553 "../src/compiler/glsl/glsl_lexer.ll"
+#line 551 "../src/compiler/glsl/glsl_lexer.ll"
 return STRUCT;
 	YY_BREAK
 case 160:
 YY_RULE_SETUP
-#line 554 "../src/compiler/glsl/glsl_lexer.ll"
+#line 552 "../src/compiler/glsl/glsl_lexer.ll"
 return VOID_TOK;
 	YY_BREAK
 case 161:
 YY_RULE_SETUP
-#line 556 "../src/compiler/glsl/glsl_lexer.ll"
+#line 554 "../src/compiler/glsl/glsl_lexer.ll"
 {
 		  if ((yyextra->is_version(140, 300))
 		      || yyextra->ARB_bindless_texture_enable
@@ -2936,139 +2934,139 @@ YY_RULE_SETUP
 	YY_BREAK
 case 162:
 YY_RULE_SETUP
-#line 578 "../src/compiler/glsl/glsl_lexer.ll"
+#line 576 "../src/compiler/glsl/glsl_lexer.ll"
 return INC_OP;
 	YY_BREAK
 case 163:
 YY_RULE_SETUP
-#line 579 "../src/compiler/glsl/glsl_lexer.ll"
+#line 577 "../src/compiler/glsl/glsl_lexer.ll"
 return DEC_OP;
 	YY_BREAK
 case 164:
 YY_RULE_SETUP
-#line 580 "../src/compiler/glsl/glsl_lexer.ll"
+#line 578 "../src/compiler/glsl/glsl_lexer.ll"
 return LE_OP;
 	YY_BREAK
 case 165:
 YY_RULE_SETUP
-#line 581 "../src/compiler/glsl/glsl_lexer.ll"
+#line 579 "../src/compiler/glsl/glsl_lexer.ll"
 return GE_OP;
 	YY_BREAK
 case 166:
 YY_RULE_SETUP
-#line 582 "../src/compiler/glsl/glsl_lexer.ll"
+#line 580 "../src/compiler/glsl/glsl_lexer.ll"
 return EQ_OP;
 	YY_BREAK
 case 167:
 YY_RULE_SETUP
-#line 583 "../src/compiler/glsl/glsl_lexer.ll"
+#line 581 "../src/compiler/glsl/glsl_lexer.ll"
 return NE_OP;
 	YY_BREAK
 case 168:
 YY_RULE_SETUP
-#line 584 "../src/compiler/glsl/glsl_lexer.ll"
+#line 582 "../src/compiler/glsl/glsl_lexer.ll"
 return AND_OP;
 	YY_BREAK
 case 169:
 YY_RULE_SETUP
-#line 585 "../src/compiler/glsl/glsl_lexer.ll"
+#line 583 "../src/compiler/glsl/glsl_lexer.ll"
 return OR_OP;
 	YY_BREAK
 case 170:
 YY_RULE_SETUP
-#line 586 "../src/compiler/glsl/glsl_lexer.ll"
+#line 584 "../src/compiler/glsl/glsl_lexer.ll"
 return XOR_OP;
 	YY_BREAK
 case 171:
 YY_RULE_SETUP
-#line 587 "../src/compiler/glsl/glsl_lexer.ll"
+#line 585 "../src/compiler/glsl/glsl_lexer.ll"
 return LEFT_OP;
 	YY_BREAK
 case 172:
 YY_RULE_SETUP
-#line 588 "../src/compiler/glsl/glsl_lexer.ll"
+#line 586 "../src/compiler/glsl/glsl_lexer.ll"
 return RIGHT_OP;
 	YY_BREAK
 case 173:
 YY_RULE_SETUP
-#line 590 "../src/compiler/glsl/glsl_lexer.ll"
+#line 588 "../src/compiler/glsl/glsl_lexer.ll"
 return MUL_ASSIGN;
 	YY_BREAK
 case 174:
 YY_RULE_SETUP
-#line 591 "../src/compiler/glsl/glsl_lexer.ll"
+#line 589 "../src/compiler/glsl/glsl_lexer.ll"
 return DIV_ASSIGN;
 	YY_BREAK
 case 175:
 YY_RULE_SETUP
-#line 592 "../src/compiler/glsl/glsl_lexer.ll"
+#line 590 "../src/compiler/glsl/glsl_lexer.ll"
 return ADD_ASSIGN;
 	YY_BREAK
 case 176:
 YY_RULE_SETUP
-#line 593 "../src/compiler/glsl/glsl_lexer.ll"
+#line 591 "../src/compiler/glsl/glsl_lexer.ll"
 return MOD_ASSIGN;
 	YY_BREAK
 case 177:
 YY_RULE_SETUP
-#line 594 "../src/compiler/glsl/glsl_lexer.ll"
+#line 592 "../src/compiler/glsl/glsl_lexer.ll"
 return LEFT_ASSIGN;
 	YY_BREAK
 case 178:
 YY_RULE_SETUP
-#line 595 "../src/compiler/glsl/glsl_lexer.ll"
+#line 593 "../src/compiler/glsl/glsl_lexer.ll"
 return RIGHT_ASSIGN;
 	YY_BREAK
 case 179:
 YY_RULE_SETUP
-#line 596 "../src/compiler/glsl/glsl_lexer.ll"
+#line 594 "../src/compiler/glsl/glsl_lexer.ll"
 return AND_ASSIGN;
 	YY_BREAK
 case 180:
 YY_RULE_SETUP
-#line 597 "../src/compiler/glsl/glsl_lexer.ll"
+#line 595 "../src/compiler/glsl/glsl_lexer.ll"
 return XOR_ASSIGN;
 	YY_BREAK
 case 181:
 YY_RULE_SETUP
-#line 598 "../src/compiler/glsl/glsl_lexer.ll"
+#line 596 "../src/compiler/glsl/glsl_lexer.ll"
 return OR_ASSIGN;
 	YY_BREAK
 case 182:
 YY_RULE_SETUP
-#line 599 "../src/compiler/glsl/glsl_lexer.ll"
+#line 597 "../src/compiler/glsl/glsl_lexer.ll"
 return SUB_ASSIGN;
 	YY_BREAK
 case 183:
 YY_RULE_SETUP
-#line 601 "../src/compiler/glsl/glsl_lexer.ll"
+#line 599 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    return LITERAL_INTEGER(10);
 			}
 	YY_BREAK
 case 184:
 YY_RULE_SETUP
-#line 604 "../src/compiler/glsl/glsl_lexer.ll"
+#line 602 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    return LITERAL_INTEGER(16);
 			}
 	YY_BREAK
 case 185:
 YY_RULE_SETUP
-#line 607 "../src/compiler/glsl/glsl_lexer.ll"
+#line 605 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    return LITERAL_INTEGER(8);
 			}
 	YY_BREAK
 case 186:
-#line 612 "../src/compiler/glsl/glsl_lexer.ll"
+#line 610 "../src/compiler/glsl/glsl_lexer.ll"
 case 187:
-#line 613 "../src/compiler/glsl/glsl_lexer.ll"
+#line 611 "../src/compiler/glsl/glsl_lexer.ll"
 case 188:
-#line 614 "../src/compiler/glsl/glsl_lexer.ll"
+#line 612 "../src/compiler/glsl/glsl_lexer.ll"
 case 189:
 YY_RULE_SETUP
-#line 614 "../src/compiler/glsl/glsl_lexer.ll"
+#line 612 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    struct _mesa_glsl_parse_state *state = yyextra;
 			    char suffix = yytext[strlen(yytext) - 1];
@@ -3082,14 +3080,14 @@ YY_RULE_SETUP
 			}
 	YY_BREAK
 case 190:
-#line 627 "../src/compiler/glsl/glsl_lexer.ll"
+#line 625 "../src/compiler/glsl/glsl_lexer.ll"
 case 191:
-#line 628 "../src/compiler/glsl/glsl_lexer.ll"
+#line 626 "../src/compiler/glsl/glsl_lexer.ll"
 case 192:
-#line 629 "../src/compiler/glsl/glsl_lexer.ll"
+#line 627 "../src/compiler/glsl/glsl_lexer.ll"
 case 193:
 YY_RULE_SETUP
-#line 629 "../src/compiler/glsl/glsl_lexer.ll"
+#line 627 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    if (!yyextra->is_version(400, 0) &&
 			        !yyextra->ARB_gpu_shader_fp64_enable)
@@ -3100,7 +3098,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 194:
 YY_RULE_SETUP
-#line 637 "../src/compiler/glsl/glsl_lexer.ll"
+#line 635 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    yylval->n = 1;
 			    return BOOLCONSTANT;
@@ -3108,7 +3106,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 195:
 YY_RULE_SETUP
-#line 641 "../src/compiler/glsl/glsl_lexer.ll"
+#line 639 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    yylval->n = 0;
 			    return BOOLCONSTANT;
@@ -3117,417 +3115,417 @@ YY_RULE_SETUP
 /* Reserved words in GLSL 1.10. */
 case 196:
 YY_RULE_SETUP
-#line 648 "../src/compiler/glsl/glsl_lexer.ll"
+#line 646 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, ASM);
 	YY_BREAK
 case 197:
 YY_RULE_SETUP
-#line 649 "../src/compiler/glsl/glsl_lexer.ll"
+#line 647 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, CLASS);
 	YY_BREAK
 case 198:
 YY_RULE_SETUP
-#line 650 "../src/compiler/glsl/glsl_lexer.ll"
+#line 648 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, UNION);
 	YY_BREAK
 case 199:
 YY_RULE_SETUP
-#line 651 "../src/compiler/glsl/glsl_lexer.ll"
+#line 649 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, ENUM);
 	YY_BREAK
 case 200:
 YY_RULE_SETUP
-#line 652 "../src/compiler/glsl/glsl_lexer.ll"
+#line 650 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, TYPEDEF);
 	YY_BREAK
 case 201:
 YY_RULE_SETUP
-#line 653 "../src/compiler/glsl/glsl_lexer.ll"
+#line 651 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, TEMPLATE);
 	YY_BREAK
 case 202:
 YY_RULE_SETUP
-#line 654 "../src/compiler/glsl/glsl_lexer.ll"
+#line 652 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, THIS);
 	YY_BREAK
 case 203:
 YY_RULE_SETUP
-#line 655 "../src/compiler/glsl/glsl_lexer.ll"
+#line 653 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(110, 100, 140, 300, yyextra->ARB_uniform_buffer_object_enable, PACKED_TOK);
 	YY_BREAK
 case 204:
 YY_RULE_SETUP
-#line 656 "../src/compiler/glsl/glsl_lexer.ll"
+#line 654 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, GOTO);
 	YY_BREAK
 case 205:
 YY_RULE_SETUP
-#line 657 "../src/compiler/glsl/glsl_lexer.ll"
+#line 655 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 130, 300, SWITCH);
 	YY_BREAK
 case 206:
 YY_RULE_SETUP
-#line 658 "../src/compiler/glsl/glsl_lexer.ll"
+#line 656 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 130, 300, DEFAULT);
 	YY_BREAK
 case 207:
 YY_RULE_SETUP
-#line 659 "../src/compiler/glsl/glsl_lexer.ll"
+#line 657 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, INLINE_TOK);
 	YY_BREAK
 case 208:
 YY_RULE_SETUP
-#line 660 "../src/compiler/glsl/glsl_lexer.ll"
+#line 658 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, NOINLINE);
 	YY_BREAK
 case 209:
 YY_RULE_SETUP
-#line 661 "../src/compiler/glsl/glsl_lexer.ll"
+#line 659 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, PUBLIC_TOK);
 	YY_BREAK
 case 210:
 YY_RULE_SETUP
-#line 662 "../src/compiler/glsl/glsl_lexer.ll"
+#line 660 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, STATIC);
 	YY_BREAK
 case 211:
 YY_RULE_SETUP
-#line 663 "../src/compiler/glsl/glsl_lexer.ll"
+#line 661 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, EXTERN);
 	YY_BREAK
 case 212:
 YY_RULE_SETUP
-#line 664 "../src/compiler/glsl/glsl_lexer.ll"
+#line 662 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, EXTERNAL);
 	YY_BREAK
 case 213:
 YY_RULE_SETUP
-#line 665 "../src/compiler/glsl/glsl_lexer.ll"
+#line 663 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, INTERFACE);
 	YY_BREAK
 case 214:
 YY_RULE_SETUP
-#line 666 "../src/compiler/glsl/glsl_lexer.ll"
+#line 664 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, LONG_TOK);
 	YY_BREAK
 case 215:
 YY_RULE_SETUP
-#line 667 "../src/compiler/glsl/glsl_lexer.ll"
+#line 665 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, SHORT_TOK);
 	YY_BREAK
 case 216:
 YY_RULE_SETUP
-#line 668 "../src/compiler/glsl/glsl_lexer.ll"
+#line 666 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 100, 130, 300, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::double_type);
 	YY_BREAK
 case 217:
 YY_RULE_SETUP
-#line 669 "../src/compiler/glsl/glsl_lexer.ll"
+#line 667 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, HALF);
 	YY_BREAK
 case 218:
 YY_RULE_SETUP
-#line 670 "../src/compiler/glsl/glsl_lexer.ll"
+#line 668 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, FIXED_TOK);
 	YY_BREAK
 case 219:
 YY_RULE_SETUP
-#line 671 "../src/compiler/glsl/glsl_lexer.ll"
+#line 669 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(110, 100, 0, 0, yyextra->EXT_gpu_shader4_enable, UNSIGNED);
 	YY_BREAK
 case 220:
 YY_RULE_SETUP
-#line 672 "../src/compiler/glsl/glsl_lexer.ll"
+#line 670 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, INPUT_TOK);
 	YY_BREAK
 case 221:
 YY_RULE_SETUP
-#line 673 "../src/compiler/glsl/glsl_lexer.ll"
+#line 671 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, OUTPUT);
 	YY_BREAK
 case 222:
 YY_RULE_SETUP
-#line 674 "../src/compiler/glsl/glsl_lexer.ll"
+#line 672 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, HVEC2);
 	YY_BREAK
 case 223:
 YY_RULE_SETUP
-#line 675 "../src/compiler/glsl/glsl_lexer.ll"
+#line 673 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, HVEC3);
 	YY_BREAK
 case 224:
 YY_RULE_SETUP
-#line 676 "../src/compiler/glsl/glsl_lexer.ll"
+#line 674 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, HVEC4);
 	YY_BREAK
 case 225:
 YY_RULE_SETUP
-#line 677 "../src/compiler/glsl/glsl_lexer.ll"
+#line 675 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dvec2_type);
 	YY_BREAK
 case 226:
 YY_RULE_SETUP
-#line 678 "../src/compiler/glsl/glsl_lexer.ll"
+#line 676 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dvec3_type);
 	YY_BREAK
 case 227:
 YY_RULE_SETUP
-#line 679 "../src/compiler/glsl/glsl_lexer.ll"
+#line 677 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dvec4_type);
 	YY_BREAK
 case 228:
 YY_RULE_SETUP
-#line 680 "../src/compiler/glsl/glsl_lexer.ll"
+#line 678 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat2_type);
 	YY_BREAK
 case 229:
 YY_RULE_SETUP
-#line 681 "../src/compiler/glsl/glsl_lexer.ll"
+#line 679 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat3_type);
 	YY_BREAK
 case 230:
 YY_RULE_SETUP
-#line 682 "../src/compiler/glsl/glsl_lexer.ll"
+#line 680 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat4_type);
 	YY_BREAK
 case 231:
 YY_RULE_SETUP
-#line 683 "../src/compiler/glsl/glsl_lexer.ll"
+#line 681 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat2_type);
 	YY_BREAK
 case 232:
 YY_RULE_SETUP
-#line 684 "../src/compiler/glsl/glsl_lexer.ll"
+#line 682 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat2x3_type);
 	YY_BREAK
 case 233:
 YY_RULE_SETUP
-#line 685 "../src/compiler/glsl/glsl_lexer.ll"
+#line 683 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat2x4_type);
 	YY_BREAK
 case 234:
 YY_RULE_SETUP
-#line 686 "../src/compiler/glsl/glsl_lexer.ll"
+#line 684 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat3x2_type);
 	YY_BREAK
 case 235:
 YY_RULE_SETUP
-#line 687 "../src/compiler/glsl/glsl_lexer.ll"
+#line 685 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat3_type);
 	YY_BREAK
 case 236:
 YY_RULE_SETUP
-#line 688 "../src/compiler/glsl/glsl_lexer.ll"
+#line 686 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat3x4_type);
 	YY_BREAK
 case 237:
 YY_RULE_SETUP
-#line 689 "../src/compiler/glsl/glsl_lexer.ll"
+#line 687 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat4x2_type);
 	YY_BREAK
 case 238:
 YY_RULE_SETUP
-#line 690 "../src/compiler/glsl/glsl_lexer.ll"
+#line 688 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat4x3_type);
 	YY_BREAK
 case 239:
 YY_RULE_SETUP
-#line 691 "../src/compiler/glsl/glsl_lexer.ll"
+#line 689 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 400, 0, yyextra->ARB_gpu_shader_fp64_enable, glsl_type::dmat4_type);
 	YY_BREAK
 case 240:
 YY_RULE_SETUP
-#line 692 "../src/compiler/glsl/glsl_lexer.ll"
+#line 690 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, FVEC2);
 	YY_BREAK
 case 241:
 YY_RULE_SETUP
-#line 693 "../src/compiler/glsl/glsl_lexer.ll"
+#line 691 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, FVEC3);
 	YY_BREAK
 case 242:
 YY_RULE_SETUP
-#line 694 "../src/compiler/glsl/glsl_lexer.ll"
+#line 692 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, FVEC4);
 	YY_BREAK
 case 243:
 YY_RULE_SETUP
-#line 695 "../src/compiler/glsl/glsl_lexer.ll"
+#line 693 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 0, 0, yyextra->ARB_texture_rectangle_enable, glsl_type::sampler2DRect_type);
 	YY_BREAK
 case 244:
 YY_RULE_SETUP
-#line 696 "../src/compiler/glsl/glsl_lexer.ll"
+#line 694 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, SAMPLER3DRECT);
 	YY_BREAK
 case 245:
 YY_RULE_SETUP
-#line 697 "../src/compiler/glsl/glsl_lexer.ll"
+#line 695 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(110, 100, 0, 0, yyextra->ARB_texture_rectangle_enable, glsl_type::sampler2DRectShadow_type);
 	YY_BREAK
 case 246:
 YY_RULE_SETUP
-#line 698 "../src/compiler/glsl/glsl_lexer.ll"
+#line 696 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, SIZEOF);
 	YY_BREAK
 case 247:
 YY_RULE_SETUP
-#line 699 "../src/compiler/glsl/glsl_lexer.ll"
+#line 697 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, CAST);
 	YY_BREAK
 case 248:
 YY_RULE_SETUP
-#line 700 "../src/compiler/glsl/glsl_lexer.ll"
+#line 698 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, NAMESPACE);
 	YY_BREAK
 case 249:
 YY_RULE_SETUP
-#line 701 "../src/compiler/glsl/glsl_lexer.ll"
+#line 699 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(110, 100, 0, 0, USING);
 	YY_BREAK
 /* Additional reserved words in GLSL 1.20. */
 case 250:
 YY_RULE_SETUP
-#line 704 "../src/compiler/glsl/glsl_lexer.ll"
+#line 702 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(120, 100, 130, 100, LOWP);
 	YY_BREAK
 case 251:
 YY_RULE_SETUP
-#line 705 "../src/compiler/glsl/glsl_lexer.ll"
+#line 703 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(120, 100, 130, 100, MEDIUMP);
 	YY_BREAK
 case 252:
 YY_RULE_SETUP
-#line 706 "../src/compiler/glsl/glsl_lexer.ll"
+#line 704 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(120, 100, 130, 100, HIGHP);
 	YY_BREAK
 case 253:
 YY_RULE_SETUP
-#line 707 "../src/compiler/glsl/glsl_lexer.ll"
+#line 705 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(120, 100, 130, 100, PRECISION);
 	YY_BREAK
 /* Additional reserved words in GLSL 1.30. */
 case 254:
 YY_RULE_SETUP
-#line 710 "../src/compiler/glsl/glsl_lexer.ll"
+#line 708 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 130, 300, CASE);
 	YY_BREAK
 case 255:
 YY_RULE_SETUP
-#line 711 "../src/compiler/glsl/glsl_lexer.ll"
+#line 709 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, COMMON);
 	YY_BREAK
 case 256:
 YY_RULE_SETUP
-#line 712 "../src/compiler/glsl/glsl_lexer.ll"
+#line 710 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, PARTITION);
 	YY_BREAK
 case 257:
 YY_RULE_SETUP
-#line 713 "../src/compiler/glsl/glsl_lexer.ll"
+#line 711 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, ACTIVE);
 	YY_BREAK
 case 258:
 YY_RULE_SETUP
-#line 714 "../src/compiler/glsl/glsl_lexer.ll"
+#line 712 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 100, 0, 0, SUPERP);
 	YY_BREAK
 case 259:
 YY_RULE_SETUP
-#line 715 "../src/compiler/glsl/glsl_lexer.ll"
+#line 713 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(130, 300, 140, 320, yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable || (yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_buffer_object), glsl_type::samplerBuffer_type);
 	YY_BREAK
 case 260:
 YY_RULE_SETUP
-#line 716 "../src/compiler/glsl/glsl_lexer.ll"
+#line 714 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(130, 300, 0, 0, FILTER);
 	YY_BREAK
 case 261:
 YY_RULE_SETUP
-#line 717 "../src/compiler/glsl/glsl_lexer.ll"
+#line 715 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(130, 0, 140, 0, yyextra->ARB_uniform_buffer_object_enable && !yyextra->es_shader, ROW_MAJOR);
 	YY_BREAK
 /* Additional reserved words in GLSL 1.40 */
 case 262:
 YY_RULE_SETUP
-#line 720 "../src/compiler/glsl/glsl_lexer.ll"
+#line 718 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(140, 300, 140, 0, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.NV_texture_rectangle && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::isampler2DRect_type);
 	YY_BREAK
 case 263:
 YY_RULE_SETUP
-#line 721 "../src/compiler/glsl/glsl_lexer.ll"
+#line 719 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(140, 300, 140, 0, yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.NV_texture_rectangle && yyextra->ctx->Extensions.EXT_texture_integer, glsl_type::usampler2DRect_type);
 	YY_BREAK
 case 264:
 YY_RULE_SETUP
-#line 722 "../src/compiler/glsl/glsl_lexer.ll"
+#line 720 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(140, 300, 140, 320, yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable || (yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_buffer_object && yyextra->ctx->Extensions.EXT_texture_integer), glsl_type::isamplerBuffer_type);
 	YY_BREAK
 case 265:
 YY_RULE_SETUP
-#line 723 "../src/compiler/glsl/glsl_lexer.ll"
+#line 721 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(140, 300, 140, 320, yyextra->EXT_texture_buffer_enable || yyextra->OES_texture_buffer_enable || (yyextra->EXT_gpu_shader4_enable && yyextra->ctx->Extensions.EXT_texture_buffer_object && yyextra->ctx->Extensions.EXT_texture_integer), glsl_type::usamplerBuffer_type);
 	YY_BREAK
 /* Additional reserved words in GLSL ES 3.00 */
 case 266:
 YY_RULE_SETUP
-#line 726 "../src/compiler/glsl/glsl_lexer.ll"
+#line 724 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD(420, 300, 0, 0, RESOURCE);
 	YY_BREAK
 case 267:
 YY_RULE_SETUP
-#line 727 "../src/compiler/glsl/glsl_lexer.ll"
+#line 725 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(400, 300, 400, 320, yyextra->ARB_gpu_shader5_enable || yyextra->OES_shader_multisample_interpolation_enable, SAMPLE);
 	YY_BREAK
 case 268:
 YY_RULE_SETUP
-#line 728 "../src/compiler/glsl/glsl_lexer.ll"
+#line 726 "../src/compiler/glsl/glsl_lexer.ll"
 KEYWORD_WITH_ALT(400, 300, 400, 0, yyextra->ARB_shader_subroutine_enable, SUBROUTINE);
 	YY_BREAK
 /* Additional words for ARB_gpu_shader_int64 */
 case 269:
 YY_RULE_SETUP
-#line 731 "../src/compiler/glsl/glsl_lexer.ll"
+#line 729 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::int64_t_type);
 	YY_BREAK
 case 270:
 YY_RULE_SETUP
-#line 732 "../src/compiler/glsl/glsl_lexer.ll"
+#line 730 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::i64vec2_type);
 	YY_BREAK
 case 271:
 YY_RULE_SETUP
-#line 733 "../src/compiler/glsl/glsl_lexer.ll"
+#line 731 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::i64vec3_type);
 	YY_BREAK
 case 272:
 YY_RULE_SETUP
-#line 734 "../src/compiler/glsl/glsl_lexer.ll"
+#line 732 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::i64vec4_type);
 	YY_BREAK
 case 273:
 YY_RULE_SETUP
-#line 736 "../src/compiler/glsl/glsl_lexer.ll"
+#line 734 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::uint64_t_type);
 	YY_BREAK
 case 274:
 YY_RULE_SETUP
-#line 737 "../src/compiler/glsl/glsl_lexer.ll"
+#line 735 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::u64vec2_type);
 	YY_BREAK
 case 275:
 YY_RULE_SETUP
-#line 738 "../src/compiler/glsl/glsl_lexer.ll"
+#line 736 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::u64vec3_type);
 	YY_BREAK
 case 276:
 YY_RULE_SETUP
-#line 739 "../src/compiler/glsl/glsl_lexer.ll"
+#line 737 "../src/compiler/glsl/glsl_lexer.ll"
 TYPE_WITH_ALT(0, 0, 0, 0, yyextra->ARB_gpu_shader_int64_enable || yyextra->AMD_gpu_shader_int64_enable, glsl_type::u64vec4_type);
 	YY_BREAK
 case 277:
 YY_RULE_SETUP
-#line 741 "../src/compiler/glsl/glsl_lexer.ll"
+#line 739 "../src/compiler/glsl/glsl_lexer.ll"
 {
 			    struct _mesa_glsl_parse_state *state = yyextra;
 			    if (state->es_shader && yyleng > 1024) {
@@ -3540,19 +3538,19 @@ YY_RULE_SETUP
 	YY_BREAK
 case 278:
 YY_RULE_SETUP
-#line 751 "../src/compiler/glsl/glsl_lexer.ll"
+#line 749 "../src/compiler/glsl/glsl_lexer.ll"
 { struct _mesa_glsl_parse_state *state = yyextra;
 			  state->is_field = true;
 			  return DOT_TOK; }
 	YY_BREAK
 case 279:
 YY_RULE_SETUP
-#line 755 "../src/compiler/glsl/glsl_lexer.ll"
+#line 753 "../src/compiler/glsl/glsl_lexer.ll"
 { return yytext[0]; }
 	YY_BREAK
 case 280:
 YY_RULE_SETUP
-#line 757 "../src/compiler/glsl/glsl_lexer.ll"
+#line 755 "../src/compiler/glsl/glsl_lexer.ll"
 YY_FATAL_ERROR( "flex scanner jammed" );
 	YY_BREAK
 #line 3559 "src/compiler/glsl/glsl_lexer.cpp"
@@ -4716,20 +4714,19 @@ void yyfree (void * ptr , yyscan_t yyscanner)
 
 #define YYTABLES_NAME "yytables"
 
-#line 757 "../src/compiler/glsl/glsl_lexer.ll"
+#line 755 "../src/compiler/glsl/glsl_lexer.ll"
 
 
 int
 classify_identifier(struct _mesa_glsl_parse_state *state, const char *name,
                     unsigned name_len, YYSTYPE *output)
 {
-   /* We're not doing linear_strdup here, to avoid an implicit call on
-    * strlen() for the length of the string, as this is already found by flex
-    * and stored in yyleng
+   /* Interned, so each identifier has one copy for the whole shader and the
+    * symbol table find it by pointer.  The length is already found by flex
+    * and stored in yyleng, so the interner don't call strlen()
     */
-   char *id = (char *) linear_alloc_child(state->linalloc, name_len + 1);
-   memcpy(id, name, name_len + 1);
-   output->identifier = id;
+   output->identifier =
+      string_interner_intern_len(state->interner, name, name_len);
 
    if (state->is_field) {
       state->is_field = false;
@@ -370,14 +370,12 @@ PATH		["][./ _A-Za-z0-9]*["]
 <PP>[ \t\r]*			{ }
 <PP>:				return COLON;
 <PP>[_a-zA-Z][_a-zA-Z0-9]*	{
-				   /* We're not doing linear_strdup here, to avoid an implicit call
-				    * on strlen() for the length of the string, as this is already
-				    * found by flex and stored in yyleng
+				   /* The length is already found by flex and stored in
+				    * yyleng, so the interner don't call strlen()
 				    */
-                                    void *mem_ctx = yyextra->linalloc;
-                                    char *id = (char *) linear_alloc_child(mem_ctx, yyleng + 1);
-                                    memcpy(id, yytext, yyleng + 1);
-                                    yylval->identifier = id;
+                                    yylval->identifier =
+                                       string_interner_intern_len(yyextra->interner,
+                                                                  yytext, yyleng);
 				   return IDENTIFIER;
 				}
 <PP>[1-9][0-9]*			{
@@ -759,13 +757,12 @@ int
 classify_identifier(struct _mesa_glsl_parse_state *state, const char *name,
                     unsigned name_len, YYSTYPE *output)
 {
-   /* We're not doing linear_strdup here, to avoid an implicit call on
-    * strlen() for the length of the string, as this is already found by flex
-    * and stored in yyleng
+   /* Interned, so each identifier has one copy for the whole shader and the
+    * symbol table find it by pointer.  The length is already found by flex
+    * and stored in yyleng, so the interner don't call strlen()
     */
-   char *id = (char *) linear_alloc_child(state->linalloc, name_len + 1);
-   memcpy(id, name, name_len + 1);
-   output->identifier = id;
+   output->identifier =
+      string_interner_intern_len(state->interner, name, name_len);
 
    if (state->is_field) {
       state->is_field = false;
@@ -69,7 +69,9 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
 
    this->scanner = NULL;
    this->translation_unit.make_empty();
-   this->symbols = new(mem_ctx) glsl_symbol_table;
+   /* before the symbols, so it is freed after them with the mem_ctx */
+   this->interner = string_interner_create(mem_ctx);
+   this->symbols = new(mem_ctx) glsl_symbol_table(this->interner);
 
    this->linalloc = linear_alloc_parent(this, 0);
 
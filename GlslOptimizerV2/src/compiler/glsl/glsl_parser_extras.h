@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include "glsl_symbol_table.h"
+#include "util/string_interner.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -387,6 +388,13 @@ struct _mesa_glsl_parse_state {
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
+   /**
+    * Identifiers of the lexer and names of the symbol table, one copy each.
+    * Allocated in the mem_ctx of the constructor, so it outlive the state,
+    * the identifiers are still used by the hir and the symbols after.
+    */
+   struct string_interner *interner;
+
    void *linalloc;
 
    unsigned num_supported_versions;
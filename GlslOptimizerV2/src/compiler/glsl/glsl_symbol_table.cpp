@@ -109,6 +109,14 @@ glsl_symbol_table::glsl_symbol_table()
    this->linalloc = linear_alloc_parent(this->mem_ctx, 0);
 }
 
+glsl_symbol_table::glsl_symbol_table(struct string_interner *interner)
+{
+   this->separate_function_namespace = false;
+   this->table = _mesa_symbol_table_ctor_interned(interner);
+   this->mem_ctx = ralloc_context(NULL);
+   this->linalloc = linear_alloc_parent(this->mem_ctx, 0);
+}
+
 glsl_symbol_table::~glsl_symbol_table()
 {
    _mesa_symbol_table_dtor(table);
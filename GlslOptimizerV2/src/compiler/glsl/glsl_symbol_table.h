@@ -43,6 +43,8 @@ struct glsl_symbol_table {
    DECLARE_RALLOC_CXX_OPERATORS(glsl_symbol_table)
 
    glsl_symbol_table();
+   /** The names are kept in the interner, who must outlive the table */
+   glsl_symbol_table(struct string_interner *interner);
    ~glsl_symbol_table();
 
    /* In 1.10, functions and variables have separate namespaces. */
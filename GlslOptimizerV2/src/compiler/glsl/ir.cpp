@@ -1685,8 +1685,17 @@ ir_swizzle::variable_referenced() const
 
 bool ir_variable::temporaries_allocate_names = false;
 
+struct string_interner *ir_variable::name_interner = NULL;
+
 const char ir_variable::tmp_name[] = "compiler_temp";
 
+bool
+ir_variable::is_name_interned() const
+{
+   return ir_variable::name_interner != NULL &&
+          string_interner_owns(ir_variable::name_interner, this->name);
+}
+
 ir_variable::ir_variable(const struct glsl_type *type, const char *name,
 			 ir_variable_mode mode)
    : ir_instruction(ir_type_variable)
@@ -1713,6 +1722,8 @@ ir_variable::ir_variable(const struct glsl_type *type, const char *name,
               strlen(name) < ARRAY_SIZE(this->name_storage)) {
       strcpy(this->name_storage, name ? name : "");
       this->name = this->name_storage;
+   } else if (ir_variable::name_interner) {
+      this->name = string_interner_intern(ir_variable::name_interner, name);
    } else {
       this->name = ralloc_strdup(this, name);
    }
@@ -611,9 +611,12 @@ public:
    inline bool is_name_ralloced() const
    {
       return this->name != ir_variable::tmp_name &&
-             this->name != this->name_storage;
+             this->name != this->name_storage &&
+             !is_name_interned();
    }
 
+   bool is_name_interned() const;
+
    /**
     * Enable emitting extension warnings for this variable
     */
@@ -639,7 +642,7 @@ public:
 private:
    /**
     * If the name length fits into name_storage, it's used, otherwise
-    * the name is ralloc'd. shader-db mining showed that 70% of variables
+    * the name is ralloc'd (or interned, see name_interner). shader-db mining showed that 70% of variables
     * fit here. This is a win over ralloc where only ralloc_header has
     * 20 bytes on 64-bit (28 bytes with DEBUG), and we can also skip malloc.
     */
@@ -1047,6 +1050,18 @@ public:
     * okay since it will only be set true while debugging.
     */
    static bool temporaries_allocate_names;
+
+   /**
+    * When not NULL, the names who don't fit in name_storage are interned
+    * here instead of ralloc'd, so the clones of a variable (linking,
+    * inlining) share the name of the original.  The interner must outlive
+    * the variables created while it is set.
+    *
+    * \warning
+    * Global like \c temporaries_allocate_names, set for the time of one
+    * compilation.
+    */
+   static struct string_interner *name_interner;
 };
 
 /**
@@ -2413,6 +2428,22 @@ visit_exec_list(exec_list *list, ir_visitor *visitor);
  */
 void validate_ir_tree(exec_list *instructions);
 
+struct hash_table;
+
+/**
+ * Validate only the functions who changed since the previous call with the
+ * same table (ir_function -> fingerprint), the instructions outside of the
+ * functions are always validated.  The fingerprint of a function covers his
+ * nodes, the variables they dereference, and the masks, operations and types
+ * the passes change in place.
+ *
+ * The fingerprints are a walk of the whole tree at each call, so a call
+ * still costs O(size of the program), only cheaper than the validation
+ * (about 6 times on a long unrolled shader).  Nothing is done without DEBUG.
+ */
+void validate_ir_tree_changed(exec_list *instructions,
+                              struct hash_table *fingerprints);
+
 struct _mesa_glsl_parse_state;
 struct gl_shader_program;
 
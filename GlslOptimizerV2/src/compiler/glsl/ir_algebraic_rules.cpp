@@ -0,0 +1,840 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_algebraic_rules.cpp
+ * Rewrite rules of do_algebraic, see ir_algebraic_rules.h.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir_algebraic_rules.h"
+#include "ir_hierarchical_visitor.h"
+#include "ir_optimization.h"
+#include "compiler/glsl_types.h"
+#include "util/hash_table.h"
+
+#define MAX_RULE_VARIABLES 4
+
+namespace {
+
+struct algebraic_rule {
+   unsigned group;
+   bool float_only; /**< only for the float operands */
+   const char *pattern;
+   const char *replacement;
+};
+
+/**
+ * The rules of a root operation are tried in this order.  A replacement
+ * must be cheaper than his pattern, and no rule may undo another.
+ */
+static const algebraic_rule algebraic_rules[] = {
+   /* inverse operations and repeated ones */
+   { ALGEBRAIC_RULES_BASIC,  false, "(neg (neg a))",                 "a" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(bit_not (bit_not a))",         "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(exp (log a))",                 "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(log (exp a))",                 "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(exp2 (log2 a))",               "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(log2 (exp2 a))",               "a" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(rcp (rcp a))",                 "a" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(rcp (rsq a))",                 "(sqrt a)" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(rcp (sqrt a))",                "(rsq a)" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(rcp (exp2 a))",                "(exp2 (neg a))" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(rcp (exp a))",                 "(exp (neg a))" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(mul (neg a) (neg b))",         "(mul a b)" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(neg (sub a b))",               "(sub b a)" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(min a a)",                     "a" },
+   { ALGEBRAIC_RULES_BASIC,  false, "(max a a)",                     "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(saturate (saturate a))",       "(saturate a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(floor (floor a))",             "(floor a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(floor (ceil a))",              "(ceil a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(ceil (ceil a))",               "(ceil a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(ceil (floor a))",              "(floor a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(trunc (trunc a))",             "(trunc a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(abs (mul a a))",               "(mul a a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(abs (dot a a))",               "(dot a a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(sqrt (mul a a))",              "(abs a)" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(mul (sqrt a) (sqrt a))",       "a" },
+   { ALGEBRAIC_RULES_BASIC,  true,  "(mul (rsq a) (rsq a))",         "(rcp a)" },
+
+   /* pow with a small constant exponent, 1, 2 and 4 are in opt_algebraic,
+    * and the same after POW_TO_EXP2
+    */
+   { ALGEBRAIC_RULES_POW,    true,  "(pow a 3.0)",                   "(mul (mul a a) a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(pow a 0.5)",                   "(sqrt a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(pow a -0.5)",                  "(rsq a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(pow a -1.0)",                  "(rcp a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(pow a -2.0)",                  "(rcp (mul a a))" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) 2.0))",     "(mul a a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) 3.0))",     "(mul (mul a a) a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) 4.0))",     "(mul (mul a a) (mul a a))" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) 0.5))",     "(sqrt a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) -0.5))",    "(rsq a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (neg (log2 a)))",         "(rcp a)" },
+   { ALGEBRAIC_RULES_POW,    true,  "(exp2 (mul (log2 a) -2.0))",    "(rcp (mul a a))" },
+
+   /* length, normalize and dot */
+   { ALGEBRAIC_RULES_LENGTH, true,  "(mul a@normalized (rsq (dot a a)))", "a" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(sqrt (dot a@normalized a))",   "1.0" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(mul (sqrt (dot a a)) (sqrt (dot a a)))", "(dot a a)" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(div a (sqrt (dot a a)))",      "(mul a (rsq (dot a a)))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(less (sqrt (dot a a)) (sqrt (dot b b)))", "(less (dot a a) (dot b b))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(gequal (sqrt (dot a a)) (sqrt (dot b b)))", "(gequal (dot a a) (dot b b))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(less (sqrt (dot a a)) b@pos)", "(less (dot a a) (mul b b))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(less b@pos (sqrt (dot a a)))", "(less (mul b b) (dot a a))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(gequal (sqrt (dot a a)) b@pos)", "(gequal (dot a a) (mul b b))" },
+   { ALGEBRAIC_RULES_LENGTH, true,  "(gequal b@pos (sqrt (dot a a)))", "(gequal (mul b b) (dot a a))" },
+
+   /* sin and cos of the same angle */
+   { ALGEBRAIC_RULES_TRIG,   true,  "(add (mul (sin a) (sin a)) (mul (cos a) (cos a)))", "1.0" },
+   { ALGEBRAIC_RULES_TRIG,   true,  "(sub (mul (cos a) (cos a)) (mul (sin a) (sin a)))", "(cos (mul a 2.0))" },
+   { ALGEBRAIC_RULES_TRIG,   true,  "(add (mul (cos a) (cos a)) (neg (mul (sin a) (sin a))))", "(cos (mul a 2.0))" },
+   { ALGEBRAIC_RULES_TRIG,   true,  "(mul (mul (sin a) (cos a)) 2.0)", "(sin (mul a 2.0))" },
+   { ALGEBRAIC_RULES_TRIG,   true,  "(cos (neg a))",                 "(cos a)" },
+   { ALGEBRAIC_RULES_TRIG,   true,  "(cos (abs a))",                 "(cos a)" },
+
+   /* multiply-add forms, like (x + 1.0) * 0.5 => x * 0.5 + 0.5 */
+   { ALGEBRAIC_RULES_MAD,    true,  "(mul (add a b@const) c@const)", "(add (mul a c) (mul b c))" },
+   { ALGEBRAIC_RULES_MAD,    true,  "(mul (sub a b@const) c@const)", "(sub (mul a c) (mul b c))" },
+   { ALGEBRAIC_RULES_MAD,    true,  "(mul (sub b@const a) c@const)", "(sub (mul b c) (mul a c))" },
+   { ALGEBRAIC_RULES_MAD,    true,  "(add (mul a (sub 1.0 c)) (mul b c))", "(lrp a b c)" },
+   { ALGEBRAIC_RULES_MAD,    true,  "(add (mul a (add 1.0 (neg c))) (mul b c))", "(lrp a b c)" },
+   { ALGEBRAIC_RULES_MAD,    true,  "(add a (mul (sub b a) c))",     "(lrp a b c)" },
+};
+
+enum rule_node_kind {
+   RULE_NODE_EXPRESSION,
+   RULE_NODE_VARIABLE,
+   RULE_NODE_CONSTANT,
+};
+
+enum rule_condition {
+   RULE_COND_NONE,
+   RULE_COND_CONST,
+   RULE_COND_POS,
+   RULE_COND_NORMALIZED,
+};
+
+struct rule_node {
+   rule_node_kind kind;
+
+   ir_expression_operation op;
+   unsigned num_operands;
+   rule_node *operands[4];
+   int swap_bit;              /**< bit of the order of the operands, or -1 */
+
+   unsigned variable;
+   rule_condition condition;
+
+   double value;
+};
+
+struct compiled_rule {
+   const algebraic_rule *rule;
+   rule_node *pattern;
+   rule_node *replacement;
+   unsigned num_swaps;                /**< commutative nodes of the pattern */
+   unsigned uses[MAX_RULE_VARIABLES]; /**< of each letter in the replacement */
+   compiled_rule *next;               /**< with the same root operation */
+};
+
+static bool
+is_commutative(ir_expression_operation op)
+{
+   switch (op) {
+   case ir_binop_add:
+   case ir_binop_mul:
+   case ir_binop_dot:
+   case ir_binop_min:
+   case ir_binop_max:
+   case ir_binop_equal:
+   case ir_binop_nequal:
+   case ir_binop_all_equal:
+   case ir_binop_any_nequal:
+   case ir_binop_bit_and:
+   case ir_binop_bit_xor:
+   case ir_binop_bit_or:
+   case ir_binop_logic_and:
+   case ir_binop_logic_xor:
+   case ir_binop_logic_or:
+      return true;
+   default:
+      return false;
+   }
+}
+
+class rule_parser {
+public:
+   rule_parser(void *mem_ctx, const char *src)
+      : num_swaps(0), mem_ctx(mem_ctx), src(src)
+   {
+   }
+
+   rule_node *parse()
+   {
+      rule_node *node = parse_node();
+      skip_spaces();
+      return *this->src == '\0' ? node : NULL;
+   }
+
+   unsigned num_swaps;
+
+private:
+   void skip_spaces()
+   {
+      while (isspace(*this->src))
+         this->src++;
+   }
+
+   rule_node *parse_node();
+
+   void *mem_ctx;
+   const char *src;
+};
+
+rule_node *
+rule_parser::parse_node()
+{
+   rule_node *node = rzalloc(this->mem_ctx, rule_node);
+   node->swap_bit = -1;
+
+   skip_spaces();
+
+   if (*this->src == '(') {
+      this->src++;
+
+      char name[32];
+      unsigned len = 0;
+      while ((isalnum(*this->src) || *this->src == '_') && len + 1 < sizeof(name))
+         name[len++] = *this->src++;
+      name[len] = '\0';
+
+      int op = -1;
+      for (int i = 0; i <= int(ir_last_opcode); i++) {
+         if (strcmp(name, ir_expression_operation_enum_strings[i]) == 0) {
+            op = i;
+            break;
+         }
+      }
+      if (op < 0)
+         return NULL;
+
+      node->kind = RULE_NODE_EXPRESSION;
+      node->op = ir_expression_operation(op);
+
+      skip_spaces();
+      while (*this->src != ')') {
+         if (*this->src == '\0' || node->num_operands == 4)
+            return NULL;
+
+         node->operands[node->num_operands] = parse_node();
+         if (node->operands[node->num_operands] == NULL)
+            return NULL;
+         node->num_operands++;
+         skip_spaces();
+      }
+      this->src++;
+
+      if (node->num_operands != ir_expression::get_num_operands(node->op))
+         return NULL;
+
+      if (is_commutative(node->op))
+         node->swap_bit = this->num_swaps++;
+   } else if (*this->src >= 'a' && *this->src < 'a' + MAX_RULE_VARIABLES) {
+      node->kind = RULE_NODE_VARIABLE;
+      node->variable = *this->src++ - 'a';
+
+      if (*this->src == '@') {
+         this->src++;
+         if (strncmp(this->src, "const", 5) == 0) {
+            node->condition = RULE_COND_CONST;
+            this->src += 5;
+         } else if (strncmp(this->src, "pos", 3) == 0) {
+            node->condition = RULE_COND_POS;
+            this->src += 3;
+         } else if (strncmp(this->src, "normalized", 10) == 0) {
+            node->condition = RULE_COND_NORMALIZED;
+            this->src += 10;
+         } else {
+            return NULL;
+         }
+      }
+   } else {
+      char *end;
+      node->kind = RULE_NODE_CONSTANT;
+      node->value = strtod(this->src, &end);
+      if (end == this->src)
+         return NULL;
+      this->src = end;
+   }
+
+   return node;
+}
+
+static void
+count_uses(const rule_node *node, unsigned *uses)
+{
+   if (node->kind == RULE_NODE_VARIABLE)
+      uses[node->variable]++;
+
+   for (unsigned i = 0; i < node->num_operands; i++)
+      count_uses(node->operands[i], uses);
+}
+
+/**
+ * The rules parsed, once for all the shaders.
+ */
+class compiled_rules {
+public:
+   compiled_rules()
+   {
+      this->mem_ctx = ralloc_context(NULL);
+      memset(this->by_operation, 0, sizeof(this->by_operation));
+
+      compiled_rule *last[ir_last_opcode + 1] = { NULL };
+
+      for (unsigned i = 0; i < ARRAY_SIZE(algebraic_rules); i++) {
+         compiled_rule *rule = rzalloc(this->mem_ctx, compiled_rule);
+         if (!compile(&algebraic_rules[i], rule)) {
+            assert(!"bad rule in algebraic_rules");
+            continue;
+         }
+
+         const ir_expression_operation op = rule->pattern->op;
+         if (last[op] != NULL)
+            last[op]->next = rule;
+         else
+            this->by_operation[op] = rule;
+         last[op] = rule;
+      }
+
+      static const algebraic_rule normalize_rule =
+         { 0, true, "(mul a (rsq (dot a a)))", "a" };
+      bool ok = compile(&normalize_rule, &this->normalize);
+      assert(ok);
+      (void) ok;
+   }
+
+   ~compiled_rules()
+   {
+      ralloc_free(this->mem_ctx);
+   }
+
+   compiled_rule *by_operation[ir_last_opcode + 1];
+   compiled_rule normalize; /**< the value of normalize() */
+
+private:
+   bool compile(const algebraic_rule *src, compiled_rule *rule)
+   {
+      memset(rule, 0, sizeof(*rule));
+      rule->rule = src;
+
+      rule_parser pattern(this->mem_ctx, src->pattern);
+      rule->pattern = pattern.parse();
+      rule->num_swaps = pattern.num_swaps;
+
+      rule_parser replacement(this->mem_ctx, src->replacement);
+      rule->replacement = replacement.parse();
+
+      if (rule->pattern == NULL ||
+          rule->pattern->kind != RULE_NODE_EXPRESSION ||
+          rule->replacement == NULL)
+         return false;
+
+      /* all the letters of the replacement are bound by the pattern */
+      unsigned bound[MAX_RULE_VARIABLES] = { 0 };
+      count_uses(rule->pattern, bound);
+      count_uses(rule->replacement, rule->uses);
+      for (unsigned i = 0; i < MAX_RULE_VARIABLES; i++) {
+         if (rule->uses[i] != 0 && bound[i] == 0)
+            return false;
+      }
+
+      return true;
+   }
+
+   void *mem_ctx;
+};
+
+static const compiled_rules &
+get_compiled_rules()
+{
+   static const compiled_rules rules;
+   return rules;
+}
+
+class single_assignment_visitor : public ir_hierarchical_visitor {
+public:
+   single_assignment_visitor(struct hash_table *assignments)
+      : assignments(assignments)
+   {
+   }
+
+   void record(ir_variable *var, ir_assignment *assign)
+   {
+      if (var == NULL)
+         return;
+
+      struct hash_entry *entry =
+         _mesa_hash_table_search(this->assignments, var);
+      if (entry != NULL)
+         entry->data = NULL;
+      else
+         _mesa_hash_table_insert(this->assignments, var, assign);
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      const bool whole = ir->condition == NULL &&
+                         ir->whole_variable_written() != NULL;
+      record(ir->lhs->variable_referenced(), whole ? ir : NULL);
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      if (ir->return_deref != NULL)
+         record(ir->return_deref->variable_referenced(), NULL);
+
+      foreach_two_lists(formal_node, &ir->callee->parameters,
+                        actual_node, &ir->actual_parameters) {
+         ir_variable *formal = (ir_variable *) formal_node;
+         ir_rvalue *actual = (ir_rvalue *) actual_node;
+
+         if (formal->data.mode == ir_var_function_out ||
+             formal->data.mode == ir_var_function_inout)
+            record(actual->variable_referenced(), NULL);
+      }
+      return visit_continue_with_parent;
+   }
+
+   struct hash_table *assignments;
+};
+
+static bool
+is_positive_constant(ir_constant *c)
+{
+   if (!c->type->is_scalar() && !c->type->is_vector())
+      return false;
+
+   for (unsigned i = 0; i < c->type->vector_elements; i++) {
+      switch (c->type->base_type) {
+      case GLSL_TYPE_FLOAT:
+         if (!(c->value.f[i] >= 0.0f))
+            return false;
+         break;
+      case GLSL_TYPE_DOUBLE:
+         if (!(c->value.d[i] >= 0.0))
+            return false;
+         break;
+      case GLSL_TYPE_INT:
+         if (c->value.i[i] < 0)
+            return false;
+         break;
+      case GLSL_TYPE_UINT:
+         break;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static ir_constant *
+make_constant(const glsl_type *type, double value, void *mem_ctx)
+{
+   const unsigned n = type->vector_elements;
+
+   switch (type->base_type) {
+   case GLSL_TYPE_FLOAT:
+      return new(mem_ctx) ir_constant(float(value), n);
+   case GLSL_TYPE_DOUBLE:
+      return new(mem_ctx) ir_constant(value, n);
+   case GLSL_TYPE_INT:
+      return new(mem_ctx) ir_constant(int(value), n);
+   case GLSL_TYPE_UINT:
+      return new(mem_ctx) ir_constant(unsigned(value), n);
+   default:
+      return NULL;
+   }
+}
+
+/**
+ * The operands of a replacement can be of any type, reject the ones the
+ * operation does not accept.
+ */
+static bool
+valid_operands(ir_expression_operation op, ir_rvalue **operands)
+{
+   switch (op) {
+   case ir_binop_add:
+   case ir_binop_sub:
+   case ir_binop_mul:
+   case ir_binop_div:
+   case ir_binop_min:
+   case ir_binop_max:
+   case ir_binop_pow:
+      return operands[0]->type->base_type == operands[1]->type->base_type &&
+             (operands[0]->type->is_scalar() ||
+              operands[1]->type->is_scalar() ||
+              operands[0]->type == operands[1]->type);
+
+   case ir_binop_less:
+   case ir_binop_gequal:
+   case ir_binop_equal:
+   case ir_binop_nequal:
+   case ir_binop_dot:
+      return operands[0]->type == operands[1]->type;
+
+   case ir_triop_fma:
+      return operands[0]->type == operands[1]->type &&
+             operands[0]->type == operands[2]->type;
+
+   case ir_triop_lrp:
+      return operands[0]->type == operands[1]->type &&
+             (operands[2]->type == operands[0]->type ||
+              operands[2]->type == operands[0]->type->get_scalar_type());
+
+   default:
+      return true;
+   }
+}
+
+} /* unnamed namespace */
+
+/**
+ * The letters bound by a pattern, for one order of the operands of its
+ * commutative nodes.
+ */
+struct algebraic_rule_match {
+   algebraic_rule_match(ir_algebraic_rules *rules, unsigned swaps)
+      : rules(rules), swaps(swaps), num_deferred(0)
+   {
+      memset(this->variables, 0, sizeof(this->variables));
+      memset(this->used, 0, sizeof(this->used));
+   }
+
+   bool match_rule(const rule_node *pattern, ir_rvalue *ir);
+   bool match(const rule_node *node, ir_rvalue *ir);
+   bool check_condition(rule_condition condition, ir_rvalue *ir);
+   bool is_normalized(ir_rvalue *ir);
+
+   ir_rvalue *replace(const compiled_rule *rule, ir_expression *ir,
+                      ir_instruction *base_ir);
+   ir_rvalue *build(const rule_node *node, const glsl_type *type,
+                    void *mem_ctx);
+
+   ir_algebraic_rules *rules;
+   unsigned swaps;
+   ir_rvalue *variables[MAX_RULE_VARIABLES];
+   bool used[MAX_RULE_VARIABLES];
+
+   /** the rvalues to check for normalized, once all the tree matches */
+   ir_rvalue *deferred[MAX_RULE_VARIABLES];
+   unsigned num_deferred;
+};
+
+bool
+algebraic_rule_match::is_normalized(ir_rvalue *ir)
+{
+   ir_rvalue *value = ir;
+
+   ir_dereference_variable *deref = ir->as_dereference_variable();
+   if (deref != NULL) {
+      ir_assignment *assign = this->rules->single_assignment(deref->var);
+      if (assign == NULL)
+         return false;
+      value = assign->rhs;
+   }
+
+   const compiled_rule &normalize = get_compiled_rules().normalize;
+   for (unsigned swaps = 0; swaps < (1u << normalize.num_swaps); swaps++) {
+      algebraic_rule_match m(this->rules, swaps);
+      if (m.match_rule(normalize.pattern, value))
+         return true;
+   }
+
+   return false;
+}
+
+bool
+algebraic_rule_match::check_condition(rule_condition condition, ir_rvalue *ir)
+{
+   switch (condition) {
+   case RULE_COND_NONE:
+      return true;
+   case RULE_COND_CONST:
+      return ir->as_constant() != NULL;
+   case RULE_COND_POS:
+      return ir->as_constant() != NULL &&
+             is_positive_constant(ir->as_constant());
+   case RULE_COND_NORMALIZED:
+      /* may look for the assignments of all the program */
+      if (this->num_deferred == MAX_RULE_VARIABLES)
+         return false;
+      this->deferred[this->num_deferred++] = ir;
+      return true;
+   }
+
+   return false;
+}
+
+bool
+algebraic_rule_match::match_rule(const rule_node *pattern, ir_rvalue *ir)
+{
+   if (!match(pattern, ir))
+      return false;
+
+   for (unsigned i = 0; i < this->num_deferred; i++) {
+      if (!is_normalized(this->deferred[i]))
+         return false;
+   }
+   return true;
+}
+
+bool
+algebraic_rule_match::match(const rule_node *node, ir_rvalue *ir)
+{
+   /* Don't want to even think about matrices. */
+   if (ir->type->is_matrix())
+      return false;
+
+   switch (node->kind) {
+   case RULE_NODE_VARIABLE:
+      /* the swaps can bind a letter first where it has no condition */
+      if (!check_condition(node->condition, ir))
+         return false;
+
+      if (this->variables[node->variable] != NULL)
+         return this->variables[node->variable]->equals(ir);
+
+      this->variables[node->variable] = ir;
+      return true;
+
+   case RULE_NODE_CONSTANT: {
+      ir_constant *c = ir->as_constant();
+      if (c == NULL)
+         return false;
+
+      /* is_value() truncates the value for the integers */
+      if (!c->type->is_float() && !c->type->is_double() &&
+          node->value != double(int(node->value)))
+         return false;
+
+      return c->is_value(float(node->value), int(node->value));
+   }
+
+   case RULE_NODE_EXPRESSION: {
+      ir_expression *expr = ir->as_expression();
+      if (expr == NULL || expr->operation != node->op)
+         return false;
+
+      const bool swap = node->swap_bit >= 0 &&
+                        (this->swaps & (1u << node->swap_bit)) != 0;
+
+      for (unsigned i = 0; i < node->num_operands; i++) {
+         if (!match(node->operands[i], expr->operands[swap ? 1 - i : i]))
+            return false;
+      }
+      return true;
+   }
+   }
+
+   return false;
+}
+
+ir_rvalue *
+algebraic_rule_match::build(const rule_node *node, const glsl_type *type,
+                            void *mem_ctx)
+{
+   switch (node->kind) {
+   case RULE_NODE_VARIABLE: {
+      /* the matched tree is dropped, each part of it can be used once */
+      ir_rvalue *value = this->variables[node->variable];
+      if (this->used[node->variable])
+         return value->clone(mem_ctx, NULL);
+
+      this->used[node->variable] = true;
+      return value;
+   }
+
+   case RULE_NODE_CONSTANT:
+      return make_constant(type, node->value, mem_ctx);
+
+   case RULE_NODE_EXPRESSION: {
+      ir_rvalue *operands[4] = { NULL, NULL, NULL, NULL };
+      const glsl_type *operand_type = type;
+      bool found = false;
+
+      /* the constants take the type of the other operands */
+      for (unsigned i = 0; i < node->num_operands; i++) {
+         if (node->operands[i]->kind == RULE_NODE_CONSTANT)
+            continue;
+
+         operands[i] = build(node->operands[i], type, mem_ctx);
+         if (operands[i] == NULL)
+            return NULL;
+
+         if (!found) {
+            operand_type = operands[i]->type;
+            found = true;
+         }
+      }
+
+      bool constant = true;
+      for (unsigned i = 0; i < node->num_operands; i++) {
+         if (operands[i] == NULL) {
+            operands[i] = make_constant(operand_type, node->operands[i]->value,
+                                        mem_ctx);
+            if (operands[i] == NULL)
+               return NULL;
+         }
+         constant = constant && operands[i]->as_constant() != NULL;
+      }
+
+      if (!valid_operands(node->op, operands))
+         return NULL;
+
+      ir_expression *expr;
+      switch (node->num_operands) {
+      case 1:
+         expr = new(mem_ctx) ir_expression(node->op, operands[0]);
+         break;
+      case 2:
+         expr = new(mem_ctx) ir_expression(node->op, operands[0],
+                                           operands[1]);
+         break;
+      default:
+         expr = new(mem_ctx) ir_expression(node->op, operands[0],
+                                           operands[1], operands[2]);
+         break;
+      }
+
+      if (constant) {
+         ir_constant *folded = expr->constant_expression_value(mem_ctx);
+         if (folded != NULL)
+            return folded;
+      }
+      return expr;
+   }
+   }
+
+   return NULL;
+}
+
+ir_rvalue *
+algebraic_rule_match::replace(const compiled_rule *rule, ir_expression *ir,
+                              ir_instruction *base_ir)
+{
+   void *mem_ctx = ralloc_parent(ir);
+   ir_variable *temps[MAX_RULE_VARIABLES] = { NULL };
+   ir_assignment *inits[MAX_RULE_VARIABLES] = { NULL };
+
+   /* a value used more than once is computed once */
+   for (unsigned i = 0; i < MAX_RULE_VARIABLES; i++) {
+      ir_rvalue *value = this->variables[i];
+      if (rule->uses[i] < 2 || value->as_constant() != NULL ||
+          value->as_dereference_variable() != NULL ||
+          (value->as_swizzle() != NULL &&
+           value->as_swizzle()->val->as_dereference_variable() != NULL))
+         continue;
+
+      temps[i] = new(mem_ctx) ir_variable(value->type, "x", ir_var_temporary);
+      inits[i] = new(mem_ctx) ir_assignment(
+         new(mem_ctx) ir_dereference_variable(temps[i]), value);
+      this->variables[i] = new(mem_ctx) ir_dereference_variable(temps[i]);
+   }
+
+   ir_rvalue *result = build(rule->replacement, ir->type, mem_ctx);
+   if (result == NULL)
+      return NULL;
+
+   /* a scalar is swizzled to the vector by do_algebraic */
+   if (result->type != ir->type &&
+       !(ir->type->is_vector() &&
+         result->type == ir->type->get_scalar_type()))
+      return NULL;
+
+   for (unsigned i = 0; i < MAX_RULE_VARIABLES; i++) {
+      if (temps[i] != NULL) {
+         base_ir->insert_before(temps[i]);
+         base_ir->insert_before(inits[i]);
+      }
+   }
+
+   return result;
+}
+
+ir_algebraic_rules::ir_algebraic_rules(exec_list *instructions,
+                                       unsigned groups)
+   : instructions(instructions), groups(groups), assignments(NULL)
+{
+}
+
+ir_algebraic_rules::~ir_algebraic_rules()
+{
+   if (this->assignments != NULL)
+      _mesa_hash_table_destroy(this->assignments, NULL);
+}
+
+ir_assignment *
+ir_algebraic_rules::single_assignment(const ir_variable *var)
+{
+   if (var->data.mode != ir_var_auto && var->data.mode != ir_var_temporary)
+      return NULL;
+
+   if (this->assignments == NULL) {
+      this->assignments = _mesa_pointer_hash_table_create(NULL);
+
+      single_assignment_visitor v(this->assignments);
+      visit_list_elements(&v, this->instructions);
+   }
+
+   struct hash_entry *entry = _mesa_hash_table_search(this->assignments, var);
+   return entry != NULL ? (ir_assignment *) entry->data : NULL;
+}
+
+ir_rvalue *
+ir_algebraic_rules::apply(ir_expression *ir, ir_instruction *base_ir)
+{
+   if (this->groups == 0)
+      return NULL;
+
+   const compiled_rules &table = get_compiled_rules();
+
+   for (const compiled_rule *rule = table.by_operation[ir->operation];
+        rule != NULL; rule = rule->next) {
+      if ((rule->rule->group & this->groups) == 0 ||
+          (rule->rule->float_only && !ir->operands[0]->type->is_float()))
+         continue;
+
+      for (unsigned swaps = 0; swaps < (1u << rule->num_swaps); swaps++) {
+         algebraic_rule_match m(this, swaps);
+         if (!m.match_rule(rule->pattern, ir))
+            continue;
+
+         ir_rvalue *result = m.replace(rule, ir, base_ir);
+         if (result != NULL)
+            return result;
+         break;
+      }
+   }
+
+   return NULL;
+}
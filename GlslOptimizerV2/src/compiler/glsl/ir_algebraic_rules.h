@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_algebraic_rules.h
+ * Table of the rewrite rules of do_algebraic.
+ *
+ * A rule is a pattern and a replacement written as s-expressions, with the
+ * names of ir_expression_operation_enum_strings :
+ *
+ *    (pow a 3.0)                     =>  (mul (mul a a) a)
+ *
+ * In the pattern, a to d match any rvalue, and the same letter twice must
+ * match equal rvalues.  A letter can have a condition : a@const for a
+ * constant, a@pos for a constant with no negative component, a@normalized
+ * for the value of normalize(), even through a temporary written once.  A
+ * number matches a constant with all its components equal to it.  The
+ * operands of the commutative operations match in both orders.
+ *
+ * In the replacement, a number is a constant of the type of the other
+ * operands, an expression of constants is folded, and a letter used more
+ * than once, if not a constant or a variable, goes first in a temporary.
+ *
+ * The table is parsed on the first use, into patterns sorted by the
+ * operation at their root.  The rules are in groups, ALGEBRAIC_RULES_* of
+ * ir_optimization.h, to enable them per target.
+ */
+
+#ifndef GLSL_IR_ALGEBRAIC_RULES_H
+#define GLSL_IR_ALGEBRAIC_RULES_H
+
+#include "ir.h"
+
+struct hash_table;
+
+class ir_algebraic_rules {
+public:
+   ir_algebraic_rules(exec_list *instructions, unsigned groups);
+   ~ir_algebraic_rules();
+
+   /**
+    * The replacement of the first rule who matches ir, or NULL.  The
+    * temporaries it needs are inserted before base_ir.
+    */
+   ir_rvalue *apply(ir_expression *ir, ir_instruction *base_ir);
+
+private:
+   friend struct algebraic_rule_match;
+
+   ir_assignment *single_assignment(const ir_variable *var);
+
+   exec_list *instructions;
+   unsigned groups;
+
+   /** variable -> his only assignment, NULL if more, built on the first need */
+   struct hash_table *assignments;
+};
+
+#endif /* GLSL_IR_ALGEBRAIC_RULES_H */
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_def_use.cpp
+ *
+ * The lists of an entry are unordered : each deref or assignment has his
+ * index in his list, a removal moves the last element of the list to his
+ * place.  An entry neither declared nor referenced is released.
+ */
+
+#include "ir_def_use.h"
+#include "ir_hierarchical_visitor.h"
+#include "util/hash_table.h"
+
+class ir_def_use_visitor : public ir_hierarchical_visitor {
+public:
+   ir_def_use_visitor(ir_def_use *index, bool adding)
+      : index(index), adding(adding)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      ir_def_use_entry *entry = this->index->get_or_create(var);
+      entry->declaration = this->adding;
+      if (!this->adding)
+         this->index->release(entry);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      ir_def_use_entry *entry = this->index->get_or_create(ir->var);
+      if (this->adding) {
+         this->index->append(&entry->derefs, ir);
+      } else {
+         this->index->erase(&entry->derefs, ir);
+         this->index->release(entry);
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_function_signature *ir)
+   {
+      /* the parameters are not declarations */
+      visit_list_elements(this, &ir->body);
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_leave(ir_assignment *ir)
+   {
+      ir_def_use_entry *entry =
+         this->index->get_or_create(ir->lhs->variable_referenced());
+      if (this->adding) {
+         this->index->append(&entry->assignments, ir);
+      } else {
+         this->index->erase(&entry->assignments, ir);
+         this->index->release(entry);
+      }
+      return visit_continue;
+   }
+
+   ir_def_use *index;
+   bool adding;
+};
+
+ir_def_use::ir_def_use(exec_list *instructions)
+{
+   this->mem_ctx = ralloc_context(NULL);
+   this->entries = _mesa_pointer_hash_table_create(this->mem_ctx);
+   this->positions = _mesa_pointer_hash_table_create(this->mem_ctx);
+
+   ir_def_use_visitor v(this, true);
+   v.run(instructions);
+}
+
+ir_def_use::~ir_def_use()
+{
+   ralloc_free(this->mem_ctx);
+}
+
+ir_def_use_entry *
+ir_def_use::get(const ir_variable *var) const
+{
+   struct hash_entry *entry = _mesa_hash_table_search(this->entries, var);
+   return entry ? (ir_def_use_entry *) entry->data : NULL;
+}
+
+ir_def_use_entry *
+ir_def_use::get_or_create(ir_variable *var)
+{
+   assert(var);
+
+   struct hash_entry *e = _mesa_hash_table_search(this->entries, var);
+   if (e)
+      return (ir_def_use_entry *) e->data;
+
+   ir_def_use_entry *entry = ralloc(this->mem_ctx, ir_def_use_entry);
+   entry->var = var;
+   entry->declaration = false;
+   util_dynarray_init(&entry->derefs, entry);
+   util_dynarray_init(&entry->assignments, entry);
+   _mesa_hash_table_insert(this->entries, var, entry);
+
+   return entry;
+}
+
+void
+ir_def_use::append(struct util_dynarray *list, ir_instruction *ir)
+{
+   _mesa_hash_table_insert(this->positions, ir, (void *) (uintptr_t)
+      util_dynarray_num_elements(list, ir_instruction *));
+   util_dynarray_append(list, ir_instruction *, ir);
+}
+
+void
+ir_def_use::erase(struct util_dynarray *list, ir_instruction *ir)
+{
+   struct hash_entry *e = _mesa_hash_table_search(this->positions, ir);
+   assert(e);
+   if (!e)
+      return;
+
+   const unsigned position = (unsigned) (uintptr_t) e->data;
+   _mesa_hash_table_remove(this->positions, e);
+
+   ir_instruction *last = util_dynarray_pop(list, ir_instruction *);
+   if (last != ir) {
+      *util_dynarray_element(list, ir_instruction *, position) = last;
+      _mesa_hash_table_insert(this->positions, last,
+                              (void *) (uintptr_t) position);
+   }
+}
+
+void
+ir_def_use::release(ir_def_use_entry *entry)
+{
+   if (entry->declaration || entry->referenced_count() != 0 ||
+       entry->assigned_count() != 0)
+      return;
+
+   _mesa_hash_table_remove_key(this->entries, entry->var);
+   ralloc_free(entry);
+}
+
+void
+ir_def_use::add(ir_instruction *ir)
+{
+   ir_def_use_visitor v(this, true);
+   ir->accept(&v);
+}
+
+void
+ir_def_use::remove(ir_instruction *ir)
+{
+   ir_def_use_visitor v(this, false);
+   ir->accept(&v);
+}
+
+bool
+ir_def_use::check(exec_list *instructions) const
+{
+   ir_def_use fresh(instructions);
+
+   if (fresh.entries->entries != this->entries->entries)
+      return false;
+
+   hash_table_foreach(fresh.entries, e) {
+      const ir_def_use_entry *a = (const ir_def_use_entry *) e->data;
+      const ir_def_use_entry *b = get(a->var);
+
+      if (b == NULL || a->declaration != b->declaration ||
+          a->referenced_count() != b->referenced_count() ||
+          a->assigned_count() != b->assigned_count())
+         return false;
+   }
+
+   return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_def_use.h
+ * Index of the references of each variable, kept from a pass to the next.
+ *
+ * It counts like ir_variable_refcount_visitor : each ir_dereference_variable
+ * is a reference, the ones of the lhs too, each ir_assignment is a write of
+ * the variable of his lhs, and the parameters of a signature are not
+ * declarations.  So the queries cost the count of references of the
+ * variable, not a walk of the program.
+ *
+ * A pass who keeps the index updates it with add() and remove() around the
+ * trees he inserts or removes.  Any other pass who made progress makes it
+ * invalid, the owner drops it and builds it again when needed.
+ */
+
+#ifndef GLSL_IR_DEF_USE_H
+#define GLSL_IR_DEF_USE_H
+
+#include "ir.h"
+#include "util/u_dynarray.h"
+
+struct hash_table;
+
+class ir_def_use_entry {
+public:
+   ir_variable *var;
+   bool declaration;                 /**< declared in the instruction stream */
+   struct util_dynarray derefs;      /**< ir_dereference_variable *, unordered */
+   struct util_dynarray assignments; /**< ir_assignment *, unordered */
+
+   unsigned referenced_count() const
+   {
+      return util_dynarray_num_elements(&this->derefs, ir_dereference_variable *);
+   }
+
+   unsigned assigned_count() const
+   {
+      return util_dynarray_num_elements(&this->assignments, ir_assignment *);
+   }
+};
+
+class ir_def_use {
+public:
+   ir_def_use(exec_list *instructions);
+   ~ir_def_use();
+
+   /** NULL if the variable is neither declared nor referenced */
+   ir_def_use_entry *get(const ir_variable *var) const;
+
+   /** Account the declarations, references and writes of the tree */
+   void add(ir_instruction *ir);
+
+   /** Forget them, the tree is removed or moved */
+   void remove(ir_instruction *ir);
+
+   /** Same counts as a new walk, for the DEBUG builds */
+   bool check(exec_list *instructions) const;
+
+   struct hash_table *entries; /**< ir_variable -> ir_def_use_entry */
+
+private:
+   friend class ir_def_use_visitor;
+
+   ir_def_use_entry *get_or_create(ir_variable *var);
+   void append(struct util_dynarray *list, ir_instruction *ir);
+   void erase(struct util_dynarray *list, ir_instruction *ir);
+   void release(ir_def_use_entry *entry);
+
+   void *mem_ctx;
+   struct hash_table *positions; /**< deref or assignment -> index in his list */
+};
+
+#endif /* GLSL_IR_DEF_USE_H */
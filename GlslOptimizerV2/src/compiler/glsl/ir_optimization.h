@@ -32,6 +32,8 @@
 
 struct gl_linked_shader;
 struct gl_shader_program;
+class ir_def_use;
+class ir_value_range;
 
 /* Operations for lower_instructions() */
 #define SUB_TO_ADD_NEG     0x01
@@ -65,6 +67,18 @@ struct gl_shader_program;
 #define DIV64                     (1U << 2)
 #define MOD64                     (1U << 3)
 
+/* Groups of rules of do_algebraic, see ir_algebraic_rules.cpp */
+#define ALGEBRAIC_RULES_BASIC     (1U << 0)
+#define ALGEBRAIC_RULES_POW       (1U << 1)
+#define ALGEBRAIC_RULES_LENGTH    (1U << 2)
+#define ALGEBRAIC_RULES_TRIG      (1U << 3)
+#define ALGEBRAIC_RULES_MAD       (1U << 4)
+#define ALGEBRAIC_RULES_ALL       0x1f
+/* TRIG and MAD change the float results, they are asked like fast_math */
+#define ALGEBRAIC_RULES_DEFAULT   (ALGEBRAIC_RULES_BASIC | \
+                                   ALGEBRAIC_RULES_POW | \
+                                   ALGEBRAIC_RULES_LENGTH)
+
 /**
  * \see class lower_packing_builtins_visitor
  */
@@ -99,7 +113,10 @@ bool ir_constant_fold(ir_rvalue **rvalue);
 
 bool do_rebalance_tree(exec_list *instructions);
 bool do_algebraic(exec_list *instructions, bool native_integers,
-                  const struct gl_shader_compiler_options *options);
+                  const struct gl_shader_compiler_options *options,
+                  ir_value_range *ranges = NULL,
+                  unsigned rules = ALGEBRAIC_RULES_DEFAULT,
+                  bool fast_math = false);
 bool opt_conditional_discard(exec_list *instructions);
 bool do_constant_folding(exec_list *instructions);
 bool do_constant_variable(exec_list *instructions);
@@ -111,11 +128,14 @@ void do_dead_builtin_varyings(struct gl_context *ctx,
                               gl_linked_shader *consumer,
                               unsigned num_tfeedback_decls,
                               class tfeedback_decl *tfeedback_decls);
-bool do_dead_code(exec_list *instructions, bool uniform_locations_assigned);
-bool do_dead_code_local(exec_list *instructions);
+bool do_dead_code(exec_list *instructions, bool uniform_locations_assigned,
+                  ir_def_use *def_use = NULL);
+bool do_dead_code_local(exec_list *instructions, ir_def_use *def_use = NULL);
 bool do_dead_code_unlinked(exec_list *instructions);
+bool do_dead_store_elimination(exec_list *instructions);
 bool do_dead_functions(exec_list *instructions, const char *vEntryFunc = "main");
 bool opt_flip_matrices(exec_list *instructions);
+bool do_extract_preshader(exec_list *instructions, exec_list *preshader);
 bool do_function_inlining(exec_list *instructions);
 bool do_lower_jumps(exec_list *instructions, bool pull_out_jumps = true, bool lower_sub_return = true, bool lower_main_return = false, bool lower_continue = false, bool lower_break = false);
 bool do_lower_texture_projection(exec_list *instructions);
@@ -123,13 +143,14 @@ bool do_if_simplification(exec_list *instructions);
 bool opt_flatten_nested_if_blocks(exec_list *instructions);
 bool do_discard_simplification(exec_list *instructions);
 bool lower_if_to_cond_assign(gl_shader_stage stage, exec_list *instructions,
-                             unsigned max_depth = 0, unsigned min_branch_cost = 0);
+                             unsigned max_depth = 0, unsigned min_branch_cost = 0,
+                             unsigned branch_cost = 0);
 bool do_mat_op_to_vec(exec_list *instructions);
-bool do_minmax_prune(exec_list *instructions);
+bool do_minmax_prune(exec_list *instructions, ir_value_range *ranges = NULL);
 bool do_structure_splitting(exec_list *instructions);
 bool optimize_swizzles(exec_list *instructions);
 bool do_vectorize(exec_list *instructions);
-bool do_tree_grafting(exec_list *instructions);
+bool do_tree_grafting(exec_list *instructions, ir_def_use *def_use = NULL);
 bool do_vec_index_to_cond_assign(exec_list *instructions);
 bool do_vec_index_to_swizzle(exec_list *instructions);
 bool lower_discard(exec_list *instructions);
@@ -138,7 +159,8 @@ bool lower_instructions(exec_list *instructions, unsigned what_to_lower);
 bool lower_noise(exec_list *instructions);
 bool lower_variable_index_to_cond_assign(gl_shader_stage stage,
     exec_list *instructions, bool lower_input, bool lower_output,
-    bool lower_temp, bool lower_uniform);
+    bool lower_temp, bool lower_uniform, unsigned linear_max_length = 4,
+    unsigned max_length = 0);
 bool lower_quadop_vector(exec_list *instructions, bool dont_lower_swz);
 bool lower_const_arrays_to_uniforms(exec_list *instructions, unsigned stage, unsigned max_uniform_components);
 bool lower_clip_cull_distance(struct gl_shader_program *prog,
@@ -0,0 +1,589 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_reassociate.cpp
+ * Fast-math reassociation of the float chains, see ir_reassociate.h.
+ */
+
+#include <string.h>
+#include "ir_reassociate.h"
+#include "ir_builder.h"
+#include "compiler/glsl_types.h"
+
+using namespace ir_builder;
+
+#define MAX_CHAIN_TERMS 16
+#define MAX_TERM_FACTORS 8
+#define MAX_FACTOR_DEPTH 2
+
+namespace {
+
+struct chain_term {
+   ir_constant *coefficient; /**< NULL for 1.0 */
+   ir_rvalue *factors[MAX_TERM_FACTORS];
+   unsigned num_factors;
+
+   /** cost of the sums taken out as a factor, see chain_builder::factor_out */
+   unsigned nested_operations;
+   unsigned nested_instructions;
+};
+
+struct chain_sum {
+   chain_term terms[MAX_CHAIN_TERMS];
+   unsigned num_terms;
+};
+
+/**
+ * The operations count each add, sub and mul, the instructions count a mul
+ * followed by an add as one mad.  A neg is free, as a source modifier.
+ */
+struct chain_cost {
+   unsigned operations;
+   unsigned instructions;
+};
+
+class chain_builder {
+public:
+   chain_builder(void *mem_ctx)
+      : mem_ctx(mem_ctx), operations(0)
+   {
+   }
+
+   bool collect_sum(ir_rvalue *ir, ir_constant *coefficient, chain_sum *sum);
+   bool collect_product(ir_rvalue *ir, chain_term *term);
+   void simplify(chain_sum *sum, unsigned depth);
+   chain_cost sum_cost(const chain_sum *sum) const;
+   ir_rvalue *build(const chain_sum *sum);
+
+   void *mem_ctx;
+
+   /** operations of the chain as it was read */
+   unsigned operations;
+
+private:
+   bool factor_out(chain_sum *sum, unsigned depth);
+   bool split(const chain_sum *sum, ir_rvalue *factor, ir_constant *coefficient,
+              unsigned depth, chain_sum *rest, chain_sum *inner);
+   ir_rvalue *build_term(const chain_term *term, bool *negate);
+
+   ir_constant *fold(ir_expression_operation op, ir_constant *a,
+                     ir_constant *b = NULL);
+   ir_constant *neg_coefficient(ir_constant *c);
+   ir_constant *mul_coefficients(ir_constant *a, ir_constant *b);
+   ir_constant *add_coefficients(ir_constant *a, ir_constant *b);
+};
+
+} /* unnamed namespace */
+
+/**
+ * An add, sub, neg or mul on float scalars or vectors.  The matrices are
+ * left alone, their mul does not commute.
+ */
+static bool
+is_float_chain(ir_rvalue *ir)
+{
+   ir_expression *expr = ir->as_expression();
+   if (expr == NULL)
+      return false;
+
+   switch (expr->operation) {
+   case ir_binop_add:
+   case ir_binop_sub:
+   case ir_binop_mul:
+   case ir_unop_neg:
+      break;
+   default:
+      return false;
+   }
+
+   if (expr->type->base_type != GLSL_TYPE_FLOAT || expr->type->is_matrix())
+      return false;
+
+   for (unsigned i = 0; i < expr->num_operands; i++) {
+      const glsl_type *type = expr->operands[i]->type;
+      if (type->base_type != GLSL_TYPE_FLOAT || type->is_matrix())
+         return false;
+   }
+
+   return true;
+}
+
+static bool
+is_negative(const ir_constant *c)
+{
+   for (unsigned i = 0; i < c->type->components(); i++) {
+      if (!(c->get_float_component(i) < 0.0f))
+         return false;
+   }
+   return true;
+}
+
+/** Same factors in any order */
+static bool
+same_factors(const chain_term *a, const chain_term *b)
+{
+   if (a->num_factors != b->num_factors)
+      return false;
+
+   bool used[MAX_TERM_FACTORS] = { false };
+   for (unsigned i = 0; i < a->num_factors; i++) {
+      unsigned j;
+      for (j = 0; j < b->num_factors; j++) {
+         if (!used[j] && b->factors[j]->equals(a->factors[i]))
+            break;
+      }
+      if (j == b->num_factors)
+         return false;
+      used[j] = true;
+   }
+   return true;
+}
+
+static unsigned
+term_muls(const chain_term *term)
+{
+   if (term->num_factors == 0)
+      return 0;
+
+   unsigned muls = term->num_factors - 1;
+   if (term->coefficient != NULL && !term->coefficient->is_negative_one())
+      muls++;
+   return muls;
+}
+
+ir_constant *
+chain_builder::fold(ir_expression_operation op, ir_constant *a, ir_constant *b)
+{
+   ir_expression *expr = b == NULL
+      ? new(mem_ctx) ir_expression(op, a->clone(mem_ctx, NULL))
+      : new(mem_ctx) ir_expression(op, a->clone(mem_ctx, NULL),
+                                   b->clone(mem_ctx, NULL));
+   return expr->constant_expression_value(mem_ctx);
+}
+
+ir_constant *
+chain_builder::neg_coefficient(ir_constant *c)
+{
+   return c == NULL ? new(mem_ctx) ir_constant(-1.0f) : fold(ir_unop_neg, c);
+}
+
+ir_constant *
+chain_builder::mul_coefficients(ir_constant *a, ir_constant *b)
+{
+   if (a == NULL)
+      return b;
+   if (b == NULL)
+      return a;
+   return fold(ir_binop_mul, a, b);
+}
+
+ir_constant *
+chain_builder::add_coefficients(ir_constant *a, ir_constant *b)
+{
+   return fold(ir_binop_add,
+               a != NULL ? a : new(mem_ctx) ir_constant(1.0f),
+               b != NULL ? b : new(mem_ctx) ir_constant(1.0f));
+}
+
+/**
+ * Appends the terms of ir times coefficient to sum.  False if the chain is
+ * too long, then nothing is done.
+ */
+bool
+chain_builder::collect_sum(ir_rvalue *ir, ir_constant *coefficient,
+                           chain_sum *sum)
+{
+   if (is_float_chain(ir)) {
+      ir_expression *expr = ir->as_expression();
+
+      switch (expr->operation) {
+      case ir_binop_add:
+         this->operations++;
+         return collect_sum(expr->operands[0], coefficient, sum) &&
+                collect_sum(expr->operands[1], coefficient, sum);
+      case ir_binop_sub:
+         this->operations++;
+         return collect_sum(expr->operands[0], coefficient, sum) &&
+                collect_sum(expr->operands[1], neg_coefficient(coefficient),
+                            sum);
+      case ir_unop_neg:
+         return collect_sum(expr->operands[0], neg_coefficient(coefficient),
+                            sum);
+      default:
+         break;
+      }
+   }
+
+   if (sum->num_terms == MAX_CHAIN_TERMS)
+      return false;
+
+   chain_term *term = &sum->terms[sum->num_terms];
+   memset(term, 0, sizeof(*term));
+   term->coefficient = coefficient;
+   if (!collect_product(ir, term))
+      return false;
+
+   /* A constant times a sum is distributed, (x + 1.0) * 2.0 => x * 2.0 + 2.0,
+    * for its constant to meet the others.
+    */
+   if (term->num_factors == 1 && is_float_chain(term->factors[0]))
+      return collect_sum(term->factors[0], term->coefficient, sum);
+
+   sum->num_terms++;
+   return true;
+}
+
+bool
+chain_builder::collect_product(ir_rvalue *ir, chain_term *term)
+{
+   if (is_float_chain(ir)) {
+      ir_expression *expr = ir->as_expression();
+
+      if (expr->operation == ir_binop_mul) {
+         this->operations++;
+         return collect_product(expr->operands[0], term) &&
+                collect_product(expr->operands[1], term);
+      }
+
+      if (expr->operation == ir_unop_neg) {
+         term->coefficient = neg_coefficient(term->coefficient);
+         return collect_product(expr->operands[0], term);
+      }
+   }
+
+   ir_constant *constant = ir->as_constant();
+   if (constant != NULL) {
+      term->coefficient = mul_coefficients(term->coefficient, constant);
+      return term->coefficient != NULL;
+   }
+
+   if (term->num_factors == MAX_TERM_FACTORS)
+      return false;
+
+   term->factors[term->num_factors++] = ir;
+   return true;
+}
+
+chain_cost
+chain_builder::sum_cost(const chain_sum *sum) const
+{
+   chain_cost cost = { 0, 0 };
+   unsigned products = 0;
+
+   for (unsigned i = 0; i < sum->num_terms; i++) {
+      const chain_term *term = &sum->terms[i];
+      const unsigned muls = term_muls(term);
+
+      cost.operations += muls + term->nested_operations;
+      cost.instructions += muls + term->nested_instructions;
+      if (muls > 0)
+         products++;
+   }
+
+   if (sum->num_terms > 1) {
+      const unsigned adds = sum->num_terms - 1;
+      cost.operations += adds;
+      cost.instructions += adds - MIN2(adds, products);
+   }
+
+   return cost;
+}
+
+/**
+ * Merges the constants and the terms with the same factors, then takes out
+ * the common factors.
+ */
+void
+chain_builder::simplify(chain_sum *sum, unsigned depth)
+{
+   unsigned count = 0;
+   for (unsigned i = 0; i < sum->num_terms; i++) {
+      const chain_term *term = &sum->terms[i];
+
+      unsigned j;
+      for (j = 0; j < count; j++) {
+         if (same_factors(&sum->terms[j], term))
+            break;
+      }
+
+      if (j < count) {
+         sum->terms[j].coefficient =
+            add_coefficients(sum->terms[j].coefficient, term->coefficient);
+      } else {
+         if (count != i)
+            sum->terms[count] = *term;
+         count++;
+      }
+   }
+
+   /* x - x is 0, ignoring the infinities and the NaN as fast-math does */
+   sum->num_terms = 0;
+   for (unsigned i = 0; i < count; i++) {
+      chain_term *term = &sum->terms[i];
+
+      if (term->coefficient != NULL) {
+         if (term->coefficient->is_zero())
+            continue;
+         if (term->coefficient->is_one() && term->num_factors > 0)
+            term->coefficient = NULL;
+      }
+
+      if (sum->num_terms != i)
+         sum->terms[sum->num_terms] = *term;
+      sum->num_terms++;
+   }
+
+   if (depth >= MAX_FACTOR_DEPTH)
+      return;
+
+   for (unsigned i = 0; i < MAX_CHAIN_TERMS; i++) {
+      if (!factor_out(sum, depth))
+         break;
+   }
+}
+
+/**
+ * Splits sum in the terms with the factor, or with the coefficient, who go
+ * in inner without it, and the others.  False if less than two have it.
+ */
+bool
+chain_builder::split(const chain_sum *sum, ir_rvalue *factor,
+                     ir_constant *coefficient, unsigned depth,
+                     chain_sum *rest, chain_sum *inner)
+{
+   rest->num_terms = 0;
+   inner->num_terms = 0;
+
+   for (unsigned i = 0; i < sum->num_terms; i++) {
+      const chain_term *term = &sum->terms[i];
+      chain_term stripped = *term;
+      bool found = false;
+
+      if (factor != NULL) {
+         for (unsigned f = 0; f < term->num_factors; f++) {
+            if (term->factors[f]->equals(factor)) {
+               memmove(&stripped.factors[f], &stripped.factors[f + 1],
+                       (term->num_factors - f - 1) * sizeof(ir_rvalue *));
+               stripped.num_factors--;
+               found = true;
+               break;
+            }
+         }
+      } else if (term->coefficient != NULL && term->num_factors > 0 &&
+                 term->coefficient->has_value(coefficient)) {
+         stripped.coefficient = NULL;
+         found = true;
+      }
+
+      if (found)
+         inner->terms[inner->num_terms++] = stripped;
+      else
+         rest->terms[rest->num_terms++] = *term;
+   }
+
+   if (inner->num_terms < 2)
+      return false;
+
+   simplify(inner, depth + 1);
+   return inner->num_terms > 0;
+}
+
+/**
+ * Takes out the factor or the coefficient common to several terms who saves
+ * the most operations, without adding instructions :
+ *
+ *    x * y * 2.0 + x * 3.0  =>  x * (y * 2.0 + 3.0)   (4 ops to 3, 3 instr to 2)
+ *    x * 2.0 + y * 2.0      =>  (x + y) * 2.0         (3 ops to 2, 2 instr to 2)
+ *
+ * x * y + x * z => x * (y + z) saves a mul too, for the same instructions.
+ */
+bool
+chain_builder::factor_out(chain_sum *sum, unsigned depth)
+{
+   const chain_cost cost = sum_cost(sum);
+   unsigned best_operations = cost.operations;
+   ir_rvalue *best_factor = NULL;
+   ir_constant *best_coefficient = NULL;
+
+   chain_sum rest, inner;
+
+   for (unsigned i = 0; i < sum->num_terms; i++) {
+      const chain_term *term = &sum->terms[i];
+
+      for (unsigned c = 0; c <= term->num_factors; c++) {
+         ir_rvalue *factor = NULL;
+         ir_constant *coefficient = NULL;
+
+         if (c < term->num_factors)
+            factor = term->factors[c];
+         else if (term->coefficient != NULL && term->num_factors > 0 &&
+                  !term->coefficient->is_negative_one())
+            coefficient = term->coefficient;
+         else
+            continue;
+
+         /* tried from an earlier term */
+         bool tried = false;
+         for (unsigned j = 0; j < i && !tried; j++) {
+            const chain_term *other = &sum->terms[j];
+            if (factor != NULL) {
+               for (unsigned f = 0; f < other->num_factors && !tried; f++)
+                  tried = other->factors[f]->equals(factor);
+            } else {
+               tried = other->coefficient != NULL && other->num_factors > 0 &&
+                       other->coefficient->has_value(coefficient);
+            }
+         }
+         if (tried)
+            continue;
+
+         if (!split(sum, factor, coefficient, depth, &rest, &inner))
+            continue;
+
+         const chain_cost inner_cost = sum_cost(&inner);
+         chain_term *term_out = &rest.terms[rest.num_terms++];
+         memset(term_out, 0, sizeof(*term_out));
+         term_out->coefficient = coefficient;
+         term_out->num_factors = factor != NULL ? 2 : 1;
+         term_out->nested_operations = inner_cost.operations;
+         term_out->nested_instructions = inner_cost.instructions;
+
+         const chain_cost factored = sum_cost(&rest);
+         if (factored.operations < best_operations &&
+             factored.instructions <= cost.instructions) {
+            best_operations = factored.operations;
+            best_factor = factor;
+            best_coefficient = coefficient;
+         }
+      }
+   }
+
+   if (best_factor == NULL && best_coefficient == NULL)
+      return false;
+
+   split(sum, best_factor, best_coefficient, depth, &rest, &inner);
+
+   const chain_cost inner_cost = sum_cost(&inner);
+   chain_term *term_out = &rest.terms[rest.num_terms++];
+   memset(term_out, 0, sizeof(*term_out));
+   term_out->coefficient = best_coefficient;
+   if (best_factor != NULL)
+      term_out->factors[term_out->num_factors++] = best_factor;
+   term_out->factors[term_out->num_factors++] = build(&inner);
+   term_out->nested_operations = inner_cost.operations;
+   term_out->nested_instructions = inner_cost.instructions;
+
+   *sum = rest;
+   return true;
+}
+
+/**
+ * The product of the term.  A coefficient of -1.0, or a negative constant,
+ * is returned positive with negate set, for a sub.
+ */
+ir_rvalue *
+chain_builder::build_term(const chain_term *term, bool *negate)
+{
+   *negate = false;
+
+   if (term->num_factors == 0) {
+      ir_constant *c = term->coefficient != NULL
+         ? term->coefficient->clone(mem_ctx, NULL)
+         : new(mem_ctx) ir_constant(1.0f);
+      if (is_negative(c)) {
+         *negate = true;
+         return fold(ir_unop_neg, c);
+      }
+      return c;
+   }
+
+   ir_rvalue *product = term->factors[0];
+   for (unsigned i = 1; i < term->num_factors; i++)
+      product = mul(product, term->factors[i]);
+
+   if (term->coefficient == NULL)
+      return product;
+
+   if (term->coefficient->is_negative_one()) {
+      *negate = true;
+      return product;
+   }
+
+   return mul(product, term->coefficient->clone(mem_ctx, NULL));
+}
+
+/**
+ * The sum, the terms without mul first, then the constant, then the
+ * products, each added by a mad.  NULL for an empty sum.
+ */
+ir_rvalue *
+chain_builder::build(const chain_sum *sum)
+{
+   ir_rvalue *result = NULL;
+
+   for (unsigned order = 0; order < 3; order++) {
+      for (unsigned i = 0; i < sum->num_terms; i++) {
+         const chain_term *term = &sum->terms[i];
+         const unsigned term_order =
+            term->num_factors == 0 ? 1 : (term_muls(term) == 0 ? 0 : 2);
+         if (term_order != order)
+            continue;
+
+         bool negate;
+         ir_rvalue *value = build_term(term, &negate);
+
+         if (result == NULL) {
+            if (negate) {
+               ir_constant *c = value->as_constant();
+               value = c != NULL ? (ir_rvalue *) fold(ir_unop_neg, c)
+                                 : neg(value);
+            }
+            result = value;
+         } else {
+            result = negate ? sub(result, value) : add(result, value);
+         }
+      }
+   }
+
+   return result;
+}
+
+ir_rvalue *
+reassociate_float_chain(ir_expression *ir)
+{
+   if (!is_float_chain(ir))
+      return NULL;
+
+   void *mem_ctx = ralloc_parent(ir);
+   chain_builder builder(mem_ctx);
+
+   chain_sum sum;
+   sum.num_terms = 0;
+   if (!builder.collect_sum(ir, NULL, &sum))
+      return NULL;
+
+   builder.simplify(&sum, 0);
+
+   /* only the operations, who don't change when do_rebalance_tree reorders
+    * the chain, else the two would undo each other forever
+    */
+   if (builder.sum_cost(&sum).operations >= builder.operations)
+      return NULL;
+
+   ir_rvalue *result = builder.build(&sum);
+   return result != NULL ? result : ir_constant::zero(mem_ctx, ir->type);
+}
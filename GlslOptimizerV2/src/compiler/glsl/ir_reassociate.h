@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_reassociate.h
+ * Fast-math reassociation of the float add and mul chains, for do_algebraic.
+ *
+ * A chain of add, sub, neg and mul on float scalars and vectors is read as a
+ * sum of terms, each a constant coefficient times a product of factors :
+ *
+ *    (x + 1.0) * 2.0 + y * x * 3.0 - 4.0 + x * y
+ *      =>  2.0 * (x) + 3.0 * (x y) + 1.0 * (x y) + 2.0 - 4.0
+ *
+ * The constants are gathered in one, the terms with the same factors are
+ * merged, and a factor or a coefficient common to several terms is taken
+ * out when it saves operations :
+ *
+ *      =>  x * 2.0 + x * y * 4.0 - 2.0
+ *      =>  -2.0 + x * (2.0 + y * 4.0)
+ *
+ * The sum is rebuilt with the products last, so each of them can be a mad.
+ *
+ * This changes the rounding, so it is opt-in, and do_algebraic never calls
+ * it in the trees assigned to a precise or invariant variable.
+ */
+
+#ifndef GLSL_IR_REASSOCIATE_H
+#define GLSL_IR_REASSOCIATE_H
+
+#include "ir.h"
+
+/**
+ * The chain at ir rebuilt with less operations, or NULL if ir is not a float
+ * chain or if nothing is saved.  The result can be a scalar for a vector ir.
+ */
+ir_rvalue *reassociate_float_chain(ir_expression *ir);
+
+#endif /* GLSL_IR_REASSOCIATE_H */
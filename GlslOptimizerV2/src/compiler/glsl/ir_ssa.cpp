@@ -0,0 +1,1153 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_ssa.cpp
+ *
+ * The IR is structured, so the dominator tree is the nesting of the blocks :
+ * the renaming walks the body in order, the versions of a branch are undone
+ * at his end, and the joins are the end of an ir_if and the header and the
+ * exit of an ir_loop.
+ *
+ * The conversion back computes the live variables backward on the body and
+ * records the interferences between the versions of a same variable.  The
+ * versions are renamed back in order when they interfere with none of the
+ * ones already renamed : the copies of a phi become copies of the variable
+ * to himself, and are removed.
+ */
+
+#include "ir_ssa.h"
+#include "ir_hierarchical_visitor.h"
+#include "compiler/glsl_types.h"
+#include "util/bitset.h"
+#include "util/hash_table.h"
+#include "util/set.h"
+#include "util/u_dynarray.h"
+
+namespace {
+
+bool
+is_eligible_type(const glsl_type *type)
+{
+   return type->is_scalar() || type->is_vector() || type->is_matrix();
+}
+
+/**
+ * Locals only written by unconditional assignments of the whole variable
+ */
+class ssa_eligible_visitor : public ir_hierarchical_visitor {
+public:
+   ssa_eligible_visitor()
+   {
+      this->eligible = _mesa_pointer_set_create(NULL);
+      util_dynarray_init(&this->declared, NULL);
+   }
+
+   ~ssa_eligible_visitor()
+   {
+      _mesa_set_destroy(this->eligible, NULL);
+      util_dynarray_fini(&this->declared);
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      if ((var->data.mode == ir_var_auto ||
+           var->data.mode == ir_var_temporary) &&
+          is_eligible_type(var->type)) {
+         _mesa_set_add(this->eligible, var);
+         util_dynarray_append(&this->declared, ir_variable *, var);
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      if (ir->condition != NULL || ir->whole_variable_written() == NULL)
+         reject(ir->lhs->variable_referenced());
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      foreach_two_lists(formal_node, &ir->callee->parameters,
+                        actual_node, &ir->actual_parameters) {
+         ir_variable *formal = (ir_variable *) formal_node;
+         ir_rvalue *actual = (ir_rvalue *) actual_node;
+
+         if (formal->data.mode == ir_var_function_out ||
+             formal->data.mode == ir_var_function_inout)
+            reject(actual->variable_referenced());
+      }
+
+      if (ir->return_deref != NULL)
+         reject(ir->return_deref->var);
+
+      return visit_continue;
+   }
+
+   void reject(ir_variable *var)
+   {
+      if (var != NULL)
+         _mesa_set_remove_key(this->eligible, var);
+   }
+
+   struct set *eligible;
+   struct util_dynarray declared; /**< ir_variable *, in order */
+};
+
+/**
+ * The eligible variables assigned in a loop, in order
+ */
+class ssa_assigned_visitor : public ir_hierarchical_visitor {
+public:
+   ssa_assigned_visitor(struct set *eligible)
+      : eligible(eligible)
+   {
+      this->seen = _mesa_pointer_set_create(NULL);
+      util_dynarray_init(&this->assigned, NULL);
+   }
+
+   ~ssa_assigned_visitor()
+   {
+      _mesa_set_destroy(this->seen, NULL);
+      util_dynarray_fini(&this->assigned);
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      ir_variable *var = ir->whole_variable_written();
+
+      if (var != NULL && _mesa_set_search(this->eligible, var) &&
+          !_mesa_set_search(this->seen, var)) {
+         _mesa_set_add(this->seen, var);
+         util_dynarray_append(&this->assigned, ir_variable *, var);
+      }
+
+      /* Only the lhs can be an assignment */
+      return visit_continue_with_parent;
+   }
+
+   struct set *eligible;
+   struct set *seen;
+   struct util_dynarray assigned;
+};
+
+class ssa_use_renamer : public ir_hierarchical_visitor {
+public:
+   ssa_use_renamer(struct hash_table *currents)
+      : currents(currents)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(this->currents, ir->var);
+      if (entry != NULL)
+         ir->var = (ir_variable *) entry->data;
+      return visit_continue;
+   }
+
+   struct hash_table *currents;
+};
+
+struct ssa_change {
+   ir_variable *var;
+   ir_variable *version; /**< in the log, the previous one, NULL if none */
+};
+
+struct ssa_loop_break {
+   ir_loop_jump *jump;
+   ir_variable *value;
+};
+
+struct ssa_loop_entry {
+   ir_variable *var;
+   ir_variable *header;
+   struct util_dynarray breaks; /**< ssa_loop_break */
+};
+
+struct ssa_loop_frame {
+   ssa_loop_frame *outer;
+   ir_loop *loop;
+   struct util_dynarray entries; /**< ssa_loop_entry */
+   bool has_break;
+};
+
+class ssa_builder {
+public:
+   ssa_builder(ir_ssa *ssa, ir_function_signature *sig);
+   ~ssa_builder();
+
+   bool run();
+
+private:
+   ir_variable *current(ir_variable *var);
+   void set_current(ir_variable *var, ir_variable *version);
+   void undo(unsigned mark);
+   void changes_since(unsigned mark, struct util_dynarray *changes);
+   ir_variable *new_version(ir_variable *var, ir_ssa_value_kind kind,
+                            ir_assignment *def, ir_instruction *join);
+   ir_assignment *copy(ir_variable *to, ir_variable *from);
+   void join(ir_if *ir, ir_variable *var, ir_variable *then_value,
+             ir_variable *else_value, bool then_falls, bool else_falls);
+
+   void rename_uses(ir_instruction *ir);
+   void rename_assignment(ir_assignment *ir);
+   void rename_jump(ir_loop_jump *ir);
+   bool rename_if(ir_if *ir);
+   bool rename_loop(ir_loop *ir);
+   bool rename_list(exec_list *list);
+
+   ir_ssa *ssa;
+   ir_function_signature *sig;
+   void *mem_ctx;
+   ssa_eligible_visitor eligible;
+   struct hash_table *currents; /**< eligible variable -> current version */
+   ssa_use_renamer renamer;
+   struct util_dynarray log;    /**< ssa_change, undone at the end of a block */
+   ssa_loop_frame *loop;
+   bool progress;
+};
+
+ssa_builder::ssa_builder(ir_ssa *ssa, ir_function_signature *sig)
+   : ssa(ssa), sig(sig), mem_ctx(ralloc_parent(sig)),
+     currents(_mesa_pointer_hash_table_create(NULL)), renamer(currents),
+     loop(NULL), progress(false)
+{
+   util_dynarray_init(&this->log, NULL);
+}
+
+ssa_builder::~ssa_builder()
+{
+   _mesa_hash_table_destroy(this->currents, NULL);
+   util_dynarray_fini(&this->log);
+}
+
+ir_variable *
+ssa_builder::current(ir_variable *var)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(this->currents, var);
+   return entry ? (ir_variable *) entry->data : var;
+}
+
+void
+ssa_builder::set_current(ir_variable *var, ir_variable *version)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(this->currents, var);
+   ssa_change change = { var, entry ? (ir_variable *) entry->data : NULL };
+
+   util_dynarray_append(&this->log, ssa_change, change);
+   if (entry != NULL)
+      entry->data = version;
+   else
+      _mesa_hash_table_insert(this->currents, var, version);
+}
+
+void
+ssa_builder::undo(unsigned mark)
+{
+   while (util_dynarray_num_elements(&this->log, ssa_change) > mark) {
+      ssa_change change = util_dynarray_pop(&this->log, ssa_change);
+
+      if (change.version != NULL) {
+         _mesa_hash_table_insert(this->currents, change.var, change.version);
+      } else {
+         struct hash_entry *entry =
+            _mesa_hash_table_search(this->currents, change.var);
+         _mesa_hash_table_remove(this->currents, entry);
+      }
+   }
+}
+
+/* The variables changed since the mark with their current version, once */
+void
+ssa_builder::changes_since(unsigned mark, struct util_dynarray *changes)
+{
+   const unsigned count = util_dynarray_num_elements(&this->log, ssa_change);
+   if (count == mark)
+      return;
+
+   struct set *seen = _mesa_pointer_set_create(NULL);
+
+   for (unsigned i = mark; i < count; i++) {
+      ir_variable *var = util_dynarray_element(&this->log, ssa_change, i)->var;
+      bool found = false;
+
+      _mesa_set_search_and_add(seen, var, &found);
+      if (!found) {
+         ssa_change change = { var, current(var) };
+         util_dynarray_append(changes, ssa_change, change);
+      }
+   }
+
+   _mesa_set_destroy(seen, NULL);
+}
+
+ir_variable *
+ssa_builder::new_version(ir_variable *var, ir_ssa_value_kind kind,
+                         ir_assignment *def, ir_instruction *join)
+{
+   ir_variable *version = var->clone(this->mem_ctx, NULL);
+
+   /* A value of the variable is not the one of all his versions */
+   version->constant_value = NULL;
+   version->constant_initializer = NULL;
+   version->data.has_initializer = false;
+
+   this->sig->body.push_head(version);
+
+   ir_ssa_value *of = this->ssa->get(var);
+   ir_ssa_value *value = ralloc(this->ssa->mem_ctx, ir_ssa_value);
+   value->var = version;
+   value->original = of ? of->original : var;
+   value->kind = kind;
+   value->def = def;
+   value->join = join;
+   _mesa_hash_table_insert(this->ssa->values, version, value);
+
+   this->progress = true;
+   return version;
+}
+
+ir_assignment *
+ssa_builder::copy(ir_variable *to, ir_variable *from)
+{
+   return new(this->mem_ctx)
+      ir_assignment(new(this->mem_ctx) ir_dereference_variable(to),
+                    new(this->mem_ctx) ir_dereference_variable(from));
+}
+
+void
+ssa_builder::rename_uses(ir_instruction *ir)
+{
+   if (ir != NULL)
+      ir->accept(&this->renamer);
+}
+
+void
+ssa_builder::rename_assignment(ir_assignment *ir)
+{
+   rename_uses(ir->rhs);
+   rename_uses(ir->condition);
+
+   ir_variable *var = ir->condition ? NULL : ir->whole_variable_written();
+   if (var != NULL && _mesa_set_search(this->eligible.eligible, var)) {
+      ir_variable *version = new_version(var, ir_ssa_assigned, ir, NULL);
+      ir->lhs->as_dereference_variable()->var = version;
+      set_current(var, version);
+   } else {
+      /* the indices of an array or a record write */
+      rename_uses(ir->lhs);
+   }
+}
+
+void
+ssa_builder::rename_jump(ir_loop_jump *ir)
+{
+   if (this->loop == NULL)
+      return;
+
+   util_dynarray_foreach(&this->loop->entries, ssa_loop_entry, entry) {
+      ir_variable *value = current(entry->var);
+
+      if (ir->is_break()) {
+         /* the exit phi is only known at the end of the loop */
+         ssa_loop_break b = { ir, value };
+         util_dynarray_append(&entry->breaks, ssa_loop_break, b);
+      } else if (value != entry->header) {
+         ir->insert_before(copy(entry->header, value));
+      }
+   }
+
+   if (ir->is_break())
+      this->loop->has_break = true;
+}
+
+void
+ssa_builder::join(ir_if *ir, ir_variable *var, ir_variable *then_value,
+                  ir_variable *else_value, bool then_falls, bool else_falls)
+{
+   ir_variable *value;
+
+   if (!else_falls || then_value == else_value) {
+      value = then_value;
+   } else if (!then_falls) {
+      value = else_value;
+   } else {
+      value = new_version(var, ir_ssa_if_phi, NULL, ir);
+      ir->then_instructions.push_tail(copy(value, then_value));
+      ir->else_instructions.push_tail(copy(value, else_value));
+   }
+
+   if (value != current(var))
+      set_current(var, value);
+}
+
+/* false when the end of the if is not reached */
+bool
+ssa_builder::rename_if(ir_if *ir)
+{
+   rename_uses(ir->condition);
+
+   const unsigned mark = util_dynarray_num_elements(&this->log, ssa_change);
+   struct util_dynarray then_changes, else_changes;
+   util_dynarray_init(&then_changes, NULL);
+   util_dynarray_init(&else_changes, NULL);
+
+   const bool then_falls = rename_list(&ir->then_instructions);
+   changes_since(mark, &then_changes);
+   undo(mark);
+
+   const bool else_falls = rename_list(&ir->else_instructions);
+   changes_since(mark, &else_changes);
+   undo(mark);
+
+   if (then_falls || else_falls) {
+      struct hash_table *else_values = _mesa_pointer_hash_table_create(NULL);
+      util_dynarray_foreach(&else_changes, ssa_change, change)
+         _mesa_hash_table_insert(else_values, change->var, change->version);
+
+      util_dynarray_foreach(&then_changes, ssa_change, change) {
+         ir_variable *else_value = current(change->var);
+         struct hash_entry *entry =
+            _mesa_hash_table_search(else_values, change->var);
+
+         if (entry != NULL) {
+            else_value = (ir_variable *) entry->data;
+            _mesa_hash_table_remove(else_values, entry);
+         }
+
+         join(ir, change->var, change->version, else_value,
+              then_falls, else_falls);
+      }
+
+      /* the ones only changed by the else */
+      util_dynarray_foreach(&else_changes, ssa_change, change) {
+         if (_mesa_hash_table_search(else_values, change->var))
+            join(ir, change->var, current(change->var), change->version,
+                 then_falls, else_falls);
+      }
+
+      _mesa_hash_table_destroy(else_values, NULL);
+   }
+
+   util_dynarray_fini(&then_changes);
+   util_dynarray_fini(&else_changes);
+
+   return then_falls || else_falls;
+}
+
+/* false when the loop has no break */
+bool
+ssa_builder::rename_loop(ir_loop *ir)
+{
+   ssa_assigned_visitor assigned(this->eligible.eligible);
+   assigned.run(&ir->body_instructions);
+
+   ssa_loop_frame frame;
+   frame.outer = this->loop;
+   frame.loop = ir;
+   frame.has_break = false;
+   util_dynarray_init(&frame.entries, NULL);
+
+   util_dynarray_foreach(&assigned.assigned, ir_variable *, var) {
+      ssa_loop_entry entry;
+      entry.var = *var;
+      entry.header = new_version(*var, ir_ssa_loop_header_phi, NULL, ir);
+      util_dynarray_init(&entry.breaks, NULL);
+      ir->insert_before(copy(entry.header, current(*var)));
+      set_current(*var, entry.header);
+      util_dynarray_append(&frame.entries, ssa_loop_entry, entry);
+   }
+
+   const unsigned mark = util_dynarray_num_elements(&this->log, ssa_change);
+
+   this->loop = &frame;
+   const bool falls = rename_list(&ir->body_instructions);
+   this->loop = frame.outer;
+
+   util_dynarray_foreach(&frame.entries, ssa_loop_entry, entry) {
+      ir_variable *value = current(entry->var);
+      if (falls && value != entry->header)
+         ir->body_instructions.push_tail(copy(entry->header, value));
+   }
+
+   undo(mark);
+
+   /* a phi at the exit only when the breaks see different values */
+   util_dynarray_foreach(&frame.entries, ssa_loop_entry, entry) {
+      ir_variable *exit = NULL;
+      bool same = true;
+
+      util_dynarray_foreach(&entry->breaks, ssa_loop_break, b) {
+         if (exit == NULL)
+            exit = b->value;
+         else if (b->value != exit)
+            same = false;
+      }
+
+      if (!same) {
+         exit = new_version(entry->var, ir_ssa_loop_exit_phi, NULL, ir);
+         util_dynarray_foreach(&entry->breaks, ssa_loop_break, b)
+            b->jump->insert_before(copy(exit, b->value));
+      }
+
+      if (exit != NULL && exit != current(entry->var))
+         set_current(entry->var, exit);
+
+      util_dynarray_fini(&entry->breaks);
+   }
+
+   util_dynarray_fini(&frame.entries);
+
+   return frame.has_break;
+}
+
+/* false when the end of the list is not reached */
+bool
+ssa_builder::rename_list(exec_list *list)
+{
+   bool falls = true;
+
+   /* the copies are inserted before the current instruction */
+   foreach_in_list(ir_instruction, ir, list) {
+      switch (ir->ir_type) {
+      case ir_type_variable:
+         break;
+      case ir_type_assignment:
+         rename_assignment((ir_assignment *) ir);
+         break;
+      case ir_type_if:
+         if (!rename_if((ir_if *) ir))
+            falls = false;
+         break;
+      case ir_type_loop:
+         if (!rename_loop((ir_loop *) ir))
+            falls = false;
+         break;
+      case ir_type_loop_jump:
+         rename_jump((ir_loop_jump *) ir);
+         falls = false;
+         break;
+      case ir_type_return:
+         rename_uses(ir);
+         falls = false;
+         break;
+      case ir_type_discard:
+         rename_uses(ir);
+         if (((ir_discard *) ir)->condition == NULL)
+            falls = false;
+         break;
+      default:
+         rename_uses(ir);
+         break;
+      }
+   }
+
+   return falls;
+}
+
+bool
+ssa_builder::run()
+{
+   this->eligible.run(&this->sig->body);
+
+   /* Each version is declared at the top of the body, the copies of a loop
+    * header are before the loop, so the variables declared in a block go
+    * at the top too.
+    */
+   const unsigned count =
+      util_dynarray_num_elements(&this->eligible.declared, ir_variable *);
+   for (unsigned i = count; i-- > 0;) {
+      ir_variable *var =
+         *util_dynarray_element(&this->eligible.declared, ir_variable *, i);
+
+      if (_mesa_set_search(this->eligible.eligible, var)) {
+         var->remove();
+         this->sig->body.push_head(var);
+      }
+   }
+
+   if (this->eligible.eligible->entries != 0)
+      rename_list(&this->sig->body);
+
+   return this->progress;
+}
+
+/*
+ * Conversion back
+ */
+
+struct ssa_member {
+   ir_variable *var;
+   unsigned group;                    /**< index in groups */
+   struct util_dynarray interferences; /**< unsigned, indices of members */
+};
+
+struct ssa_group {
+   ir_variable *original;
+   unsigned first; /**< the members of a group have consecutive indices */
+   unsigned count;
+};
+
+/**
+ * The versions and the originals referenced in a signature, grouped by
+ * original in the order of their first reference
+ */
+class ssa_member_visitor : public ir_hierarchical_visitor {
+public:
+   ssa_member_visitor(ir_ssa *ssa)
+      : ssa(ssa)
+   {
+      this->originals = _mesa_pointer_set_create(NULL);
+      this->declared = _mesa_pointer_set_create(NULL);
+      this->indices = _mesa_pointer_hash_table_create(NULL);
+      this->group_indices = _mesa_pointer_hash_table_create(NULL);
+      util_dynarray_init(&this->members, NULL);
+      util_dynarray_init(&this->groups, NULL);
+
+      hash_table_foreach(ssa->values, entry)
+         _mesa_set_add(this->originals,
+                       ((ir_ssa_value *) entry->data)->original);
+   }
+
+   ~ssa_member_visitor()
+   {
+      util_dynarray_foreach(&this->members, ssa_member, member)
+         util_dynarray_fini(&member->interferences);
+
+      _mesa_set_destroy(this->originals, NULL);
+      _mesa_set_destroy(this->declared, NULL);
+      _mesa_hash_table_destroy(this->indices, NULL);
+      _mesa_hash_table_destroy(this->group_indices, NULL);
+      util_dynarray_fini(&this->members);
+      util_dynarray_fini(&this->groups);
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      _mesa_set_add(this->declared, var);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      if (_mesa_hash_table_search(this->indices, ir->var))
+         return visit_continue;
+
+      ir_ssa_value *value = this->ssa->get(ir->var);
+      if (value == NULL && !_mesa_set_search(this->originals, ir->var))
+         return visit_continue;
+
+      ir_variable *original = value ? value->original : ir->var;
+      struct hash_entry *entry =
+         _mesa_hash_table_search(this->group_indices, original);
+      unsigned group;
+
+      if (entry != NULL) {
+         group = (unsigned) (uintptr_t) entry->data;
+      } else {
+         group = util_dynarray_num_elements(&this->groups, ssa_group);
+         ssa_group g = { original, 0, 0 };
+         util_dynarray_append(&this->groups, ssa_group, g);
+         _mesa_hash_table_insert(this->group_indices, original,
+                                 (void *) (uintptr_t) group);
+      }
+
+      ssa_member member;
+      member.var = ir->var;
+      member.group = group;
+      util_dynarray_init(&member.interferences, NULL);
+      util_dynarray_append(&this->members, ssa_member, member);
+      util_dynarray_element(&this->groups, ssa_group, group)->count++;
+      _mesa_hash_table_insert(this->indices, ir->var, (void *) (uintptr_t)
+         util_dynarray_num_elements(&this->members, ssa_member));
+
+      return visit_continue;
+   }
+
+   /* after the run, the members of each group are made consecutive */
+   void sort_groups()
+   {
+      unsigned next = 0;
+      util_dynarray_foreach(&this->groups, ssa_group, group) {
+         group->first = next;
+         next += group->count;
+         group->count = 0;
+      }
+
+      struct util_dynarray sorted;
+      util_dynarray_init(&sorted, NULL);
+      util_dynarray_resize(&sorted, ssa_member, next);
+
+      util_dynarray_foreach(&this->members, ssa_member, member) {
+         ssa_group *group = util_dynarray_element(&this->groups, ssa_group,
+                                                  member->group);
+         const unsigned index = group->first + group->count++;
+
+         *util_dynarray_element(&sorted, ssa_member, index) = *member;
+         _mesa_hash_table_insert(this->indices, member->var,
+                                 (void *) (uintptr_t) (index + 1));
+      }
+
+      util_dynarray_fini(&this->members);
+      this->members = sorted;
+   }
+
+   ir_ssa *ssa;
+   struct set *originals;
+   struct set *declared;            /**< the variables declared in the body */
+   struct hash_table *indices;      /**< ir_variable -> index in members + 1 */
+   struct hash_table *group_indices; /**< original -> index in groups */
+   struct util_dynarray members;    /**< ssa_member */
+   struct util_dynarray groups;     /**< ssa_group */
+};
+
+class ssa_use_visitor : public ir_hierarchical_visitor {
+public:
+   ssa_use_visitor(struct hash_table *indices)
+      : indices(indices), live(NULL)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(this->indices, ir->var);
+      if (entry != NULL)
+         BITSET_SET(this->live, (uintptr_t) entry->data - 1);
+      return visit_continue;
+   }
+
+   struct hash_table *indices;
+   BITSET_WORD *live;
+};
+
+struct ssa_live_loop {
+   ssa_live_loop *outer;
+   BITSET_WORD *header; /**< live at the start of the body */
+   BITSET_WORD *exit;   /**< live after the loop */
+};
+
+/**
+ * Backward liveness of the members on the structured body, each loop until
+ * his header is stable.  On the checking walk, a write of a member
+ * interferes with the members of his group live after it, but the one he
+ * is a copy of.
+ */
+class ssa_coalescer {
+public:
+   ssa_coalescer(ssa_member_visitor *members)
+      : m(members), uses(members->indices), loop(NULL), check(false)
+   {
+      this->words = BITSET_WORDS(
+         util_dynarray_num_elements(&members->members, ssa_member));
+      this->mem_ctx = ralloc_context(NULL);
+   }
+
+   ~ssa_coalescer()
+   {
+      ralloc_free(this->mem_ctx);
+   }
+
+   void run(exec_list *body)
+   {
+      BITSET_WORD *live = new_set();
+      transfer_list(body, live);
+      this->check = true;
+      memset(live, 0, this->words * sizeof(BITSET_WORD));
+      transfer_list(body, live);
+   }
+
+   /* version -> representative of his group, NULL to remove */
+   void coalesce(ir_ssa *ssa, struct hash_table *renames);
+
+private:
+   BITSET_WORD *new_set()
+   {
+      return rzalloc_array(this->mem_ctx, BITSET_WORD, MAX2(this->words, 1));
+   }
+
+   BITSET_WORD *copy_set(const BITSET_WORD *set)
+   {
+      BITSET_WORD *copy = new_set();
+      memcpy(copy, set, this->words * sizeof(BITSET_WORD));
+      return copy;
+   }
+
+   int index(ir_variable *var)
+   {
+      struct hash_entry *entry = var ?
+         _mesa_hash_table_search(this->m->indices, var) : NULL;
+      return entry ? (int) (uintptr_t) entry->data - 1 : -1;
+   }
+
+   void add_uses(ir_instruction *ir, BITSET_WORD *live)
+   {
+      if (ir != NULL) {
+         this->uses.live = live;
+         ir->accept(&this->uses);
+      }
+   }
+
+   void interfere(int written, int copied, const BITSET_WORD *live);
+   void write(ir_rvalue *lhs, bool whole, int copied, BITSET_WORD *live);
+   void transfer(ir_instruction *ir, BITSET_WORD *live);
+   void transfer_list(exec_list *list, BITSET_WORD *live);
+
+   ssa_member_visitor *m;
+   ssa_use_visitor uses;
+   ssa_live_loop *loop;
+   unsigned words;
+   bool check;
+   void *mem_ctx;
+};
+
+void
+ssa_coalescer::interfere(int written, int copied, const BITSET_WORD *live)
+{
+   ssa_member *a = util_dynarray_element(&this->m->members, ssa_member,
+                                         written);
+   ssa_group *group = util_dynarray_element(&this->m->groups, ssa_group,
+                                            a->group);
+
+   const unsigned end = group->first + group->count;
+
+   for (unsigned other = group->first; other < end; other++) {
+      /* a variable written many times has many versions, few live */
+      if (live[BITSET_BITWORD(other)] == 0) {
+         other |= BITSET_WORDBITS - 1;
+         continue;
+      }
+
+      if ((int) other == written || (int) other == copied ||
+          !BITSET_TEST(live, other))
+         continue;
+
+      ssa_member *b = util_dynarray_element(&this->m->members, ssa_member,
+                                            other);
+      util_dynarray_append(&a->interferences, unsigned, other);
+      util_dynarray_append(&b->interferences, unsigned, (unsigned) written);
+   }
+}
+
+/* the uses of the lhs are added by the caller */
+void
+ssa_coalescer::write(ir_rvalue *lhs, bool whole, int copied,
+                     BITSET_WORD *live)
+{
+   const int written = index(lhs->variable_referenced());
+   if (written < 0)
+      return;
+
+   if (this->check)
+      interfere(written, copied, live);
+   if (whole)
+      BITSET_CLEAR(live, written);
+}
+
+void
+ssa_coalescer::transfer(ir_instruction *ir, BITSET_WORD *live)
+{
+   switch (ir->ir_type) {
+   case ir_type_variable:
+      break;
+
+   case ir_type_assignment: {
+      ir_assignment *a = (ir_assignment *) ir;
+      const bool whole = a->condition == NULL &&
+                         a->whole_variable_written() != NULL;
+      ir_dereference_variable *rhs = a->rhs->as_dereference_variable();
+
+      write(a->lhs, whole, rhs ? index(rhs->var) : -1, live);
+      /* a partial write keeps the other channels, so reads the variable */
+      if (!whole)
+         add_uses(a->lhs, live);
+      add_uses(a->rhs, live);
+      add_uses(a->condition, live);
+      break;
+   }
+
+   case ir_type_call: {
+      ir_call *call = (ir_call *) ir;
+
+      if (call->return_deref != NULL)
+         write(call->return_deref, true, -1, live);
+
+      foreach_two_lists(formal_node, &call->callee->parameters,
+                        actual_node, &call->actual_parameters) {
+         ir_variable *formal = (ir_variable *) formal_node;
+         ir_rvalue *actual = (ir_rvalue *) actual_node;
+
+         if (formal->data.mode == ir_var_function_out ||
+             formal->data.mode == ir_var_function_inout)
+            write(actual, false, -1, live);
+      }
+
+      foreach_in_list(ir_rvalue, actual, &call->actual_parameters)
+         add_uses(actual, live);
+      break;
+   }
+
+   case ir_type_if: {
+      ir_if *branch = (ir_if *) ir;
+      BITSET_WORD *else_live = copy_set(live);
+
+      transfer_list(&branch->then_instructions, live);
+      transfer_list(&branch->else_instructions, else_live);
+      for (unsigned i = 0; i < this->words; i++)
+         live[i] |= else_live[i];
+      add_uses(branch->condition, live);
+      break;
+   }
+
+   case ir_type_loop: {
+      ir_loop *l = (ir_loop *) ir;
+      ssa_live_loop frame;
+      frame.outer = this->loop;
+      frame.header = new_set();
+      frame.exit = copy_set(live);
+      this->loop = &frame;
+
+      /* the header only grows, the checks are done on the last walk */
+      const bool check = this->check;
+      this->check = false;
+      BITSET_WORD *body = new_set();
+      for (;;) {
+         memcpy(body, frame.header, this->words * sizeof(BITSET_WORD));
+         transfer_list(&l->body_instructions, body);
+         if (memcmp(body, frame.header, this->words * sizeof(BITSET_WORD)) == 0)
+            break;
+         memcpy(frame.header, body, this->words * sizeof(BITSET_WORD));
+      }
+
+      this->check = check;
+      if (check) {
+         memcpy(body, frame.header, this->words * sizeof(BITSET_WORD));
+         transfer_list(&l->body_instructions, body);
+      }
+
+      this->loop = frame.outer;
+      memcpy(live, frame.header, this->words * sizeof(BITSET_WORD));
+      break;
+   }
+
+   case ir_type_loop_jump:
+      if (this->loop != NULL) {
+         const ir_loop_jump *jump = (ir_loop_jump *) ir;
+         memcpy(live, jump->is_break() ? this->loop->exit : this->loop->header,
+                this->words * sizeof(BITSET_WORD));
+      }
+      break;
+
+   case ir_type_return:
+      memset(live, 0, this->words * sizeof(BITSET_WORD));
+      add_uses(ir, live);
+      break;
+
+   case ir_type_discard:
+      if (((ir_discard *) ir)->condition == NULL)
+         memset(live, 0, this->words * sizeof(BITSET_WORD));
+      add_uses(ir, live);
+      break;
+
+   default:
+      add_uses(ir, live);
+      break;
+   }
+}
+
+void
+ssa_coalescer::transfer_list(exec_list *list, BITSET_WORD *live)
+{
+   foreach_in_list_reverse(ir_instruction, ir, list)
+      transfer(ir, live);
+}
+
+void
+ssa_coalescer::coalesce(ir_ssa *ssa, struct hash_table *renames)
+{
+   BITSET_WORD *merged = new_set();
+
+   util_dynarray_foreach(&this->m->groups, ssa_group, group) {
+      /* the original is removed by dead code when no more referenced */
+      ir_variable *representative =
+         _mesa_set_search(this->m->declared, group->original) ?
+         group->original : NULL;
+
+      const int original = index(group->original);
+      if (original >= 0)
+         BITSET_SET(merged, original);
+
+      for (unsigned i = group->first; i < group->first + group->count; i++) {
+         ssa_member *member = util_dynarray_element(&this->m->members,
+                                                    ssa_member, i);
+
+         if ((int) i == original)
+            continue;
+
+         bool fits = true;
+         util_dynarray_foreach(&member->interferences, unsigned, other) {
+            if (BITSET_TEST(merged, *other)) {
+               fits = false;
+               break;
+            }
+         }
+
+         if (!fits)
+            continue;
+
+         BITSET_SET(merged, i);
+         if (representative == NULL)
+            representative = member->var;
+         else
+            _mesa_hash_table_insert(renames, member->var, representative);
+      }
+   }
+
+   /* the versions no more referenced are only declared */
+   hash_table_foreach(ssa->values, entry) {
+      if (!_mesa_hash_table_search(this->m->indices, entry->key))
+         _mesa_hash_table_insert(renames, entry->key, NULL);
+   }
+}
+
+/**
+ * Rename the versions, remove the declarations of the renamed and the
+ * unreferenced ones, and the copies of a variable to himself
+ */
+class ssa_back_renamer : public ir_hierarchical_visitor {
+public:
+   ssa_back_renamer(struct hash_table *renames)
+      : renames(renames), progress(false)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      if (_mesa_hash_table_search(this->renames, var)) {
+         var->remove();
+         this->progress = true;
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(this->renames, ir->var);
+      if (entry != NULL && entry->data != NULL)
+         ir->var = (ir_variable *) entry->data;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_leave(ir_assignment *ir)
+   {
+      ir_dereference_variable *lhs = ir->lhs->as_dereference_variable();
+      ir_dereference_variable *rhs = ir->rhs->as_dereference_variable();
+
+      if (ir->condition == NULL && lhs != NULL && rhs != NULL &&
+          lhs->var == rhs->var && ir->whole_variable_written() != NULL)
+         ir->remove();
+
+      return visit_continue;
+   }
+
+   struct hash_table *renames; /**< version -> variable, NULL to remove */
+   bool progress;
+};
+
+bool
+destroy_signature(ir_ssa *ssa, ir_function_signature *sig)
+{
+   ssa_member_visitor members(ssa);
+   members.run(&sig->body);
+   members.sort_groups();
+
+   struct hash_table *renames = _mesa_pointer_hash_table_create(NULL);
+
+   ssa_coalescer coalescer(&members);
+   coalescer.run(&sig->body);
+   coalescer.coalesce(ssa, renames);
+
+   ssa_back_renamer renamer(renames);
+   renamer.run(&sig->body);
+
+   _mesa_hash_table_destroy(renames, NULL);
+
+   return renamer.progress;
+}
+
+} /* anonymous namespace */
+
+ir_ssa::ir_ssa()
+{
+   this->mem_ctx = ralloc_context(NULL);
+   this->values = _mesa_pointer_hash_table_create(this->mem_ctx);
+}
+
+ir_ssa::~ir_ssa()
+{
+   ralloc_free(this->mem_ctx);
+}
+
+ir_ssa_value *
+ir_ssa::get(const ir_variable *var) const
+{
+   struct hash_entry *entry = _mesa_hash_table_search(this->values, var);
+   return entry ? (ir_ssa_value *) entry->data : NULL;
+}
+
+bool
+ir_ssa::build(exec_list *instructions)
+{
+   bool progress = false;
+
+   foreach_in_list(ir_instruction, node, instructions) {
+      ir_function *f = node->as_function();
+      if (f == NULL)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         if (!sig->is_defined)
+            continue;
+
+         ssa_builder builder(this, sig);
+         progress |= builder.run();
+      }
+   }
+
+   return progress;
+}
+
+bool
+ir_ssa::destroy(exec_list *instructions)
+{
+   bool progress = false;
+
+   foreach_in_list(ir_instruction, node, instructions) {
+      ir_function *f = node->as_function();
+      if (f == NULL)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         if (sig->is_defined)
+            progress |= destroy_signature(this, sig);
+      }
+   }
+
+   _mesa_hash_table_clear(this->values, NULL);
+
+   return progress;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_ssa.h
+ * Optional SSA form of the function bodies.
+ *
+ * The IR has no phi node, so the form is kept with copies.  Each assignment
+ * of an eligible local gets its own variable, a version.  At a join (after
+ * an ir_if, at the header and at the exit of an ir_loop) the values who
+ * differ are copied to a phi version at the end of each predecessor : end
+ * of the branches, before a break or a continue, end of the loop body.
+ * A version who is not a phi has a single assignment, who dominates all
+ * the uses.
+ *
+ * The IR stays valid for all the passes.  ir_ssa::destroy renames back the
+ * versions to their variable when the live ranges don't overlap, and
+ * removes the copies this makes useless.
+ *
+ * The eligible locals are the auto and temporary variables of scalar,
+ * vector or matrix type, only written by unconditional assignments of the
+ * whole variable.  Their declarations are moved to the top of the body.
+ */
+
+#ifndef GLSL_IR_SSA_H
+#define GLSL_IR_SSA_H
+
+#include "ir.h"
+
+struct hash_table;
+
+enum ir_ssa_value_kind {
+   ir_ssa_assigned,         /**< Written by a single assignment */
+   ir_ssa_if_phi,           /**< Written at the end of both branches */
+   ir_ssa_loop_header_phi,  /**< Written before the loop, at the end of the
+                             *   body and before the continues */
+   ir_ssa_loop_exit_phi,    /**< Written before the breaks */
+};
+
+struct ir_ssa_value {
+   ir_variable *var;        /**< The version */
+   ir_variable *original;   /**< The variable before any conversion */
+   ir_ssa_value_kind kind;
+   ir_assignment *def;      /**< The single assignment, NULL for a phi */
+   ir_instruction *join;    /**< ir_if or ir_loop of a phi, NULL otherwise */
+};
+
+class ir_ssa {
+public:
+   ir_ssa();
+   ~ir_ssa();
+
+   /**
+    * Convert the bodies of the functions, the ir already in SSA form gets
+    * versions of his versions.  Returns true if a variable was versioned.
+    */
+   bool build(exec_list *instructions);
+
+   /**
+    * Rename back the versions who can be, the others stay as plain
+    * temporaries.  Returns true if the ir changed.
+    */
+   bool destroy(exec_list *instructions);
+
+   /** NULL if var is not a version */
+   ir_ssa_value *get(const ir_variable *var) const;
+
+   void *mem_ctx;
+   struct hash_table *values; /**< version -> ir_ssa_value */
+};
+
+#endif /* GLSL_IR_SSA_H */
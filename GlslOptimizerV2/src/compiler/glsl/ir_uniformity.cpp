@@ -0,0 +1,342 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_uniformity.cpp
+ * Dynamic uniformity of the rvalues, see ir_uniformity.h.
+ */
+
+#include "ir_uniformity.h"
+#include "ir_hierarchical_visitor.h"
+#include "util/set.h"
+
+namespace {
+
+struct uniform_value_state {
+   const ir_uniformity *uniformity;
+   bool uniform;
+};
+
+} /* unnamed namespace */
+
+class uniformity_visitor : public ir_hierarchical_visitor {
+public:
+   uniformity_visitor(ir_uniformity *uniformity)
+      : uniformity(uniformity), signature(NULL), divergent(0),
+        changed(false)
+   {
+      this->globals = _mesa_pointer_set_create(NULL);
+   }
+
+   ~uniformity_visitor()
+   {
+      _mesa_set_destroy(this->globals, NULL);
+   }
+
+   void mark(ir_variable *var)
+   {
+      if (var == NULL ||
+          (var->data.mode != ir_var_auto &&
+           var->data.mode != ir_var_temporary) ||
+          _mesa_set_search(this->uniformity->varying, var) != NULL)
+         return;
+
+      /* a write seen before the declaration makes the local known too */
+      _mesa_set_add(this->uniformity->locals, var);
+      _mesa_set_add(this->uniformity->varying, var);
+      this->changed = true;
+   }
+
+   bool has_divergent_jump(exec_list *list, bool loop, bool divergent_if);
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      if (var->data.mode == ir_var_auto ||
+          var->data.mode == ir_var_temporary) {
+         _mesa_set_add(this->uniformity->locals, var);
+         if (this->signature == NULL)
+            _mesa_set_add(this->globals, var);
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_function_signature *sig)
+   {
+      /* a return under a non uniform if leaves the rest of the body to
+       * some invocations only
+       */
+      const bool divergent = has_divergent_jump(&sig->body, false, false);
+
+      this->signature = sig;
+      this->divergent += divergent;
+      visit_list_elements(this, &sig->body);
+      this->divergent -= divergent;
+      this->signature = NULL;
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      if (this->divergent != 0 ||
+          !this->uniformity->is_uniform_value(ir->rhs) ||
+          (ir->condition != NULL &&
+           !this->uniformity->is_uniform_value(ir->condition)) ||
+          !this->uniformity->is_uniform_value(ir->lhs))
+         mark(ir->lhs->variable_referenced());
+
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      if (ir->return_deref != NULL)
+         mark(ir->return_deref->variable_referenced());
+
+      foreach_two_lists(formal_node, &ir->callee->parameters,
+                        actual_node, &ir->actual_parameters) {
+         ir_variable *formal = (ir_variable *) formal_node;
+         ir_rvalue *actual = (ir_rvalue *) actual_node;
+
+         if (formal->data.mode == ir_var_function_out ||
+             formal->data.mode == ir_var_function_inout)
+            mark(actual->variable_referenced());
+      }
+
+      /* the globals written by the callee */
+      if (this->divergent != 0) {
+         set_foreach(this->globals, entry)
+            mark((ir_variable *) entry->key);
+      }
+
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_if *ir)
+   {
+      const bool divergent =
+         !this->uniformity->is_uniform_value(ir->condition);
+
+      this->divergent += divergent;
+      visit_list_elements(this, &ir->then_instructions);
+      visit_list_elements(this, &ir->else_instructions);
+      this->divergent -= divergent;
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_loop *ir)
+   {
+      /* the iterations run by each invocation may differ */
+      const bool divergent =
+         has_divergent_jump(&ir->body_instructions, true, false);
+
+      this->divergent += divergent;
+      visit_list_elements(this, &ir->body_instructions);
+      this->divergent -= divergent;
+      return visit_continue_with_parent;
+   }
+
+   ir_uniformity *uniformity;
+   ir_function_signature *signature;
+   struct set *globals; /**< the auto variables out of the functions */
+   unsigned divergent;  /**< count of the enclosing non uniform blocks */
+   bool changed;
+};
+
+/**
+ * True if a jump out of the list is under an if on a non uniform condition,
+ * the break and continue only for the body of a loop.
+ */
+bool
+uniformity_visitor::has_divergent_jump(exec_list *list, bool loop,
+                                       bool divergent_if)
+{
+   foreach_in_list(ir_instruction, ir, list) {
+      switch (ir->ir_type) {
+      case ir_type_if: {
+         ir_if *branch = (ir_if *) ir;
+         const bool divergent = divergent_if ||
+            !this->uniformity->is_uniform_value(branch->condition);
+
+         if (has_divergent_jump(&branch->then_instructions, loop, divergent) ||
+             has_divergent_jump(&branch->else_instructions, loop, divergent))
+            return true;
+         break;
+      }
+
+      case ir_type_loop:
+         /* the jumps of an inner loop stay in it, but not his returns */
+         if (has_divergent_jump(&((ir_loop *) ir)->body_instructions, false,
+                                divergent_if))
+            return true;
+         break;
+
+      case ir_type_loop_jump:
+         if (loop && divergent_if)
+            return true;
+         break;
+
+      case ir_type_return:
+         if (divergent_if)
+            return true;
+         break;
+
+      default:
+         break;
+      }
+   }
+
+   return false;
+}
+
+ir_uniformity::ir_uniformity(exec_list *instructions)
+   : instructions(instructions), built(false)
+{
+   this->locals = _mesa_pointer_set_create(NULL);
+   this->varying = _mesa_pointer_set_create(NULL);
+}
+
+ir_uniformity::~ir_uniformity()
+{
+   _mesa_set_destroy(this->locals, NULL);
+   _mesa_set_destroy(this->varying, NULL);
+}
+
+bool
+ir_uniformity::is_uniform(ir_rvalue *ir)
+{
+   if (!this->built)
+      build();
+
+   return is_uniform_value(ir);
+}
+
+bool
+ir_uniformity::is_uniform_variable(const ir_variable *var) const
+{
+   switch (var->data.mode) {
+   case ir_var_uniform:
+      return true;
+
+   case ir_var_auto:
+   case ir_var_temporary:
+      return _mesa_set_search(this->locals, var) != NULL &&
+             _mesa_set_search(this->varying, var) == NULL;
+
+   default:
+      return false;
+   }
+}
+
+void
+ir_uniformity::check_node(ir_instruction *ir, void *data)
+{
+   uniform_value_state *state = (uniform_value_state *) data;
+
+   if (ir->ir_type == ir_type_dereference_variable &&
+       !state->uniformity->is_uniform_variable(
+          ((ir_dereference_variable *) ir)->var))
+      state->uniform = false;
+}
+
+/** The operations who read nothing but their operands */
+static bool
+is_uniform_only_operation(ir_expression_operation op)
+{
+   switch (op) {
+   case ir_unop_dFdx:
+   case ir_unop_dFdx_coarse:
+   case ir_unop_dFdx_fine:
+   case ir_unop_dFdy:
+   case ir_unop_dFdy_coarse:
+   case ir_unop_dFdy_fine:
+   case ir_unop_interpolate_at_centroid:
+   case ir_binop_interpolate_at_offset:
+   case ir_binop_interpolate_at_sample:
+   case ir_unop_noise:
+   case ir_unop_get_buffer_size:
+   case ir_unop_ssbo_unsized_array_length:
+   case ir_unop_subroutine_to_int:
+   case ir_binop_ubo_load:
+   case ir_unop_pack_sampler_2x32:
+   case ir_unop_unpack_sampler_2x32:
+   case ir_unop_pack_image_2x32:
+   case ir_unop_unpack_image_2x32:
+      return false;
+   default:
+      return true;
+   }
+}
+
+void
+ir_uniformity::check_uniform_only_node(ir_instruction *ir, void *data)
+{
+   bool *uniform_only = (bool *) data;
+
+   switch (ir->ir_type) {
+   case ir_type_constant:
+   case ir_type_swizzle:
+   case ir_type_dereference_array:
+   case ir_type_dereference_record:
+      break;
+
+   case ir_type_dereference_variable: {
+      const ir_variable *var = ((ir_dereference_variable *) ir)->var;
+      if (var->data.mode != ir_var_uniform || var->type->contains_opaque())
+         *uniform_only = false;
+      break;
+   }
+
+   case ir_type_expression:
+      if (!is_uniform_only_operation(((ir_expression *) ir)->operation))
+         *uniform_only = false;
+      break;
+
+   default:
+      *uniform_only = false;
+      break;
+   }
+}
+
+bool
+ir_uniformity::is_uniform_only(ir_rvalue *ir)
+{
+   bool uniform_only = true;
+   visit_tree(ir, check_uniform_only_node, &uniform_only);
+   return uniform_only;
+}
+
+bool
+ir_uniformity::is_uniform_value(ir_rvalue *ir) const
+{
+   uniform_value_state state;
+   state.uniformity = this;
+   state.uniform = true;
+   visit_tree(ir, check_node, &state);
+   return state.uniform;
+}
+
+void
+ir_uniformity::build()
+{
+   this->built = true;
+
+   /* the variables only become non uniform, so this ends */
+   uniformity_visitor v(this);
+   do {
+      v.changed = false;
+      visit_list_elements(&v, this->instructions);
+   } while (v.changed);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_uniformity.h
+ * Which rvalues are dynamically uniform, the same for all the invocations
+ * of a draw, for the passes who keep or flatten the control flow.
+ *
+ * The constants and the uniforms are uniform, the inputs, the system
+ * values, the outputs and the parameters of the functions are not.  A
+ * local variable is uniform until one of his writes is not : a value or a
+ * condition who is not uniform, a non uniform array index in the lhs, a
+ * write inside an if on a non uniform condition, or inside a loop or a
+ * function left by a jump under such an if.  The out parameters and the
+ * return values of the calls are not uniform.  The walk is repeated until
+ * no more variable changes.
+ *
+ * The analysis is done on the first query.  It stays valid while the
+ * values of the variables it knows do not change, a variable created
+ * after it is not uniform.
+ */
+
+#ifndef GLSL_IR_UNIFORMITY_H
+#define GLSL_IR_UNIFORMITY_H
+
+#include "ir.h"
+
+struct set;
+
+class ir_uniformity {
+public:
+   ir_uniformity(exec_list *instructions);
+   ~ir_uniformity();
+
+   bool is_uniform(ir_rvalue *ir);
+
+   /**
+    * Stricter than is_uniform, true if ir is computed from the constants and
+    * the uniforms alone, so can be computed once per draw out of the shader :
+    * no texture, no local, no derivative nor interpolation, no buffer load
+    * and no opaque value.  Needs no analysis.
+    */
+   static bool is_uniform_only(ir_rvalue *ir);
+
+private:
+   friend class uniformity_visitor;
+
+   void build();
+   bool is_uniform_variable(const ir_variable *var) const;
+   bool is_uniform_value(ir_rvalue *ir) const;
+   static void check_node(ir_instruction *ir, void *data);
+   static void check_uniform_only_node(ir_instruction *ir, void *data);
+
+   exec_list *instructions;
+   bool built;
+
+   struct set *locals;  /**< the auto and temporary variables declared */
+   struct set *varying; /**< the locals who are not uniform */
+};
+
+#endif /* GLSL_IR_UNIFORMITY_H */
@@ -1098,3 +1098,73 @@ validate_ir_tree(exec_list *instructions)
    }
 #endif
 }
+
+#ifdef DEBUG
+static void
+fingerprint_ir(ir_instruction *ir, void *data)
+{
+   uintptr_t *fingerprint = (uintptr_t *) data;
+   uintptr_t value = (uintptr_t) ir ^ ir->ir_type;
+
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable:
+      value ^= (uintptr_t) ((ir_dereference_variable *) ir)->var << 1;
+      break;
+   case ir_type_assignment:
+      value ^= (uintptr_t) ((ir_assignment *) ir)->write_mask << 8;
+      break;
+   case ir_type_expression:
+      value ^= (uintptr_t) ((ir_expression *) ir)->operation << 8;
+      break;
+   case ir_type_swizzle: {
+      const ir_swizzle_mask &mask = ((ir_swizzle *) ir)->mask;
+      value ^= (uintptr_t) (mask.x | mask.y << 2 | mask.z << 4 | mask.w << 6 |
+                            mask.num_components << 8) << 8;
+      break;
+   }
+   default:
+      break;
+   }
+
+   ir_rvalue *rvalue = ir->as_rvalue();
+   if (rvalue != NULL)
+      value ^= (uintptr_t) rvalue->type << 3;
+
+   *fingerprint = *fingerprint * 31 + value;
+}
+#endif
+
+void
+validate_ir_tree_changed(exec_list *instructions,
+                         struct hash_table *fingerprints)
+{
+#ifdef DEBUG
+   ir_validate v;
+
+   foreach_in_list(ir_instruction, ir, instructions) {
+      ir_function *f = ir->as_function();
+      uintptr_t fingerprint = 0;
+
+      if (f != NULL) {
+         visit_tree(f, fingerprint_ir, &fingerprint);
+
+         struct hash_entry *entry = _mesa_hash_table_search(fingerprints, f);
+         if (entry != NULL && (uintptr_t) entry->data == fingerprint)
+            continue;
+      }
+
+      /* The variables of the list before a function are declared to the
+       * validator by this walk, the ones of the skipped functions are not
+       * visible to the others anyway.
+       */
+      ir->accept(&v);
+      visit_tree(ir, check_node_type, NULL);
+
+      if (f != NULL)
+         _mesa_hash_table_insert(fingerprints, f, (void *) fingerprint);
+   }
+#else
+   (void) instructions;
+   (void) fingerprints;
+#endif
+}
@@ -0,0 +1,808 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_value_range.cpp
+ *
+ * The empty range is the bottom of the iteration : a variable not yet
+ * written has no value, an expression reading it neither.  At the end, the
+ * variables still empty (never written, or only from themselves) are
+ * unbounded.
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "ir_value_range.h"
+#include "ir_hierarchical_visitor.h"
+#include "loop_analysis.h"
+#include "compiler/glsl_types.h"
+#include "util/hash_table.h"
+#include "util/bitset.h"
+#include "util/u_dynarray.h"
+
+/* a bound who grows more often than this goes to the infinite */
+#define VALUE_RANGE_MAX_CHANGES 4
+
+/* margin of the float operations the GPUs approximate */
+#define VALUE_RANGE_APPROX_ULPS 4
+
+struct value_range_var {
+   ir_range range;
+   unsigned changes;
+   unsigned writes;
+   bool declared;   /**< in the ir walked, else written elsewhere too */
+   bool escaped;    /**< written by a call, never bounded */
+   struct util_dynarray readers; /**< indices of the writes reading it */
+};
+
+namespace {
+
+struct value_range_induction {
+   ir_rvalue *init;  /**< rhs of the assignment before the loop */
+   double increment;
+   int count;        /**< most times the increment runs */
+};
+
+} /* unnamed namespace */
+
+static ir_range
+range(double low, double high)
+{
+   ir_range r;
+   r.low = low;
+   r.high = high;
+   return r;
+}
+
+static ir_range
+unbounded()
+{
+   return range(-INFINITY, INFINITY);
+}
+
+static ir_range
+empty()
+{
+   return range(INFINITY, -INFINITY);
+}
+
+static ir_range
+hull(ir_range a, ir_range b)
+{
+   if (a.is_empty())
+      return b;
+   if (b.is_empty())
+      return a;
+   return range(MIN2(a.low, b.low), MAX2(a.high, b.high));
+}
+
+static bool
+is_tracked_type(const glsl_type *type)
+{
+   const glsl_type *t = type->without_array();
+   return t->base_type == GLSL_TYPE_FLOAT || t->base_type == GLSL_TYPE_INT ||
+          t->base_type == GLSL_TYPE_UINT;
+}
+
+/**
+ * Rounds the bounds computed with doubles outward to the precision of the
+ * type, then moves them by ulps more, but not over 0.  The integer bounds
+ * out of the 32 bits wrap, they are unbounded.
+ *
+ * The double sums and products of the float bounds, rounded outward, hold
+ * the correctly rounded float results.
+ */
+static ir_range
+fit(ir_range r, const glsl_type *type, unsigned ulps = 0)
+{
+   if (r.is_empty())
+      return r;
+
+   switch (type->base_type) {
+   case GLSL_TYPE_FLOAT: {
+      if (isnan(r.low) || isnan(r.high))
+         return unbounded();
+
+      float low = (float) r.low;
+      if ((double) low > r.low)
+         low = nextafterf(low, -INFINITY);
+      float high = (float) r.high;
+      if ((double) high < r.high)
+         high = nextafterf(high, INFINITY);
+
+      for (unsigned i = 0; i < ulps; i++) {
+         low = nextafterf(low, -INFINITY);
+         high = nextafterf(high, INFINITY);
+      }
+      return range(r.low >= 0.0 ? MAX2(low, 0.0f) : low,
+                   r.high <= 0.0 ? MIN2(high, 0.0f) : high);
+   }
+
+   case GLSL_TYPE_INT:
+      if (isnan(r.low) || isnan(r.high) ||
+          r.low < (double) INT32_MIN || r.high > (double) INT32_MAX)
+         return range(INT32_MIN, INT32_MAX);
+      return r;
+
+   case GLSL_TYPE_UINT:
+      if (isnan(r.low) || isnan(r.high) ||
+          r.low < 0.0 || r.high > (double) UINT32_MAX)
+         return range(0.0, UINT32_MAX);
+      return r;
+
+   default:
+      return unbounded();
+   }
+}
+
+static ir_range
+add(ir_range a, ir_range b)
+{
+   if (a.is_empty() || b.is_empty())
+      return empty();
+   return range(a.low + b.low, a.high + b.high);
+}
+
+static ir_range
+mul(ir_range a, ir_range b)
+{
+   if (a.is_empty() || b.is_empty())
+      return empty();
+
+   /* 0 * inf is nan, the products are taken bound by bound */
+   const double p[4] = {
+      a.low * b.low, a.low * b.high, a.high * b.low, a.high * b.high
+   };
+   ir_range r = empty();
+   for (unsigned i = 0; i < 4; i++) {
+      if (isnan(p[i]))
+         return unbounded();
+      r = hull(r, range(p[i], p[i]));
+   }
+   return r;
+}
+
+static ir_range
+neg(ir_range a)
+{
+   if (a.is_empty())
+      return a;
+   return range(-a.high, -a.low);
+}
+
+ir_range
+ir_value_range::eval_variable(ir_variable *var) const
+{
+   struct hash_entry *entry = _mesa_hash_table_search(this->vars, var);
+   if (entry != NULL)
+      return ((value_range_var *) entry->data)->range;
+
+   return unbounded();
+}
+
+ir_range
+ir_value_range::eval(ir_rvalue *ir) const
+{
+   switch (ir->ir_type) {
+   case ir_type_constant: {
+      ir_constant *c = (ir_constant *) ir;
+      if (!c->type->is_scalar() && !c->type->is_vector())
+         return unbounded();
+
+      ir_range r = empty();
+      for (unsigned i = 0; i < c->type->components(); i++) {
+         double v;
+         switch (c->type->base_type) {
+         case GLSL_TYPE_FLOAT: v = c->value.f[i]; break;
+         case GLSL_TYPE_INT:   v = c->value.i[i]; break;
+         case GLSL_TYPE_UINT:  v = c->value.u[i]; break;
+         default:              return unbounded();
+         }
+         if (isnan(v))
+            return unbounded();
+         r = hull(r, range(v, v));
+      }
+      return r;
+   }
+
+   case ir_type_dereference_variable:
+   case ir_type_dereference_array: {
+      /* a component of a vector or an element of an array */
+      ir_dereference *deref = (ir_dereference *) ir;
+      ir_dereference_array *a = ir->as_dereference_array();
+      while (a != NULL) {
+         deref = a->array->as_dereference();
+         if (deref == NULL)
+            return unbounded();
+         a = deref->as_dereference_array();
+      }
+
+      if (deref->ir_type != ir_type_dereference_variable)
+         return unbounded();
+      /* at least the range of the integer type */
+      return fit(eval_variable(((ir_dereference_variable *) deref)->var),
+                 ir->type->without_array());
+   }
+
+   case ir_type_swizzle:
+      return eval(((ir_swizzle *) ir)->val);
+
+   case ir_type_texture: {
+      ir_texture *tex = (ir_texture *) ir;
+      if (tex->type->base_type != GLSL_TYPE_FLOAT)
+         return unbounded();
+
+      switch (tex->op) {
+      case ir_tex:
+      case ir_txb:
+      case ir_txl:
+      case ir_txd:
+      case ir_txf:
+      case ir_txf_ms:
+      case ir_tg4:
+         /* a comparison, filtered or not */
+         if (tex->shadow_comparator != NULL || this->normalized_textures)
+            return range(0.0, 1.0);
+         return unbounded();
+      default:
+         return unbounded();
+      }
+   }
+
+   case ir_type_expression:
+      return eval_expression((ir_expression *) ir);
+
+   default:
+      return unbounded();
+   }
+}
+
+ir_range
+ir_value_range::eval_expression(ir_expression *ir) const
+{
+   if (!is_tracked_type(ir->type) || ir->type->is_matrix())
+      return unbounded();
+
+   ir_range op[4];
+   for (unsigned i = 0; i < ir->num_operands; i++) {
+      if (ir->operands[i]->type->is_matrix())
+         return unbounded();
+      op[i] = eval(ir->operands[i]);
+   }
+
+   /* the operands of b2f, b2i, csel conditions are booleans */
+   switch (ir->operation) {
+   case ir_unop_b2f:
+   case ir_unop_b2i:
+      return range(0.0, 1.0);
+   case ir_unop_saturate:
+      if (op[0].is_within(0.0, 1.0))
+         return op[0];
+      return op[0].is_empty() ? op[0] : range(0.0, 1.0);
+   case ir_unop_fract:
+      /* fract of a tiny negative rounds to 1.0 */
+      return op[0].is_empty() ? op[0] : range(0.0, 1.0);
+   case ir_unop_sin:
+   case ir_unop_cos:
+   case ir_unop_sign:
+      return op[0].is_empty() ? op[0] : range(-1.0, 1.0);
+   case ir_triop_csel:
+      if (op[1].is_empty() || op[2].is_empty())
+         return empty();
+      return hull(op[1], op[2]);
+   default:
+      break;
+   }
+
+   for (unsigned i = 0; i < ir->num_operands; i++) {
+      if (op[i].is_empty())
+         return empty();
+   }
+
+   const glsl_type *type = ir->type;
+   const bool is_float = type->base_type == GLSL_TYPE_FLOAT;
+
+   switch (ir->operation) {
+   case ir_unop_neg:
+      return fit(neg(op[0]), type);
+
+   case ir_unop_abs:
+      if (op[0].low >= 0.0)
+         return op[0];
+      if (op[0].high <= 0.0)
+         return fit(neg(op[0]), type);
+      return fit(range(0.0, MAX2(-op[0].low, op[0].high)), type);
+
+   case ir_unop_floor:
+      return range(floor(op[0].low), floor(op[0].high));
+   case ir_unop_ceil:
+      return range(ceil(op[0].low), ceil(op[0].high));
+   case ir_unop_trunc:
+      return range(trunc(op[0].low), trunc(op[0].high));
+   case ir_unop_round_even:
+      return range(floor(op[0].low), ceil(op[0].high));
+
+   case ir_unop_exp:
+   case ir_unop_exp2:
+      return range(0.0, INFINITY);
+
+   case ir_unop_sqrt:
+      if (op[0].high < 0.0)
+         return unbounded();
+      return fit(range(sqrt(MAX2(op[0].low, 0.0)), sqrt(op[0].high)),
+                 type, VALUE_RANGE_APPROX_ULPS);
+
+   case ir_unop_rsq:
+      if (op[0].low > 0.0)
+         return fit(range(1.0 / sqrt(op[0].high), 1.0 / sqrt(op[0].low)),
+                    type, VALUE_RANGE_APPROX_ULPS);
+      return range(0.0, INFINITY);
+
+   case ir_unop_rcp:
+      if (op[0].low > 0.0 || op[0].high < 0.0)
+         return fit(range(1.0 / op[0].high, 1.0 / op[0].low),
+                    type, VALUE_RANGE_APPROX_ULPS);
+      return unbounded();
+
+   case ir_unop_i2f:
+   case ir_unop_u2f:
+      return fit(op[0], type);
+
+   case ir_unop_f2i:
+   case ir_unop_f2u: {
+      /* out of the integer range, the conversion is undefined */
+      const ir_range r = range(trunc(op[0].low), trunc(op[0].high));
+      if (fit(r, type).low != r.low || fit(r, type).high != r.high)
+         return unbounded();
+      return r;
+   }
+
+   case ir_unop_i2u:
+   case ir_unop_u2i:
+      /* the same bits */
+      if (op[0].is_within(0.0, INT32_MAX))
+         return op[0];
+      return unbounded();
+
+   case ir_binop_add:
+      return fit(add(op[0], op[1]), type);
+
+   case ir_binop_sub:
+      return fit(add(op[0], neg(op[1])), type);
+
+   case ir_binop_mul:
+      return fit(mul(op[0], op[1]), type);
+
+   case ir_triop_fma:
+      /* fused or not */
+      return fit(add(fit(mul(op[0], op[1]), type), op[2]), type);
+
+   case ir_binop_dot: {
+      const unsigned n = ir->operands[0]->type->components();
+      return fit(mul(mul(op[0], op[1]), range(n, n)), type, n);
+   }
+
+   case ir_binop_div: {
+      if (op[1].low <= 0.0 && op[1].high >= 0.0)
+         return unbounded();
+
+      const ir_range r = mul(op[0], range(1.0 / op[1].high, 1.0 / op[1].low));
+      if (is_float) {
+         /* by a power of two, only the exponent changes */
+         int exp;
+         if (op[1].low == op[1].high && fabs(frexp(op[1].low, &exp)) == 0.5)
+            return fit(r, type);
+         return fit(r, type, VALUE_RANGE_APPROX_ULPS);
+      }
+
+      /* the integer division truncates */
+      const double q[4] = {
+         op[0].low / op[1].low, op[0].low / op[1].high,
+         op[0].high / op[1].low, op[0].high / op[1].high
+      };
+      ir_range t = empty();
+      for (unsigned i = 0; i < 4; i++)
+         t = hull(t, range(trunc(q[i]), trunc(q[i])));
+      return fit(t, type);
+   }
+
+   case ir_binop_mod:
+      if (op[1].low <= 0.0)
+         return unbounded();
+      if (is_float)
+         return fit(range(0.0, op[1].high), type);
+      if (op[0].low >= 0.0)
+         return range(0.0, op[1].high - 1.0);
+      return unbounded();
+
+   case ir_binop_bit_and:
+      if (op[0].low >= 0.0 && op[1].low >= 0.0)
+         return range(0.0, MIN2(op[0].high, op[1].high));
+      if (op[0].low >= 0.0)
+         return range(0.0, op[0].high);
+      if (op[1].low >= 0.0)
+         return range(0.0, op[1].high);
+      return unbounded();
+
+   case ir_binop_min:
+      return range(MIN2(op[0].low, op[1].low), MIN2(op[0].high, op[1].high));
+
+   case ir_binop_max:
+      return range(MAX2(op[0].low, op[1].low), MAX2(op[0].high, op[1].high));
+
+   case ir_binop_vector_extract:
+      return op[0];
+
+   case ir_triop_lrp:
+      /* a + t * (b - a) may round a bit out of the hull */
+      if (op[2].is_within(0.0, 1.0))
+         return fit(hull(op[0], op[1]), type, VALUE_RANGE_APPROX_ULPS);
+      return unbounded();
+
+   case ir_quadop_vector: {
+      ir_range r = empty();
+      for (unsigned i = 0; i < ir->num_operands; i++)
+         r = hull(r, op[i]);
+      return r;
+   }
+
+   default:
+      return unbounded();
+   }
+}
+
+/**
+ * The variables, their writes, who reads what they write, the calls and
+ * the loops.
+ */
+class value_range_collector : public ir_hierarchical_visitor {
+public:
+   value_range_collector(ir_value_range *ranges)
+      : ranges(ranges), current(-1)
+   {
+      util_dynarray_init(&this->writes, ranges->mem_ctx);
+      util_dynarray_init(&this->escaped, ranges->mem_ctx);
+      util_dynarray_init(&this->loops, ranges->mem_ctx);
+   }
+
+   value_range_var *get(ir_variable *var)
+   {
+      struct hash_entry *entry = var ?
+         _mesa_hash_table_search(this->ranges->vars, var) : NULL;
+      return entry ? (value_range_var *) entry->data : NULL;
+   }
+
+   /** The state of a local variable, made on his first use */
+   value_range_var *track(ir_variable *var)
+   {
+      if (var == NULL ||
+          (var->data.mode != ir_var_auto &&
+           var->data.mode != ir_var_temporary) ||
+          !is_tracked_type(var->type))
+         return NULL;
+
+      value_range_var *v = get(var);
+      if (v == NULL) {
+         v = rzalloc(this->ranges->mem_ctx, value_range_var);
+         v->range = empty();
+         util_dynarray_init(&v->readers, this->ranges->mem_ctx);
+         _mesa_hash_table_insert(this->ranges->vars, var, v);
+      }
+      return v;
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      value_range_var *v = track(var);
+      if (v != NULL) {
+         v->declared = true;
+         if (var->constant_initializer)
+            v->range = this->ranges->eval(var->constant_initializer);
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *deref)
+   {
+      value_range_var *v = this->current >= 0 ? track(deref->var) : NULL;
+      if (v == NULL)
+         return visit_continue;
+
+      const unsigned n = util_dynarray_num_elements(&v->readers, unsigned);
+      if (n == 0 ||
+          *util_dynarray_element(&v->readers, unsigned, n - 1) !=
+          (unsigned) this->current)
+         util_dynarray_append(&v->readers, unsigned, this->current);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      value_range_var *v = track(ir->lhs->variable_referenced());
+      if (v == NULL)
+         return visit_continue_with_parent;
+
+      v->writes++;
+      this->current = util_dynarray_num_elements(&this->writes,
+                                                 ir_assignment *);
+      util_dynarray_append(&this->writes, ir_assignment *, ir);
+
+      /* only the rhs gives the range */
+      ir->rhs->accept(this);
+      this->current = -1;
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      if (ir->return_deref != NULL)
+         util_dynarray_append(&this->escaped, ir_variable *,
+                              ir->return_deref->variable_referenced());
+
+      foreach_two_lists(formal_node, &ir->callee->parameters,
+                        actual_node, &ir->actual_parameters) {
+         ir_variable *formal = (ir_variable *) formal_node;
+         ir_rvalue *actual = (ir_rvalue *) actual_node;
+
+         if (formal->data.mode == ir_var_function_out ||
+             formal->data.mode == ir_var_function_inout)
+            util_dynarray_append(&this->escaped, ir_variable *,
+                                 actual->variable_referenced());
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_loop *ir)
+   {
+      util_dynarray_append(&this->loops, ir_loop *, ir);
+      return visit_continue;
+   }
+
+   void add_inductions(ir_loop *ir, loop_state *loops);
+
+   ir_value_range *ranges;
+   int current;                  /**< index of the write visited, or -1 */
+   struct util_dynarray writes;  /**< ir_assignment * to tracked variables */
+   struct util_dynarray escaped; /**< ir_variable * written by the calls */
+   struct util_dynarray loops;   /**< ir_loop * */
+};
+
+/* like find_initial_value of the loop analysis, but the assignment */
+static ir_assignment *
+find_initial_assignment(ir_loop *loop, ir_variable *var)
+{
+   for (exec_node *node = loop->prev; !node->is_head_sentinel();
+        node = node->prev) {
+      ir_instruction *ir = (ir_instruction *) node;
+
+      switch (ir->ir_type) {
+      case ir_type_call:
+      case ir_type_loop:
+      case ir_type_loop_jump:
+      case ir_type_return:
+      case ir_type_if:
+         return NULL;
+
+      case ir_type_assignment: {
+         ir_assignment *assign = (ir_assignment *) ir;
+         if (assign->lhs->whole_variable_referenced() == var)
+            return assign->condition == NULL ? assign : NULL;
+         break;
+      }
+
+      default:
+         break;
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * The limiting terminator exits in the iteration `iterations`, the
+ * instructions of the body before it run once more than the ones after.
+ */
+static bool
+is_before_terminator(ir_loop *loop, ir_instruction *ir, ir_if *terminator)
+{
+   foreach_in_list(ir_instruction, node, &loop->body_instructions) {
+      if (node == ir)
+         return true;
+      if (node == terminator)
+         return false;
+   }
+   return true;
+}
+
+void
+value_range_collector::add_inductions(ir_loop *ir, loop_state *loops)
+{
+   loop_variable_state *ls = loops->get(ir);
+   if (ls == NULL || ls->limiting_terminator == NULL ||
+       ls->limiting_terminator->iterations < 0)
+      return;
+
+   foreach_in_list(loop_variable, lv, &ls->induction_variables) {
+      if (lv->num_assignments != 1 || lv->conditional_or_nested_assignment ||
+          lv->first_assignment == NULL || !lv->var->type->is_scalar())
+         continue;
+
+      /* the trip count is only known from a constant initial value */
+      ir_constant *inc =
+         lv->increment->constant_expression_value(this->ranges->mem_ctx);
+      ir_assignment *init = find_initial_assignment(ir, lv->var);
+      if (inc == NULL || init == NULL || init->rhs->as_constant() == NULL)
+         continue;
+
+      value_range_induction *induction =
+         ralloc(this->ranges->mem_ctx, value_range_induction);
+      induction->init = init->rhs;
+      induction->increment = inc->get_float_component(0);
+      induction->count = ls->limiting_terminator->iterations;
+      if (is_before_terminator(ir, lv->first_assignment,
+                               ls->limiting_terminator->ir))
+         induction->count++;
+      _mesa_hash_table_insert(this->ranges->inductions,
+                              lv->first_assignment, induction);
+   }
+}
+
+ir_value_range::ir_value_range(exec_list *instructions, loop_state *loops,
+                               bool normalized_textures)
+   : instructions(instructions), loops(loops),
+     normalized_textures(normalized_textures), built(false)
+{
+   this->mem_ctx = ralloc_context(NULL);
+   this->vars = _mesa_pointer_hash_table_create(this->mem_ctx);
+   this->inductions = _mesa_pointer_hash_table_create(this->mem_ctx);
+}
+
+ir_value_range::~ir_value_range()
+{
+   ralloc_free(this->mem_ctx);
+}
+
+ir_range
+ir_value_range::get(ir_rvalue *ir)
+{
+   if (!this->built)
+      build();
+
+   const ir_range r = eval(ir);
+   return r.is_empty() ? unbounded() : r;
+}
+
+ir_range
+ir_value_range::eval_assignment(ir_assignment *ir, ir_variable *var) const
+{
+   struct hash_entry *entry = this->inductions->entries != 0 ?
+      _mesa_hash_table_search(this->inductions, ir) : NULL;
+   if (entry == NULL)
+      return eval(ir->rhs);
+
+   /* init + k * inc, k in [1, count] */
+   const value_range_induction *i = (const value_range_induction *) entry->data;
+   const ir_range init = eval(i->init);
+   const double inc = i->increment;
+   const double last = inc * i->count;
+   if (init.is_empty() || i->count == 0)
+      return empty();
+
+   ir_range r = add(init, inc > 0.0 ? range(inc, last) : range(last, inc));
+
+   /* the float sums are exact only on the small integers */
+   if (var->type->is_float() &&
+       (r.low != floor(r.low) || r.high != floor(r.high) ||
+        !r.is_within(-16777216.0, 16777216.0)))
+      return unbounded();
+   return fit(r, var->type);
+}
+
+bool
+ir_value_range::merge(value_range_var *v, ir_range r)
+{
+   ir_range merged = hull(v->range, r);
+   if (merged.low == v->range.low && merged.high == v->range.high)
+      return false;
+
+   if (++v->changes > VALUE_RANGE_MAX_CHANGES && !v->range.is_empty()) {
+      if (merged.low < v->range.low)
+         merged.low = -INFINITY;
+      if (merged.high > v->range.high)
+         merged.high = INFINITY;
+   }
+
+   v->range = merged;
+   return true;
+}
+
+void
+ir_value_range::build()
+{
+   this->built = true;
+
+   value_range_collector collector(this);
+   visit_list_elements(&collector, this->instructions);
+
+   if (util_dynarray_num_elements(&collector.loops, ir_loop *) != 0) {
+      loop_state *loops = this->loops;
+      if (loops == NULL)
+         loops = analyze_loop_variables(this->instructions);
+
+      util_dynarray_foreach(&collector.loops, ir_loop *, loop)
+         collector.add_inductions(*loop, loops);
+
+      if (loops != this->loops)
+         delete loops;
+   }
+   this->loops = NULL;
+
+   util_dynarray_foreach(&collector.escaped, ir_variable *, var) {
+      value_range_var *v = collector.get(*var);
+      if (v != NULL)
+         v->escaped = true;
+   }
+
+   hash_table_foreach(this->vars, entry) {
+      value_range_var *v = (value_range_var *) entry->data;
+      if (!v->declared)
+         v->escaped = true;
+      if (v->escaped || (v->range.is_empty() && v->writes == 0))
+         v->range = unbounded();
+   }
+
+   /* the writes to evaluate again, each once in the list */
+   const unsigned count = util_dynarray_num_elements(&collector.writes,
+                                                     ir_assignment *);
+   ir_assignment **writes = (ir_assignment **) collector.writes.data;
+   BITSET_WORD *queued = rzalloc_array(this->mem_ctx, BITSET_WORD,
+                                       BITSET_WORDS(count) + 1);
+   unsigned *worklist = ralloc_array(this->mem_ctx, unsigned, count + 1);
+   unsigned pending = 0;
+
+   for (unsigned i = count; i-- > 0;) {
+      worklist[pending++] = i;
+      BITSET_SET(queued, i);
+   }
+
+   while (pending != 0) {
+      const unsigned i = worklist[--pending];
+      BITSET_CLEAR(queued, i);
+
+      ir_variable *var = writes[i]->lhs->variable_referenced();
+      value_range_var *v = collector.get(var);
+      if (v->escaped)
+         continue;
+
+      const ir_range r = eval_assignment(writes[i], var);
+      if (r.is_empty() || !merge(v, r))
+         continue;
+
+      util_dynarray_foreach(&v->readers, unsigned, reader) {
+         if (!BITSET_TEST(queued, *reader)) {
+            worklist[pending++] = *reader;
+            BITSET_SET(queued, *reader);
+         }
+      }
+   }
+
+   hash_table_foreach(this->vars, entry) {
+      value_range_var *v = (value_range_var *) entry->data;
+      if (v->range.is_empty())
+         v->range = unbounded();
+   }
+}
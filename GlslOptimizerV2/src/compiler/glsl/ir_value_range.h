@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file ir_value_range.h
+ * Range of the values of the numeric rvalues, for do_minmax_prune and
+ * do_algebraic.
+ *
+ * A range is an interval holding all the components of the value.  The
+ * expressions get theirs from their operands : fixed ones for saturate,
+ * fract, sin, cos, sign, b2f, the shadow samplers (and all the float
+ * samplers when the textures are known to be normalized), interval
+ * arithmetic for the others.  The float bounds are rounded outward, and
+ * widened by a few ulps for the operations the GPUs only approximate.
+ *
+ * A local variable gets the union of the ranges of all his writes, this is
+ * flow insensitive.  The union is iterated until stable, a write being
+ * evaluated again only when a variable it reads grows, and a bound still
+ * growing after a few changes goes to the infinite.  The increment of a
+ * loop induction variable with a known trip count is bounded by his
+ * initial value and the count, from the loop analysis.
+ *
+ * The analysis is done on the first query.  Any change of the ir but the
+ * replacement of an expression by an equal one makes it invalid.
+ */
+
+#ifndef GLSL_IR_VALUE_RANGE_H
+#define GLSL_IR_VALUE_RANGE_H
+
+#include "ir.h"
+
+struct hash_table;
+struct value_range_var;
+class loop_state;
+
+struct ir_range {
+   double low;   /**< -INFINITY if unbounded */
+   double high;  /**< +INFINITY if unbounded */
+
+   bool is_empty() const
+   {
+      return this->low > this->high;
+   }
+
+   bool is_within(double low, double high) const
+   {
+      return this->low >= low && this->high <= high;
+   }
+};
+
+class ir_value_range {
+public:
+   /**
+    * \param loops  analysis of the loops of the ir, NULL to do it if needed
+    * \param normalized_textures  the float samplers all read unorm formats
+    */
+   ir_value_range(exec_list *instructions, loop_state *loops = NULL,
+                  bool normalized_textures = false);
+   ~ir_value_range();
+
+   /** Unbounded if nothing is known */
+   ir_range get(ir_rvalue *ir);
+
+private:
+   friend class value_range_collector;
+
+   void build();
+   bool merge(struct value_range_var *v, ir_range r);
+   ir_range eval(ir_rvalue *ir) const;
+   ir_range eval_expression(ir_expression *ir) const;
+   ir_range eval_variable(ir_variable *var) const;
+   ir_range eval_assignment(ir_assignment *ir, ir_variable *var) const;
+
+   exec_list *instructions;
+   loop_state *loops;
+   bool normalized_textures;
+   bool built;
+
+   void *mem_ctx;
+   struct hash_table *vars;       /**< ir_variable -> value_range_var */
+   struct hash_table *inductions; /**< ir_assignment -> value_range_induction */
+};
+
+#endif /* GLSL_IR_VALUE_RANGE_H */
@@ -42,9 +42,25 @@ is_break(ir_instruction *ir)
 }
 
 
+/**
+ * One decision of the loop unroller, given to the report callback of
+ * unroll_loops for each analyzed loop.
+ */
+struct loop_unroll_decision {
+   const char *function;  /**< Name of the function holding the loop */
+   int iterations;        /**< Trip count, -1 when not known */
+   int body_cost;         /**< Estimated instructions of one iteration */
+   int factor;            /**< Copies of the body, 0 when the loop is kept */
+   const char *decision;
+};
+
+typedef void (*loop_unroll_report_cb)(const struct loop_unroll_decision *d,
+                                      void *data);
+
 extern bool
 unroll_loops(exec_list *instructions, loop_state *ls,
-             const struct gl_shader_compiler_options *options);
+             const struct gl_shader_compiler_options *options,
+             loop_unroll_report_cb report = NULL, void *report_data = NULL);
 
 
 /**
@@ -32,15 +32,25 @@ namespace {
 class loop_unroll_visitor : public ir_hierarchical_visitor {
 public:
    loop_unroll_visitor(loop_state *state,
-                       const struct gl_shader_compiler_options *options)
+                       const struct gl_shader_compiler_options *options,
+                       loop_unroll_report_cb report_cb, void *report_data)
    {
       this->state = state;
       this->progress = false;
       this->options = options;
+      this->report_cb = report_cb;
+      this->report_data = report_data;
+      this->function = "";
    }
 
+   virtual ir_visitor_status visit_enter(ir_function_signature *ir);
    virtual ir_visitor_status visit_leave(ir_loop *ir);
    void simple_unroll(ir_loop *ir, int iterations);
+   int partial_unroll_factor(ir_loop *ir, loop_variable_state *ls,
+                             int iterations, int body_cost, int budget);
+   void partial_unroll(ir_loop *ir, int factor);
+   void report(int iterations, int body_cost, int factor,
+               const char *decision);
    void complex_unroll(ir_loop *ir, int iterations,
                        bool continue_from_then_branch,
                        bool limiting_term_first,
@@ -51,13 +61,24 @@ public:
 
    bool progress;
    const struct gl_shader_compiler_options *options;
+
+   loop_unroll_report_cb report_cb;
+   void *report_data;
+   const char *function;
 };
 
 } /* anonymous namespace */
 
+/**
+ * Estimate of the instructions of a loop body.  With a MaxUnrollInstructions
+ * budget, the texture lookups and the calls count too, and an operation on a
+ * matrix counts once per column, since it is done column by column.  Without
+ * it, only the assignments and the expressions are counted, as they always
+ * were against MaxUnrollIterations * 5, so the decisions don't change.
+ */
 class loop_unroll_count : public ir_hierarchical_visitor {
 public:
-   int nodes;
+   int cost;
    bool unsupported_variable_indexing;
    bool array_indexed_by_induction_var_with_exact_iterations;
    /* If there are nested loops, the node count will be inaccurate. */
@@ -67,7 +88,8 @@ public:
                      const struct gl_shader_compiler_options *options)
       : ls(ls), options(options)
    {
-      nodes = 0;
+      cost = 0;
+      weighted = options->MaxUnrollInstructions != 0;
       nested_loop = false;
       unsupported_variable_indexing = false;
       array_indexed_by_induction_var_with_exact_iterations = false;
@@ -77,13 +99,27 @@ public:
 
    virtual ir_visitor_status visit_enter(ir_assignment *)
    {
-      nodes++;
+      cost++;
       return visit_continue;
    }
 
-   virtual ir_visitor_status visit_enter(ir_expression *)
+   virtual ir_visitor_status visit_enter(ir_expression *ir)
    {
-      nodes++;
+      cost += weighted && ir->type->is_matrix() ? ir->type->matrix_columns : 1;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_texture *)
+   {
+      if (weighted)
+         cost++;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *)
+   {
+      if (weighted)
+         cost++;
       return visit_continue;
    }
 
@@ -161,6 +197,7 @@ public:
 private:
    loop_variable_state *ls;
    const struct gl_shader_compiler_options *options;
+   bool weighted; /**< the cost of a MaxUnrollInstructions budget */
 };
 
 
@@ -248,6 +285,110 @@ loop_unroll_visitor::simple_unroll(ir_loop *ir, int iterations)
 }
 
 
+/**
+ * Unroll a loop by a factor of its trip count, keeping the loop.  The loop
+ * must start with its limiting terminator, an if holding only the break, and
+ * contain no other jump.  For example, if the input is:
+ *
+ *     (loop (
+ *      (if (cond) (break))
+ *      ...instrs...))
+ *
+ * And the factor is 3, the output will be:
+ *
+ *     (loop (
+ *      (if (cond) (break))
+ *      ...instrs... ...instrs... ...instrs...))
+ *
+ * Since the factor divides the trip count, the condition is still true at
+ * the same iteration as before, it is only tested less often.
+ */
+void
+loop_unroll_visitor::partial_unroll(ir_loop *ir, int factor)
+{
+   void *const mem_ctx = ralloc_parent(ir);
+
+   /* the body of one iteration, without the terminator */
+   exec_list iteration;
+   iteration.make_empty();
+   clone_ir_list(mem_ctx, &iteration, &ir->body_instructions);
+   ((ir_instruction *) iteration.get_head())->remove();
+
+   for (int i = 2; i < factor; i++) {
+      exec_list copy_list;
+
+      copy_list.make_empty();
+      clone_ir_list(mem_ctx, &copy_list, &iteration);
+
+      ir->body_instructions.append_list(&copy_list);
+   }
+
+   ir->body_instructions.append_list(&iteration);
+
+   this->progress = true;
+}
+
+
+/**
+ * The biggest factor of the trip count who keep the unrolled body in the
+ * budget, or 0 if the loop can't be partially unrolled.
+ */
+int
+loop_unroll_visitor::partial_unroll_factor(ir_loop *ir,
+                                           loop_variable_state *ls,
+                                           int iterations, int body_cost,
+                                           int budget)
+{
+   if (!options->UnrollPartial || body_cost <= 0 || iterations < 4)
+      return 0;
+
+   /* the limiting terminator is the only jump of the loop */
+   if (ls->num_loop_jumps != 1 || ls->terminators.length() != 1)
+      return 0;
+
+   ir_if *limit_if = ls->limiting_terminator->ir;
+   if ((ir_instruction *) ir->body_instructions.get_head() != limit_if)
+      return 0;
+
+   /* if (cond) break; or if (cond) {} else break; with nothing else */
+   exec_list *exit_list = &limit_if->then_instructions;
+   exec_list *continue_list = &limit_if->else_instructions;
+   if (!is_break((ir_instruction *) exit_list->get_tail())) {
+      exit_list = &limit_if->else_instructions;
+      continue_list = &limit_if->then_instructions;
+   }
+   if (!is_break((ir_instruction *) exit_list->get_tail()) ||
+       exit_list->get_head() != exit_list->get_tail() ||
+       !continue_list->is_empty())
+      return 0;
+
+   int factor = MIN2(budget / body_cost, (int) options->MaxUnrollIterations);
+   for (; factor >= 2; factor--) {
+      if (factor < iterations && iterations % factor == 0)
+         return factor;
+   }
+
+   return 0;
+}
+
+
+void
+loop_unroll_visitor::report(int iterations, int body_cost, int factor,
+                            const char *decision)
+{
+   if (report_cb == NULL)
+      return;
+
+   struct loop_unroll_decision d;
+   d.function = function;
+   d.iterations = iterations;
+   d.body_cost = body_cost;
+   d.factor = factor;
+   d.decision = decision;
+   report_cb(&d, report_data);
+}
+
+
 /**
  * Unroll a loop whose last statement is an ir_if.  If \c
  * continue_from_then_branch is true, the loop is repeated only when the
@@ -377,6 +518,13 @@ exit_branch_has_instructions(ir_if *term_if, bool lt_then_continue)
    return true;
 }
 
+ir_visitor_status
+loop_unroll_visitor::visit_enter(ir_function_signature *ir)
+{
+   function = ir->function_name();
+   return visit_continue;
+}
+
 ir_visitor_status
 loop_unroll_visitor::visit_leave(ir_loop *ir)
 {
@@ -455,33 +603,52 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
          last_ir->remove();
 
          simple_unroll(ir, 1);
+         report(1, 0, 1, "full, do-while(false)");
+         return visit_continue;
       }
 
       /* Don't try to unroll loops where the number of iterations is not known
        * at compile-time.
        */
+      report(-1, 0, 0, "kept, unknown trip count");
       return visit_continue;
    }
 
    int iterations = ls->limiting_terminator->iterations;
 
    const int max_iterations = options->MaxUnrollIterations;
+   const int budget = options->MaxUnrollInstructions ?
+      (int) options->MaxUnrollInstructions : max_iterations * 5;
 
-   /* Don't try to unroll loops that have zillions of iterations either.
-    */
-   if (iterations > max_iterations)
-      return visit_continue;
-
-   /* Don't try to unroll nested loops and loops with a huge body.
-    */
    loop_unroll_count count(&ir->body_instructions, ls, options);
 
-   bool loop_too_large =
-      count.nested_loop || count.nodes * iterations > max_iterations * 5;
-
-   if (loop_too_large && !count.unsupported_variable_indexing &&
-       !count.array_indexed_by_induction_var_with_exact_iterations)
+   /* Don't try to unroll loops that have zillions of iterations either,
+    * nor nested loops and loops whose unrolled body is over the budget.
+    * What fit in the budget may still be unrolled by a factor of the trip
+    * count.
+    */
+   const char *kept = NULL;
+   if (iterations > max_iterations)
+      kept = "kept, too many iterations";
+   else if (count.unsupported_variable_indexing ||
+            count.array_indexed_by_induction_var_with_exact_iterations)
+      kept = NULL;
+   else if (count.nested_loop)
+      kept = "kept, nested loop";
+   else if (count.cost * iterations > budget)
+      kept = "kept, over budget";
+
+   if (kept) {
+      const int factor = count.nested_loop ? 0 :
+         partial_unroll_factor(ir, ls, iterations, count.cost, budget);
+      if (factor) {
+         partial_unroll(ir, factor);
+         report(iterations, count.cost, factor, "partial");
+      } else {
+         report(iterations, count.cost, 0, kept);
+      }
       return visit_continue;
+   }
 
    /* Note: the limiting terminator contributes 1 to ls->num_loop_jumps.
     * We'll be removing the limiting terminator before we unroll.
@@ -489,11 +656,14 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
    assert(ls->num_loop_jumps > 0);
    unsigned predicted_num_loop_jumps = ls->num_loop_jumps - 1;
 
-   if (predicted_num_loop_jumps > 1)
+   if (predicted_num_loop_jumps > 1) {
+      report(iterations, count.cost, 0, "kept, too many jumps");
       return visit_continue;
+   }
 
    if (predicted_num_loop_jumps == 0) {
       simple_unroll(ir, iterations);
+      report(iterations, count.cost, iterations, "full");
       return visit_continue;
    }
 
@@ -508,6 +678,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
       last_ir->remove();
 
       simple_unroll(ir, 1);
+      report(iterations, count.cost, 1, "full, break at the end");
       return visit_continue;
    }
 
@@ -518,8 +689,10 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
     * isn't any additional unknown terminators, or any other jumps nested
     * inside futher ifs.
     */
-   if (ls->num_loop_jumps != 2 || ls->terminators.length() != 2)
+   if (ls->num_loop_jumps != 2 || ls->terminators.length() != 2) {
+      report(iterations, count.cost, 0, "kept, unknown terminators");
       return visit_continue;
+   }
 
    ir_instruction *first_ir =
       (ir_instruction *) ir->body_instructions.get_head();
@@ -544,6 +717,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
                            first_ir->as_if() != ls->limiting_terminator->ir ||
                            ebi,
                            first_term_then_continue);
+            report(iterations, count.cost, iterations, "full, complex");
             return visit_continue;
          }
       } else {
@@ -562,6 +736,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
                               first_ir->as_if() != ls->limiting_terminator->ir ||
                               ebi,
                               first_term_then_continue);
+               report(iterations, count.cost, iterations, "full, complex");
                return visit_continue;
             } else {
                first_term_then_continue = true;
@@ -575,15 +750,17 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
    /* Did not find the break statement.  It must be in a complex if-nesting,
     * so don't try to unroll.
     */
+   report(iterations, count.cost, 0, "kept, break in nested ifs");
    return visit_continue;
 }
 
 
 bool
 unroll_loops(exec_list *instructions, loop_state *ls,
-             const struct gl_shader_compiler_options *options)
+             const struct gl_shader_compiler_options *options,
+             loop_unroll_report_cb report, void *report_data)
 {
-   loop_unroll_visitor v(ls, options);
+   loop_unroll_visitor v(ls, options, report, report_data);
 
    v.run(instructions);
 
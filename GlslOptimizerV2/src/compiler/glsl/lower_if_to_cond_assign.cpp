@@ -33,6 +33,9 @@
  *   (controlled by min_branch_cost, that's the cost for a branch to be
  *    preserved)
  *
+ * - the flattened branch is estimated to run less work than the branch
+ *   (controlled by branch_cost, the cost of the branch itself)
+ *
  * It can't handle other control flow being inside of its block, such
  * as calls or loops.  Hopefully loop unrolling and inlining will take
  * care of those.
@@ -49,26 +52,50 @@
  *    lower_if_to_cond_assign(instructions, N)
  *
  * to attempt to flatten any if-statements appearing at depth > N.
+ *
+ * The cost of a block is the sum of the weights of its assignments,
+ * expressions and texture lookups, in units of a simple alu op.  The
+ * flattened code runs both blocks and the conditions.  The branch is
+ * estimated for groups of invocations diverging half of the time, running
+ * both blocks, and else running one block or the other :
+ *
+ *    branch_cost + 3 / 4 * (then_cost + else_cost)
+ *
+ * A branch on a dynamically uniform condition never diverges, it is kept by
+ * the cost model, but not from min_branch_cost : the moves of a small block
+ * are cheaper conditional than behind any branch.  Blocks with a discard
+ * or a non constant array index are kept in both cases.
  */
 
+#include <limits.h>
 #include "compiler/glsl_types.h"
 #include "ir.h"
+#include "ir_uniformity.h"
 #include "util/set.h"
 #include "util/hash_table.h" /* Needed for the hashing functions */
 #include "main/macros.h" /* for MAX2 */
 
+/* weights of the cost model */
+#define IF_COST_ALU            1
+#define IF_COST_TRANSCENDENTAL 4
+#define IF_COST_TEXTURE        16
+
 namespace {
 
 class ir_if_to_cond_assign_visitor : public ir_hierarchical_visitor {
 public:
    ir_if_to_cond_assign_visitor(gl_shader_stage stage,
+                                exec_list *instructions,
                                 unsigned max_depth,
-                                unsigned min_branch_cost)
+                                unsigned min_branch_cost,
+                                unsigned branch_cost)
+      : uniformity(instructions)
    {
       this->progress = false;
       this->stage = stage;
       this->max_depth = max_depth;
       this->min_branch_cost = min_branch_cost;
+      this->branch_cost = branch_cost;
       this->depth = 0;
 
       this->condition_variables = _mesa_pointer_set_create(NULL);
@@ -79,6 +106,23 @@ public:
       _mesa_set_destroy(this->condition_variables, NULL);
    }
 
+   void add_cost(unsigned cost)
+   {
+      if (this->is_then)
+         this->then_cost += cost;
+      else
+         this->else_cost += cost;
+   }
+
+   /* a node counted against min_branch_cost */
+   void add_node()
+   {
+      if (this->is_then)
+         this->then_nodes++;
+      else
+         this->else_nodes++;
+   }
+
    ir_visitor_status visit_enter(ir_if *);
    ir_visitor_status visit_leave(ir_if *);
 
@@ -90,29 +134,63 @@ public:
    gl_shader_stage stage;
    unsigned then_cost;
    unsigned else_cost;
+   unsigned then_nodes;
+   unsigned else_nodes;
    unsigned min_branch_cost;
+   unsigned branch_cost;
    unsigned max_depth;
    unsigned depth;
 
    struct set *condition_variables;
+   ir_uniformity uniformity;
 };
 
 } /* anonymous namespace */
 
 bool
 lower_if_to_cond_assign(gl_shader_stage stage, exec_list *instructions,
-                        unsigned max_depth, unsigned min_branch_cost)
+                        unsigned max_depth, unsigned min_branch_cost,
+                        unsigned branch_cost)
 {
    if (max_depth == UINT_MAX)
       return false;
 
-   ir_if_to_cond_assign_visitor v(stage, max_depth, min_branch_cost);
+   ir_if_to_cond_assign_visitor v(stage, instructions, max_depth,
+                                  min_branch_cost, branch_cost);
 
    visit_list_elements(&v, instructions);
 
    return v.progress;
 }
 
+static unsigned
+expression_cost(const ir_expression *ir)
+{
+   unsigned cost;
+
+   switch (ir->operation) {
+   case ir_unop_rcp:
+   case ir_unop_rsq:
+   case ir_unop_sqrt:
+   case ir_unop_exp:
+   case ir_unop_log:
+   case ir_unop_exp2:
+   case ir_unop_log2:
+   case ir_unop_sin:
+   case ir_unop_cos:
+   case ir_binop_div:
+   case ir_binop_mod:
+   case ir_binop_pow:
+      cost = IF_COST_TRANSCENDENTAL;
+      break;
+   default:
+      cost = IF_COST_ALU;
+      break;
+   }
+
+   return ir->type->is_matrix() ? cost * ir->type->matrix_columns : cost;
+}
+
 static void
 check_ir_node(ir_instruction *ir, void *data)
 {
@@ -127,6 +205,10 @@ check_ir_node(ir_instruction *ir, void *data)
    case ir_type_emit_vertex:
    case ir_type_end_primitive:
    case ir_type_barrier:
+   /* an inner if that was kept, the assignments only get the
+    * condition when moved out
+    */
+   case ir_type_if:
       v->found_unsupported_op = true;
       break;
 
@@ -145,6 +227,7 @@ check_ir_node(ir_instruction *ir, void *data)
    /* SSBO, images, atomic counters are handled by ir_type_call */
    case ir_type_texture:
       v->found_expensive_op = true;
+      v->add_cost(IF_COST_TEXTURE);
       break;
 
    case ir_type_dereference_array: {
@@ -152,13 +235,22 @@ check_ir_node(ir_instruction *ir, void *data)
 
       if (deref->array_index->ir_type != ir_type_constant)
          v->found_dynamic_arrayref = true;
-   } /* fall-through */
-   case ir_type_expression:
+      v->add_node();
+      break;
+   }
+
    case ir_type_dereference_record:
-      if (v->is_then)
-         v->then_cost++;
-      else
-         v->else_cost++;
+      v->add_node();
+      break;
+
+   case ir_type_expression:
+      v->add_node();
+      v->add_cost(expression_cost((ir_expression *) ir));
+      break;
+
+   /* a move, conditional once flattened */
+   case ir_type_assignment:
+      v->add_cost(IF_COST_ALU);
       break;
 
    default:
@@ -227,7 +319,7 @@ ir_if_to_cond_assign_visitor::visit_leave(ir_if *ir)
    bool must_lower = this->depth-- > this->max_depth;
 
    /* Only flatten when beyond the GPU's maximum supported nesting depth. */
-   if (!must_lower && this->min_branch_cost == 0)
+   if (!must_lower && this->min_branch_cost == 0 && this->branch_cost == 0)
       return visit_continue;
 
    this->found_unsupported_op = false;
@@ -235,6 +327,8 @@ ir_if_to_cond_assign_visitor::visit_leave(ir_if *ir)
    this->found_dynamic_arrayref = false;
    this->then_cost = 0;
    this->else_cost = 0;
+   this->then_nodes = 0;
+   this->else_nodes = 0;
 
    ir_assignment *assign;
 
@@ -252,19 +346,36 @@ ir_if_to_cond_assign_visitor::visit_leave(ir_if *ir)
    if (this->found_unsupported_op)
       return visit_continue; /* can't handle inner unsupported opcodes */
 
-   /* Skip if the branch cost is high enough or if there's an expensive op.
-    *
-    * Also skip if non-constant array indices were encountered, since those
+   /* Skip if non-constant array indices were encountered, since those
     * can be out-of-bounds for a not-taken branch, and so generating an
     * assignment would be incorrect. In the case of must_lower, it's up to the
     * backend to deal with any potential fall-out (perhaps by translating the
     * assignments to hardware-predicated moves).
     */
-   if (!must_lower &&
-       (this->found_expensive_op ||
-        this->found_dynamic_arrayref ||
-        MAX2(this->then_cost, this->else_cost) >= this->min_branch_cost))
-      return visit_continue;
+   if (!must_lower) {
+      if (this->found_dynamic_arrayref)
+         return visit_continue;
+
+      /* Skip if the branch cost is high enough or if there's an expensive
+       * op, then ask the cost model.
+       */
+      const bool small = !this->found_expensive_op &&
+         MAX2(this->then_nodes, this->else_nodes) < this->min_branch_cost;
+      if (!small) {
+         if (this->branch_cost == 0 ||
+             this->uniformity.is_uniform(ir->condition))
+            return visit_continue;
+
+         /* the flattened blocks and the conditions, against the branch, in
+          * quarters of alu op
+          */
+         const unsigned blocks = this->then_cost + this->else_cost;
+         const unsigned conditions =
+            ir->else_instructions.is_empty() ? IF_COST_ALU : 3 * IF_COST_ALU;
+         if (4 * (blocks + conditions) >= 4 * this->branch_cost + 3 * blocks)
+            return visit_continue;
+      }
+   }
 
    void *mem_ctx = ralloc_parent(ir);
 
@@ -44,6 +44,14 @@
  * temporary is conditionally assigned to each element of the canonical form
  * by comparing \c i with each index.  The same clone-and-replace scheme is
  * used.
+ *
+ * The compares are done by blocks of four indices.  An array of up to
+ * \c linear_max_length elements is lowered to a single chain of conditional
+ * moves, so a read of N elements costs N - 1 of them.  A longer array is
+ * split by a balanced tree of \c if statements on the index, down to the
+ * blocks of four, so a read costs log2(N / 4) branches, one move and at most
+ * three conditional ones.  The arrays longer than \c max_length are left with their indirect
+ * addressing, for the drivers who can afford it on the big ones.
  */
 
 #include "ir.h"
@@ -278,7 +286,10 @@ struct switch_generator
 
    void bisect(unsigned begin, unsigned end, ir_factory &body)
    {
-      unsigned middle = (begin + end) >> 1;
+      /* split on a whole number of leaves, so only the last one is short */
+      const unsigned leaf = this->linear_sequence_max_length;
+      const unsigned leaves = DIV_ROUND_UP(end - begin, leaf);
+      unsigned middle = begin + ((leaves + 1) >> 1) * leaf;
 
       assert(index->type->is_integer_32());
 
@@ -316,10 +327,13 @@ public:
                                          bool lower_input,
                                          bool lower_output,
                                          bool lower_temp,
-                                         bool lower_uniform)
+                                         bool lower_uniform,
+                                         unsigned linear_max_length,
+                                         unsigned max_length)
       : progress(false), stage(stage), lower_inputs(lower_input),
         lower_outputs(lower_output), lower_temps(lower_temp),
-        lower_uniforms(lower_uniform)
+        lower_uniforms(lower_uniform),
+        linear_max_length(linear_max_length), max_length(max_length)
    {
       /* empty */
    }
@@ -331,9 +345,21 @@ public:
    bool lower_outputs;
    bool lower_temps;
    bool lower_uniforms;
+   unsigned linear_max_length;
+   unsigned max_length; /**< 0 for no limit */
+
+   static unsigned array_length(const ir_dereference_array *deref)
+   {
+      return (deref->array->type->is_array())
+         ? deref->array->type->length
+         : deref->array->type->matrix_columns;
+   }
 
    bool storage_type_needs_lowering(ir_dereference_array *deref) const
    {
+      if (this->max_length != 0 && array_length(deref) > this->max_length)
+         return false;
+
       /* If a variable isn't eventually the target of this dereference, then
        * it must be a constant or some sort of anonymous temporary storage.
        *
@@ -436,9 +462,7 @@ public:
 
       assert(is_array_or_matrix(orig_deref->array));
 
-      const unsigned length = (orig_deref->array->type->is_array())
-         ? orig_deref->array->type->length
-         : orig_deref->array->type->matrix_columns;
+      const unsigned length = array_length(orig_deref);
 
       /* Temporary storage for either the result of the dereference of
        * the array, or the RHS that's being assigned into the
@@ -476,7 +500,9 @@ public:
          ag.is_write = false;
       }
 
-      switch_generator sg(ag, index, 4, 4);
+      /* a single chain for the small arrays, else a tree of blocks of 4 */
+      switch_generator sg(ag, index,
+                          length <= this->linear_max_length ? length : 4, 4);
 
       /* If the original assignment has a condition, respect that original
        * condition!  This is acomplished by wrapping the new conditional
@@ -543,13 +569,17 @@ lower_variable_index_to_cond_assign(gl_shader_stage stage,
                                     bool lower_input,
                                     bool lower_output,
                                     bool lower_temp,
-                                    bool lower_uniform)
+                                    bool lower_uniform,
+                                    unsigned linear_max_length,
+                                    unsigned max_length)
 {
    variable_index_to_cond_assign_visitor v(stage,
                                            lower_input,
                                            lower_output,
                                            lower_temp,
-                                           lower_uniform);
+                                           lower_uniform,
+                                           linear_max_length,
+                                           max_length);
 
    /* Continue lowering until no progress is made.  If there are multiple
     * levels of indirection (e.g., non-constant indexing of array elements and
@@ -104,15 +104,26 @@ ir_vec_index_to_cond_assign_visitor::convert_vec_index_to_cond_assign(void *mem_
    /* Temporary where we store whichever value we swizzle out. */
    ir_variable *const var = body.make_temp(type, "vec_index_tmp_v");
 
-   /* Generate a single comparison condition "mask" for all of the components
-    * in the vector.
+   /* Read the first component unconditionally, like the linear sequences of
+    * lower_variable_index_to_cond_assign, the other ones may overwrite it.
     */
-   ir_variable *const cond =
-      compare_index_block(body, index, 0, orig_vector->type->vector_elements);
+   const unsigned components = orig_vector->type->vector_elements;
+   body.emit(assign(var, swizzle(value, 0, 1)));
 
-   /* Generate a conditional move of each vector element to the temp. */
-   for (unsigned i = 0; i < orig_vector->type->vector_elements; i++)
-      body.emit(assign(var, swizzle(value, i, 1), swizzle(cond, i, 1)));
+   if (components > 1) {
+      /* Generate a single comparison condition "mask" for all of the other
+       * components in the vector.
+       */
+      ir_variable *const cond =
+         compare_index_block(body, index, 1, components - 1);
+
+      /* Generate a conditional move of each vector element to the temp. */
+      for (unsigned i = 1; i < components; i++) {
+         body.emit(assign(var, swizzle(value, i, 1),
+                          components > 2 ? swizzle(cond, i - 1, 1)
+                                         : operand(cond).val));
+      }
+   }
 
    /* Put all of the new instructions in the IR stream before the old
     * instruction.
@@ -33,6 +33,9 @@
 #include "ir_rvalue_visitor.h"
 #include "ir_optimization.h"
 #include "ir_builder.h"
+#include "ir_value_range.h"
+#include "ir_algebraic_rules.h"
+#include "ir_reassociate.h"
 #include "compiler/glsl_types.h"
 #include "main/mtypes.h"
 
@@ -46,10 +49,13 @@ namespace {
 
 class ir_algebraic_visitor : public ir_rvalue_visitor {
 public:
-   ir_algebraic_visitor(bool native_integers,
-                        const struct gl_shader_compiler_options *options)
-      : options(options)
+   ir_algebraic_visitor(exec_list *instructions, bool native_integers,
+                        const struct gl_shader_compiler_options *options,
+                        ir_value_range *ranges, unsigned rules,
+                        bool fast_math)
+      : options(options), ranges(ranges), rules(instructions, rules)
    {
+      this->fast_math = fast_math;
       this->progress = false;
       this->mem_ctx = NULL;
       this->native_integers = native_integers;
@@ -75,9 +81,12 @@ public:
 				  ir_rvalue *operand);
 
    const struct gl_shader_compiler_options *options;
+   ir_value_range *ranges; /**< May be NULL */
+   ir_algebraic_rules rules; /**< The table of the simple rewrites */
    void *mem_ctx;
 
    bool native_integers;
+   bool fast_math; /**< Reassociate the float chains, see ir_reassociate.h */
    bool progress;
 };
 
@@ -344,13 +353,22 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
    if (this->mem_ctx == NULL)
       this->mem_ctx = ralloc_parent(ir);
 
-   switch (ir->operation) {
-   case ir_unop_bit_not:
-      if (op_expr[0] && op_expr[0]->operation == ir_unop_bit_not)
-         return op_expr[0]->operands[0];
-      break;
+   if (this->fast_math) {
+      ir_rvalue *chain = reassociate_float_chain(ir);
+      if (chain != NULL)
+         return chain;
+   }
 
+   switch (ir->operation) {
    case ir_unop_abs:
+      if (this->ranges != NULL) {
+         const ir_range r = this->ranges->get(ir->operands[0]);
+         if (r.low >= 0.0)
+            return ir->operands[0];
+         if (r.high <= 0.0)
+            return neg(ir->operands[0]);
+      }
+
       if (op_expr[0] == NULL)
 	 break;
 
@@ -363,41 +381,10 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
       }
       break;
 
-   case ir_unop_neg:
-      if (op_expr[0] == NULL)
-	 break;
-
-      if (op_expr[0]->operation == ir_unop_neg) {
-         return op_expr[0]->operands[0];
-      }
-      break;
-
-   case ir_unop_exp:
-      if (op_expr[0] == NULL)
-	 break;
-
-      if (op_expr[0]->operation == ir_unop_log) {
-         return op_expr[0]->operands[0];
-      }
-      break;
-
-   case ir_unop_log:
-      if (op_expr[0] == NULL)
-	 break;
-
-      if (op_expr[0]->operation == ir_unop_exp) {
-         return op_expr[0]->operands[0];
-      }
-      break;
-
    case ir_unop_exp2:
       if (op_expr[0] == NULL)
 	 break;
 
-      if (op_expr[0]->operation == ir_unop_log2) {
-         return op_expr[0]->operands[0];
-      }
-
       if (!options->EmitNoPow && op_expr[0]->operation == ir_binop_mul) {
          for (int log2_pos = 0; log2_pos < 2; log2_pos++) {
             ir_expression *log2_expr =
@@ -413,15 +400,6 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
       }
       break;
 
-   case ir_unop_log2:
-      if (op_expr[0] == NULL)
-	 break;
-
-      if (op_expr[0]->operation == ir_unop_exp2) {
-         return op_expr[0]->operands[0];
-      }
-      break;
-
    case ir_unop_f2i:
    case ir_unop_f2u:
       if (op_expr[0] && op_expr[0]->operation == ir_unop_trunc) {
@@ -462,6 +440,10 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
    }
 
    case ir_unop_saturate:
+      if (this->ranges != NULL &&
+          this->ranges->get(ir->operands[0]).is_within(0.0, 1.0))
+         return ir->operands[0];
+
       if (op_expr[0] && op_expr[0]->operation == ir_binop_add) {
          ir_expression *b2f_0 = op_expr[0]->operands[0]->as_expression();
          ir_expression *b2f_1 = op_expr[0]->operands[1]->as_expression();
@@ -932,29 +914,6 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
 
       break;
 
-   case ir_unop_rcp:
-      if (op_expr[0] && op_expr[0]->operation == ir_unop_rcp)
-	 return op_expr[0]->operands[0];
-
-      if (op_expr[0] && (op_expr[0]->operation == ir_unop_exp2 ||
-                         op_expr[0]->operation == ir_unop_exp)) {
-         return new(mem_ctx) ir_expression(op_expr[0]->operation, ir->type,
-                                           neg(op_expr[0]->operands[0]));
-      }
-
-      /* While ir_to_mesa.cpp will lower sqrt(x) to rcp(rsq(x)), it does so at
-       * its IR level, so we can always apply this transformation.
-       */
-      if (op_expr[0] && op_expr[0]->operation == ir_unop_rsq)
-         return sqrt(op_expr[0]->operands[0]);
-
-      /* As far as we know, all backends are OK with rsq. */
-      if (op_expr[0] && op_expr[0]->operation == ir_unop_sqrt) {
-	 return rsq(op_expr[0]->operands[0]);
-      }
-
-      break;
-
    case ir_triop_fma:
       /* Operands are op0 * op1 + op2. */
       if (is_vec_zero(op_const[0]) || is_vec_zero(op_const[1])) {
@@ -1019,7 +978,8 @@ ir_algebraic_visitor::handle_expression(ir_expression *ir)
       break;
    }
 
-   return ir;
+   ir_rvalue *replacement = this->rules.apply(ir, this->base_ir);
+   return replacement != NULL ? replacement : ir;
 }
 
 void
@@ -1047,9 +1007,11 @@ ir_algebraic_visitor::handle_rvalue(ir_rvalue **rvalue)
 
 bool
 do_algebraic(exec_list *instructions, bool native_integers,
-             const struct gl_shader_compiler_options *options)
+             const struct gl_shader_compiler_options *options,
+             ir_value_range *ranges, unsigned rules, bool fast_math)
 {
-   ir_algebraic_visitor v(native_integers, options);
+   ir_algebraic_visitor v(instructions, native_integers, options, ranges,
+                          rules, fast_math);
 
    visit_list_elements(&v, instructions);
 
@@ -89,6 +89,7 @@ public:
        * be destroyed when the state is destroyed.
        */
       _mesa_hash_table_clear(acp, NULL);
+      _mesa_hash_table_clear(fallback_reads, NULL);
       fallback = NULL;
    }
 
@@ -126,12 +127,24 @@ public:
 
    acp_entry *read(ir_variable *var)
    {
-      for (copy_propagation_state *s = this; s != NULL; s = s->fallback) {
-         hash_entry *ht_entry = _mesa_hash_table_search(s->acp, var);
-         if (ht_entry)
-            return (acp_entry *) ht_entry->data;
-      }
-      return NULL;
+      hash_entry *ht_entry = _mesa_hash_table_search(acp, var);
+      if (ht_entry)
+         return (acp_entry *) ht_entry->data;
+
+      if (fallback == NULL)
+         return NULL;
+
+      /* The fallbacks don't change while this state is alive, so what was
+       * found in them (or not) is kept, else the reads in nested blocks
+       * would walk the whole chain each time.
+       */
+      ht_entry = _mesa_hash_table_search(fallback_reads, var);
+      if (ht_entry)
+         return (acp_entry *) ht_entry->data;
+
+      acp_entry *entry = fallback->read(var);
+      _mesa_hash_table_insert(fallback_reads, var, entry);
+      return entry;
    }
 
    void write_elements(ir_variable *lhs, ir_variable *rhs, unsigned write_mask, int swizzle[4])
@@ -204,6 +217,7 @@ private:
        * needed later.
        */
       acp = _mesa_pointer_hash_table_create(this);
+      fallback_reads = _mesa_pointer_hash_table_create(this);
       lin_ctx = linear_alloc_parent(this, 0);
    }
 
@@ -217,19 +231,11 @@ private:
       acp_entry *entry = new(lin_ctx) acp_entry();
       _mesa_hash_table_insert(acp, var, entry);
 
-      bool found = false;
-      for (copy_propagation_state *s = fallback; s != NULL; s = s->fallback) {
-         hash_entry *fallback_ht_entry = _mesa_hash_table_search(s->acp, var);
-         if (fallback_ht_entry) {
-            acp_entry *fallback_entry = (acp_entry *) fallback_ht_entry->data;
-            *entry = *fallback_entry;
-            entry->dsts = _mesa_set_clone(fallback_entry->dsts, this);
-            found = true;
-            break;
-         }
-      }
-
-      if (!found) {
+      acp_entry *fallback_entry = fallback ? fallback->read(var) : NULL;
+      if (fallback_entry) {
+         *entry = *fallback_entry;
+         entry->dsts = _mesa_set_clone(fallback_entry->dsts, this);
+      } else {
          entry->dsts = _mesa_pointer_set_create(this);
       }
 
@@ -251,6 +257,9 @@ private:
    /** When a state is cloned, entries are copied on demand from fallback. */
    copy_propagation_state *fallback;
 
+   /** The entries read from the fallbacks, NULL when they have none. */
+   hash_table *fallback_reads;
+
    void *lin_ctx;
 };
 
@@ -270,6 +279,47 @@ public:
    unsigned int write_mask;
 };
 
+/**
+ * The variables whose values were killed in a block, one kill_entry per
+ * variable with the channels of all its kills.  The kills of a block are
+ * replayed in the enclosing block, so without merging, nested blocks
+ * would replay every assignment of their bodies once per level.
+ */
+class kill_set
+{
+public:
+   DECLARE_RALLOC_CXX_OPERATORS(kill_set)
+
+   kill_set()
+   {
+      /* Use 'this' as context for the table, freed with the set. */
+      this->ht = _mesa_pointer_hash_table_create(this);
+   }
+
+   /** Moves k in the set, or merges it in the entry of its variable */
+   void add(kill_entry *k)
+   {
+      hash_entry *ht_entry = _mesa_hash_table_search(this->ht, k->var);
+      if (ht_entry) {
+         ((kill_entry *) ht_entry->data)->write_mask |= k->write_mask;
+         return;
+      }
+
+      /* If we were on a list, remove ourselves before inserting */
+      if (k->next)
+         k->remove();
+
+      this->entries.push_tail(k);
+      _mesa_hash_table_insert(this->ht, k->var, k);
+   }
+
+   /** List of kill_entry */
+   exec_list entries;
+
+private:
+   hash_table *ht;
+};
+
 class ir_copy_propagation_elements_visitor : public ir_rvalue_visitor {
 public:
    ir_copy_propagation_elements_visitor()
@@ -279,7 +329,7 @@ public:
       this->mem_ctx = ralloc_context(NULL);
       this->lin_ctx = linear_alloc_parent(this->mem_ctx, 0);
       this->shader_mem_ctx = NULL;
-      this->kills = new(mem_ctx) exec_list;
+      this->kills = new(mem_ctx) kill_set;
       this->state = copy_propagation_state::create(mem_ctx);
    }
    ~ir_copy_propagation_elements_visitor()
@@ -301,15 +351,14 @@ public:
 
    void add_copy(ir_assignment *ir);
    void kill(kill_entry *k);
-   void handle_if_block(exec_list *instructions, exec_list *kills, bool *killed_all);
+   void handle_if_block(exec_list *instructions, kill_set *kills, bool *killed_all);
 
    copy_propagation_state *state;
 
    /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
+    * The variables whose values were killed in this block.
     */
-   exec_list *kills;
+   kill_set *kills;
 
    bool progress;
 
@@ -346,10 +395,10 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_kills = this->kills;
+   kill_set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->kills = new(mem_ctx) exec_list;
+   this->kills = new(mem_ctx) kill_set;
    this->killed_all = false;
 
    copy_propagation_state *orig_state = state;
@@ -539,9 +588,9 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
 }
 
 void
-ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions, exec_list *kills, bool *killed_all)
+ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions, kill_set *kills, bool *killed_all)
 {
-   exec_list *orig_kills = this->kills;
+   kill_set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
    this->kills = kills;
@@ -566,7 +615,7 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 {
    ir->condition->accept(this);
 
-   exec_list *new_kills = new(mem_ctx) exec_list;
+   kill_set *new_kills = new(mem_ctx) kill_set;
    bool then_killed_all = false;
    bool else_killed_all = false;
 
@@ -577,7 +626,7 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
       state->erase_all();
       killed_all = true;
    } else {
-      foreach_in_list_safe(kill_entry, k, new_kills)
+      foreach_in_list_safe(kill_entry, k, &new_kills->entries)
          kill(k);
    }
 
@@ -590,10 +639,10 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 void
 ir_copy_propagation_elements_visitor::handle_loop(ir_loop *ir, bool keep_acp)
 {
-   exec_list *orig_kills = this->kills;
+   kill_set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->kills = new(mem_ctx) exec_list;
+   this->kills = new(mem_ctx) kill_set;
    this->killed_all = false;
 
    copy_propagation_state *orig_state = state;
@@ -613,11 +662,11 @@ ir_copy_propagation_elements_visitor::handle_loop(ir_loop *ir, bool keep_acp)
    if (this->killed_all)
       this->state->erase_all();
 
-   exec_list *new_kills = this->kills;
+   kill_set *new_kills = this->kills;
    this->kills = orig_kills;
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list_safe(kill_entry, k, new_kills) {
+   foreach_in_list_safe(kill_entry, k, &new_kills->entries) {
       kill(k);
    }
 
@@ -640,11 +689,7 @@ ir_copy_propagation_elements_visitor::kill(kill_entry *k)
 {
    state->erase(k->var, k->write_mask);
 
-   /* If we were on a list, remove ourselves before inserting */
-   if (k->next)
-      k->remove();
-
-   this->kills->push_tail(k);
+   this->kills->add(k);
 }
 
 /**
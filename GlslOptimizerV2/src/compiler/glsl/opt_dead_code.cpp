@@ -29,9 +29,11 @@
 
 #include "ir.h"
 #include "ir_visitor.h"
-#include "ir_variable_refcount.h"
+#include "ir_def_use.h"
+#include "ir_optimization.h"
 #include "compiler/glsl_types.h"
 #include "util/hash_table.h"
+#include "util/u_dynarray.h"
 
 static bool debug = false;
 
@@ -41,17 +43,25 @@ static bool debug = false;
  *
  * Note that this will remove assignments to globals, so it is not suitable
  * for usage on an unlinked instruction stream.
+ *
+ * The counts are the ones of def_use before the pass, who updates it after
+ * his decisions.  Without def_use, a temporary one is built.
  */
 bool
-do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
+do_dead_code(exec_list *instructions, bool uniform_locations_assigned,
+             ir_def_use *def_use)
 {
-   ir_variable_refcount_visitor v;
+   ir_def_use *index = def_use ? def_use : new ir_def_use(instructions);
+   struct util_dynarray dead_assignments, dead_variables;
    bool progress = false;
 
-   v.run(instructions);
+   util_dynarray_init(&dead_assignments, NULL);
+   util_dynarray_init(&dead_variables, NULL);
 
-   hash_table_foreach(v.ht, e) {
-      ir_variable_refcount_entry *entry = (ir_variable_refcount_entry *)e->data;
+   hash_table_foreach(index->entries, e) {
+      ir_def_use_entry *entry = (ir_def_use_entry *)e->data;
+      const unsigned referenced_count = entry->referenced_count();
+      const unsigned assigned_count = entry->assigned_count();
 
       /* Since each assignment is a reference, the refereneced count must be
        * greater than or equal to the assignment count.  If they are equal,
@@ -61,16 +71,16 @@ do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
        * Note that if the variable is neither assigned nor referenced, both
        * counts will be zero and will be caught by the equality test.
        */
-      assert(entry->referenced_count >= entry->assigned_count);
+      assert(referenced_count >= assigned_count);
 
       if (debug) {
 	 printf("%s@%p: %d refs, %d assigns, %sdeclared in our scope\n",
 		entry->var->name, (void *) entry->var,
-		entry->referenced_count, entry->assigned_count,
+		referenced_count, assigned_count,
 		entry->declaration ? "" : "not ");
       }
 
-      if ((entry->referenced_count > entry->assigned_count)
+      if ((referenced_count > assigned_count)
 	  || !entry->declaration)
 	 continue;
 
@@ -88,87 +98,95 @@ do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
       if (entry->var->data.always_active_io)
          continue;
 
-      if (!entry->assign_list.is_empty()) {
+      if (assigned_count != 0) {
 	 /* Remove all the dead assignments to the variable we found.
 	  * Don't do so if it's a shader or function output, though.
 	  */
-	 if (entry->var->data.mode != ir_var_function_out &&
-	     entry->var->data.mode != ir_var_function_inout &&
-             entry->var->data.mode != ir_var_shader_out &&
-             entry->var->data.mode != ir_var_shader_storage) {
-
-            while (!entry->assign_list.is_empty()) {
-               struct assignment_entry *assignment_entry =
-                  exec_node_data(struct assignment_entry,
-                                 entry->assign_list.get_head_raw(), link);
-
-	       assignment_entry->assign->remove();
-
-	       if (debug) {
-	          printf("Removed assignment to %s@%p\n",
-		         entry->var->name, (void *) entry->var);
-               }
-
-               assignment_entry->link.remove();
-               free(assignment_entry);
-            }
-            progress = true;
-	 }
+	 if (entry->var->data.mode == ir_var_function_out ||
+	     entry->var->data.mode == ir_var_function_inout ||
+             entry->var->data.mode == ir_var_shader_out ||
+             entry->var->data.mode == ir_var_shader_storage)
+            continue;
+
+         util_dynarray_foreach(&entry->assignments, ir_assignment *, assign)
+            util_dynarray_append(&dead_assignments, ir_assignment *, *assign);
       }
 
-      if (entry->assign_list.is_empty()) {
-	 /* If there are no assignments or references to the variable left,
-	  * then we can remove its declaration.
-	  */
+      /* If there are no assignments or references to the variable left,
+       * then we can remove its declaration.
+       */
 
-	 /* uniform initializers are precious, and could get used by another
-	  * stage.  Also, once uniform locations have been assigned, the
-	  * declaration cannot be deleted.
-	  */
-         if (entry->var->data.mode == ir_var_uniform ||
-             entry->var->data.mode == ir_var_shader_storage) {
-            if (uniform_locations_assigned || entry->var->constant_initializer)
+      /* uniform initializers are precious, and could get used by another
+       * stage.  Also, once uniform locations have been assigned, the
+       * declaration cannot be deleted.
+       */
+      if (entry->var->data.mode == ir_var_uniform ||
+          entry->var->data.mode == ir_var_shader_storage) {
+         if (uniform_locations_assigned || entry->var->constant_initializer)
+            continue;
+
+         /* Section 2.11.6 (Uniform Variables) of the OpenGL ES 3.0.3 spec
+          * says:
+          *
+          *     "All members of a named uniform block declared with a
+          *     shared or std140 layout qualifier are considered active,
+          *     even if they are not referenced in any shader in the
+          *     program. The uniform block itself is also considered
+          *     active, even if no member of the block is referenced."
+          *
+          * If the variable is in a uniform block with one of those
+          * layouts, do not eliminate it.
+          */
+         if (entry->var->is_in_buffer_block()) {
+            if (entry->var->get_interface_type_packing() !=
+                GLSL_INTERFACE_PACKING_PACKED) {
+               /* Set used to false so it doesn't get set as referenced by
+                * the shader in the program resource list. This will also
+                * help avoid the state being unnecessarily flushed for the
+                * shader stage.
+                */
+               entry->var->data.used = false;
                continue;
-
-            /* Section 2.11.6 (Uniform Variables) of the OpenGL ES 3.0.3 spec
-             * says:
-             *
-             *     "All members of a named uniform block declared with a
-             *     shared or std140 layout qualifier are considered active,
-             *     even if they are not referenced in any shader in the
-             *     program. The uniform block itself is also considered
-             *     active, even if no member of the block is referenced."
-             *
-             * If the variable is in a uniform block with one of those
-             * layouts, do not eliminate it.
-             */
-            if (entry->var->is_in_buffer_block()) {
-               if (entry->var->get_interface_type_packing() !=
-                   GLSL_INTERFACE_PACKING_PACKED) {
-                  /* Set used to false so it doesn't get set as referenced by
-                   * the shader in the program resource list. This will also
-                   * help avoid the state being unnecessarily flushed for the
-                   * shader stage.
-                   */
-                  entry->var->data.used = false;
-                  continue;
-               }
             }
-
-            if (entry->var->type->is_subroutine())
-               continue;
          }
 
-	 entry->var->remove();
-	 progress = true;
+         if (entry->var->type->is_subroutine())
+            continue;
+      }
 
-	 if (debug) {
-	    printf("Removed declaration of %s@%p\n",
-		   entry->var->name, (void *) entry->var);
-	 }
+      util_dynarray_append(&dead_variables, ir_variable *, entry->var);
+   }
+
+   /* the removals don't change the decisions above */
+   util_dynarray_foreach(&dead_assignments, ir_assignment *, assign) {
+      if (debug) {
+         printf("Removed assignment to %s@%p\n",
+                (*assign)->lhs->variable_referenced()->name,
+                (void *) (*assign)->lhs->variable_referenced());
       }
+
+      index->remove(*assign);
+      (*assign)->remove();
+      progress = true;
    }
 
+   util_dynarray_foreach(&dead_variables, ir_variable *, var) {
+      if (debug) {
+         printf("Removed declaration of %s@%p\n",
+                (*var)->name, (void *) *var);
+      }
+
+      index->remove(*var);
+      (*var)->remove();
+      progress = true;
+   }
+
+   util_dynarray_fini(&dead_assignments);
+   util_dynarray_fini(&dead_variables);
+
+   if (index != def_use)
+      delete index;
+
    return progress;
 }
 
@@ -35,8 +35,10 @@
 
 #include "ir.h"
 #include "ir_basic_block.h"
+#include "ir_def_use.h"
 #include "ir_optimization.h"
 #include "compiler/glsl_types.h"
+#include "util/hash_table.h"
 
 static bool debug = false;
 
@@ -64,29 +66,69 @@ public:
    int unused;
 };
 
+/**
+ * The assignments available to be removed, in a list per variable, so a
+ * use or a write only visits the assignments of its variable.
+ */
+class assignment_table
+{
+public:
+   assignment_table(void *mem_ctx)
+   {
+      this->mem_ctx = mem_ctx;
+      this->ht = _mesa_pointer_hash_table_create(mem_ctx);
+      this->lin_ctx = linear_alloc_parent(mem_ctx, 0);
+   }
+
+   /* the assignments of var, an empty list if there is none */
+   exec_list *find(ir_variable *var)
+   {
+      hash_entry *entry = _mesa_hash_table_search(this->ht, var);
+      return entry ? (exec_list *) entry->data : &this->none;
+   }
+
+   void add(ir_variable *var, ir_assignment *ir)
+   {
+      hash_entry *entry = _mesa_hash_table_search(this->ht, var);
+      exec_list *list;
+      if (entry) {
+         list = (exec_list *) entry->data;
+      } else {
+         list = new(this->mem_ctx) exec_list;
+         _mesa_hash_table_insert(this->ht, var, list);
+      }
+      list->push_tail(new(this->lin_ctx) assignment_entry(var, ir));
+   }
+
+   hash_table *ht;
+
+private:
+   void *mem_ctx;
+   void *lin_ctx;
+   exec_list none;
+};
+
 class kill_for_derefs_visitor : public ir_hierarchical_visitor {
 public:
-   kill_for_derefs_visitor(exec_list *assignments)
+   kill_for_derefs_visitor(assignment_table *assignments)
    {
       this->assignments = assignments;
    }
 
    void use_channels(ir_variable *const var, int used)
    {
-      foreach_in_list_safe(assignment_entry, entry, this->assignments) {
-	 if (entry->lhs == var) {
-	    if (var->type->is_scalar() || var->type->is_vector()) {
-	       if (debug)
-		  printf("used %s (0x%01x - 0x%01x)\n", entry->lhs->name,
-			 entry->unused, used & 0xf);
-	       entry->unused &= ~used;
-	       if (!entry->unused)
-		  entry->remove();
-	    } else {
-	       if (debug)
-		  printf("used %s\n", entry->lhs->name);
+      foreach_in_list_safe(assignment_entry, entry, this->assignments->find(var)) {
+	 if (var->type->is_scalar() || var->type->is_vector()) {
+	    if (debug)
+	       printf("used %s (0x%01x - 0x%01x)\n", entry->lhs->name,
+		      entry->unused, used & 0xf);
+	    entry->unused &= ~used;
+	    if (!entry->unused)
 	       entry->remove();
-	    }
+	 } else {
+	    if (debug)
+	       printf("used %s\n", entry->lhs->name);
+	    entry->remove();
 	 }
       }
    }
@@ -123,19 +165,21 @@ public:
       /* For the purpose of dead code elimination, emitting a vertex counts as
        * "reading" all of the currently assigned output variables.
        */
-      foreach_in_list_safe(assignment_entry, entry, this->assignments) {
-         if (entry->lhs->data.mode == ir_var_shader_out) {
-            if (debug)
-               printf("kill %s\n", entry->lhs->name);
-            entry->remove();
-         }
+      hash_table_foreach(this->assignments->ht, ht_entry) {
+         const ir_variable *var = (const ir_variable *) ht_entry->key;
+         if (var->data.mode != ir_var_shader_out)
+            continue;
+
+         if (debug)
+            printf("kill %s\n", var->name);
+         ((exec_list *) ht_entry->data)->make_empty();
       }
 
       return visit_continue;
    }
 
 private:
-   exec_list *assignments;
+   assignment_table *assignments;
 };
 
 class array_index_visit : public ir_hierarchical_visitor {
@@ -160,14 +204,28 @@ public:
    ir_hierarchical_visitor *visitor;
 };
 
+struct dead_code_local_state {
+   bool progress;
+   ir_def_use *def_use; /**< Kept up to date if not NULL */
+};
+
 } /* unnamed namespace */
 
+static void
+remove_assignment(ir_assignment *ir, ir_def_use *def_use)
+{
+   if (def_use)
+      def_use->remove(ir);
+   ir->remove();
+}
+
 /**
  * Adds an entry to the available copy list if it's a plain assignment
  * of a variable to a variable.
  */
 static bool
-process_assignment(void *lin_ctx, ir_assignment *ir, exec_list *assignments)
+process_assignment(ir_assignment *ir, assignment_table *assignments,
+                   ir_def_use *def_use)
 {
    ir_variable *var = NULL;
    bool progress = false;
@@ -179,7 +237,7 @@ process_assignment(void *lin_ctx, ir_assignment *ir, exec_list *assignments)
        */
       const ir_variable *const lhs_var = ir->whole_variable_written();
       if (lhs_var != NULL && lhs_var == ir->rhs->whole_variable_referenced()) {
-         ir->remove();
+         remove_assignment(ir, def_use);
          return true;
       }
    }
@@ -210,10 +268,7 @@ process_assignment(void *lin_ctx, ir_assignment *ir, exec_list *assignments)
 	    printf("looking for %s.0x%01x to remove\n", var->name,
 		   ir->write_mask);
 
-	 foreach_in_list_safe(assignment_entry, entry, assignments) {
-	    if (entry->lhs != var)
-	       continue;
-
+	 foreach_in_list_safe(assignment_entry, entry, assignments->find(var)) {
             /* Skip if the assignment we're trying to eliminate isn't a plain
              * variable deref. */
             if (entry->ir->lhs->ir_type != ir_type_dereference_variable)
@@ -239,7 +294,7 @@ process_assignment(void *lin_ctx, ir_assignment *ir, exec_list *assignments)
 	       entry->unused &= ~remove;
 	       if (entry->ir->write_mask == 0) {
 		  /* Delete the dead assignment. */
-		  entry->ir->remove();
+		  remove_assignment(entry->ir, def_use);
 		  entry->remove();
 	       } else {
 		  void *mem_ctx = ralloc_parent(entry->ir);
@@ -275,28 +330,27 @@ process_assignment(void *lin_ctx, ir_assignment *ir, exec_list *assignments)
 	  */
 	 if (debug)
 	    printf("looking for %s to remove\n", var->name);
-	 foreach_in_list_safe(assignment_entry, entry, assignments) {
-	    if (entry->lhs == var) {
-	       if (debug)
-		  printf("removing %s\n", var->name);
-	       entry->ir->remove();
-	       entry->remove();
-	       progress = true;
-	    }
+	 foreach_in_list_safe(assignment_entry, entry, assignments->find(var)) {
+	    if (debug)
+	       printf("removing %s\n", var->name);
+	    remove_assignment(entry->ir, def_use);
+	    entry->remove();
+	    progress = true;
 	 }
       }
    }
 
    /* Add this instruction to the assignment list available to be removed. */
-   assignment_entry *entry = new(lin_ctx) assignment_entry(var, ir);
-   assignments->push_tail(entry);
+   assignments->add(var, ir);
 
    if (debug) {
       printf("add %s\n", var->name);
 
       printf("current entries\n");
-      foreach_in_list(assignment_entry, entry, assignments) {
-	 printf("    %s (0x%01x)\n", entry->lhs->name, entry->unused);
+      hash_table_foreach(assignments->ht, ht_entry) {
+	 foreach_in_list(assignment_entry, entry, (exec_list *) ht_entry->data) {
+	    printf("    %s (0x%01x)\n", entry->lhs->name, entry->unused);
+	 }
       }
    }
 
@@ -309,13 +363,12 @@ dead_code_local_basic_block(ir_instruction *first,
 			     void *data)
 {
    ir_instruction *ir, *ir_next;
-   /* List of avaialble_copy */
-   exec_list assignments;
-   bool *out_progress = (bool *)data;
+   dead_code_local_state *state = (dead_code_local_state *)data;
    bool progress = false;
 
    void *ctx = ralloc_context(NULL);
-   void *lin_ctx = linear_alloc_parent(ctx, 0);
+   /* Available assignments, by variable */
+   assignment_table assignments(ctx);
 
    /* Safe looping, since process_assignment */
    for (ir = first, ir_next = (ir_instruction *)first->next;;
@@ -328,8 +381,8 @@ dead_code_local_basic_block(ir_instruction *first,
       }
 
       if (ir_assign) {
-	 progress = process_assignment(lin_ctx, ir_assign, &assignments) ||
-                    progress;
+	 progress = process_assignment(ir_assign, &assignments,
+                                       state->def_use) || progress;
       } else {
 	 kill_for_derefs_visitor kill(&assignments);
 	 ir->accept(&kill);
@@ -338,7 +391,9 @@ dead_code_local_basic_block(ir_instruction *first,
       if (ir == last)
 	 break;
    }
-   *out_progress = progress;
+   /* the progress of the previous blocks is kept */
+   if (progress)
+      state->progress = true;
    ralloc_free(ctx);
 }
 
@@ -346,11 +401,13 @@ dead_code_local_basic_block(ir_instruction *first,
  * Does a copy propagation pass on the code present in the instruction stream.
  */
 bool
-do_dead_code_local(exec_list *instructions)
+do_dead_code_local(exec_list *instructions, ir_def_use *def_use)
 {
-   bool progress = false;
+   dead_code_local_state state;
+   state.progress = false;
+   state.def_use = def_use;
 
-   call_for_basic_blocks(instructions, dead_code_local_basic_block, &progress);
+   call_for_basic_blocks(instructions, dead_code_local_basic_block, &state);
 
-   return progress;
+   return state.progress;
 }
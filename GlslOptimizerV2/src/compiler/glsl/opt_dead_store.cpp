@@ -0,0 +1,400 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file opt_dead_store.cpp
+ *
+ * Removes the writes of local variables who are never read, across the
+ * control flow.
+ *
+ * do_dead_code_local only sees the overwrites inside a basic block, and
+ * do_dead_code only the variables never read.  Here a backward liveness of
+ * each channel of the scalar and vector locals is computed on the
+ * structured body : the branches of an ir_if are joined, each ir_loop is
+ * walked until the set live at the start of his body is stable.  Then an
+ * assignment whose written channels are all dead is removed, and one with
+ * some dead channels gets a smaller write mask, like in do_dead_code_local.
+ *
+ * The reads are the ir_dereference_variable nodes, a swizzle of a variable
+ * only reads his channels.  The writes of a call, a partial write through
+ * an array index and the writes of other types are not tracked, their
+ * derefs just count as reads of the whole variable.
+ */
+
+#include "ir.h"
+#include "ir_hierarchical_visitor.h"
+#include "ir_optimization.h"
+#include "compiler/glsl_types.h"
+#include "util/bitset.h"
+#include "util/hash_table.h"
+
+namespace {
+
+/* 4 channels per variable */
+#define STORE_CHANNELS 4
+
+class store_candidate_visitor : public ir_hierarchical_visitor {
+public:
+   store_candidate_visitor(struct hash_table *indices)
+      : indices(indices), count(0)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_variable *var)
+   {
+      if ((var->data.mode == ir_var_auto ||
+           var->data.mode == ir_var_temporary) &&
+          (var->type->is_scalar() || var->type->is_vector())) {
+         _mesa_hash_table_insert(this->indices, var,
+                                 (void *) (uintptr_t) (++this->count));
+      }
+      return visit_continue;
+   }
+
+   struct hash_table *indices; /**< ir_variable -> index + 1 */
+   unsigned count;
+};
+
+class store_use_visitor : public ir_hierarchical_visitor {
+public:
+   store_use_visitor(struct hash_table *indices)
+      : indices(indices), live(NULL)
+   {
+   }
+
+   void use(ir_variable *var, unsigned channels)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(this->indices, var);
+      if (entry == NULL)
+         return;
+
+      const unsigned first = ((uintptr_t) entry->data - 1) * STORE_CHANNELS;
+      for (unsigned i = 0; i < STORE_CHANNELS; i++) {
+         if (channels & (1 << i))
+            BITSET_SET(this->live, first + i);
+      }
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      use(ir->var, (1 << STORE_CHANNELS) - 1);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_swizzle *ir)
+   {
+      ir_dereference_variable *deref = ir->val->as_dereference_variable();
+      if (deref == NULL)
+         return visit_continue;
+
+      unsigned channels = 1 << ir->mask.x;
+      if (ir->mask.num_components > 1)
+         channels |= 1 << ir->mask.y;
+      if (ir->mask.num_components > 2)
+         channels |= 1 << ir->mask.z;
+      if (ir->mask.num_components > 3)
+         channels |= 1 << ir->mask.w;
+
+      use(deref->var, channels);
+      return visit_continue_with_parent;
+   }
+
+   struct hash_table *indices;
+   BITSET_WORD *live;
+};
+
+struct store_loop {
+   store_loop *outer;
+   BITSET_WORD *header; /**< live at the start of the body */
+   BITSET_WORD *exit;   /**< live after the loop */
+};
+
+class dead_store_pass {
+public:
+   dead_store_pass(void *mem_ctx, struct hash_table *indices, unsigned count)
+      : uses(indices), loop(NULL), removing(false), found(false),
+        progress(false), mem_ctx(mem_ctx)
+   {
+      this->words = BITSET_WORDS(count * STORE_CHANNELS);
+      this->headers = _mesa_pointer_hash_table_create(mem_ctx);
+   }
+
+   bool run(exec_list *body)
+   {
+      BITSET_WORD *live = new_set();
+      transfer_list(body, live);
+
+      /* the sets only grow, so a store dead at the end was dead on his
+       * last analysis too
+       */
+      if (!this->found)
+         return false;
+
+      this->removing = true;
+      memset(live, 0, this->words * sizeof(BITSET_WORD));
+      transfer_list(body, live);
+      return this->progress;
+   }
+
+private:
+   BITSET_WORD *new_set()
+   {
+      return rzalloc_array(this->mem_ctx, BITSET_WORD, MAX2(this->words, 1));
+   }
+
+   BITSET_WORD *copy_set(const BITSET_WORD *set)
+   {
+      BITSET_WORD *copy = new_set();
+      memcpy(copy, set, this->words * sizeof(BITSET_WORD));
+      return copy;
+   }
+
+   void add_uses(ir_instruction *ir, BITSET_WORD *live)
+   {
+      if (ir != NULL) {
+         this->uses.live = live;
+         ir->accept(&this->uses);
+      }
+   }
+
+   void transfer_assignment(ir_assignment *ir, BITSET_WORD *live);
+   void transfer(ir_instruction *ir, BITSET_WORD *live);
+   void transfer_list(exec_list *list, BITSET_WORD *live);
+
+   store_use_visitor uses;
+   store_loop *loop;
+   struct hash_table *headers; /**< ir_loop -> header of the last walk */
+   unsigned words;
+   bool removing;
+   bool found; /**< a store with dead channels was seen */
+   bool progress;
+   void *mem_ctx;
+};
+
+} /* unnamed namespace */
+
+void
+dead_store_pass::transfer_assignment(ir_assignment *ir, BITSET_WORD *live)
+{
+   ir_dereference_variable *lhs = ir->lhs->as_dereference_variable();
+   struct hash_entry *entry = lhs != NULL ?
+      _mesa_hash_table_search(this->uses.indices, lhs->var) : NULL;
+
+   if (entry == NULL) {
+      add_uses(ir, live);
+      return;
+   }
+
+   const unsigned first = ((uintptr_t) entry->data - 1) * STORE_CHANNELS;
+   unsigned live_channels = 0;
+   for (unsigned i = 0; i < STORE_CHANNELS; i++) {
+      if (BITSET_TEST(live, first + i))
+         live_channels |= 1 << i;
+   }
+
+   const unsigned dead = ir->write_mask & ~live_channels;
+   if (dead != 0)
+      this->found = true;
+
+   /* a dead store reads nothing, so the values only read by it die too */
+   if (dead == ir->write_mask) {
+      if (this->removing) {
+         ir->remove();
+         this->progress = true;
+      }
+      return;
+   }
+
+   if (this->removing && dead != 0 && lhs->type->is_vector() &&
+       ir->rhs->type->is_vector()) {
+      /* Reswizzle the rhs to the channels still written */
+      unsigned components[4];
+      unsigned channels = 0;
+      unsigned next = 0;
+
+      for (unsigned i = 0; i < 4; i++) {
+         if (ir->write_mask & (1 << i)) {
+            if (!(dead & (1 << i)))
+               components[channels++] = next;
+            next++;
+         }
+      }
+
+      void *mem_ctx = ralloc_parent(ir);
+      ir->rhs = new(mem_ctx) ir_swizzle(ir->rhs, components, channels);
+      ir->write_mask &= ~dead;
+      this->progress = true;
+   }
+
+   /* only an unconditional write kills the channels */
+   if (ir->condition == NULL) {
+      for (unsigned i = 0; i < STORE_CHANNELS; i++) {
+         if (ir->write_mask & (1 << i))
+            BITSET_CLEAR(live, first + i);
+      }
+   }
+
+   add_uses(ir->rhs, live);
+   add_uses(ir->condition, live);
+}
+
+void
+dead_store_pass::transfer(ir_instruction *ir, BITSET_WORD *live)
+{
+   switch (ir->ir_type) {
+   case ir_type_variable:
+      break;
+
+   case ir_type_assignment:
+      transfer_assignment((ir_assignment *) ir, live);
+      break;
+
+   case ir_type_if: {
+      ir_if *branch = (ir_if *) ir;
+      BITSET_WORD *else_live = copy_set(live);
+
+      transfer_list(&branch->then_instructions, live);
+      transfer_list(&branch->else_instructions, else_live);
+      for (unsigned i = 0; i < this->words; i++)
+         live[i] |= else_live[i];
+      add_uses(branch->condition, live);
+      break;
+   }
+
+   case ir_type_loop: {
+      ir_loop *l = (ir_loop *) ir;
+      store_loop frame;
+      frame.outer = this->loop;
+      frame.exit = copy_set(live);
+      this->loop = &frame;
+
+      /* an outer loop only grows the exit, so the header of his previous
+       * walk is a lower bound of the new one.  The removing walk sees the
+       * exits of the last analysis, the headers are already stable.
+       */
+      struct hash_entry *entry = _mesa_hash_table_search(this->headers, l);
+      if (entry != NULL) {
+         frame.header = (BITSET_WORD *) entry->data;
+      } else {
+         frame.header = new_set();
+         _mesa_hash_table_insert(this->headers, l, frame.header);
+      }
+
+      BITSET_WORD *body = new_set();
+      while (!this->removing) {
+         memcpy(body, frame.header, this->words * sizeof(BITSET_WORD));
+         transfer_list(&l->body_instructions, body);
+
+         bool grown = false;
+         for (unsigned i = 0; i < this->words; i++) {
+            if (body[i] & ~frame.header[i]) {
+               frame.header[i] |= body[i];
+               grown = true;
+            }
+         }
+         if (!grown)
+            break;
+      }
+
+      if (this->removing) {
+         memcpy(body, frame.header, this->words * sizeof(BITSET_WORD));
+         transfer_list(&l->body_instructions, body);
+      }
+
+      this->loop = frame.outer;
+      memcpy(live, frame.header, this->words * sizeof(BITSET_WORD));
+      break;
+   }
+
+   case ir_type_loop_jump:
+      if (this->loop != NULL) {
+         const ir_loop_jump *jump = (ir_loop_jump *) ir;
+         memcpy(live, jump->is_break() ? this->loop->exit : this->loop->header,
+                this->words * sizeof(BITSET_WORD));
+      }
+      break;
+
+   case ir_type_return:
+      /* the locals die with the function */
+      memset(live, 0, this->words * sizeof(BITSET_WORD));
+      add_uses(ir, live);
+      break;
+
+   case ir_type_discard:
+      if (((ir_discard *) ir)->condition == NULL)
+         memset(live, 0, this->words * sizeof(BITSET_WORD));
+      add_uses(ir, live);
+      break;
+
+   default:
+      add_uses(ir, live);
+      break;
+   }
+}
+
+void
+dead_store_pass::transfer_list(exec_list *list, BITSET_WORD *live)
+{
+   foreach_in_list_reverse_safe(ir_instruction, ir, list)
+      transfer(ir, live);
+}
+
+static bool
+dead_store_body(exec_list *body)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct hash_table *indices = _mesa_pointer_hash_table_create(mem_ctx);
+
+   store_candidate_visitor candidates(indices);
+   visit_list_elements(&candidates, body);
+
+   bool progress = false;
+   if (candidates.count != 0) {
+      dead_store_pass pass(mem_ctx, indices, candidates.count);
+      progress = pass.run(body);
+   }
+
+   ralloc_free(mem_ctx);
+   return progress;
+}
+
+/**
+ * The list is a whole shader, or a single function body when called from
+ * the optimization of the function bodies.
+ */
+bool
+do_dead_store_elimination(exec_list *instructions)
+{
+   bool progress = false;
+   bool functions = false;
+
+   foreach_in_list(ir_instruction, ir, instructions) {
+      ir_function *f = ir->as_function();
+      if (f == NULL)
+         continue;
+
+      functions = true;
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         if (sig->is_defined)
+            progress = dead_store_body(&sig->body) || progress;
+      }
+   }
+
+   if (!functions)
+      progress = dead_store_body(instructions);
+
+   return progress;
+}
@@ -28,13 +28,19 @@
  * can be proven to not contribute to the final result.
  *
  * The algorithm is similar to alpha-beta pruning on a minmax search.
+ *
+ * The limits of the operands are their constants, or the bounds given by an
+ * ir_value_range when one is passed.
  */
 
+#include <math.h>
+
 #include "ir.h"
 #include "ir_visitor.h"
 #include "ir_rvalue_visitor.h"
 #include "ir_optimization.h"
 #include "ir_builder.h"
+#include "ir_value_range.h"
 #include "program/prog_instruction.h"
 #include "compiler/glsl_types.h"
 #include "main/macros.h"
@@ -71,16 +77,24 @@ public:
 
 class ir_minmax_visitor : public ir_rvalue_enter_visitor {
 public:
-   ir_minmax_visitor()
-      : progress(false)
+   ir_minmax_visitor(ir_value_range *ranges)
+      : progress(false), ranges(ranges), mem_ctx(NULL)
    {
    }
 
    ir_rvalue *prune_expression(ir_expression *expr, minmax_range baserange);
 
+   minmax_range get_range(ir_rvalue *rval);
+
    void handle_rvalue(ir_rvalue **rvalue);
 
    bool progress;
+
+   /** Range of the operands who are not constants, may be NULL */
+   ir_value_range *ranges;
+
+   /** The limits from the ranges, they never go in the ir */
+   void *mem_ctx;
 };
 
 /*
@@ -167,29 +181,37 @@ compare_components(ir_constant *a, ir_constant *b)
 static ir_constant *
 combine_constant(bool ismin, ir_constant *a, ir_constant *b)
 {
+   /* a scalar goes with each component of a vector */
+   if (a->type->is_scalar() && !b->type->is_scalar()) {
+      ir_constant *t = a;
+      a = b;
+      b = t;
+   }
+
    void *mem_ctx = ralloc_parent(a);
    ir_constant *c = a->clone(mem_ctx, NULL);
-   for (unsigned i = 0; i < c->type->components(); i++) {
+   const unsigned b_inc = b->type->is_scalar() ? 0 : 1;
+   for (unsigned i = 0, j = 0; i < c->type->components(); i++, j += b_inc) {
       switch (c->type->base_type) {
       case GLSL_TYPE_UINT:
-         if ((ismin && b->value.u[i] < c->value.u[i]) ||
-             (!ismin && b->value.u[i] > c->value.u[i]))
-            c->value.u[i] = b->value.u[i];
+         if ((ismin && b->value.u[j] < c->value.u[i]) ||
+             (!ismin && b->value.u[j] > c->value.u[i]))
+            c->value.u[i] = b->value.u[j];
          break;
       case GLSL_TYPE_INT:
-         if ((ismin && b->value.i[i] < c->value.i[i]) ||
-             (!ismin && b->value.i[i] > c->value.i[i]))
-            c->value.i[i] = b->value.i[i];
+         if ((ismin && b->value.i[j] < c->value.i[i]) ||
+             (!ismin && b->value.i[j] > c->value.i[i]))
+            c->value.i[i] = b->value.i[j];
          break;
       case GLSL_TYPE_FLOAT:
-         if ((ismin && b->value.f[i] < c->value.f[i]) ||
-             (!ismin && b->value.f[i] > c->value.f[i]))
-            c->value.f[i] = b->value.f[i];
+         if ((ismin && b->value.f[j] < c->value.f[i]) ||
+             (!ismin && b->value.f[j] > c->value.f[i]))
+            c->value.f[i] = b->value.f[j];
          break;
       case GLSL_TYPE_DOUBLE:
-         if ((ismin && b->value.d[i] < c->value.d[i]) ||
-             (!ismin && b->value.d[i] > c->value.d[i]))
-            c->value.d[i] = b->value.d[i];
+         if ((ismin && b->value.d[j] < c->value.d[i]) ||
+             (!ismin && b->value.d[j] > c->value.d[i]))
+            c->value.d[i] = b->value.d[j];
          break;
       default:
          assert(!"not reached");
@@ -282,8 +304,27 @@ range_intersection(minmax_range r0, minmax_range r1)
    return ret;
 }
 
-static minmax_range
-get_range(ir_rvalue *rval)
+/* a scalar limit of the type of rval, NULL if the bound is infinite */
+static ir_constant *
+range_limit(void *mem_ctx, const glsl_type *type, double bound)
+{
+   if (isinf(bound))
+      return NULL;
+
+   switch (type->base_type) {
+   case GLSL_TYPE_FLOAT:
+      return new(mem_ctx) ir_constant((float) bound);
+   case GLSL_TYPE_INT:
+      return new(mem_ctx) ir_constant((int) bound);
+   case GLSL_TYPE_UINT:
+      return new(mem_ctx) ir_constant((unsigned) bound);
+   default:
+      return NULL;
+   }
+}
+
+minmax_range
+ir_minmax_visitor::get_range(ir_rvalue *rval)
 {
    ir_expression *expr = rval->as_expression();
    if (expr && (expr->operation == ir_binop_min ||
@@ -298,6 +339,12 @@ get_range(ir_rvalue *rval)
       return minmax_range(c, c);
    }
 
+   if (this->ranges != NULL && !rval->type->is_matrix()) {
+      const ir_range r = this->ranges->get(rval);
+      return minmax_range(range_limit(this->mem_ctx, rval->type, r.low),
+                          range_limit(this->mem_ctx, rval->type, r.high));
+   }
+
    return minmax_range();
 }
 
@@ -478,11 +525,13 @@ ir_minmax_visitor::handle_rvalue(ir_rvalue **rvalue)
 }
 
 bool
-do_minmax_prune(exec_list *instructions)
+do_minmax_prune(exec_list *instructions, ir_value_range *ranges)
 {
-   ir_minmax_visitor v;
+   ir_minmax_visitor v(ranges);
+   v.mem_ctx = ralloc_context(NULL);
 
    visit_list_elements(&v, instructions);
 
+   ralloc_free(v.mem_ctx);
    return v.progress;
 }
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file opt_preshader.cpp
+ *
+ * Moves the expressions of the uniforms alone out of the shader, the
+ * "preshader".
+ *
+ * Each largest rvalue computed from the constants and the uniforms alone,
+ * see ir_uniformity::is_uniform_only, is replaced by the read of a new
+ * uniform, preshader_0, preshader_1...  The equal rvalues share the same
+ * one.  For each new uniform, an assignment of the removed rvalue is added
+ * to the preshader list, for the caller to compute it once per draw, like
+ * with ir_constant_expression and the values of the uniforms.
+ *
+ *    gl_FragColor = texture(s, uv) * pow(exposure, 2.2) * color;
+ * =>
+ *    uniform float preshader_0;     preshader_0 = pow(exposure, 2.2)
+ *    gl_FragColor = texture(s, uv) * preshader_0 * color;
+ *
+ * An rvalue without an operation, or with only neg and abs who are free
+ * source modifiers, is kept.  The uniform arrays must have a constant index,
+ * for each value read to have a name like lights[2].color.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ir.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_optimization.h"
+#include "ir_uniformity.h"
+#include "compiler/glsl_types.h"
+
+namespace {
+
+struct preshader_cost {
+   unsigned operations;
+   unsigned uniforms;
+};
+
+class ir_preshader_visitor : public ir_rvalue_enter_visitor {
+public:
+   ir_preshader_visitor(exec_list *instructions, exec_list *preshader)
+      : instructions(instructions), preshader(preshader), last(NULL), count(0)
+   {
+      this->progress = false;
+   }
+
+   virtual void handle_rvalue(ir_rvalue **rvalue);
+
+   ir_variable *get_uniform(ir_rvalue *ir);
+
+   exec_list *instructions;
+   exec_list *preshader;
+   ir_variable *last;  /**< last uniform added, the next is declared after */
+   unsigned count;
+   bool progress;
+};
+
+} /* unnamed namespace */
+
+static bool
+is_value_type(const glsl_type *type)
+{
+   return type->is_scalar() || type->is_vector() || type->is_matrix();
+}
+
+static void
+count_node(ir_instruction *ir, void *data)
+{
+   preshader_cost *cost = (preshader_cost *) data;
+
+   if (ir->ir_type == ir_type_expression) {
+      switch (((ir_expression *) ir)->operation) {
+      case ir_unop_neg:
+      case ir_unop_abs:
+         break;
+      default:
+         cost->operations++;
+         break;
+      }
+   } else if (ir->ir_type == ir_type_dereference_variable) {
+      cost->uniforms++;
+   }
+}
+
+/**
+ * True if each value read by ir has a constant name : the arrays of
+ * uniforms, of structures or of values, have a constant index, and the
+ * structures are never read whole.
+ */
+static bool
+has_constant_names(ir_rvalue *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_constant:
+      return is_value_type(ir->type);
+
+   case ir_type_swizzle:
+      return has_constant_names(((ir_swizzle *) ir)->val);
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      for (unsigned i = 0; i < expr->num_operands; i++) {
+         if (!has_constant_names(expr->operands[i]))
+            return false;
+      }
+      return true;
+   }
+
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      if (deref->array_index->as_constant() == NULL)
+         return false;
+      /* a column of a matrix or a component of a vector */
+      if (!deref->array->type->is_array())
+         return has_constant_names(deref->array);
+      break;
+   }
+
+   case ir_type_dereference_record:
+   case ir_type_dereference_variable:
+      break;
+
+   default:
+      return false;
+   }
+
+   if (!is_value_type(ir->type))
+      return false;
+
+   /* the path of the dereference, up to the uniform */
+   ir_rvalue *path = ir;
+   while (path->ir_type != ir_type_dereference_variable) {
+      if (path->ir_type == ir_type_dereference_array) {
+         ir_dereference_array *deref = (ir_dereference_array *) path;
+         if (deref->array_index->as_constant() == NULL)
+            return false;
+         path = deref->array;
+      } else if (path->ir_type == ir_type_dereference_record) {
+         path = ((ir_dereference_record *) path)->record;
+      } else {
+         return false;
+      }
+   }
+   return true;
+}
+
+static bool
+is_name_used(exec_list *instructions, const char *name)
+{
+   foreach_in_list(ir_instruction, ir, instructions) {
+      ir_variable *var = ir->as_variable();
+      if (var != NULL && var->name != NULL && strcmp(var->name, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+/** The uniform of the preshader for ir, a new one if no equal rvalue has it */
+ir_variable *
+ir_preshader_visitor::get_uniform(ir_rvalue *ir)
+{
+   foreach_in_list(ir_assignment, assign, this->preshader) {
+      if (assign->rhs->type == ir->type && assign->rhs->equals(ir))
+         return assign->lhs->variable_referenced();
+   }
+
+   void *mem_ctx = ralloc_parent(ir);
+
+   char name[32];
+   do {
+      snprintf(name, sizeof(name), "preshader_%u", this->count++);
+   } while (is_name_used(this->instructions, name));
+
+   ir_variable *var = new(mem_ctx) ir_variable(ir->type, name,
+                                               ir_var_uniform);
+   var->data.location = -1;
+   if (this->last != NULL)
+      this->last->insert_after(var);
+   else
+      this->instructions->push_head(var);
+   this->last = var;
+
+   this->preshader->push_tail(
+      new(mem_ctx) ir_assignment(new(mem_ctx) ir_dereference_variable(var),
+                                 ir));
+   return var;
+}
+
+void
+ir_preshader_visitor::handle_rvalue(ir_rvalue **rvalue)
+{
+   ir_rvalue *ir = *rvalue;
+   if (ir == NULL || this->in_assignee ||
+       ir->ir_type == ir_type_constant ||
+       ir->ir_type == ir_type_dereference_variable ||
+       !is_value_type(ir->type))
+      return;
+
+   preshader_cost cost = { 0, 0 };
+   visit_tree(ir, count_node, &cost);
+   if (cost.operations == 0 || cost.uniforms == 0)
+      return;
+
+   if (!ir_uniformity::is_uniform_only(ir) || !has_constant_names(ir))
+      return;
+
+   *rvalue = new(ralloc_parent(ir)) ir_dereference_variable(get_uniform(ir));
+   this->progress = true;
+}
+
+bool
+do_extract_preshader(exec_list *instructions, exec_list *preshader)
+{
+   ir_preshader_visitor v(instructions, preshader);
+
+   foreach_in_list(ir_instruction, ir, instructions) {
+      if (ir->ir_type == ir_type_function)
+         ir->accept(&v);
+   }
+
+   return v.progress;
+}
@@ -49,10 +49,12 @@
 
 #include "ir.h"
 #include "ir_visitor.h"
-#include "ir_variable_refcount.h"
+#include "ir_def_use.h"
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "compiler/glsl_types.h"
+#include "util/hash_table.h"
+#include "util/u_dynarray.h"
 
 namespace {
 
@@ -61,11 +63,13 @@ static bool debug = false;
 class ir_tree_grafting_visitor : public ir_hierarchical_visitor {
 public:
    ir_tree_grafting_visitor(ir_assignment *graft_assign,
-			    ir_variable *graft_var)
+			    ir_variable *graft_var,
+			    ir_def_use *def_use)
    {
       this->progress = false;
       this->graft_assign = graft_assign;
       this->graft_var = graft_var;
+      this->def_use = def_use;
    }
 
    virtual ir_visitor_status visit_leave(class ir_assignment *);
@@ -85,6 +89,7 @@ public:
    bool progress;
    ir_variable *graft_var;
    ir_assignment *graft_assign;
+   ir_def_use *def_use;
 };
 
 struct find_deref_info {
@@ -135,6 +140,11 @@ ir_tree_grafting_visitor::do_graft(ir_rvalue **rvalue)
       fprintf(stderr, "\n");
    }
 
+   /* the references of the rhs move, only the ones of graft_var go */
+   this->def_use->remove(deref);
+   this->def_use->remove(this->graft_assign);
+   this->def_use->add(this->graft_assign->rhs);
+
    this->graft_assign->remove();
    *rvalue = this->graft_assign->rhs;
 
@@ -305,17 +315,183 @@ ir_tree_grafting_visitor::visit_enter(ir_texture *ir)
    return visit_continue;
 }
 
+/**
+ * For each variable, the positions of the instructions of a basic block who
+ * dereference it, and of those who write it (where check_graft() is called).
+ *
+ * Between the graft and the next instruction who dereferences the grafted
+ * variable or writes a variable of its expression, the grafting visitor
+ * can neither graft nor stop, so try_tree_grafting() jumps over them.
+ * Without it, each graft visits the rest of the block when its use is far
+ * or out of the block, quadratic on the long blocks of unrolled loops.
+ */
+class bb_positions {
+public:
+   bb_positions(ir_instruction *bb_first, ir_instruction *bb_last);
+   ~bb_positions();
+
+   static const unsigned none = ~0u;
+
+   /** first position > after in the list of var, or none */
+   unsigned next(hash_table *ht, ir_variable *var, unsigned after) const;
+
+   /** Top-level instructions of the block, by position */
+   ir_instruction **instructions;
+   unsigned count;
+
+   hash_table *derefs;
+   hash_table *writes;
+
+   void add(hash_table *ht, ir_variable *var, unsigned position);
+
+private:
+   void *mem_ctx;
+};
+
+struct bb_positions_add_info {
+   bb_positions *positions;
+   unsigned position;
+};
+
+static void
+bb_positions_add_deref(ir_instruction *ir, void *data)
+{
+   struct bb_positions_add_info *info = (struct bb_positions_add_info *)data;
+   ir_dereference_variable *deref = ir->as_dereference_variable();
+
+   if (deref)
+      info->positions->add(info->positions->derefs, deref->var,
+                           info->position);
+}
+
+bb_positions::bb_positions(ir_instruction *bb_first, ir_instruction *bb_last)
+{
+   this->mem_ctx = ralloc_context(NULL);
+   this->derefs = _mesa_pointer_hash_table_create(this->mem_ctx);
+   this->writes = _mesa_pointer_hash_table_create(this->mem_ctx);
+
+   this->count = 0;
+   for (ir_instruction *ir = bb_first; ir != bb_last->next;
+        ir = (ir_instruction *)ir->next)
+      this->count++;
+
+   this->instructions = ralloc_array(this->mem_ctx, ir_instruction *,
+                                     this->count);
+
+   unsigned position = 0;
+   for (ir_instruction *ir = bb_first; ir != bb_last->next;
+        ir = (ir_instruction *)ir->next, position++) {
+      this->instructions[position] = ir;
+
+      /* the grafting visitor don't enter in functions */
+      if (ir->as_function())
+         continue;
+
+      struct bb_positions_add_info info = { this, position };
+      visit_tree(ir, bb_positions_add_deref, &info);
+
+      ir_assignment *assign = ir->as_assignment();
+      if (assign) {
+         add(this->writes, assign->lhs->variable_referenced(), position);
+         continue;
+      }
+
+      ir_call *call = ir->as_call();
+      if (call) {
+         foreach_in_list(ir_variable, sig_param, &call->callee->parameters) {
+            if (sig_param->data.mode != ir_var_function_in &&
+                sig_param->data.mode != ir_var_const_in)
+               add(this->writes, sig_param, position);
+         }
+         if (call->return_deref)
+            add(this->writes, call->return_deref->var, position);
+      }
+   }
+}
+
+bb_positions::~bb_positions()
+{
+   ralloc_free(this->mem_ctx);
+}
+
+void
+bb_positions::add(hash_table *ht, ir_variable *var, unsigned position)
+{
+   hash_entry *entry = _mesa_hash_table_search(ht, var);
+   struct util_dynarray *list;
+
+   if (entry) {
+      list = (struct util_dynarray *) entry->data;
+      /* the positions are added in order, once */
+      if (util_dynarray_top(list, unsigned) == position)
+         return;
+   } else {
+      list = ralloc(this->mem_ctx, struct util_dynarray);
+      util_dynarray_init(list, this->mem_ctx);
+      _mesa_hash_table_insert(ht, var, list);
+   }
+
+   util_dynarray_append(list, unsigned, position);
+}
+
+unsigned
+bb_positions::next(hash_table *ht, ir_variable *var, unsigned after) const
+{
+   hash_entry *entry = _mesa_hash_table_search(ht, var);
+   if (!entry)
+      return none;
+
+   const struct util_dynarray *list = (struct util_dynarray *) entry->data;
+   const unsigned *positions = (const unsigned *) list->data;
+   unsigned lo = 0;
+   unsigned hi = util_dynarray_num_elements(list, unsigned);
+
+   while (lo < hi) {
+      const unsigned mid = lo + (hi - lo) / 2;
+      if (positions[mid] <= after)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo < util_dynarray_num_elements(list, unsigned) ? positions[lo]
+                                                           : none;
+}
+
+struct next_write_info {
+   const bb_positions *positions;
+   unsigned after;
+   unsigned next;
+};
+
+static void
+next_write_callback(ir_instruction *ir, void *data)
+{
+   struct next_write_info *info = (struct next_write_info *)data;
+   ir_dereference_variable *deref = ir->as_dereference_variable();
+
+   if (!deref)
+      return;
+
+   const unsigned next = info->positions->next(info->positions->writes,
+                                               deref->var, info->after);
+   if (next < info->next)
+      info->next = next;
+}
+
 struct tree_grafting_info {
-   ir_variable_refcount_visitor *refs;
+   ir_def_use *refs;
    bool progress;
 };
 
 static bool
 try_tree_grafting(ir_assignment *start,
 		  ir_variable *lhs_var,
-		  ir_instruction *bb_last)
+		  unsigned start_position,
+		  const bb_positions *positions,
+		  ir_def_use *refs)
 {
-   ir_tree_grafting_visitor v(start, lhs_var);
+   ir_tree_grafting_visitor v(start, lhs_var, refs);
 
    if (debug) {
       fprintf(stderr, "trying to graft: ");
@@ -323,9 +499,22 @@ try_tree_grafting(ir_assignment *start,
       fprintf(stderr, "\n");
    }
 
-   for (ir_instruction *ir = (ir_instruction *)start->next;
-	ir != bb_last->next;
-	ir = (ir_instruction *)ir->next) {
+   unsigned position = start_position;
+   for (;;) {
+      /* The next instruction who can graft (a deref of lhs_var) or stop
+       * (a write of a variable of the rhs), the others are not visited.
+       * The rhs don't change until the graft, who stops.
+       */
+      struct next_write_info info = { positions, position,
+                                      positions->next(positions->derefs,
+                                                      lhs_var, position) };
+      visit_tree(start->rhs, next_write_callback, &info);
+
+      if (info.next == bb_positions::none)
+         return false;
+
+      position = info.next;
+      ir_instruction *ir = positions->instructions[position];
 
       if (debug) {
 	 fprintf(stderr, "- ");
@@ -337,8 +526,6 @@ try_tree_grafting(ir_assignment *start,
       if (s == visit_stop)
 	 return v.progress;
    }
-
-   return false;
 }
 
 static void
@@ -348,10 +535,15 @@ tree_grafting_basic_block(ir_instruction *bb_first,
 {
    struct tree_grafting_info *info = (struct tree_grafting_info *)data;
    ir_instruction *ir, *next;
+   unsigned position = 0;
+   bb_positions *positions = NULL; /* built on the first graft tried */
 
+   /* A graft only removes the assignment grafted, so the positions of the
+    * instructions after it are unchanged.
+    */
    for (ir = bb_first, next = (ir_instruction *)ir->next;
 	ir != bb_last->next;
-	ir = next, next = (ir_instruction *)ir->next) {
+	ir = next, next = (ir_instruction *)ir->next, position++) {
       ir_assignment *assign = ir->as_assignment();
 
       if (!assign)
@@ -382,38 +574,46 @@ tree_grafting_basic_block(ir_instruction *bb_first,
       if (lhs_var->type->is_sampler() || lhs_var->type->is_image())
          continue;
 
-      ir_variable_refcount_entry *entry = info->refs->get_variable_entry(lhs_var);
+      ir_def_use_entry *entry = info->refs->get(lhs_var);
 
       if (!entry->declaration ||
-	  entry->assigned_count != 1 ||
-	  entry->referenced_count != 2)
+	  entry->assigned_count() != 1 ||
+	  entry->referenced_count() != 2)
 	 continue;
 
       /* Found a possibly graftable assignment.  Now, walk through the
        * rest of the BB seeing if the deref is here, and if nothing interfered with
        * pasting its expression's values in between.
        */
-      info->progress |= try_tree_grafting(assign, lhs_var, bb_last);
+      if (!positions)
+         positions = new bb_positions(bb_first, bb_last);
+
+      info->progress |= try_tree_grafting(assign, lhs_var, position,
+                                          positions, info->refs);
    }
+
+   delete positions;
 }
 
 } /* unnamed namespace */
 
 /**
  * Does a copy propagation pass on the code present in the instruction stream.
+ *
+ * def_use is updated at each graft, without it a temporary one is built.
  */
 bool
-do_tree_grafting(exec_list *instructions)
+do_tree_grafting(exec_list *instructions, ir_def_use *def_use)
 {
-   ir_variable_refcount_visitor refs;
    struct tree_grafting_info info;
 
    info.progress = false;
-   info.refs = &refs;
-
-   visit_list_elements(info.refs, instructions);
+   info.refs = def_use ? def_use : new ir_def_use(instructions);
 
    call_for_basic_blocks(instructions, tree_grafting_basic_block, &info);
 
+   if (info.refs != def_use)
+      delete info.refs;
+
    return info.progress;
 }
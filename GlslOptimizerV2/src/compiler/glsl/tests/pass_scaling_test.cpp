@@ -0,0 +1,205 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * \file pass_scaling_test.cpp
+ * The passes who keep a state per variable on a basic block must stay near
+ * linear on long code, like the unrolled loops : each pass is timed alone on
+ * 1k, 10k and 100k statements built with ir_builder, straight-line or in
+ * nested branches, and the time per statement must not grow more than
+ * MAX_GROWTH times.  A quadratic pass grows 100 times from 1k to 100k.
+ */
+
+#include "ir.h"
+#include "ir_builder.h"
+#include "ir_optimization.h"
+#include "compiler/glsl_types.h"
+#include "util/ralloc.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace ir_builder;
+
+#define MAX_GROWTH 10.0
+#define COUNT_RUNS 3
+
+struct shader
+{
+   ir_variable *u[8];
+   ir_variable *k;
+   ir_variable *col;
+   ir_function_signature *main;
+};
+
+static void
+declare(void *mem_ctx, exec_list *ir, shader *s)
+{
+   for (unsigned i = 0; i < 8; i++) {
+      s->u[i] = new(mem_ctx) ir_variable(glsl_type::vec4_type, "u", ir_var_uniform);
+      ir->push_tail(s->u[i]);
+   }
+   s->k = new(mem_ctx) ir_variable(glsl_type::float_type, "k", ir_var_uniform);
+   ir->push_tail(s->k);
+   s->col = new(mem_ctx) ir_variable(glsl_type::vec4_type, "col", ir_var_shader_out);
+   ir->push_tail(s->col);
+
+   ir_function *f = new(mem_ctx) ir_function("main");
+   s->main = new(mem_ctx) ir_function_signature(glsl_type::void_type);
+   s->main->is_defined = true;
+   f->add_signature(s->main);
+   ir->push_tail(f);
+}
+
+/* n temporaries, all used at the end :
+ *    t_i = u[i % 8] * (k + i); ... s = s + t_i; ... col = s;
+ */
+static void
+build_far(void *mem_ctx, exec_list *ir, unsigned n)
+{
+   shader s;
+   declare(mem_ctx, ir, &s);
+   ir_factory body(&s.main->body, mem_ctx);
+
+   std::vector<ir_variable *> t(n);
+   for (unsigned i = 0; i < n; i++) {
+      t[i] = body.make_temp(glsl_type::vec4_type, "t");
+      body.emit(assign(t[i], mul(s.u[i % 8], add(s.k, body.constant((float) i)))));
+   }
+
+   ir_variable *sum = body.make_temp(glsl_type::vec4_type, "s");
+   body.emit(assign(sum, new(mem_ctx) ir_constant(0.0f, 4)));
+   for (unsigned i = 0; i < n; i++)
+      body.emit(assign(sum, add(sum, t[i])));
+   body.emit(assign(s.col, sum));
+}
+
+/* swizzled copies between two vectors, in nested branches of 100 statements,
+ * the writes kill them and the kills of each branch go up to its parent :
+ *    if (k < 0) { ... a.x = b.w; b = a * u[i % 8]; ... if (k < 1) { ... } }
+ *    col = a + b;
+ */
+static void
+build_nested_chain(void *mem_ctx, exec_list *ir, unsigned n)
+{
+   shader s;
+   declare(mem_ctx, ir, &s);
+   ir_factory body(&s.main->body, mem_ctx);
+
+   ir_variable *a = body.make_temp(glsl_type::vec4_type, "a");
+   ir_variable *b = body.make_temp(glsl_type::vec4_type, "b");
+   body.emit(assign(a, s.u[0]));
+   body.emit(assign(b, s.u[1]));
+
+   exec_list *block = &s.main->body;
+   for (unsigned level = 0; level < n / 100; level++) {
+      ir_if *branch = new(mem_ctx) ir_if(less(s.k, new(mem_ctx) ir_constant((float) level)));
+      block->push_tail(branch);
+      block = &branch->then_instructions;
+
+      ir_factory branch_body(block, mem_ctx);
+      for (unsigned i = 0; i < 50; i++) {
+         branch_body.emit(assign(a, swizzle_w(b), WRITEMASK_X));
+         branch_body.emit(assign(b, mul(a, s.u[i % 8])));
+      }
+   }
+
+   body.emit(assign(s.col, add(a, b)));
+}
+
+struct pass
+{
+   const char *name;
+   bool (*run)(exec_list *ir);
+   void (*build)(void *mem_ctx, exec_list *ir, unsigned n);
+};
+
+static bool
+run_copy_propagation_elements(exec_list *ir)
+{
+   return do_copy_propagation_elements(ir);
+}
+
+static bool
+run_dead_code_local(exec_list *ir)
+{
+   return do_dead_code_local(ir);
+}
+
+static bool
+run_tree_grafting(exec_list *ir)
+{
+   return do_tree_grafting(ir);
+}
+
+/* best time per statement, in nanoseconds */
+static double
+time_per_statement(const pass &p, unsigned n)
+{
+   double best = 1e30;
+   for (unsigned run = 0; run < COUNT_RUNS; run++) {
+      void *mem_ctx = ralloc_context(NULL);
+      exec_list *ir = new(mem_ctx) exec_list;
+      p.build(mem_ctx, ir, n);
+
+      auto start = std::chrono::steady_clock::now();
+      p.run(ir);
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      if (ns < best)
+         best = ns;
+
+      ralloc_free(mem_ctx);
+   }
+   return best / n;
+}
+
+int
+main(void)
+{
+   static const pass passes[] = {
+      { "copy_propagation_elements", run_copy_propagation_elements, build_nested_chain },
+      { "dead_code_local", run_dead_code_local, build_far },
+      { "tree_grafting", run_tree_grafting, build_far },
+   };
+   static const unsigned sizes[] = { 1000, 10000, 100000 };
+
+   glsl_type_singleton_init_or_ref();
+
+   bool ok = true;
+   for (const pass &p : passes) {
+      double first = 0.0, last = 0.0;
+      printf("%-26s", p.name);
+      for (unsigned n : sizes) {
+         last = time_per_statement(p, n);
+         if (first == 0.0)
+            first = last;
+         printf("  %6uk %8.1f ns", n / 1000, last);
+      }
+      printf("  (x%.1f)\n", last / first);
+
+      if (last > first * MAX_GROWTH) {
+         printf("FAIL : %s is not linear, x%.1f per statement from %uk to %uk statements\n",
+                p.name, last / first, sizes[0] / 1000, sizes[2] / 1000);
+         ok = false;
+      }
+   }
+
+   glsl_type_singleton_decref();
+
+   return ok ? 0 : 1;
+}
@@ -28,8 +28,12 @@
 #include "util/hash_table.h"
 #include "util/u_string.h"
 
+#include <mutex>
 
-//mtx_t glsl_type::hash_mutex = _MTX_INITIALIZER_NP;
+
+/* c11/threads.h is not used in this build, the per function optimization
+ * create types from many threads */
+static std::mutex hash_mutex;
 hash_table *glsl_type::explicit_matrix_types = NULL;
 hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::struct_types = NULL;
@@ -477,20 +481,20 @@ hash_free_type_function(struct hash_entry *entry)
 void
 glsl_type_singleton_init_or_ref()
 {
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    glsl_type_users++;
-   //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 }
 
 void
 glsl_type_singleton_decref()
 {
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    /* Do not release glsl_types if they are still used. */
    if (--glsl_type_users) {
-      //mtx_unlock(&glsl_type::hash_mutex);
+      hash_mutex.unlock();
       return;
    }
 
@@ -525,7 +529,7 @@ glsl_type_singleton_decref()
       glsl_type::subroutine_types = NULL;
    }
 
-   //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 }
 
 
@@ -637,7 +641,7 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns,
       snprintf(name, sizeof(name), "%sx%uB%s", bare_type->name,
                explicit_stride, row_major ? "RM" : "");
 
-     //mtx_lock(&glsl_type::hash_mutex);
+      hash_mutex.lock();
       assert(glsl_type_users > 0);
 
       if (explicit_matrix_types == NULL) {
@@ -663,7 +667,7 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns,
       assert(((glsl_type *) entry->data)->matrix_columns == columns);
       assert(((glsl_type *) entry->data)->explicit_stride == explicit_stride);
 
-      //mtx_unlock(&glsl_type::hash_mutex);
+      hash_mutex.unlock();
 
       return (const glsl_type *) entry->data;
    }
@@ -1003,7 +1007,7 @@ glsl_type::get_array_instance(const glsl_type *base,
    snprintf(key, sizeof(key), "%p[%u]x%uB", (void *) base, array_size,
             explicit_stride);
 
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    if (array_types == NULL) {
@@ -1024,7 +1028,7 @@ glsl_type::get_array_instance(const glsl_type *base,
    assert(((glsl_type *) entry->data)->length == array_size);
    assert(((glsl_type *) entry->data)->fields.array == base);
 
-   //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 
    return (glsl_type *) entry->data;
 }
@@ -1204,7 +1208,7 @@ glsl_type::get_struct_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, name, packed);
 
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    if (struct_types == NULL) {
@@ -1225,7 +1229,7 @@ glsl_type::get_struct_instance(const glsl_struct_field *fields,
    assert(strcmp(((glsl_type *) entry->data)->name, name) == 0);
    assert(((glsl_type *) entry->data)->packed == packed);
 
-   //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 
    return (glsl_type *) entry->data;
 }
@@ -1240,7 +1244,7 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, packing, row_major, block_name);
 
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    if (interface_types == NULL) {
@@ -1261,7 +1265,7 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
    assert(((glsl_type *) entry->data)->length == num_fields);
    assert(strcmp(((glsl_type *) entry->data)->name, block_name) == 0);
 
-   //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 
    return (glsl_type *) entry->data;
 }
@@ -1271,7 +1275,7 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
 {
    const glsl_type key(subroutine_name);
 
-  //mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    if (subroutine_types == NULL) {
@@ -1290,7 +1294,7 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
    assert(strcmp(((glsl_type *) entry->data)->name, subroutine_name) == 0);
 
- //  //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 
    return (glsl_type *) entry->data;
 }
@@ -1325,7 +1329,7 @@ glsl_type::get_function_instance(const glsl_type *return_type,
 {
    const glsl_type key(return_type, params, num_params);
 
-  ////mtx_lock(&glsl_type::hash_mutex);
+   hash_mutex.lock();
    assert(glsl_type_users > 0);
 
    if (function_types == NULL) {
@@ -1345,7 +1349,7 @@ glsl_type::get_function_instance(const glsl_type *return_type,
    assert(t->base_type == GLSL_TYPE_FUNCTION);
    assert(t->length == num_params);
 
- //  //mtx_unlock(&glsl_type::hash_mutex);
+   hash_mutex.unlock();
 
    return t;
 }
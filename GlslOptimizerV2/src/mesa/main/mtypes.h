@@ -3178,6 +3178,8 @@ struct gl_shader_compiler_options
 
    GLuint MaxIfDepth;               /**< Maximum nested IF blocks */
    GLuint MaxUnrollIterations;
+   GLuint MaxUnrollInstructions;    /**< Budget of body cost times copies, 0 => MaxUnrollIterations * 5 nodes */
+   GLboolean UnrollPartial;         /**< Unroll by a factor of the trip count when the full unroll is over budget */
 
    /**
     * Optimize code for array of structures backends.
@@ -26,6 +26,7 @@
 #include "symbol_table.h"
 #include "../../util/hash_table.h"
 #include "util/u_string.h"
+#include "util/string_interner.h"
 
 struct symbol {
    /** Symbol name. */
@@ -81,6 +82,12 @@ struct _mesa_symbol_table {
 
     /** Current scope depth. */
     unsigned depth;
+
+    /**
+     * When not NULL, the names are interned here instead of strdup'd, the
+     * symbols with an equal name share it and it is not freed with them.
+     */
+    struct string_interner *interner;
 };
 
 void
@@ -106,7 +113,8 @@ _mesa_symbol_table_pop_scope(struct _mesa_symbol_table *table)
            hte->data = sym->next_with_same_name;
         } else {
            _mesa_hash_table_remove(table->ht, hte);
-           free(sym->name);
+           if (table->interner == NULL)
+              free(sym->name);
         }
 
         free(sym);
@@ -130,6 +138,15 @@ _mesa_symbol_table_push_scope(struct _mesa_symbol_table *table)
 }
 
 
+static char *
+copy_name(struct _mesa_symbol_table *table, const char *name)
+{
+   if (table->interner)
+      return (char *) string_interner_intern(table->interner, name);
+   return strdup(name);
+}
+
+
 static struct symbol *
 find_symbol(struct _mesa_symbol_table *table, const char *name)
 {
@@ -194,7 +211,7 @@ _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
       new_sym->next_with_same_name = sym;
       new_sym->name = sym->name;
    } else {
-      new_sym->name = strdup(name);
+      new_sym->name = copy_name(table, name);
       if (new_sym->name == NULL) {
          free(new_sym);
          _mesa_error_no_memory(__func__);
@@ -266,7 +283,7 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
       sym->name = inner_sym->name;
    } else {
-      sym->name = strdup(name);
+      sym->name = copy_name(table, name);
       if (sym->name == NULL) {
          free(sym);
          _mesa_error_no_memory(__func__);
@@ -286,6 +303,31 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
 
 
+/* the keys are interned, so an interned name is found without strcmp */
+static bool
+interned_string_equal(const void *a, const void *b)
+{
+   return a == b || strcmp(a, b) == 0;
+}
+
+
+struct _mesa_symbol_table *
+_mesa_symbol_table_ctor_interned(struct string_interner *interner)
+{
+    struct _mesa_symbol_table *table = calloc(1, sizeof(*table));
+
+    if (table != NULL) {
+       table->interner = interner;
+       table->ht = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
+                                           interned_string_equal);
+
+       _mesa_symbol_table_push_scope(table);
+    }
+
+    return table;
+}
+
+
 struct _mesa_symbol_table *
 _mesa_symbol_table_ctor(void)
 {
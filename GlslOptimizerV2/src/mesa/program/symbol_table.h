@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 struct _mesa_symbol_table;
+struct string_interner;
 
 extern void _mesa_symbol_table_push_scope(struct _mesa_symbol_table *table);
 
@@ -53,6 +54,13 @@ extern void *_mesa_symbol_table_find_symbol(struct _mesa_symbol_table *symtab,
 
 extern struct _mesa_symbol_table *_mesa_symbol_table_ctor(void);
 
+/**
+ * Symbol table who keeps the names in an interner, instead of a copy per
+ * name.  The interner must outlive the table.
+ */
+extern struct _mesa_symbol_table *
+_mesa_symbol_table_ctor_interned(struct string_interner *interner);
+
 extern void _mesa_symbol_table_dtor(struct _mesa_symbol_table *);
 
 #ifdef __cplusplus
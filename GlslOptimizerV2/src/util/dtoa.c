@@ -0,0 +1,385 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file dtoa.c
+ * Shortest round-trip formatting of floats and doubles.
+ *
+ * Grisu2 of Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers" (PLDI 2010) : the boundaries of the value are
+ * scaled by a cached power of ten in 64 bits fixed point, and the digits are
+ * generated until the number is inside them.  The result always read back
+ * to the same bits.  It is the shortest but when the shortest is exactly on
+ * a boundary of the rounding interval, who is left out for stay safe : then
+ * it has one digit more (about 0.2% of the floats, 0.1% of the doubles).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dtoa.h"
+#include "bitscan.h"
+
+struct diy_fp {
+   uint64_t f;
+   int e;
+};
+
+/* 10^k for k in [-348, 340] by step of 8, normalized to 64 bits */
+static const uint64_t cached_powers_f[] = {
+   UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+   UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+   UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+   UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+   UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+   UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+   UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+   UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+   UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+   UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+   UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+   UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+   UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+   UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+   UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+   UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+   UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+   UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+   UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+   UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+   UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+   UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+   UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+   UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+   UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+   UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+   UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+   UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+   UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b),
+};
+
+static const int16_t cached_powers_e[] = {
+   -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+   -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+   -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+   -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+   -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+   109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+   375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+   641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+   907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t pow10_64[] = {
+   1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+   100000000ull, 1000000000ull, 10000000000ull, 100000000000ull,
+   1000000000000ull, 10000000000000ull, 100000000000000ull,
+   1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+   1000000000000000000ull, 10000000000000000000ull
+};
+
+static struct diy_fp
+diy_fp_normalize(struct diy_fp x)
+{
+   const int shift = 64 - (int) util_last_bit64(x.f);
+   x.f <<= shift;
+   x.e -= shift;
+   return x;
+}
+
+/* upper 64 bits of the product, rounded */
+static struct diy_fp
+diy_fp_mul(struct diy_fp x, struct diy_fp y)
+{
+   const uint64_t m32 = 0xFFFFFFFFu;
+   const uint64_t a = x.f >> 32, b = x.f & m32;
+   const uint64_t c = y.f >> 32, d = y.f & m32;
+   const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+   uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+   tmp += 1u << 31;
+
+   struct diy_fp r;
+   r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+   r.e = x.e + y.e + 64;
+   return r;
+}
+
+/* a cached power c_mk with the scaled exponent of e in [-60, -32], K = -k */
+static struct diy_fp
+cached_power(int e, int *K)
+{
+   const double dk = (-61 - e) * 0.30102999566398114 + 347;
+   int k = (int) dk;
+   if (dk - k > 0.0)
+      k++;
+
+   const unsigned index = (unsigned) ((k >> 3) + 1);
+   *K = -(-348 + (int) (index << 3));
+
+   struct diy_fp r;
+   r.f = cached_powers_f[index];
+   r.e = cached_powers_e[index];
+   return r;
+}
+
+static int
+count_decimal_digits32(uint32_t n)
+{
+   if (n < 10) return 1;
+   if (n < 100) return 2;
+   if (n < 1000) return 3;
+   if (n < 10000) return 4;
+   if (n < 100000) return 5;
+   if (n < 1000000) return 6;
+   if (n < 10000000) return 7;
+   if (n < 100000000) return 8;
+   return 9;
+}
+
+/* move the last digit toward w while the number stay in the boundaries */
+static void
+grisu_round(char *digits, int count, uint64_t delta, uint64_t rest,
+            uint64_t ten_kappa, uint64_t wp_w)
+{
+   while (rest < wp_w && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < wp_w ||
+           wp_w - rest > rest + ten_kappa - wp_w)) {
+      digits[count - 1]--;
+      rest += ten_kappa;
+   }
+}
+
+static int
+digit_gen(struct diy_fp w, struct diy_fp mp, uint64_t delta,
+          char *digits, int *K)
+{
+   const struct diy_fp one = { (uint64_t) 1 << -mp.e, mp.e };
+   const uint64_t wp_w = mp.f - w.f;
+   uint32_t p1 = (uint32_t) (mp.f >> -one.e);
+   uint64_t p2 = mp.f & (one.f - 1);
+   int kappa = count_decimal_digits32(p1);
+   int count = 0;
+
+   /* integral part */
+   while (kappa > 0) {
+      const uint32_t div = (uint32_t) pow10_64[kappa - 1];
+      const uint32_t d = p1 / div;
+      p1 %= div;
+      if (d || count)
+         digits[count++] = (char) ('0' + d);
+      kappa--;
+
+      const uint64_t rest = ((uint64_t) p1 << -one.e) + p2;
+      if (rest <= delta) {
+         *K += kappa;
+         grisu_round(digits, count, delta, rest,
+                     pow10_64[kappa] << -one.e, wp_w);
+         return count;
+      }
+   }
+
+   /* fractional part */
+   for (;;) {
+      p2 *= 10;
+      delta *= 10;
+      const char d = (char) (p2 >> -one.e);
+      if (d || count)
+         digits[count++] = (char) ('0' + d);
+      p2 &= one.f - 1;
+      kappa--;
+      if (p2 < delta) {
+         *K += kappa;
+         const int index = -kappa;
+         grisu_round(digits, count, delta, p2, one.f,
+                     wp_w * (index < 20 ? pow10_64[index] : 0));
+         return count;
+      }
+   }
+}
+
+/**
+ * \param f          significand, with the hidden bit
+ * \param e          binary exponent, value = f * 2^e
+ * \param lower_closer  the value is a power of two, not the smallest normal
+ */
+static int
+grisu2(uint64_t f, int e, bool lower_closer, char *digits, int *exponent)
+{
+   struct diy_fp v = { f, e };
+
+   struct diy_fp plus = { (f << 1) + 1, e - 1 };
+   plus = diy_fp_normalize(plus);
+
+   struct diy_fp minus;
+   if (lower_closer) {
+      minus.f = (f << 2) - 1;
+      minus.e = e - 2;
+   } else {
+      minus.f = (f << 1) - 1;
+      minus.e = e - 1;
+   }
+   minus.f <<= minus.e - plus.e;
+   minus.e = plus.e;
+
+   int K;
+   const struct diy_fp c_mk = cached_power(plus.e, &K);
+
+   const struct diy_fp w = diy_fp_mul(diy_fp_normalize(v), c_mk);
+   struct diy_fp wp = diy_fp_mul(plus, c_mk);
+   struct diy_fp wm = diy_fp_mul(minus, c_mk);
+   wm.f++;
+   wp.f--;
+
+   int count = digit_gen(w, wp, wp.f - wm.f, digits, &K);
+
+   while (count > 1 && digits[count - 1] == '0') {
+      count--;
+      K++;
+   }
+
+   *exponent = K;
+   return count;
+}
+
+int
+util_dtoa_digits_float(float f, char *digits, int *exponent)
+{
+   uint32_t bits;
+   memcpy(&bits, &f, sizeof(bits));
+
+   const uint32_t biased_e = (bits >> 23) & 0xFF;
+   const uint32_t mantissa = bits & 0x7FFFFF;
+
+   if (biased_e != 0)
+      return grisu2(mantissa | 0x800000, (int) biased_e - 150,
+                    mantissa == 0 && biased_e > 1, digits, exponent);
+
+   return grisu2(mantissa, 1 - 150, false, digits, exponent);
+}
+
+int
+util_dtoa_digits_double(double d, char *digits, int *exponent)
+{
+   uint64_t bits;
+   memcpy(&bits, &d, sizeof(bits));
+
+   const uint32_t biased_e = (uint32_t) (bits >> 52) & 0x7FF;
+   const uint64_t mantissa = bits & 0xFFFFFFFFFFFFFull;
+
+   if (biased_e != 0)
+      return grisu2(mantissa | 0x10000000000000ull, (int) biased_e - 1075,
+                    mantissa == 0 && biased_e > 1, digits, exponent);
+
+   return grisu2(mantissa, 1 - 1075, false, digits, exponent);
+}
+
+/* the layout of printf %g, with the given digits */
+static int
+format(char *buf, bool negative, const char *digits, int count, int exponent,
+       int precision)
+{
+   const int x = count - 1 + exponent; /* decimal exponent of the first digit */
+   const int p = precision > 0 ? (precision < 17 ? precision : 17) : count;
+   char *s = buf;
+
+   if (negative)
+      *s++ = '-';
+
+   if (x < -4 || x >= p) {
+      *s++ = digits[0];
+      if (count > 1) {
+         *s++ = '.';
+         memcpy(s, digits + 1, count - 1);
+         s += count - 1;
+      }
+      *s++ = 'e';
+      *s++ = x < 0 ? '-' : '+';
+      int ax = abs(x);
+      if (ax >= 100) {
+         *s++ = (char) ('0' + ax / 100);
+         ax %= 100;
+      }
+      *s++ = (char) ('0' + ax / 10);
+      *s++ = (char) ('0' + ax % 10);
+   } else if (x < 0) {
+      *s++ = '0';
+      *s++ = '.';
+      for (int i = -1; i > x; i--)
+         *s++ = '0';
+      memcpy(s, digits, count);
+      s += count;
+   } else {
+      for (int i = 0; i <= x; i++)
+         *s++ = i < count ? digits[i] : '0';
+      if (count > x + 1) {
+         *s++ = '.';
+         memcpy(s, digits + x + 1, count - x - 1);
+         s += count - x - 1;
+      }
+   }
+
+   *s = '\0';
+   return (int) (s - buf);
+}
+
+static int
+format_special(char *buf, bool negative, bool nan, bool inf)
+{
+   char *s = buf;
+   if (negative)
+      *s++ = '-';
+   strcpy(s, nan ? "nan" : inf ? "inf" : "0");
+   return (int) (s - buf) + (int) strlen(s);
+}
+
+int
+util_dtoa_float(float f, int precision, char *buf)
+{
+   uint32_t bits;
+   memcpy(&bits, &f, sizeof(bits));
+
+   const bool negative = (bits >> 31) != 0;
+   const uint32_t abs_bits = bits & 0x7FFFFFFF;
+   if (abs_bits == 0 || abs_bits >= 0x7F800000)
+      return format_special(buf, negative && abs_bits <= 0x7F800000,
+                            abs_bits > 0x7F800000, abs_bits == 0x7F800000);
+
+   char digits[20];
+   int exponent;
+   const int count = util_dtoa_digits_float(negative ? -f : f, digits, &exponent);
+   return format(buf, negative, digits, count, exponent, precision);
+}
+
+int
+util_dtoa_double(double d, int precision, char *buf)
+{
+   uint64_t bits;
+   memcpy(&bits, &d, sizeof(bits));
+
+   const bool negative = (bits >> 63) != 0;
+   const uint64_t abs_bits = bits & 0x7FFFFFFFFFFFFFFFull;
+   if (abs_bits == 0 || abs_bits >= 0x7FF0000000000000ull)
+      return format_special(buf, negative && abs_bits <= 0x7FF0000000000000ull,
+                            abs_bits > 0x7FF0000000000000ull,
+                            abs_bits == 0x7FF0000000000000ull);
+
+   char digits[20];
+   int exponent;
+   const int count = util_dtoa_digits_double(negative ? -d : d, digits, &exponent);
+   return format(buf, negative, digits, count, exponent, precision);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DTOA_H
+#define DTOA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Enough for any output of util_dtoa_float and util_dtoa_double */
+#define UTIL_DTOA_BUFFER_SIZE 32
+
+/**
+ * Decimal digits of a finite, non zero, positive value, as few as possible
+ * for read back the same bits (Grisu2).  value = digits * 10^exponent.
+ * digits gets 1 to 17 ascii digits, not terminated.  Returns the count.
+ */
+extern int
+util_dtoa_digits_float(float f, char *digits, int *exponent);
+
+extern int
+util_dtoa_digits_double(double d, char *digits, int *exponent);
+
+/**
+ * Shortest text who read back to the same bits, in the notation
+ * printf("%.*g", precision) would choose : scientific when the decimal
+ * exponent is < -4 or >= precision.  A precision of 0 means the digit
+ * count, so the shortest text.  buf needs UTIL_DTOA_BUFFER_SIZE bytes.
+ * Zero keep his sign, inf and nan are printed as "inf" and "nan".
+ * Returns the length.
+ */
+extern int
+util_dtoa_float(float f, int precision, char *buf);
+
+extern int
+util_dtoa_double(double d, int precision, char *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DTOA_H */
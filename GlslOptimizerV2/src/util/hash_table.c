@@ -38,6 +38,9 @@
  * For more information, see:
  *
  * http://cgit.freedesktop.org/~anholt/hash_table/tree/README
+ *
+ * With USE_SWISS_HASH_TABLE, the storage is a swiss table instead, see
+ * swiss_table.h.  The API and its guarantees are the same.
  */
 
 #include <stdlib.h>
@@ -49,9 +52,19 @@
 #include "macros.h"
 #include "main/hash.h"
 #include "fast_urem_by_const.h"
+#include "bitscan.h"
+#include "swiss_table.h"
 
 static const uint32_t deleted_key_value;
 
+static inline bool
+key_pointer_is_reserved(const struct hash_table *ht, const void *key)
+{
+   return key == NULL || key == ht->deleted_key;
+}
+
+#ifndef USE_SWISS_HASH_TABLE
+
 /**
  * From Knuth -- a good choice for hash/rehash values is p, p-2 where
  * p and p-2 are both prime.  These tables are sized to have an extra 10%
@@ -98,12 +111,6 @@ static const struct {
    ENTRY(2147483648ul, 2362232233ul, 2362232231ul )
 };
 
-static inline bool
-key_pointer_is_reserved(const struct hash_table *ht, const void *key)
-{
-   return key == NULL || key == ht->deleted_key;
-}
-
 static int
 entry_is_free(const struct hash_entry *entry)
 {
@@ -145,29 +152,6 @@ _mesa_hash_table_init(struct hash_table *ht,
    return ht->table != NULL;
 }
 
-struct hash_table *
-_mesa_hash_table_create(void *mem_ctx,
-                        uint32_t (*key_hash_function)(const void *key),
-                        bool (*key_equals_function)(const void *a,
-                                                    const void *b))
-{
-   struct hash_table *ht;
-
-   /* mem_ctx is used to allocate the hash table, but the hash table is used
-    * to allocate all of the suballocations.
-    */
-   ht = ralloc(mem_ctx, struct hash_table);
-   if (ht == NULL)
-      return NULL;
-
-   if (!_mesa_hash_table_init(ht, ht, key_hash_function, key_equals_function)) {
-      ralloc_free(ht);
-      return NULL;
-   }
-
-   return ht;
-}
-
 struct hash_table *
 _mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
 {
@@ -190,27 +174,6 @@ _mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
    return ht;
 }
 
-/**
- * Frees the given hash table.
- *
- * If delete_function is passed, it gets called on each entry present before
- * freeing.
- */
-void
-_mesa_hash_table_destroy(struct hash_table *ht,
-                         void (*delete_function)(struct hash_entry *entry))
-{
-   if (!ht)
-      return;
-
-   if (delete_function) {
-      hash_table_foreach(ht, entry) {
-         delete_function(entry);
-      }
-   }
-   ralloc_free(ht);
-}
-
 /**
  * Deletes all entries of the given hash table without deleting the table
  * itself or changing its structure.
@@ -237,22 +200,6 @@ _mesa_hash_table_clear(struct hash_table *ht,
    ht->deleted_entries = 0;
 }
 
-/** Sets the value of the key pointer used for deleted entries in the table.
- *
- * The assumption is that usually keys are actual pointers, so we use a
- * default value of a pointer to an arbitrary piece of storage in the library.
- * But in some cases a consumer wants to store some other sort of value in the
- * table, like a uint32_t, in which case that pointer may conflict with one of
- * their valid keys.  This lets that user select a safe value.
- *
- * This must be called before any keys are actually deleted from the table.
- */
-void
-_mesa_hash_table_set_deleted_key(struct hash_table *ht, const void *deleted_key)
-{
-   ht->deleted_key = deleted_key;
-}
-
 static struct hash_entry *
 hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
@@ -283,27 +230,6 @@ hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
    return NULL;
 }
 
-/**
- * Finds a hash table entry with the given key and hash of that key.
- *
- * Returns NULL if no entry is found.  Note that the data pointer may be
- * modified by the user.
- */
-struct hash_entry *
-_mesa_hash_table_search(struct hash_table *ht, const void *key)
-{
-   assert(ht->key_hash_function);
-   return hash_table_search(ht, ht->key_hash_function(key), key);
-}
-
-struct hash_entry *
-_mesa_hash_table_search_pre_hashed(struct hash_table *ht, uint32_t hash,
-                                  const void *key)
-{
-   assert(ht->key_hash_function == NULL || hash == ht->key_hash_function(key));
-   return hash_table_search(ht, hash, key);
-}
-
 static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data);
@@ -438,27 +364,6 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
    return NULL;
 }
 
-/**
- * Inserts the key with the given hash into the table.
- *
- * Note that insertion may rearrange the table on a resize or rehash,
- * so previously found hash_entries are no longer valid after this function.
- */
-struct hash_entry *
-_mesa_hash_table_insert(struct hash_table *ht, const void *key, void *data)
-{
-   assert(ht->key_hash_function);
-   return hash_table_insert(ht, ht->key_hash_function(key), key, data);
-}
-
-struct hash_entry *
-_mesa_hash_table_insert_pre_hashed(struct hash_table *ht, uint32_t hash,
-                                   const void *key, void *data)
-{
-   assert(ht->key_hash_function == NULL || hash == ht->key_hash_function(key));
-   return hash_table_insert(ht, hash, key, data);
-}
-
 /**
  * This function deletes the given hash table entry.
  *
@@ -477,15 +382,6 @@ _mesa_hash_table_remove(struct hash_table *ht,
    ht->deleted_entries++;
 }
 
-/**
- * Removes the entry with the corresponding key, if exists.
- */
-void _mesa_hash_table_remove_key(struct hash_table *ht,
-                                 const void *key)
-{
-   _mesa_hash_table_remove(ht, _mesa_hash_table_search(ht, key));
-}
-
 /**
  * This function is an iterator over the hash table.
  *
@@ -545,6 +441,386 @@ _mesa_hash_table_random_entry(struct hash_table *ht,
    return NULL;
 }
 
+#else /* USE_SWISS_HASH_TABLE */
+
+/*
+ * Swiss table variant, see swiss_table.h.  The entries and their control
+ * bytes are in one allocation, the capacity is a power of two.
+ */
+
+static size_t
+hash_table_bytes(uint32_t capacity)
+{
+   return (size_t) capacity * sizeof(struct hash_entry) + swiss_ctrl_bytes(capacity);
+}
+
+static bool
+hash_table_alloc(struct hash_table *ht, void *mem_ctx, uint32_t capacity)
+{
+   struct hash_entry *table = ralloc_size(mem_ctx, hash_table_bytes(capacity));
+   if (table == NULL)
+      return false;
+
+   ht->table = table;
+   ht->ctrl = (uint8_t *) (table + capacity);
+   swiss_ctrl_init(ht->ctrl, capacity);
+   ht->size = capacity;
+   ht->max_entries = swiss_max_entries(capacity);
+   ht->entries = 0;
+   ht->deleted_entries = 0;
+
+   return true;
+}
+
+bool
+_mesa_hash_table_init(struct hash_table *ht,
+                      void *mem_ctx,
+                      uint32_t (*key_hash_function)(const void *key),
+                      bool (*key_equals_function)(const void *a,
+                                                  const void *b))
+{
+   memset(ht, 0, sizeof(*ht));
+   ht->key_hash_function = key_hash_function;
+   ht->key_equals_function = key_equals_function;
+   ht->deleted_key = &deleted_key_value;
+
+   return hash_table_alloc(ht, mem_ctx, SWISS_MIN_CAPACITY);
+}
+
+struct hash_table *
+_mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
+{
+   struct hash_table *ht;
+
+   ht = ralloc(dst_mem_ctx, struct hash_table);
+   if (ht == NULL)
+      return NULL;
+
+   memcpy(ht, src, sizeof(struct hash_table));
+
+   ht->table = ralloc_size(ht, hash_table_bytes(ht->size));
+   if (ht->table == NULL) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
+   memcpy(ht->table, src->table, hash_table_bytes(ht->size));
+   ht->ctrl = (uint8_t *) (ht->table + ht->size);
+
+   return ht;
+}
+
+void
+_mesa_hash_table_clear(struct hash_table *ht,
+                       void (*delete_function)(struct hash_entry *entry))
+{
+   if (delete_function) {
+      hash_table_foreach(ht, entry) {
+         delete_function(entry);
+      }
+   }
+
+   swiss_ctrl_init(ht->ctrl, ht->size);
+   ht->entries = 0;
+   ht->deleted_entries = 0;
+}
+
+static struct hash_entry *
+hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
+{
+   assert(!key_pointer_is_reserved(ht, key));
+
+   const uint32_t mixed = swiss_mix(hash);
+   const uint8_t h2 = swiss_h2(mixed);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+
+   do {
+      const uint8_t *ctrl = ht->ctrl + probe.offset;
+      unsigned match = swiss_group_match(ctrl, h2);
+      while (match) {
+         struct hash_entry *entry = ht->table + probe.offset + u_bit_scan(&match);
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
+            return entry;
+      }
+
+      if (swiss_group_match_empty(ctrl))
+         return NULL;
+   } while (swiss_probe_next(&probe));
+
+   return NULL;
+}
+
+/* no compare, the key is not in the table and there is no deleted slot */
+static void
+hash_table_insert_rehash(struct hash_table *ht, uint32_t hash,
+                         const void *key, void *data)
+{
+   const uint32_t mixed = swiss_mix(hash);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+
+   do {
+      unsigned empty = swiss_group_match_empty(ht->ctrl + probe.offset);
+      if (likely(empty)) {
+         const uint32_t index = probe.offset + u_bit_scan(&empty);
+         struct hash_entry *entry = ht->table + index;
+         ht->ctrl[index] = swiss_h2(mixed);
+         entry->hash = hash;
+         entry->key = key;
+         entry->data = data;
+         return;
+      }
+   } while (swiss_probe_next(&probe));
+}
+
+static void
+_mesa_hash_table_rehash(struct hash_table *ht, uint32_t capacity)
+{
+   struct hash_table old_ht = *ht;
+
+   /* size * 2 overflow */
+   if (capacity == 0)
+      return;
+
+   if (!hash_table_alloc(ht, ralloc_parent(old_ht.table), capacity))
+      return;
+
+   hash_table_foreach(&old_ht, entry) {
+      hash_table_insert_rehash(ht, entry->hash, entry->key, entry->data);
+   }
+
+   ht->entries = old_ht.entries;
+
+   ralloc_free(old_ht.table);
+}
+
+static struct hash_entry *
+hash_table_insert(struct hash_table *ht, uint32_t hash,
+                  const void *key, void *data)
+{
+   assert(!key_pointer_is_reserved(ht, key));
+
+   if (ht->entries >= ht->max_entries) {
+      _mesa_hash_table_rehash(ht, ht->size * 2);
+   } else if (ht->deleted_entries + ht->entries >= ht->max_entries) {
+      _mesa_hash_table_rehash(ht, ht->size);
+   }
+
+   const uint32_t mixed = swiss_mix(hash);
+   const uint8_t h2 = swiss_h2(mixed);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+   uint32_t available_index = UINT32_MAX;
+
+   do {
+      const uint8_t *ctrl = ht->ctrl + probe.offset;
+      unsigned match = swiss_group_match(ctrl, h2);
+      while (match) {
+         struct hash_entry *entry = ht->table + probe.offset + u_bit_scan(&match);
+         /* replacement, as the linear probing variant */
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            entry->data = data;
+            return entry;
+         }
+      }
+
+      /* Stash the first available slot we find */
+      if (available_index == UINT32_MAX) {
+         unsigned available = swiss_group_match_available(ctrl, ht->size);
+         if (available)
+            available_index = probe.offset + u_bit_scan(&available);
+      }
+
+      if (swiss_group_match_empty(ctrl))
+         break;
+   } while (swiss_probe_next(&probe));
+
+   /* We could hit here if a required resize failed. */
+   if (available_index == UINT32_MAX)
+      return NULL;
+
+   if (ht->ctrl[available_index] == SWISS_CTRL_DELETED)
+      ht->deleted_entries--;
+   ht->ctrl[available_index] = h2;
+
+   struct hash_entry *entry = ht->table + available_index;
+   entry->hash = hash;
+   entry->key = key;
+   entry->data = data;
+   ht->entries++;
+   return entry;
+}
+
+void
+_mesa_hash_table_remove(struct hash_table *ht,
+                        struct hash_entry *entry)
+{
+   if (!entry)
+      return;
+
+   const uint32_t index = (uint32_t) (entry - ht->table);
+   const uint8_t ctrl = swiss_removed_ctrl(ht->ctrl, index);
+   if (ctrl == SWISS_CTRL_DELETED)
+      ht->deleted_entries++;
+   ht->ctrl[index] = ctrl;
+
+   entry->key = ht->deleted_key;
+   ht->entries--;
+}
+
+struct hash_entry *
+_mesa_hash_table_next_entry(struct hash_table *ht,
+                            struct hash_entry *entry)
+{
+   uint32_t index = entry == NULL ? 0 : (uint32_t) (entry - ht->table) + 1;
+
+   while (index < ht->size) {
+      const uint32_t group = index & ~(uint32_t) (SWISS_GROUP_SIZE - 1);
+      unsigned full = swiss_group_match_full(ht->ctrl + group);
+      full &= ~0u << (index - group);
+      if (full)
+         return ht->table + group + u_bit_scan(&full);
+      index = group + SWISS_GROUP_SIZE;
+   }
+
+   return NULL;
+}
+
+struct hash_entry *
+_mesa_hash_table_random_entry(struct hash_table *ht,
+                              bool (*predicate)(struct hash_entry *entry))
+{
+   uint32_t i = rand() % ht->size;
+
+   if (ht->entries == 0)
+      return NULL;
+
+   for (uint32_t j = 0; j < ht->size; j++) {
+      const uint32_t index = (i + j) & (ht->size - 1);
+      struct hash_entry *entry = ht->table + index;
+      if (swiss_ctrl_is_full(ht->ctrl[index]) &&
+          (!predicate || predicate(entry))) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+#endif /* USE_SWISS_HASH_TABLE */
+
+struct hash_table *
+_mesa_hash_table_create(void *mem_ctx,
+                        uint32_t (*key_hash_function)(const void *key),
+                        bool (*key_equals_function)(const void *a,
+                                                    const void *b))
+{
+   struct hash_table *ht;
+
+   /* mem_ctx is used to allocate the hash table, but the hash table is used
+    * to allocate all of the suballocations.
+    */
+   ht = ralloc(mem_ctx, struct hash_table);
+   if (ht == NULL)
+      return NULL;
+
+   if (!_mesa_hash_table_init(ht, ht, key_hash_function, key_equals_function)) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
+   return ht;
+}
+
+/**
+ * Frees the given hash table.
+ *
+ * If delete_function is passed, it gets called on each entry present before
+ * freeing.
+ */
+void
+_mesa_hash_table_destroy(struct hash_table *ht,
+                         void (*delete_function)(struct hash_entry *entry))
+{
+   if (!ht)
+      return;
+
+   if (delete_function) {
+      hash_table_foreach(ht, entry) {
+         delete_function(entry);
+      }
+   }
+   ralloc_free(ht);
+}
+
+/** Sets the value of the key pointer used for deleted entries in the table.
+ *
+ * The assumption is that usually keys are actual pointers, so we use a
+ * default value of a pointer to an arbitrary piece of storage in the library.
+ * But in some cases a consumer wants to store some other sort of value in the
+ * table, like a uint32_t, in which case that pointer may conflict with one of
+ * their valid keys.  This lets that user select a safe value.
+ *
+ * This must be called before any keys are actually deleted from the table.
+ */
+void
+_mesa_hash_table_set_deleted_key(struct hash_table *ht, const void *deleted_key)
+{
+   ht->deleted_key = deleted_key;
+}
+
+/**
+ * Finds a hash table entry with the given key and hash of that key.
+ *
+ * Returns NULL if no entry is found.  Note that the data pointer may be
+ * modified by the user.
+ */
+struct hash_entry *
+_mesa_hash_table_search(struct hash_table *ht, const void *key)
+{
+   assert(ht->key_hash_function);
+   return hash_table_search(ht, ht->key_hash_function(key), key);
+}
+
+struct hash_entry *
+_mesa_hash_table_search_pre_hashed(struct hash_table *ht, uint32_t hash,
+                                  const void *key)
+{
+   assert(ht->key_hash_function == NULL || hash == ht->key_hash_function(key));
+   return hash_table_search(ht, hash, key);
+}
+
+/**
+ * Inserts the key with the given hash into the table.
+ *
+ * Note that insertion may rearrange the table on a resize or rehash,
+ * so previously found hash_entries are no longer valid after this function.
+ */
+struct hash_entry *
+_mesa_hash_table_insert(struct hash_table *ht, const void *key, void *data)
+{
+   assert(ht->key_hash_function);
+   return hash_table_insert(ht, ht->key_hash_function(key), key, data);
+}
+
+struct hash_entry *
+_mesa_hash_table_insert_pre_hashed(struct hash_table *ht, uint32_t hash,
+                                   const void *key, void *data)
+{
+   assert(ht->key_hash_function == NULL || hash == ht->key_hash_function(key));
+   return hash_table_insert(ht, hash, key, data);
+}
+
+/**
+ * Removes the entry with the corresponding key, if exists.
+ */
+void _mesa_hash_table_remove_key(struct hash_table *ht,
+                                 const void *key)
+{
+   _mesa_hash_table_remove(ht, _mesa_hash_table_search(ht, key));
+}
 
 /**
  * Quick FNV-1a hash implementation based on:
@@ -76,12 +76,21 @@ struct
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+#ifdef USE_RALLOC_STATS
+   /* Size of the block, the high bit is set if the block is accounted in
+    * the stats.  Free only for the gcc/clang release builds, where it takes
+    * the alignment padding; the debug canary, or the 8 alignment of MSVC on
+    * 64-bit, make the header grow by 8 or 16 bytes.
+    */
+   size_t size;
+#endif
 };
 
 typedef struct ralloc_header ralloc_header;
 
 static void unlink_block(ralloc_header *info);
-static void unsafe_free(ralloc_header *info);
+static void unsafe_free(ralloc_header *info, ralloc_header *root);
 
 static ralloc_header *
 get_header(const void *ptr)
@@ -94,6 +103,250 @@ get_header(const void *ptr)
 
 #define PTR_FROM_HEADER(info) (((char *) info) + sizeof(ralloc_header))
 
+/*
+ * Stats
+ */
+
+#ifdef USE_RALLOC_STATS
+
+#define ACCOUNTED_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define BLOCK_SIZE(info) ((info)->size & ~ACCOUNTED_BIT)
+#define ROOT_TABLE_SIZE 1024 /* power of two */
+
+struct root_stats
+{
+   ralloc_header *root;
+   struct ralloc_stats stats;
+};
+
+static bool stats_enabled = false;
+static bool stats_used = false; /* enabled, or accounted blocks are still alive */
+static struct ralloc_stats global_stats;
+static struct root_stats root_table[ROOT_TABLE_SIZE]; /* open addressing, linear probing */
+static struct ralloc_stats untracked_roots; /* when the table is full */
+
+static ralloc_header *
+find_root(ralloc_header *info)
+{
+   while (info->parent != NULL)
+      info = info->parent;
+   return info;
+}
+
+static unsigned
+root_hash(const ralloc_header *root)
+{
+   uintptr_t p = (uintptr_t)root >> 4;
+   return (unsigned)((p ^ (p >> 15)) * 2654435761u) & (ROOT_TABLE_SIZE - 1);
+}
+
+static struct ralloc_stats *
+get_root_stats(ralloc_header *root, bool create)
+{
+   unsigned i = root_hash(root);
+   for (unsigned n = 0; n < ROOT_TABLE_SIZE; n++) {
+      if (root_table[i].root == root)
+         return &root_table[i].stats;
+      if (root_table[i].root == NULL) {
+         if (!create)
+            return NULL;
+         root_table[i].root = root;
+         memset(&root_table[i].stats, 0, sizeof(struct ralloc_stats));
+         return &root_table[i].stats;
+      }
+      i = (i + 1) & (ROOT_TABLE_SIZE - 1);
+   }
+   return create ? &untracked_roots : NULL;
+}
+
+static void
+remove_root_stats(ralloc_header *root)
+{
+   unsigned i = root_hash(root);
+   unsigned n;
+   for (n = 0; n < ROOT_TABLE_SIZE; n++) {
+      if (root_table[i].root == root)
+         break;
+      if (root_table[i].root == NULL)
+         return;
+      i = (i + 1) & (ROOT_TABLE_SIZE - 1);
+   }
+   if (n == ROOT_TABLE_SIZE)
+      return;
+
+   /* backward shift deletion, keep the probe sequences without holes */
+   root_table[i].root = NULL;
+   unsigned j = i;
+   while (true) {
+      j = (j + 1) & (ROOT_TABLE_SIZE - 1);
+      if (root_table[j].root == NULL)
+         break;
+      unsigned k = root_hash(root_table[j].root);
+      bool movable = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+      if (movable) {
+         root_table[i] = root_table[j];
+         root_table[j].root = NULL;
+         i = j;
+      }
+   }
+}
+
+static void
+stats_add(struct ralloc_stats *stats, size_t bytes, size_t count, size_t allocs)
+{
+   stats->live_bytes += bytes;
+   stats->live_count += count;
+   stats->alloc_count += allocs;
+   if (stats->live_bytes > stats->peak_bytes)
+      stats->peak_bytes = stats->live_bytes;
+}
+
+static void
+stats_sub(struct ralloc_stats *stats, size_t bytes, size_t count)
+{
+   stats->live_bytes -= bytes;
+   stats->live_count -= count;
+}
+
+static void
+account_add(ralloc_header *root, size_t bytes, size_t count, size_t allocs)
+{
+   stats_add(&global_stats, bytes, count, allocs);
+   stats_add(get_root_stats(root, true), bytes, count, allocs);
+}
+
+/* no accounted block alive and the stats disabled, the frees no longer have
+ * to find their root
+ */
+static void
+forget_roots(void)
+{
+   stats_used = false;
+   memset(root_table, 0, sizeof(root_table));
+   memset(&untracked_roots, 0, sizeof(untracked_roots));
+}
+
+static void
+account_sub(ralloc_header *root, size_t bytes, size_t count)
+{
+   stats_sub(&global_stats, bytes, count);
+   stats_sub(get_root_stats(root, true), bytes, count);
+   if (global_stats.live_count == 0 && !stats_enabled)
+      forget_roots();
+}
+
+/* sum of the accounted blocks of a subtree */
+static void
+sum_accounted(ralloc_header *info, size_t *bytes, size_t *count)
+{
+   if (info->size & ACCOUNTED_BIT) {
+      *bytes += BLOCK_SIZE(info);
+      *count += 1;
+   }
+   for (ralloc_header *child = info->child; child != NULL; child = child->next)
+      sum_accounted(child, bytes, count);
+}
+
+/* a subtree changed of root, move his accounted blocks */
+static void
+move_accounted(ralloc_header *old_root, ralloc_header *new_root,
+               size_t bytes, size_t count)
+{
+   if (old_root == new_root || (bytes == 0 && count == 0))
+      return;
+   stats_sub(get_root_stats(old_root, true), bytes, count);
+   stats_add(get_root_stats(new_root, true), bytes, count, 0);
+}
+
+void
+ralloc_stats_enable(bool enable)
+{
+   stats_enabled = enable;
+   if (enable)
+      stats_used = true;
+   else if (global_stats.live_count == 0)
+      forget_roots();
+}
+
+bool
+ralloc_stats_enabled(void)
+{
+   return stats_enabled;
+}
+
+bool
+ralloc_stats_used(void)
+{
+   return stats_used;
+}
+
+void
+ralloc_stats_get(struct ralloc_stats *stats)
+{
+   *stats = global_stats;
+}
+
+void
+ralloc_stats_reset_peak(void)
+{
+   global_stats.peak_bytes = global_stats.live_bytes;
+}
+
+bool
+ralloc_stats_get_root(const void *ctx, struct ralloc_stats *stats)
+{
+   if (ctx == NULL || !stats_used)
+      return false;
+
+   struct ralloc_stats *root_stats = get_root_stats(find_root(get_header(ctx)), false);
+   if (root_stats == NULL)
+      return false;
+
+   *stats = *root_stats;
+   return true;
+}
+
+#else /* USE_RALLOC_STATS */
+
+void
+ralloc_stats_enable(bool enable)
+{
+   (void) enable;
+}
+
+bool
+ralloc_stats_enabled(void)
+{
+   return false;
+}
+
+bool
+ralloc_stats_used(void)
+{
+   return false;
+}
+
+void
+ralloc_stats_get(struct ralloc_stats *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+}
+
+void
+ralloc_stats_reset_peak(void)
+{
+}
+
+bool
+ralloc_stats_get_root(const void *ctx, struct ralloc_stats *stats)
+{
+   (void) ctx;
+   (void) stats;
+   return false;
+}
+
+#endif /* USE_RALLOC_STATS */
+
 static void
 add_child(ralloc_header *parent, ralloc_header *info)
 {
@@ -133,11 +386,21 @@ ralloc_size(const void *ctx, size_t size)
    info->prev = NULL;
    info->next = NULL;
    info->destructor = NULL;
+#ifdef USE_RALLOC_STATS
+   info->size = size;
+#endif
 
    parent = ctx != NULL ? get_header(ctx) : NULL;
 
    add_child(parent, info);
 
+#ifdef USE_RALLOC_STATS
+   if (unlikely(stats_enabled)) {
+      info->size |= ACCOUNTED_BIT;
+      account_add(find_root(info), size, 1, 1);
+   }
+#endif
+
 #ifndef NDEBUG
    info->canary = CANARY;
 #endif
@@ -184,6 +447,31 @@ resize(void *ptr, size_t size)
    for (child = info->child; child != NULL; child = child->next)
       child->parent = info;
 
+#ifdef USE_RALLOC_STATS
+   if (unlikely(stats_used)) {
+      /* a moved root is a new key of the root table */
+      if (info != old && info->parent == NULL) {
+         struct ralloc_stats *old_stats = get_root_stats(old, false);
+         if (old_stats != NULL) {
+            struct ralloc_stats moved = *old_stats;
+            remove_root_stats(old);
+            *get_root_stats(info, true) = moved;
+         }
+      }
+
+      if (info->size & ACCOUNTED_BIT) {
+         ralloc_header *root = find_root(info);
+         account_sub(root, BLOCK_SIZE(info), 0);
+         account_add(root, size, 0, 1);
+         info->size = size | ACCOUNTED_BIT;
+      } else {
+         info->size = size;
+      }
+   } else {
+      info->size = size;
+   }
+#endif
+
    return PTR_FROM_HEADER(info);
 }
 
@@ -258,8 +546,20 @@ ralloc_free(void *ptr)
       return;
 
    info = get_header(ptr);
+
+#ifdef USE_RALLOC_STATS
+   ralloc_header *root = unlikely(stats_used) ? find_root(info) : NULL;
+#else
+   ralloc_header *root = NULL;
+#endif
+
    unlink_block(info);
-   unsafe_free(info);
+   unsafe_free(info, root);
+
+#ifdef USE_RALLOC_STATS
+   if (unlikely(root == info))
+      remove_root_stats(info);
+#endif
 }
 
 static void
@@ -282,20 +582,27 @@ unlink_block(ralloc_header *info)
 }
 
 static void
-unsafe_free(ralloc_header *info)
+unsafe_free(ralloc_header *info, ralloc_header *root)
 {
    /* Recursively free any children...don't waste time unlinking them. */
    ralloc_header *temp;
    while (info->child != NULL) {
       temp = info->child;
       info->child = temp->next;
-      unsafe_free(temp);
+      unsafe_free(temp, root);
    }
 
    /* Free the block itself.  Call the destructor first, if any. */
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
+#ifdef USE_RALLOC_STATS
+   if (unlikely(info->size & ACCOUNTED_BIT))
+      account_sub(root, BLOCK_SIZE(info), 1);
+#else
+   (void) root;
+#endif
+
    free(info);
 }
 
@@ -310,9 +617,26 @@ ralloc_steal(const void *new_ctx, void *ptr)
    info = get_header(ptr);
    parent = new_ctx ? get_header(new_ctx) : NULL;
 
+#ifdef USE_RALLOC_STATS
+   ralloc_header *old_root = unlikely(stats_used) ? find_root(info) : NULL;
+#endif
+
    unlink_block(info);
 
    add_child(parent, info);
+
+#ifdef USE_RALLOC_STATS
+   if (unlikely(stats_used)) {
+      ralloc_header *new_root = find_root(info);
+      if (new_root != old_root) {
+         size_t bytes = 0, count = 0;
+         sum_accounted(info, &bytes, &count);
+         move_accounted(old_root, new_root, bytes, count);
+         if (old_root == info)
+            remove_root_stats(info);
+      }
+   }
+#endif
 }
 
 void
@@ -330,6 +654,19 @@ ralloc_adopt(const void *new_ctx, void *old_ctx)
    if (unlikely(old_info->child == NULL))
       return;
 
+#ifdef USE_RALLOC_STATS
+   if (unlikely(stats_used)) {
+      ralloc_header *old_root = find_root(old_info);
+      ralloc_header *new_root = find_root(new_info);
+      if (old_root != new_root) {
+         size_t bytes = 0, count = 0;
+         for (child = old_info->child; child != NULL; child = child->next)
+            sum_accounted(child, &bytes, &count);
+         move_accounted(old_root, new_root, bytes, count);
+      }
+   }
+#endif
+
    /* Set all the children's parent to new_ctx; get a pointer to the last child. */
    for (child = old_info->child; child->next != NULL; child = child->next) {
       child->parent = new_info;
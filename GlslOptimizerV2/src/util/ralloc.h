@@ -313,6 +313,66 @@ void *ralloc_parent(const void *ptr);
  */
 void ralloc_set_destructor(const void *ptr, void(*destructor)(void *));
 
+/// \defgroup stats Allocation Statistics @{
+/**
+ * Optional accounting of the ralloc allocations, disabled by default.
+ *
+ * Once enabled, each new block is accounted to the global counters and to
+ * the counters of its root (the ancestor without parent).  The blocks
+ * allocated before the enable are ignored, the accounted blocks stay
+ * accounted until they are freed even if the stats are disabled later.
+ *
+ * The counters are shared by all the trees, so while the stats are enabled
+ * or accounted blocks are alive, distinct contexts can no longer be used
+ * from many threads (see ralloc_stats_used).
+ *
+ * Built only with USE_RALLOC_STATS, else the block size is not stored and
+ * these functions do nothing.
+ */
+struct ralloc_stats
+{
+   size_t live_bytes;   /**< Bytes currently allocated, headers excluded */
+   size_t live_count;   /**< Blocks currently allocated */
+   size_t peak_bytes;   /**< High-water mark of live_bytes */
+   size_t alloc_count;  /**< Allocations and resizes done */
+};
+
+/**
+ * Enable or disable the accounting of the new allocations.
+ */
+void ralloc_stats_enable(bool enable);
+
+bool ralloc_stats_enabled(void);
+
+/**
+ * True while the stats are enabled or accounted blocks are still alive.
+ */
+bool ralloc_stats_used(void);
+
+/**
+ * Get the global counters, all roots included.
+ *
+ * peak_bytes is the high-water mark since the last ralloc_stats_reset_peak.
+ */
+void ralloc_stats_get(struct ralloc_stats *stats);
+
+/**
+ * Restart the global high-water mark from the current live bytes.
+ *
+ * Used for measure the peak of a phase.
+ */
+void ralloc_stats_reset_peak(void);
+
+/**
+ * Get the counters of the root of \p ctx.
+ *
+ * peak_bytes is the high-water mark since the root creation.
+ *
+ * \return False if nothing was accounted to this root.
+ */
+bool ralloc_stats_get_root(const void *ctx, struct ralloc_stats *stats);
+/// @}
+
 /// \defgroup array String Functions @{
 /**
  * Duplicate a string, allocating the memory from the given context.
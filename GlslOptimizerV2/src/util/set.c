@@ -41,6 +41,19 @@
 #include "ralloc.h"
 #include "set.h"
 #include "fast_urem_by_const.h"
+#include "bitscan.h"
+#include "swiss_table.h"
+
+static const uint32_t deleted_key_value;
+static const void *deleted_key = &deleted_key_value;
+
+static inline bool
+key_pointer_is_reserved(const void *key)
+{
+   return key == NULL || key == deleted_key;
+}
+
+#ifndef USE_SWISS_HASH_TABLE
 
 /*
  * From Knuth -- a good choice for hash/rehash values is p, p-2 where
@@ -48,9 +61,6 @@
  * free to avoid exponential performance degradation as the hash table fills
  */
 
-static const uint32_t deleted_key_value;
-static const void *deleted_key = &deleted_key_value;
-
 static const struct {
    uint32_t max_entries, size, rehash;
    uint64_t size_magic, rehash_magic;
@@ -92,12 +102,6 @@ static const struct {
    ENTRY(2147483648ul, 2362232233ul, 2362232231ul )
 };
 
-static inline bool
-key_pointer_is_reserved(const void *key)
-{
-   return key == NULL || key == deleted_key;
-}
-
 static int
 entry_is_free(struct set_entry *entry)
 {
@@ -170,27 +174,6 @@ _mesa_set_clone(struct set *set, void *dst_mem_ctx)
    return clone;
 }
 
-/**
- * Frees the given set.
- *
- * If delete_function is passed, it gets called on each entry present before
- * freeing.
- */
-void
-_mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entry))
-{
-   if (!ht)
-      return;
-
-   if (delete_function) {
-      set_foreach (ht, entry) {
-         delete_function(entry);
-      }
-   }
-   ralloc_free(ht->table);
-   ralloc_free(ht);
-}
-
 /**
  * Clears all values from the given set.
  *
@@ -246,22 +229,6 @@ set_search(const struct set *ht, uint32_t hash, const void *key)
    return NULL;
 }
 
-struct set_entry *
-_mesa_set_search(const struct set *set, const void *key)
-{
-   assert(set->key_hash_function);
-   return set_search(set, set->key_hash_function(key), key);
-}
-
-struct set_entry *
-_mesa_set_search_pre_hashed(const struct set *set, uint32_t hash,
-                            const void *key)
-{
-   assert(set->key_hash_function == NULL ||
-          hash == set->key_hash_function(key));
-   return set_search(set, hash, key);
-}
-
 static void
 set_add_rehash(struct set *ht, uint32_t hash, const void *key)
 {
@@ -400,6 +367,395 @@ set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
    return NULL;
 }
 
+/**
+ * This function deletes the given hash table entry.
+ *
+ * Note that deletion doesn't otherwise modify the table, so an iteration over
+ * the table deleting entries is safe.
+ */
+void
+_mesa_set_remove(struct set *ht, struct set_entry *entry)
+{
+   if (!entry)
+      return;
+
+   entry->key = deleted_key;
+   ht->entries--;
+   ht->deleted_entries++;
+}
+
+/**
+ * This function is an iterator over the hash table.
+ *
+ * Pass in NULL for the first entry, as in the start of a for loop.  Note that
+ * an iteration over the table is O(table_size) not O(entries).
+ */
+struct set_entry *
+_mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
+{
+   if (entry == NULL)
+      entry = ht->table;
+   else
+      entry = entry + 1;
+
+   for (; entry != ht->table + ht->size; entry++) {
+      if (entry_is_present(entry)) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+struct set_entry *
+_mesa_set_random_entry(struct set *ht,
+                       int (*predicate)(struct set_entry *entry))
+{
+   struct set_entry *entry;
+   uint32_t i = rand() % ht->size;
+
+   if (ht->entries == 0)
+      return NULL;
+
+   for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
+      if (entry_is_present(entry) &&
+          (!predicate || predicate(entry))) {
+         return entry;
+      }
+   }
+
+   for (entry = ht->table; entry != ht->table + i; entry++) {
+      if (entry_is_present(entry) &&
+          (!predicate || predicate(entry))) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+#else /* USE_SWISS_HASH_TABLE */
+
+/*
+ * Swiss table variant, see swiss_table.h.  The entries and their control
+ * bytes are in one allocation, the capacity is a power of two.
+ */
+
+static size_t
+set_bytes(uint32_t capacity)
+{
+   return (size_t) capacity * sizeof(struct set_entry) + swiss_ctrl_bytes(capacity);
+}
+
+static bool
+set_alloc(struct set *ht, uint32_t capacity)
+{
+   struct set_entry *table = ralloc_size(ht, set_bytes(capacity));
+   if (table == NULL)
+      return false;
+
+   ht->table = table;
+   ht->ctrl = (uint8_t *) (table + capacity);
+   swiss_ctrl_init(ht->ctrl, capacity);
+   ht->size = capacity;
+   ht->max_entries = swiss_max_entries(capacity);
+   ht->entries = 0;
+   ht->deleted_entries = 0;
+
+   return true;
+}
+
+struct set *
+_mesa_set_create(void *mem_ctx,
+                 uint32_t (*key_hash_function)(const void *key),
+                 bool (*key_equals_function)(const void *a,
+                                             const void *b))
+{
+   struct set *ht;
+
+   ht = rzalloc(mem_ctx, struct set);
+   if (ht == NULL)
+      return NULL;
+
+   ht->key_hash_function = key_hash_function;
+   ht->key_equals_function = key_equals_function;
+
+   if (!set_alloc(ht, SWISS_MIN_CAPACITY)) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
+   return ht;
+}
+
+struct set *
+_mesa_set_clone(struct set *set, void *dst_mem_ctx)
+{
+   struct set *clone;
+
+   clone = ralloc(dst_mem_ctx, struct set);
+   if (clone == NULL)
+      return NULL;
+
+   memcpy(clone, set, sizeof(struct set));
+
+   clone->table = ralloc_size(clone, set_bytes(clone->size));
+   if (clone->table == NULL) {
+      ralloc_free(clone);
+      return NULL;
+   }
+
+   memcpy(clone->table, set->table, set_bytes(clone->size));
+   clone->ctrl = (uint8_t *) (clone->table + clone->size);
+
+   return clone;
+}
+
+void
+_mesa_set_clear(struct set *set, void (*delete_function)(struct set_entry *entry))
+{
+   if (!set)
+      return;
+
+   if (delete_function) {
+      set_foreach (set, entry) {
+         delete_function(entry);
+      }
+   }
+
+   swiss_ctrl_init(set->ctrl, set->size);
+   set->entries = set->deleted_entries = 0;
+}
+
+static struct set_entry *
+set_search(const struct set *ht, uint32_t hash, const void *key)
+{
+   assert(!key_pointer_is_reserved(key));
+
+   const uint32_t mixed = swiss_mix(hash);
+   const uint8_t h2 = swiss_h2(mixed);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+
+   do {
+      const uint8_t *ctrl = ht->ctrl + probe.offset;
+      unsigned match = swiss_group_match(ctrl, h2);
+      while (match) {
+         struct set_entry *entry = ht->table + probe.offset + u_bit_scan(&match);
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
+            return entry;
+      }
+
+      if (swiss_group_match_empty(ctrl))
+         return NULL;
+   } while (swiss_probe_next(&probe));
+
+   return NULL;
+}
+
+/* no compare, the key is not in the set and there is no deleted slot */
+static void
+set_add_rehash(struct set *ht, uint32_t hash, const void *key)
+{
+   const uint32_t mixed = swiss_mix(hash);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+
+   do {
+      unsigned empty = swiss_group_match_empty(ht->ctrl + probe.offset);
+      if (likely(empty)) {
+         const uint32_t index = probe.offset + u_bit_scan(&empty);
+         struct set_entry *entry = ht->table + index;
+         ht->ctrl[index] = swiss_h2(mixed);
+         entry->hash = hash;
+         entry->key = key;
+         return;
+      }
+   } while (swiss_probe_next(&probe));
+}
+
+static void
+set_rehash(struct set *ht, uint32_t capacity)
+{
+   struct set old_ht = *ht;
+
+   /* size * 2 overflow */
+   if (capacity == 0)
+      return;
+
+   if (!set_alloc(ht, capacity))
+      return;
+
+   set_foreach(&old_ht, entry) {
+      set_add_rehash(ht, entry->hash, entry->key);
+   }
+
+   ht->entries = old_ht.entries;
+
+   ralloc_free(old_ht.table);
+}
+
+void
+_mesa_set_resize(struct set *set, uint32_t entries)
+{
+   /* You can't shrink a set below its number of entries */
+   if (set->entries > entries)
+      entries = set->entries;
+
+   set_rehash(set, swiss_capacity_for(entries));
+}
+
+static struct set_entry *
+set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
+{
+   assert(!key_pointer_is_reserved(key));
+
+   if (ht->entries >= ht->max_entries) {
+      set_rehash(ht, ht->size * 2);
+   } else if (ht->deleted_entries + ht->entries >= ht->max_entries) {
+      set_rehash(ht, ht->size);
+   }
+
+   const uint32_t mixed = swiss_mix(hash);
+   const uint8_t h2 = swiss_h2(mixed);
+   struct swiss_probe probe;
+   swiss_probe_start(&probe, mixed, ht->size);
+   uint32_t available_index = UINT32_MAX;
+
+   do {
+      const uint8_t *ctrl = ht->ctrl + probe.offset;
+      unsigned match = swiss_group_match(ctrl, h2);
+      while (match) {
+         struct set_entry *entry = ht->table + probe.offset + u_bit_scan(&match);
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key)) {
+            if (found)
+               *found = true;
+            return entry;
+         }
+      }
+
+      /* Stash the first available slot we find */
+      if (available_index == UINT32_MAX) {
+         unsigned available = swiss_group_match_available(ctrl, ht->size);
+         if (available)
+            available_index = probe.offset + u_bit_scan(&available);
+      }
+
+      if (swiss_group_match_empty(ctrl))
+         break;
+   } while (swiss_probe_next(&probe));
+
+   /* We could hit here if a required resize failed. */
+   if (available_index == UINT32_MAX)
+      return NULL;
+
+   /* There is no matching entry, create it. */
+   if (ht->ctrl[available_index] == SWISS_CTRL_DELETED)
+      ht->deleted_entries--;
+   ht->ctrl[available_index] = h2;
+
+   struct set_entry *entry = ht->table + available_index;
+   entry->hash = hash;
+   entry->key = key;
+   ht->entries++;
+   if (found)
+      *found = false;
+   return entry;
+}
+
+void
+_mesa_set_remove(struct set *ht, struct set_entry *entry)
+{
+   if (!entry)
+      return;
+
+   const uint32_t index = (uint32_t) (entry - ht->table);
+   const uint8_t ctrl = swiss_removed_ctrl(ht->ctrl, index);
+   if (ctrl == SWISS_CTRL_DELETED)
+      ht->deleted_entries++;
+   ht->ctrl[index] = ctrl;
+
+   entry->key = deleted_key;
+   ht->entries--;
+}
+
+struct set_entry *
+_mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
+{
+   uint32_t index = entry == NULL ? 0 : (uint32_t) (entry - ht->table) + 1;
+
+   while (index < ht->size) {
+      const uint32_t group = index & ~(uint32_t) (SWISS_GROUP_SIZE - 1);
+      unsigned full = swiss_group_match_full(ht->ctrl + group);
+      full &= ~0u << (index - group);
+      if (full)
+         return ht->table + group + u_bit_scan(&full);
+      index = group + SWISS_GROUP_SIZE;
+   }
+
+   return NULL;
+}
+
+struct set_entry *
+_mesa_set_random_entry(struct set *ht,
+                       int (*predicate)(struct set_entry *entry))
+{
+   uint32_t i = rand() % ht->size;
+
+   if (ht->entries == 0)
+      return NULL;
+
+   for (uint32_t j = 0; j < ht->size; j++) {
+      const uint32_t index = (i + j) & (ht->size - 1);
+      struct set_entry *entry = ht->table + index;
+      if (swiss_ctrl_is_full(ht->ctrl[index]) &&
+          (!predicate || predicate(entry))) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+#endif /* USE_SWISS_HASH_TABLE */
+
+/**
+ * Frees the given set.
+ *
+ * If delete_function is passed, it gets called on each entry present before
+ * freeing.
+ */
+void
+_mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entry))
+{
+   if (!ht)
+      return;
+
+   if (delete_function) {
+      set_foreach (ht, entry) {
+         delete_function(entry);
+      }
+   }
+   ralloc_free(ht->table);
+   ralloc_free(ht);
+}
+
+struct set_entry *
+_mesa_set_search(const struct set *set, const void *key)
+{
+   assert(set->key_hash_function);
+   return set_search(set, set->key_hash_function(key), key);
+}
+
+struct set_entry *
+_mesa_set_search_pre_hashed(const struct set *set, uint32_t hash,
+                            const void *key)
+{
+   assert(set->key_hash_function == NULL ||
+          hash == set->key_hash_function(key));
+   return set_search(set, hash, key);
+}
+
 /**
  * Inserts the key with the given hash into the table.
  *
@@ -485,23 +841,6 @@ _mesa_set_search_or_add_pre_hashed(struct set *set, uint32_t hash,
    return set_search_or_add(set, hash, key, NULL);
 }
 
-/**
- * This function deletes the given hash table entry.
- *
- * Note that deletion doesn't otherwise modify the table, so an iteration over
- * the table deleting entries is safe.
- */
-void
-_mesa_set_remove(struct set *ht, struct set_entry *entry)
-{
-   if (!entry)
-      return;
-
-   entry->key = deleted_key;
-   ht->entries--;
-   ht->deleted_entries++;
-}
-
 /**
  * Removes the entry with the corresponding key, if exists.
  */
@@ -511,56 +850,6 @@ _mesa_set_remove_key(struct set *set, const void *key)
    _mesa_set_remove(set, _mesa_set_search(set, key));
 }
 
-/**
- * This function is an iterator over the hash table.
- *
- * Pass in NULL for the first entry, as in the start of a for loop.  Note that
- * an iteration over the table is O(table_size) not O(entries).
- */
-struct set_entry *
-_mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
-{
-   if (entry == NULL)
-      entry = ht->table;
-   else
-      entry = entry + 1;
-
-   for (; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry)) {
-         return entry;
-      }
-   }
-
-   return NULL;
-}
-
-struct set_entry *
-_mesa_set_random_entry(struct set *ht,
-                       int (*predicate)(struct set_entry *entry))
-{
-   struct set_entry *entry;
-   uint32_t i = rand() % ht->size;
-
-   if (ht->entries == 0)
-      return NULL;
-
-   for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
-      }
-   }
-
-   for (entry = ht->table; entry != ht->table + i; entry++) {
-      if (entry_is_present(entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
-      }
-   }
-
-   return NULL;
-}
-
 /**
  * Helper to create a set with pointer keys.
  */
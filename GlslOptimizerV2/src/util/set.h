@@ -53,6 +53,7 @@ struct set {
    uint32_t size_index;
    uint32_t entries;
    uint32_t deleted_entries;
+   uint8_t *ctrl; /* USE_SWISS_HASH_TABLE, after the entries */
 };
 
 struct set *
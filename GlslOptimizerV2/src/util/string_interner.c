@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "string_interner.h"
+#include "hash_table.h"
+#include "ralloc.h"
+#include "set.h"
+
+struct string_interner {
+   struct set *strings;
+   void *linalloc; /* the copies, packed */
+};
+
+/* the length is known on intern, so the hash don't search the end */
+static uint32_t
+hash_string_len(const char *str, size_t len)
+{
+   return _mesa_hash_data(str, len);
+}
+
+static uint32_t
+hash_string(const void *key)
+{
+   const char *str = (const char *) key;
+   return hash_string_len(str, strlen(str));
+}
+
+struct string_interner *
+string_interner_create(void *mem_ctx)
+{
+   struct string_interner *interner = ralloc(mem_ctx, struct string_interner);
+   if (interner == NULL)
+      return NULL;
+
+   interner->strings = _mesa_set_create(interner, hash_string,
+                                        _mesa_key_string_equal);
+   interner->linalloc = linear_alloc_parent(interner, 0);
+   if (interner->strings == NULL || interner->linalloc == NULL) {
+      ralloc_free(interner);
+      return NULL;
+   }
+
+   return interner;
+}
+
+const char *
+string_interner_intern_len(struct string_interner *interner,
+                           const char *str, size_t len)
+{
+   assert(str[len] == '\0');
+
+   const uint32_t hash = hash_string_len(str, len);
+   struct set_entry *entry =
+      _mesa_set_search_pre_hashed(interner->strings, hash, str);
+   if (entry)
+      return (const char *) entry->key;
+
+   char *copy = (char *) linear_alloc_child(interner->linalloc, len + 1);
+   if (copy == NULL)
+      return NULL;
+   memcpy(copy, str, len + 1);
+
+   _mesa_set_add_pre_hashed(interner->strings, hash, copy);
+   return copy;
+}
+
+const char *
+string_interner_intern(struct string_interner *interner, const char *str)
+{
+   return string_interner_intern_len(interner, str, strlen(str));
+}
+
+bool
+string_interner_owns(const struct string_interner *interner, const char *str)
+{
+   struct set_entry *entry =
+      _mesa_set_search_pre_hashed(interner->strings, hash_string(str), str);
+   return entry && entry->key == str;
+}
+
+unsigned
+string_interner_count(const struct string_interner *interner)
+{
+   return interner->strings->entries;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file string_interner.h
+ * One copy of each string, for the identifiers of a compilation.
+ *
+ * The strings interned with the same interner are equal if and only if
+ * their pointers are equal, and live as long as the interner, who is a
+ * ralloc child of the context given at creation.
+ */
+
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct string_interner;
+
+extern struct string_interner *
+string_interner_create(void *mem_ctx);
+
+/**
+ * The unique copy of str.  len is strlen(str), when the caller know it
+ * already (the lexer).
+ */
+extern const char *
+string_interner_intern_len(struct string_interner *interner,
+                           const char *str, size_t len);
+
+extern const char *
+string_interner_intern(struct string_interner *interner, const char *str);
+
+/** true if str is the copy returned by the interner, not only equal to it */
+extern bool
+string_interner_owns(const struct string_interner *interner, const char *str);
+
+/** Count of the unique strings */
+extern unsigned
+string_interner_count(const struct string_interner *interner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRING_INTERNER_H */
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file swiss_table.h
+ * Control bytes of the swiss table variant of hash_table.c and set.c
+ * (USE_SWISS_HASH_TABLE).
+ *
+ * The slots are in groups of 16, each slot has a control byte : empty,
+ * deleted, or the 7 low bits of the mixed hash when full.  A probe compares
+ * the 16 control bytes of a group at once (SSE2 when available), so only
+ * the candidates have their entry loaded and their key compared.  The
+ * groups are probed in triangular order, who visits all of them since their
+ * count is a power of two.  A small table (4 or 8 slots) has one group,
+ * the control bytes after the capacity are sentinels.
+ */
+
+#ifndef SWISS_TABLE_H
+#define SWISS_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SWISS_TABLE_SSE2 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWISS_GROUP_SIZE 16
+#define SWISS_MIN_CAPACITY 4
+
+#define SWISS_CTRL_EMPTY ((uint8_t) 0x80)
+#define SWISS_CTRL_DELETED ((uint8_t) 0xFE)
+#define SWISS_CTRL_SENTINEL ((uint8_t) 0xFF)
+
+/* usable slots of a capacity, 7/8 */
+static inline uint32_t
+swiss_max_entries(uint32_t capacity)
+{
+   return (uint32_t) (((uint64_t) capacity * 7) / 8);
+}
+
+/* control bytes of a capacity, at least one group */
+static inline uint32_t
+swiss_ctrl_bytes(uint32_t capacity)
+{
+   return capacity < SWISS_GROUP_SIZE ? SWISS_GROUP_SIZE : capacity;
+}
+
+static inline void
+swiss_ctrl_init(uint8_t *ctrl, uint32_t capacity)
+{
+   memset(ctrl, SWISS_CTRL_EMPTY, capacity);
+   if (capacity < SWISS_GROUP_SIZE)
+      memset(ctrl + capacity, SWISS_CTRL_SENTINEL, SWISS_GROUP_SIZE - capacity);
+}
+
+/* smallest capacity for this count of entries */
+static inline uint32_t
+swiss_capacity_for(uint32_t entries)
+{
+   uint32_t capacity = SWISS_MIN_CAPACITY;
+   while (swiss_max_entries(capacity) < entries && capacity < (1u << 31))
+      capacity *= 2;
+   return capacity;
+}
+
+/*
+ * the hashes of the tables can be weak in the low bits (pointers), so they
+ * are mixed (murmur3 finalizer) : 7 bits for the control byte, the others
+ * for the group
+ */
+static inline uint32_t
+swiss_mix(uint32_t hash)
+{
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6bu;
+   hash ^= hash >> 13;
+   hash *= 0xc2b2ae35u;
+   hash ^= hash >> 16;
+   return hash;
+}
+
+static inline uint8_t
+swiss_h2(uint32_t mixed)
+{
+   return (uint8_t) (mixed & 0x7F);
+}
+
+static inline bool
+swiss_ctrl_is_full(uint8_t ctrl)
+{
+   return (ctrl & 0x80) == 0;
+}
+
+/* the bit i is set when ctrl[i] == h2 */
+static inline unsigned
+swiss_group_match(const uint8_t *ctrl, uint8_t h2)
+{
+#ifdef SWISS_TABLE_SSE2
+   const __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+   return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) h2)));
+#else
+   unsigned mask = 0;
+   for (unsigned i = 0; i < SWISS_GROUP_SIZE; i++)
+      mask |= (unsigned) (ctrl[i] == h2) << i;
+   return mask;
+#endif
+}
+
+static inline unsigned
+swiss_group_match_empty(const uint8_t *ctrl)
+{
+   return swiss_group_match(ctrl, SWISS_CTRL_EMPTY);
+}
+
+static inline unsigned
+swiss_group_match_empty_or_deleted(const uint8_t *ctrl)
+{
+#ifdef SWISS_TABLE_SSE2
+   const __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+   return (unsigned) _mm_movemask_epi8(group);
+#else
+   unsigned mask = 0;
+   for (unsigned i = 0; i < SWISS_GROUP_SIZE; i++)
+      mask |= (unsigned) (ctrl[i] >> 7) << i;
+   return mask;
+#endif
+}
+
+/* empty or deleted, without the sentinels of a small table */
+static inline unsigned
+swiss_group_match_available(const uint8_t *ctrl, uint32_t capacity)
+{
+   unsigned mask = swiss_group_match_empty_or_deleted(ctrl);
+   if (capacity < SWISS_GROUP_SIZE)
+      mask &= (1u << capacity) - 1;
+   return mask;
+}
+
+static inline unsigned
+swiss_group_match_full(const uint8_t *ctrl)
+{
+   return ~swiss_group_match_empty_or_deleted(ctrl) & 0xFFFFu;
+}
+
+/*
+ * a slot can be empty again on remove if its group has an empty slot :
+ * no probe went further than this group, so no probe chain is broken
+ */
+static inline uint8_t
+swiss_removed_ctrl(const uint8_t *ctrl, uint32_t index)
+{
+   const uint32_t group = index & ~(uint32_t) (SWISS_GROUP_SIZE - 1);
+   return swiss_group_match_empty(ctrl + group) ? SWISS_CTRL_EMPTY
+                                                : SWISS_CTRL_DELETED;
+}
+
+struct swiss_probe {
+   uint32_t group;
+   uint32_t group_mask;
+   uint32_t step;
+   uint32_t offset; /* first slot of the group */
+};
+
+static inline void
+swiss_probe_start(struct swiss_probe *probe, uint32_t mixed, uint32_t capacity)
+{
+   probe->group_mask = swiss_ctrl_bytes(capacity) / SWISS_GROUP_SIZE - 1;
+   probe->group = (mixed >> 7) & probe->group_mask;
+   probe->step = 0;
+   probe->offset = probe->group * SWISS_GROUP_SIZE;
+}
+
+/* false when all the groups were visited */
+static inline bool
+swiss_probe_next(struct swiss_probe *probe)
+{
+   if (probe->step == probe->group_mask)
+      return false;
+   probe->step++;
+   probe->group = (probe->group + probe->step) & probe->group_mask;
+   probe->offset = probe->group * SWISS_GROUP_SIZE;
+   return true;
+}
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* SWISS_TABLE_H */
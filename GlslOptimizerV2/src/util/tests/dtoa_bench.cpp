@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* The printing of the float constants : util_dtoa_float against the
+ * snprintf it replaced, on 65536 random floats like a big constant array.
+ * Checks that the shortest text read back to the same bits.
+ */
+
+#include "util/dtoa.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#define COUNT_VALUES 65536
+#define COUNT_RUNS 5
+
+static float s_Values[COUNT_VALUES];
+static char s_Text[COUNT_VALUES][UTIL_DTOA_BUFFER_SIZE];
+
+/* xorshift, the same values on all the platforms */
+static uint32_t
+next_random(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return *state = x;
+}
+
+static void
+print_snprintf_7g(void)
+{
+   for (int i = 0; i < COUNT_VALUES; i++)
+      snprintf(s_Text[i], UTIL_DTOA_BUFFER_SIZE, "%.7g", s_Values[i]);
+}
+
+/* the old minified output : the first precision who read back */
+static void
+print_snprintf_shortest(void)
+{
+   for (int i = 0; i < COUNT_VALUES; i++) {
+      for (int precision = 1; precision <= 9; precision++) {
+         snprintf(s_Text[i], UTIL_DTOA_BUFFER_SIZE, "%.*g", precision, s_Values[i]);
+         if (strtof(s_Text[i], NULL) == s_Values[i])
+            break;
+      }
+   }
+}
+
+static void
+print_dtoa_7(void)
+{
+   for (int i = 0; i < COUNT_VALUES; i++)
+      util_dtoa_float(s_Values[i], 7, s_Text[i]);
+}
+
+static void
+print_dtoa_shortest(void)
+{
+   for (int i = 0; i < COUNT_VALUES; i++)
+      util_dtoa_float(s_Values[i], 0, s_Text[i]);
+}
+
+static double
+best_time_ms(void (*print)(void))
+{
+   double best = 1e30;
+   for (int run = 0; run < COUNT_RUNS; run++) {
+      auto start = std::chrono::steady_clock::now();
+      print();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (ms < best)
+         best = ms;
+   }
+   return best;
+}
+
+int
+main(void)
+{
+   /* exponents from 2^-31 to 2^32, the range of the shader constants */
+   uint32_t state = 0x2545F491;
+   for (int i = 0; i < COUNT_VALUES; i++) {
+      uint32_t bits = (next_random(&state) & 0x3FFFFFFF) | 0x30000000;
+      memcpy(&s_Values[i], &bits, sizeof(bits));
+   }
+
+   printf("%d floats, best of %d runs\n", COUNT_VALUES, COUNT_RUNS);
+   printf("snprintf %%.7g          %8.2f ms\n", best_time_ms(print_snprintf_7g));
+   printf("util_dtoa_float(7)     %8.2f ms\n", best_time_ms(print_dtoa_7));
+   printf("snprintf shortest loop %8.2f ms\n", best_time_ms(print_snprintf_shortest));
+   printf("util_dtoa_float(0)     %8.2f ms\n", best_time_ms(print_dtoa_shortest));
+
+   int failures = 0;
+   for (int i = 0; i < COUNT_VALUES; i++) {
+      float value = strtof(s_Text[i], NULL);
+      if (memcmp(&value, &s_Values[i], sizeof(value)) != 0) {
+         if (failures++ < 10)
+            printf("FAIL : %.9g printed as %s\n", s_Values[i], s_Text[i]);
+      }
+   }
+
+   return failures == 0 ? 0 : 1;
+}
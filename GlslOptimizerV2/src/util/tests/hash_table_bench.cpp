@@ -0,0 +1,178 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* util/hash_table and util/set, built twice from their sources : with the
+ * linear probing storage (hash_table_bench_linear) and with the swiss table
+ * one (hash_table_bench_swiss).  The workloads are the ones of a compile :
+ * many small pointer tables, big pointer tables and sets, names tables.
+ */
+
+#include "util/hash_table.h"
+#include "util/set.h"
+#include "util/ralloc.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#ifdef USE_SWISS_HASH_TABLE
+#define VARIANT "swiss"
+#else
+#define VARIANT "linear"
+#endif
+
+#define COUNT_KEYS 262144
+#define COUNT_NAMES 65536
+#define COUNT_SMALL_TABLES 100000
+#define COUNT_RUNS 3
+
+/* the keys are the addresses of nodes of the same size, like the ir */
+struct node
+{
+   uint64_t payload[2];
+};
+
+static struct node *s_Nodes; /* 2 * COUNT_KEYS, the second half for the misses */
+static char s_Names[COUNT_NAMES][16];
+static bool s_Failed = false;
+
+static void
+check(bool condition, const char *what)
+{
+   if (!condition && !s_Failed) {
+      printf("FAIL : %s\n", what);
+      s_Failed = true;
+   }
+}
+
+static void
+small_tables(void)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   size_t found = 0, expected = 0;
+   for (int t = 0; t < COUNT_SMALL_TABLES; t++) {
+      struct hash_table *ht = _mesa_pointer_hash_table_create(mem_ctx);
+      const int count = 1 + (t % 8);
+      struct node *keys = &s_Nodes[(t * 8) % (COUNT_KEYS - 8)];
+      for (int i = 0; i < count; i++)
+         _mesa_hash_table_insert(ht, &keys[i], &keys[i]);
+      for (int i = 0; i < 8; i++)
+         found += _mesa_hash_table_search(ht, &keys[i]) != NULL;
+      expected += count;
+      _mesa_hash_table_destroy(ht, NULL);
+   }
+   ralloc_free(mem_ctx);
+   check(found == expected, "small tables");
+}
+
+static void
+big_table(void)
+{
+   struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+   for (int i = 0; i < COUNT_KEYS; i++)
+      _mesa_hash_table_insert(ht, &s_Nodes[i], &s_Nodes[i]);
+
+   size_t found = 0;
+   for (int i = 0; i < 2 * COUNT_KEYS; i++)
+      found += _mesa_hash_table_search(ht, &s_Nodes[i]) != NULL;
+   check(found == COUNT_KEYS, "big table search");
+
+   for (int i = 0; i < COUNT_KEYS; i += 2)
+      _mesa_hash_table_remove_key(ht, &s_Nodes[i]);
+   for (int i = 0; i < COUNT_KEYS; i += 2)
+      _mesa_hash_table_insert(ht, &s_Nodes[COUNT_KEYS + i], &s_Nodes[i]);
+
+   size_t iterated = 0;
+   hash_table_foreach(ht, entry)
+      iterated++;
+   check(iterated == COUNT_KEYS && ht->entries == COUNT_KEYS, "big table iteration");
+
+   _mesa_hash_table_destroy(ht, NULL);
+}
+
+static void
+big_set(void)
+{
+   struct set *set = _mesa_pointer_set_create(NULL);
+   for (int i = 0; i < COUNT_KEYS; i++)
+      _mesa_set_add(set, &s_Nodes[i]);
+
+   size_t found = 0;
+   for (int i = 0; i < 2 * COUNT_KEYS; i++)
+      found += _mesa_set_search(set, &s_Nodes[i]) != NULL;
+   check(found == COUNT_KEYS, "set search");
+
+   for (int i = 0; i < COUNT_KEYS; i += 2)
+      _mesa_set_remove_key(set, &s_Nodes[i]);
+   check(set->entries == COUNT_KEYS / 2, "set remove");
+
+   _mesa_set_destroy(set, NULL);
+}
+
+static void
+names_table(void)
+{
+   struct hash_table *ht = _mesa_hash_table_create(NULL, _mesa_hash_string, _mesa_key_string_equal);
+   for (int i = 0; i < COUNT_NAMES; i++)
+      _mesa_hash_table_insert(ht, s_Names[i], s_Names[i]);
+
+   /* by value, not by address */
+   size_t found = 0;
+   char name[16];
+   for (int i = 0; i < COUNT_NAMES; i++) {
+      memcpy(name, s_Names[i], sizeof(name));
+      struct hash_entry *entry = _mesa_hash_table_search(ht, name);
+      found += entry != NULL && entry->data == s_Names[i];
+   }
+   check(found == COUNT_NAMES, "names table");
+
+   _mesa_hash_table_destroy(ht, NULL);
+}
+
+static double
+best_time_ms(void (*workload)(void))
+{
+   double best = 1e30;
+   for (int run = 0; run < COUNT_RUNS; run++) {
+      auto start = std::chrono::steady_clock::now();
+      workload();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (ms < best)
+         best = ms;
+   }
+   return best;
+}
+
+int
+main(void)
+{
+   s_Nodes = (struct node *) calloc(2 * COUNT_KEYS, sizeof(struct node));
+   for (int i = 0; i < COUNT_NAMES; i++)
+      snprintf(s_Names[i], sizeof(s_Names[i]), "var_%d", i);
+
+   printf("%s storage, best of %d runs\n", VARIANT, COUNT_RUNS);
+   printf("%d small pointer tables  %8.2f ms\n", COUNT_SMALL_TABLES, best_time_ms(small_tables));
+   printf("pointer table, %d keys  %8.2f ms\n", COUNT_KEYS, best_time_ms(big_table));
+   printf("pointer set, %d keys    %8.2f ms\n", COUNT_KEYS, best_time_ms(big_set));
+   printf("names table, %d names    %8.2f ms\n", COUNT_NAMES, best_time_ms(names_table));
+
+   free(s_Nodes);
+
+   return s_Failed ? 1 : 0;
+}
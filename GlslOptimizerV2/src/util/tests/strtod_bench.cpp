@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* The parsing of the float literals : _mesa_strtof and _mesa_strtod against
+ * the libc, on the 65536 literals of a big constant array.  Half are the
+ * shortest texts printed by the optimizer, half are 17 digit texts like a
+ * generated table.  Checks the values and the end pointers against the libc.
+ */
+
+#include "util/strtod.h"
+#include "util/dtoa.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#define COUNT_LITERALS 65536
+#define COUNT_RUNS 5
+
+static char s_Literals[COUNT_LITERALS][32];
+static volatile float s_Sink; /* keep the conversions */
+
+static uint32_t
+next_random(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return *state = x;
+}
+
+static void
+parse_strtod_cast(void)
+{
+   float sum = 0.0f;
+   for (int i = 0; i < COUNT_LITERALS; i++)
+      sum += (float) strtod(s_Literals[i], NULL);
+   s_Sink = sum;
+}
+
+static void
+parse_strtof(void)
+{
+   float sum = 0.0f;
+   for (int i = 0; i < COUNT_LITERALS; i++)
+      sum += strtof(s_Literals[i], NULL);
+   s_Sink = sum;
+}
+
+static void
+parse_mesa_strtof(void)
+{
+   float sum = 0.0f;
+   for (int i = 0; i < COUNT_LITERALS; i++)
+      sum += _mesa_strtof(s_Literals[i], NULL);
+   s_Sink = sum;
+}
+
+static void
+parse_mesa_strtod(void)
+{
+   float sum = 0.0f;
+   for (int i = 0; i < COUNT_LITERALS; i++)
+      sum += (float) _mesa_strtod(s_Literals[i], NULL);
+   s_Sink = sum;
+}
+
+static double
+best_time_ms(void (*parse)(void))
+{
+   double best = 1e30;
+   for (int run = 0; run < COUNT_RUNS; run++) {
+      auto start = std::chrono::steady_clock::now();
+      parse();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (ms < best)
+         best = ms;
+   }
+   return best;
+}
+
+int
+main(void)
+{
+   _mesa_locale_init();
+
+   /* exponents from 2^-31 to 2^32, no subnormals */
+   uint32_t state = 0x2545F491;
+   for (int i = 0; i < COUNT_LITERALS; i++) {
+      uint32_t bits = (next_random(&state) & 0x3FFFFFFF) | 0x30000000;
+      float value;
+      memcpy(&value, &bits, sizeof(bits));
+      if (i & 1)
+         snprintf(s_Literals[i], sizeof(s_Literals[i]), "%.17g", (double) value);
+      else
+         util_dtoa_float(value, 0, s_Literals[i]);
+   }
+
+   printf("%d literals, best of %d runs\n", COUNT_LITERALS, COUNT_RUNS);
+   printf("(float)strtod  %8.2f ms\n", best_time_ms(parse_strtod_cast));
+   printf("strtof         %8.2f ms\n", best_time_ms(parse_strtof));
+   printf("_mesa_strtof   %8.2f ms\n", best_time_ms(parse_mesa_strtof));
+   printf("_mesa_strtod   %8.2f ms\n", best_time_ms(parse_mesa_strtod));
+
+   int failures = 0;
+   for (int i = 0; i < COUNT_LITERALS; i++) {
+      char *end, *mesa_end;
+      float f = strtof(s_Literals[i], &end);
+      float mesa_f = _mesa_strtof(s_Literals[i], &mesa_end);
+      bool same = memcmp(&f, &mesa_f, sizeof(f)) == 0 && end == mesa_end;
+
+      double d = strtod(s_Literals[i], &end);
+      double mesa_d = _mesa_strtod(s_Literals[i], &mesa_end);
+      same = same && memcmp(&d, &mesa_d, sizeof(d)) == 0 && end == mesa_end;
+
+      if (!same && failures++ < 10)
+         printf("FAIL : %s\n", s_Literals[i]);
+   }
+
+   _mesa_locale_fini();
+
+   return failures == 0 ? 0 : 1;
+}
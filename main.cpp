@@ -10,6 +10,7 @@
 
 #include "ctools/GLVersionChecker.h"
 #include "src/MainFrame.h"
+#include "src/Server/OptimizerServer.h"
 #include "Res/CustomFont.cpp"
 
 #include <glad/glad.h> 
@@ -72,8 +73,12 @@ void FoundBestOpenGLVersionAvailable(int *vMajor, int *vMinor)
 	// on charge que les cores. ya pas de core avant 3.2
 }
 
-int main(int, char**argv)
+int main(int argc, char**argv)
 {
+	// no window in server mode
+	if (OptimizerServer::IsServerMode(argc, argv))
+		return OptimizerServer::Instance()->Run(argc, argv);
+
 	FileHelper::Instance()->SetAppPath(std::string(argv[0]));
 #ifndef _DEBUG
 	FileHelper::Instance()->SetCurDirectory(FileHelper::Instance()->GetAppPath());
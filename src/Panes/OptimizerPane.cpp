@@ -162,6 +162,71 @@ int OptimizerPane::DrawPane(ProjectFile *vProjectFile, int vWidgetId)
 							change |= ImGui::CheckBoxBitWize<GlslConvert::ControlFlags>("Skip Preprocessor", "preprocessor directives and comments will be removed before link",
 								&vProjectFile->m_OptimizationStruct.controlFlags, GlslConvert::ControlFlags::CONTROL_SKIP_PREPROCESSING, false);
 						}
+						if (!(vProjectFile->m_OptimizationStruct.controlFlags & GlslConvert::ControlFlags::CONTROL_SKIP_PREPROCESSING))
+						{
+							ImGui::Separator();
+							GlslConvert::OptimizationStruct::IncludeOptions def;
+							static char includePathsBuffer[1024] = "\0";
+							snprintf(includePathsBuffer, 1023, "%s", vProjectFile->m_OptimizationStruct.includeOptions.includePaths.c_str());
+							if (ImGui::InputText("Include Paths", includePathsBuffer, 1023))
+							{
+								vProjectFile->m_OptimizationStruct.includeOptions.includePaths = includePathsBuffer;
+								change = true;
+							}
+							if (ImGui::IsItemHovered())
+								ImGui::SetTooltip("paths separated by ';'\nthe dir of the shader file is searched first for #include \"file\"");
+							change |= ImGui::CheckBoxDefault("Implicit include extension", 
+								&vProjectFile->m_OptimizationStruct.includeOptions.implicit_extension, def.implicit_extension, 
+								"true  => #include allowed without #extension GL_ARB_shading_language_include\nfalse => the extension must be enabled in the shader");
+						}
+						ImGui::Separator();
+						GlslConvert::OptimizationStruct::PrintOptions defPrint;
+						change |= ImGui::CheckBoxDefault("Minify",
+							&vProjectFile->m_OptimizationStruct.printOptions.minify, defPrint.minify,
+							"glsl target only\nlocals, temporaries and functions renamed with the shortest names\nno spaces and shortest floats");
+						ImGui::Separator();
+						static char pipelineBuffer[2048] = "\0";
+						snprintf(pipelineBuffer, 2047, "%s", vProjectFile->m_OptimizationStruct.pipelineOptions.pipeline.c_str());
+						if (ImGui::InputText("Pipeline", pipelineBuffer, 2047))
+						{
+							vProjectFile->m_OptimizationStruct.pipelineOptions.pipeline = pipelineBuffer;
+							change = true;
+						}
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("order of the passes, empty for the default one\nex : inline,dce,cprop*,(cfold,algebraic)*8,unroll\n'*' => run while progress, '*N' => at most N times\nthe disabled passes are skipped");
+						ImGui::Separator();
+						GlslConvert::OptimizationStruct::PerFunctionOptions defPerFunction;
+						change |= ImGui::CheckBoxDefault("Per Function Pre-Pass",
+							&vProjectFile->m_OptimizationStruct.perFunctionOptions.enabled, defPerFunction.enabled,
+							"optimize each function body alone before the inlining, on many threads");
+						if (vProjectFile->m_OptimizationStruct.perFunctionOptions.enabled)
+						{
+							change |= ImGui::SliderIntDefault(100, "Threads", 
+								&vProjectFile->m_OptimizationStruct.perFunctionOptions.threads, 0, 64, defPerFunction.threads);
+							if (ImGui::IsItemHovered())
+								ImGui::SetTooltip("0 => hardware concurrency\n1 => serial\nthe result is the same in any case");
+						}
+						ImGui::Separator();
+						GlslConvert::OptimizationStruct::BudgetOptions defBudget;
+						change |= ImGui::SliderIntDefault(100, "Time Budget (ms)",
+							&vProjectFile->m_OptimizationStruct.budgetOptions.timeMs, 0, 10000, defBudget.timeMs);
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("0 => no limit\nchecked between the passes, the result is the ir reached when the time is out");
+						ImGui::Separator();
+						GlslConvert::OptimizationStruct::PreshaderOptions defPreshader;
+						change |= ImGui::CheckBoxDefault("Preshader",
+							&vProjectFile->m_OptimizationStruct.preshaderOptions.enabled, defPreshader.enabled,
+							"move the expressions of the uniforms alone (no texture, no derivative)\nto new uniforms preshader_N, computed once per draw on the cpu\n ( like : pow(exposure, 2.2) => preshader_0 )");
+						ImGui::Separator();
+						static int _validationLevel = (int)GlslConvert::ValidationLevel::VALIDATION_FINAL;
+						_validationLevel = (int)vProjectFile->m_OptimizationStruct.validationOptions.level;
+						if (ImGui::Combo("Ir Validation", &_validationLevel, "Off\0Final\0Changed Functions\0Full\0\0"))
+						{
+							vProjectFile->m_OptimizationStruct.validationOptions.level = (GlslConvert::ValidationLevel)_validationLevel;
+							change = true;
+						}
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("debug builds of mesa only\nFinal => once after the passes\nChanged Functions => at each validate of the pipeline, the functions changed since the previous one (found by a walk of the whole ir)\nFull => at each validate of the pipeline, the whole ir");
 					}
 					ImGui::Unindent();
 
@@ -271,7 +336,14 @@ bool OptimizerPane::DrawOptimizationFlags(ProjectFile *vProjectFile, ImVec2 vSiz
 			if (vProjectFile->m_OptimizationStruct.optimizationFlags & GlslConvert::OptimizationFlags::OPT_algebraic)
 			{
 				ImGui::Indent();
+				GlslConvert::OptimizationStruct::AlgebraicOptions def;
 				change |= ImGui::CheckBoxDefault("native_integers", &vProjectFile->m_OptimizationStruct.algebraicOptions.native_integers, false, 0);
+				change |= ImGui::CheckBoxDefault("rules_basic", &vProjectFile->m_OptimizationStruct.algebraicOptions.rules_basic, def.rules_basic, "inverse and repeated ops\n ( like : rcp(rcp(x)) => x )");
+				change |= ImGui::CheckBoxDefault("rules_pow", &vProjectFile->m_OptimizationStruct.algebraicOptions.rules_pow, def.rules_pow, "pow with a small constant exponent\n ( like : pow(x, 3.0) => x * x * x )");
+				change |= ImGui::CheckBoxDefault("rules_length", &vProjectFile->m_OptimizationStruct.algebraicOptions.rules_length, def.rules_length, "length and normalize\n ( like : length(x) < r => dot(x, x) < r * r )");
+				change |= ImGui::CheckBoxDefault("rules_trig", &vProjectFile->m_OptimizationStruct.algebraicOptions.rules_trig, def.rules_trig, "sin and cos of the same angle\n ( like : sin(x) * cos(x) * 2.0 => sin(x * 2.0) )\nchange the float results");
+				change |= ImGui::CheckBoxDefault("rules_mad", &vProjectFile->m_OptimizationStruct.algebraicOptions.rules_mad, def.rules_mad, "multiply-add forms and lerps\n ( like : (x + 1.0) * 0.5 => x * 0.5 + 0.5 )\nchange the rounding");
+				change |= ImGui::CheckBoxDefault("fast_math", &vProjectFile->m_OptimizationStruct.algebraicOptions.fast_math, def.fast_math, "reassociate the float add and mul chains,\ngather the constants and factor the common terms\n ( like : x * y * 2.0 + x * 3.0 + 1.0 - 4.0 => -3.0 + x * (3.0 + y * 2.0) )\nchange the rounding, never done for precise and invariant");
 				ImGui::Unindent();
 			}
 			ImGui::Separator();
@@ -340,6 +412,8 @@ bool OptimizerPane::DrawOptimizationFlags(ProjectFile *vProjectFile, ImVec2 vSiz
 				change |= ImGui::CheckBoxDefault("lower_output", &vProjectFile->m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_output, def.lower_output, 0);
 				change |= ImGui::CheckBoxDefault("lower_temp", &vProjectFile->m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_temp, def.lower_temp, 0);
 				change |= ImGui::CheckBoxDefault("lower_uniform", &vProjectFile->m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_uniform, def.lower_uniform, 0);
+				change |= ImGui::SliderIntDefault(100, "linear_max_length", &vProjectFile->m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.linear_max_length, 1, 64, def.linear_max_length);
+				change |= ImGui::SliderIntDefault(100, "max_length", &vProjectFile->m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.max_length, 0, 256, def.max_length);
 				ImGui::Unindent();
 			}
 			ImGui::Separator();
@@ -376,7 +450,8 @@ bool OptimizerPane::DrawOptimizationFlags(ProjectFile *vProjectFile, ImVec2 vSiz
 				ImGui::Indent();
 				GlslConvert::OptimizationStruct::LowerIfToCondAssignOptions def;
 				change |= ImGui::SliderIntDefault(100, "max_depth", &vProjectFile->m_OptimizationStruct.lowerIfToCondAssignOptions.max_depth, 0, 120, 10);
-				change |= ImGui::SliderIntDefault(100, "min_branch_cost", &vProjectFile->m_OptimizationStruct.lowerIfToCondAssignOptions.min_branch_cost, 0, 120, 1);
+				change |= ImGui::SliderIntDefault(100, "min_branch_cost", &vProjectFile->m_OptimizationStruct.lowerIfToCondAssignOptions.min_branch_cost, 0, 120, def.min_branch_cost);
+				change |= ImGui::SliderIntDefault(100, "branch_cost", &vProjectFile->m_OptimizationStruct.lowerIfToCondAssignOptions.branch_cost, 0, 120, def.branch_cost);
 				ImGui::Unindent();
 			}
 			ImGui::Separator();
@@ -411,6 +486,19 @@ bool OptimizerPane::DrawOptimizationFlags(ProjectFile *vProjectFile, ImVec2 vSiz
 			CHECK_BIS("optimize_split_arrays", 0, OPT_optimize_split_arrays, true);
 			ImGui::Separator();
 			CHECK_BIS("set_unroll_Loops", 0, OPT_set_unroll_Loops, true);
+			ImGui::Separator();
+			CHECK_BIS("dead_store", "Remove the writes never read, across the if and the loops", OPT_dead_store, true);
+			ImGui::Separator();
+			CHECK_BIS("value_range", "Ranges of the values, for minmax_prune and algebraic\n ( like : clamp(x, 0.0, 1.0) => x when x is in [0,1] )", OPT_value_range, true);
+			if (vProjectFile->m_OptimizationStruct.optimizationFlags_Bis & GlslConvert::OptimizationFlags_Bis::OPT_value_range)
+			{
+				ImGui::Indent();
+				GlslConvert::OptimizationStruct::ValueRangeOptions def;
+				change |= ImGui::CheckBoxDefault("normalized_textures",
+					&vProjectFile->m_OptimizationStruct.valueRangeOptions.normalized_textures,
+					def.normalized_textures, "true  => the float samplers read only unorm formats, in [0,1]\nfalse => only the shadow samplers are in [0,1]");
+				ImGui::Unindent();
+			}
 		}
 		ImGui::Unindent();
 		ImGui::EndChild();
@@ -505,6 +593,8 @@ void OptimizerPane::Generate(ProjectFile *vProjectFile)
 		codeToOptimize = m_Current_OpenGlVersionStruct.DefineCode + "\n\n" + codeToOptimize;
 	}
 
+	vProjectFile->m_OptimizationStruct.shaderPath = vProjectFile->m_ProjectFilePath;
+
 	std::string optCode = GlslConvert::Instance()->Optimize(
 		codeToOptimize,
 		vProjectFile->m_ShaderStage,
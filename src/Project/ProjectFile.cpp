@@ -277,6 +277,12 @@ std::string ProjectFile::getXml_From_OptimizationStruct(const std::string& vOffs
 	str += offset + "<instructiontolower_flags>" + ct::toStr(m_OptimizationStruct.instructionToLowerFlags) + "</instructiontolower_flags>\n";
 
 	str += offset + "<algebraic_native_integers>" + ct::toStr(m_OptimizationStruct.algebraicOptions.native_integers) + "</algebraic_native_integers>\n";
+	str += offset + "<algebraic_rules_basic>" + ct::toStr(m_OptimizationStruct.algebraicOptions.rules_basic) + "</algebraic_rules_basic>\n";
+	str += offset + "<algebraic_rules_pow>" + ct::toStr(m_OptimizationStruct.algebraicOptions.rules_pow) + "</algebraic_rules_pow>\n";
+	str += offset + "<algebraic_rules_length>" + ct::toStr(m_OptimizationStruct.algebraicOptions.rules_length) + "</algebraic_rules_length>\n";
+	str += offset + "<algebraic_rules_trig>" + ct::toStr(m_OptimizationStruct.algebraicOptions.rules_trig) + "</algebraic_rules_trig>\n";
+	str += offset + "<algebraic_rules_mad>" + ct::toStr(m_OptimizationStruct.algebraicOptions.rules_mad) + "</algebraic_rules_mad>\n";
+	str += offset + "<algebraic_fast_math>" + ct::toStr(m_OptimizationStruct.algebraicOptions.fast_math) + "</algebraic_fast_math>\n";
 
 	str += offset + "<lower_jump_pull_out_jumps>" + ct::toStr(m_OptimizationStruct.lowerJumpsOptions.pull_out_jumps) + "</lower_jump_pull_out_jumps>\n";
 	str += offset + "<lower_jump_lower_sub_return>" + ct::toStr(m_OptimizationStruct.lowerJumpsOptions.lower_sub_return) + "</lower_jump_lower_sub_return>\n";
@@ -286,22 +292,44 @@ std::string ProjectFile::getXml_From_OptimizationStruct(const std::string& vOffs
 
 	str += offset + "<lower_if_to_cond_assign_max_depth>" + ct::toStr(m_OptimizationStruct.lowerIfToCondAssignOptions.max_depth) + "</lower_if_to_cond_assign_max_depth>\n";
 	str += offset + "<lower_if_to_cond_assign_min_branch_cost>" + ct::toStr(m_OptimizationStruct.lowerIfToCondAssignOptions.min_branch_cost) + "</lower_if_to_cond_assign_min_branch_cost>\n";
+	str += offset + "<lower_if_to_cond_assign_branch_cost>" + ct::toStr(m_OptimizationStruct.lowerIfToCondAssignOptions.branch_cost) + "</lower_if_to_cond_assign_branch_cost>\n";
 
 	str += offset + "<lower_variable_index_to_cond_assign_lower_input>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_input) + "</lower_variable_index_to_cond_assign_lower_input>\n";
 	str += offset + "<lower_variable_index_to_cond_assign_lower_output>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_output) + "</lower_variable_index_to_cond_assign_lower_output>\n";
 	str += offset + "<lower_variable_index_to_cond_assign_lower_temp>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_temp) + "</lower_variable_index_to_cond_assign_lower_temp>\n";
 	str += offset + "<lower_variable_index_to_cond_assign_lower_uniform>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_uniform) + "</lower_variable_index_to_cond_assign_lower_uniform>\n";
+	str += offset + "<lower_variable_index_to_cond_assign_linear_max_length>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.linear_max_length) + "</lower_variable_index_to_cond_assign_linear_max_length>\n";
+	str += offset + "<lower_variable_index_to_cond_assign_max_length>" + ct::toStr(m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.max_length) + "</lower_variable_index_to_cond_assign_max_length>\n";
 
 	str += offset + "<dead_code_keep_only_assigned_uniforms>" + ct::toStr(m_OptimizationStruct.deadCodeOptions.keep_only_assigned_uniforms) + "</dead_code_keep_only_assigned_uniforms>\n";
 
 	str += offset + "<dead_function_entryFunc>" + m_OptimizationStruct.deadFunctionOptions.entryFunc + "</dead_function_entryFunc>\n";
 
 	str += offset + "<lower_vector_insert_lower_nonconstant_index>" + ct::toStr(m_OptimizationStruct.lowerVectorInsertOptions.lower_nonconstant_index) + "</lower_vector_insert_lower_nonconstant_index>\n";
+	str += offset + "<value_range_normalized_textures>" + ct::toStr(m_OptimizationStruct.valueRangeOptions.normalized_textures) + "</value_range_normalized_textures>\n";
 	
 	str += offset + "<lower_quadop_vector_dont_lower_swz>" + ct::toStr(m_OptimizationStruct.lowerQuadopVector.dont_lower_swz) + "</lower_quadop_vector_dont_lower_swz>\n";
 
 	str += offset + "<instruction_to_lower_max_if_depth>" + ct::toStr(m_OptimizationStruct.instructionToLower.MaxIfDepth) + "</instruction_to_lower_max_if_depth>\n";
 	str += offset + "<instruction_to_lower_max_unroll_iterations>" + ct::toStr(m_OptimizationStruct.instructionToLower.MaxUnrollIterations) + "</instruction_to_lower_max_unroll_iterations>\n";
+	str += offset + "<instruction_to_lower_max_unroll_instructions>" + ct::toStr(m_OptimizationStruct.instructionToLower.MaxUnrollInstructions) + "</instruction_to_lower_max_unroll_instructions>\n";
+	str += offset + "<instruction_to_lower_partial_unroll>" + ct::toStr(m_OptimizationStruct.instructionToLower.PartialUnroll) + "</instruction_to_lower_partial_unroll>\n";
+
+	str += offset + "<include_paths>" + m_OptimizationStruct.includeOptions.includePaths + "</include_paths>\n";
+	str += offset + "<include_implicit_extension>" + ct::toStr(m_OptimizationStruct.includeOptions.implicit_extension) + "</include_implicit_extension>\n";
+
+	str += offset + "<print_minify>" + ct::toStr(m_OptimizationStruct.printOptions.minify) + "</print_minify>\n";
+
+	str += offset + "<pipeline>" + m_OptimizationStruct.pipelineOptions.pipeline + "</pipeline>\n";
+
+	str += offset + "<per_function_enabled>" + ct::toStr(m_OptimizationStruct.perFunctionOptions.enabled) + "</per_function_enabled>\n";
+	str += offset + "<per_function_threads>" + ct::toStr(m_OptimizationStruct.perFunctionOptions.threads) + "</per_function_threads>\n";
+
+	str += offset + "<budget_time_ms>" + ct::toStr(m_OptimizationStruct.budgetOptions.timeMs) + "</budget_time_ms>\n";
+
+	str += offset + "<validation_level>" + ct::toStr((int)m_OptimizationStruct.validationOptions.level) + "</validation_level>\n";
+
+	str += offset + "<preshader_enabled>" + ct::toStr(m_OptimizationStruct.preshaderOptions.enabled) + "</preshader_enabled>\n";
 
 	str += vOffset + "</optimization>\n";
 
@@ -331,37 +359,69 @@ void ProjectFile::setOptimizationStruct_From_Xml(tinyxml2::XMLElement* vElem, ti
 
 	if (strParentName == "optimization")
 	{
-		if (strName == "compiler_flags") m_OptimizationStruct.compilerFlags = (GlslConvert::CompilerFlags)ct::ivariant(strValue).getI();
-		if (strName == "control_flags") m_OptimizationStruct.controlFlags = (GlslConvert::ControlFlags)ct::ivariant(strValue).getI();
-		if (strName == "optimization_flags") m_OptimizationStruct.optimizationFlags = (GlslConvert::OptimizationFlags)ct::ivariant(strValue).getI();
-		if (strName == "optimization_flags_bis") m_OptimizationStruct.optimizationFlags_Bis = (GlslConvert::OptimizationFlags_Bis)ct::ivariant(strValue).getI();
-		if (strName == "instructiontolower_flags") m_OptimizationStruct.instructionToLowerFlags = (GlslConvert::InstructionToLowerFlags)ct::ivariant(strValue).getI();
-
-		if (strName == "algebraic_native_integers") m_OptimizationStruct.algebraicOptions.native_integers = ct::ivariant(strValue).getB();
-
-		if (strName == "lower_jump_pull_out_jumps") m_OptimizationStruct.lowerJumpsOptions.pull_out_jumps = ct::ivariant(strValue).getB();
-		if (strName == "lower_jump_lower_sub_return") m_OptimizationStruct.lowerJumpsOptions.lower_sub_return = ct::ivariant(strValue).getB();
-		if (strName == "lower_jump_lower_main_return") m_OptimizationStruct.lowerJumpsOptions.lower_main_return = ct::ivariant(strValue).getB();
-		if (strName == "lower_jump_lower_continue") m_OptimizationStruct.lowerJumpsOptions.lower_continue = ct::ivariant(strValue).getB();
-		if (strName == "lower_jump_lower_break") m_OptimizationStruct.lowerJumpsOptions.lower_break = ct::ivariant(strValue).getB();
-
-		if (strName == "lower_if_to_cond_assign_max_depth") m_OptimizationStruct.lowerIfToCondAssignOptions.max_depth = ct::ivariant(strValue).getI();
-		if (strName == "lower_if_to_cond_assign_min_branch_cost") m_OptimizationStruct.lowerIfToCondAssignOptions.min_branch_cost = ct::ivariant(strValue).getI();
-
-		if (strName == "lower_variable_index_to_cond_assign_lower_input") m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_input = ct::ivariant(strValue).getB();
-		if (strName == "lower_variable_index_to_cond_assign_lower_output") m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_output = ct::ivariant(strValue).getB();
-		if (strName == "lower_variable_index_to_cond_assign_lower_temp") m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_temp = ct::ivariant(strValue).getB();
-		if (strName == "lower_variable_index_to_cond_assign_lower_uniform") m_OptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_uniform = ct::ivariant(strValue).getB();
-
-		if (strName == "dead_code_keep_only_assigned_uniforms") m_OptimizationStruct.deadCodeOptions.keep_only_assigned_uniforms = ct::ivariant(strValue).getB();
-
-		if (strName == "dead_function_entryFunc") m_OptimizationStruct.deadFunctionOptions.entryFunc = strValue;
-
-		if (strName == "lower_vector_insert_lower_nonconstant_index") m_OptimizationStruct.lowerVectorInsertOptions.lower_nonconstant_index = ct::ivariant(strValue).getB();
-
-		if (strName == "lower_quadop_vector_dont_lower_swz") m_OptimizationStruct.lowerQuadopVector.dont_lower_swz = ct::ivariant(strValue).getB();
-
-		if (strName == "instruction_to_lower_max_if_depth") m_OptimizationStruct.instructionToLower.MaxIfDepth = ct::ivariant(strValue).getI();
-		if (strName == "instruction_to_lower_max_unroll_iterations") m_OptimizationStruct.instructionToLower.MaxUnrollIterations = ct::ivariant(strValue).getI();
+		SetOptimizationStructValue(m_OptimizationStruct, strName, strValue);
 	}
 }
+
+// set one field of the OptimizationStruct from his xml tag name and his value as string
+// used by the project file and by the server requests
+void ProjectFile::SetOptimizationStructValue(GlslConvert::OptimizationStruct& vOptimizationStruct, const std::string& vName, const std::string& vValue)
+{
+	if (vName == "compiler_flags") vOptimizationStruct.compilerFlags = (GlslConvert::CompilerFlags)ct::ivariant(vValue).getI();
+	if (vName == "control_flags") vOptimizationStruct.controlFlags = (GlslConvert::ControlFlags)ct::ivariant(vValue).getI();
+	if (vName == "optimization_flags") vOptimizationStruct.optimizationFlags = (GlslConvert::OptimizationFlags)ct::ivariant(vValue).getI();
+	if (vName == "optimization_flags_bis") vOptimizationStruct.optimizationFlags_Bis = (GlslConvert::OptimizationFlags_Bis)ct::ivariant(vValue).getI();
+	if (vName == "instructiontolower_flags") vOptimizationStruct.instructionToLowerFlags = (GlslConvert::InstructionToLowerFlags)ct::ivariant(vValue).getI();
+
+	if (vName == "algebraic_native_integers") vOptimizationStruct.algebraicOptions.native_integers = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_rules_basic") vOptimizationStruct.algebraicOptions.rules_basic = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_rules_pow") vOptimizationStruct.algebraicOptions.rules_pow = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_rules_length") vOptimizationStruct.algebraicOptions.rules_length = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_rules_trig") vOptimizationStruct.algebraicOptions.rules_trig = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_rules_mad") vOptimizationStruct.algebraicOptions.rules_mad = ct::ivariant(vValue).getB();
+	if (vName == "algebraic_fast_math") vOptimizationStruct.algebraicOptions.fast_math = ct::ivariant(vValue).getB();
+
+	if (vName == "lower_jump_pull_out_jumps") vOptimizationStruct.lowerJumpsOptions.pull_out_jumps = ct::ivariant(vValue).getB();
+	if (vName == "lower_jump_lower_sub_return") vOptimizationStruct.lowerJumpsOptions.lower_sub_return = ct::ivariant(vValue).getB();
+	if (vName == "lower_jump_lower_main_return") vOptimizationStruct.lowerJumpsOptions.lower_main_return = ct::ivariant(vValue).getB();
+	if (vName == "lower_jump_lower_continue") vOptimizationStruct.lowerJumpsOptions.lower_continue = ct::ivariant(vValue).getB();
+	if (vName == "lower_jump_lower_break") vOptimizationStruct.lowerJumpsOptions.lower_break = ct::ivariant(vValue).getB();
+
+	if (vName == "lower_if_to_cond_assign_max_depth") vOptimizationStruct.lowerIfToCondAssignOptions.max_depth = ct::ivariant(vValue).getI();
+	if (vName == "lower_if_to_cond_assign_min_branch_cost") vOptimizationStruct.lowerIfToCondAssignOptions.min_branch_cost = ct::ivariant(vValue).getI();
+	if (vName == "lower_if_to_cond_assign_branch_cost") vOptimizationStruct.lowerIfToCondAssignOptions.branch_cost = ct::ivariant(vValue).getI();
+
+	if (vName == "lower_variable_index_to_cond_assign_lower_input") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_input = ct::ivariant(vValue).getB();
+	if (vName == "lower_variable_index_to_cond_assign_lower_output") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_output = ct::ivariant(vValue).getB();
+	if (vName == "lower_variable_index_to_cond_assign_lower_temp") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_temp = ct::ivariant(vValue).getB();
+	if (vName == "lower_variable_index_to_cond_assign_lower_uniform") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.lower_uniform = ct::ivariant(vValue).getB();
+	if (vName == "lower_variable_index_to_cond_assign_linear_max_length") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.linear_max_length = ct::ivariant(vValue).getI();
+	if (vName == "lower_variable_index_to_cond_assign_max_length") vOptimizationStruct.lowerVariableIndexToCondAssignOptions.max_length = ct::ivariant(vValue).getI();
+
+	if (vName == "dead_code_keep_only_assigned_uniforms") vOptimizationStruct.deadCodeOptions.keep_only_assigned_uniforms = ct::ivariant(vValue).getB();
+
+	if (vName == "dead_function_entryFunc") vOptimizationStruct.deadFunctionOptions.entryFunc = vValue;
+
+	if (vName == "lower_vector_insert_lower_nonconstant_index") vOptimizationStruct.lowerVectorInsertOptions.lower_nonconstant_index = ct::ivariant(vValue).getB();
+	if (vName == "value_range_normalized_textures") vOptimizationStruct.valueRangeOptions.normalized_textures = ct::ivariant(vValue).getB();
+
+	if (vName == "lower_quadop_vector_dont_lower_swz") vOptimizationStruct.lowerQuadopVector.dont_lower_swz = ct::ivariant(vValue).getB();
+
+	if (vName == "instruction_to_lower_max_if_depth") vOptimizationStruct.instructionToLower.MaxIfDepth = ct::ivariant(vValue).getI();
+	if (vName == "instruction_to_lower_max_unroll_iterations") vOptimizationStruct.instructionToLower.MaxUnrollIterations = ct::ivariant(vValue).getI();
+	if (vName == "instruction_to_lower_max_unroll_instructions") vOptimizationStruct.instructionToLower.MaxUnrollInstructions = ct::ivariant(vValue).getI();
+	if (vName == "instruction_to_lower_partial_unroll") vOptimizationStruct.instructionToLower.PartialUnroll = ct::ivariant(vValue).getB();
+
+	if (vName == "include_paths") vOptimizationStruct.includeOptions.includePaths = vValue;
+	if (vName == "include_implicit_extension") vOptimizationStruct.includeOptions.implicit_extension = ct::ivariant(vValue).getB();
+
+	if (vName == "print_minify") vOptimizationStruct.printOptions.minify = ct::ivariant(vValue).getB();
+
+	if (vName == "pipeline") vOptimizationStruct.pipelineOptions.pipeline = vValue;
+
+	if (vName == "per_function_enabled") vOptimizationStruct.perFunctionOptions.enabled = ct::ivariant(vValue).getB();
+	if (vName == "per_function_threads") vOptimizationStruct.perFunctionOptions.threads = ct::ivariant(vValue).getI();
+	if (vName == "budget_time_ms") vOptimizationStruct.budgetOptions.timeMs = ct::ivariant(vValue).getI();
+	if (vName == "validation_level") vOptimizationStruct.validationOptions.level = (GlslConvert::ValidationLevel)ct::ivariant(vValue).getI();
+	if (vName == "preshader_enabled") vOptimizationStruct.preshaderOptions.enabled = ct::ivariant(vValue).getB();
+}
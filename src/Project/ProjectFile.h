@@ -64,6 +64,9 @@ public:
 	std::string getXml(const std::string& vOffset) override;
 	void setFromXml(tinyxml2::XMLElement* vElem, tinyxml2::XMLElement* vParent) override;
 
+public:
+	static void SetOptimizationStructValue(GlslConvert::OptimizationStruct& vOptimizationStruct, const std::string& vName, const std::string& vValue);
+
 private:
 	std::string getXml_From_OptimizationStruct(const std::string& vOffset);
 	void setOptimizationStruct_From_Xml(tinyxml2::XMLElement* vElem, tinyxml2::XMLElement* vParent);
@@ -0,0 +1,817 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OptimizerServer.h"
+
+#include "src/code/GlslConvert.h"
+#include "Project/ProjectFile.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#ifdef UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+//// JSON /////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// minimal json, just what the protocol need
+struct JsonValue
+{
+	enum JsonType
+	{
+		JSON_NULL = 0,
+		JSON_BOOL,
+		JSON_NUMBER,
+		JSON_STRING,
+		JSON_ARRAY,
+		JSON_OBJECT
+	};
+
+	JsonType type = JSON_NULL;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string; // string, or the raw text of a number
+	std::vector<JsonValue> array;
+	std::vector<std::pair<std::string, JsonValue>> object;
+
+	const JsonValue* Get(const std::string& vKey) const
+	{
+		for (auto &it : object)
+			if (it.first == vKey)
+				return &it.second;
+		return 0;
+	}
+
+	std::string GetString(const std::string& vKey, const std::string& vDefault = "") const
+	{
+		const JsonValue* v = Get(vKey);
+		if (v && v->type == JSON_STRING) return v->string;
+		return vDefault;
+	}
+
+	int GetInt(const std::string& vKey, int vDefault = 0) const
+	{
+		const JsonValue* v = Get(vKey);
+		if (v && v->type == JSON_NUMBER) return (int)(long long)v->number;
+		return vDefault;
+	}
+
+	bool GetBool(const std::string& vKey, bool vDefault = false) const
+	{
+		const JsonValue* v = Get(vKey);
+		if (v && v->type == JSON_BOOL) return v->boolean;
+		return vDefault;
+	}
+
+	// the value as given to ProjectFile::SetOptimizationStructValue
+	std::string ToOptionString() const
+	{
+		switch (type)
+		{
+		case JSON_BOOL: return boolean ? "true" : "false";
+		case JSON_NUMBER: return std::to_string((int)(long long)number); // flags above INT_MAX wrap like the xml ones
+		case JSON_STRING: return string;
+		default: return "";
+		}
+	}
+};
+
+class JsonParser
+{
+private:
+	const char* m_Cur = 0;
+	std::string m_Error;
+
+public:
+	bool Parse(const std::string& vText, JsonValue* vValue, std::string* vError)
+	{
+		m_Cur = vText.c_str();
+		m_Error.clear();
+		bool ok = ParseValue(vValue);
+		if (ok)
+		{
+			SkipSpaces();
+			if (*m_Cur)
+				ok = SetError("unexpected chars after the value");
+		}
+		if (!ok && vError)
+			*vError = m_Error;
+		return ok;
+	}
+
+private:
+	bool SetError(const char* vError)
+	{
+		if (m_Error.empty())
+			m_Error = vError;
+		return false;
+	}
+
+	void SkipSpaces()
+	{
+		while (*m_Cur == ' ' || *m_Cur == '\t' || *m_Cur == '\r' || *m_Cur == '\n')
+			++m_Cur;
+	}
+
+	bool ParseValue(JsonValue* vValue)
+	{
+		SkipSpaces();
+		switch (*m_Cur)
+		{
+		case '{': return ParseObject(vValue);
+		case '[': return ParseArray(vValue);
+		case '"': vValue->type = JsonValue::JSON_STRING; return ParseString(&vValue->string);
+		case 't': return ParseLiteral("true", vValue, JsonValue::JSON_BOOL, true);
+		case 'f': return ParseLiteral("false", vValue, JsonValue::JSON_BOOL, false);
+		case 'n': return ParseLiteral("null", vValue, JsonValue::JSON_NULL, false);
+		default: return ParseNumber(vValue);
+		}
+	}
+
+	bool ParseLiteral(const char* vLiteral, JsonValue* vValue, JsonValue::JsonType vType, bool vBool)
+	{
+		size_t len = strlen(vLiteral);
+		if (strncmp(m_Cur, vLiteral, len) != 0)
+			return SetError("invalid literal");
+		m_Cur += len;
+		vValue->type = vType;
+		vValue->boolean = vBool;
+		return true;
+	}
+
+	static bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	// -?int frac? exp? only, strtod would take inf, nan or hex and the token is echoed back as the id
+	bool ParseNumber(JsonValue* vValue)
+	{
+		const char* end = m_Cur;
+		if (*end == '-') ++end;
+		if (*end == '0') ++end;
+		else if (*end >= '1' && *end <= '9') { while (IsDigit(*end)) ++end; }
+		else return SetError("invalid value");
+		if (*end == '.')
+		{
+			++end;
+			if (!IsDigit(*end)) return SetError("invalid number");
+			while (IsDigit(*end)) ++end;
+		}
+		if (*end == 'e' || *end == 'E')
+		{
+			++end;
+			if (*end == '+' || *end == '-') ++end;
+			if (!IsDigit(*end)) return SetError("invalid number");
+			while (IsDigit(*end)) ++end;
+		}
+		vValue->type = JsonValue::JSON_NUMBER;
+		vValue->string = std::string(m_Cur, (size_t)(end - m_Cur));
+		vValue->number = strtod(vValue->string.c_str(), 0);
+		m_Cur = end;
+		return true;
+	}
+
+	static void AppendUtf8(std::string* vStr, unsigned vCode)
+	{
+		if (vCode < 0x80)
+		{
+			*vStr += (char)vCode;
+		}
+		else if (vCode < 0x800)
+		{
+			*vStr += (char)(0xC0 | (vCode >> 6));
+			*vStr += (char)(0x80 | (vCode & 0x3F));
+		}
+		else if (vCode < 0x10000)
+		{
+			*vStr += (char)(0xE0 | (vCode >> 12));
+			*vStr += (char)(0x80 | ((vCode >> 6) & 0x3F));
+			*vStr += (char)(0x80 | (vCode & 0x3F));
+		}
+		else
+		{
+			*vStr += (char)(0xF0 | (vCode >> 18));
+			*vStr += (char)(0x80 | ((vCode >> 12) & 0x3F));
+			*vStr += (char)(0x80 | ((vCode >> 6) & 0x3F));
+			*vStr += (char)(0x80 | (vCode & 0x3F));
+		}
+	}
+
+	bool ParseHex4(unsigned* vCode)
+	{
+		unsigned code = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			char c = *m_Cur;
+			if (!c)
+				return SetError("invalid \\u escape");
+			++m_Cur;
+			code <<= 4;
+			if (c >= '0' && c <= '9') code |= (unsigned)(c - '0');
+			else if (c >= 'a' && c <= 'f') code |= (unsigned)(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') code |= (unsigned)(c - 'A' + 10);
+			else return SetError("invalid \\u escape");
+		}
+		*vCode = code;
+		return true;
+	}
+
+	bool ParseString(std::string* vStr)
+	{
+		++m_Cur; // "
+		while (*m_Cur != '"')
+		{
+			if (!*m_Cur)
+				return SetError("unterminated string");
+			if (*m_Cur == '\\')
+			{
+				++m_Cur;
+				switch (*m_Cur++)
+				{
+				case '"': *vStr += '"'; break;
+				case '\\': *vStr += '\\'; break;
+				case '/': *vStr += '/'; break;
+				case 'b': *vStr += '\b'; break;
+				case 'f': *vStr += '\f'; break;
+				case 'n': *vStr += '\n'; break;
+				case 'r': *vStr += '\r'; break;
+				case 't': *vStr += '\t'; break;
+				case 'u':
+				{
+					unsigned code = 0;
+					if (!ParseHex4(&code)) return false;
+					// surrogate pair, a lone one is not a code point
+					if (code >= 0xDC00 && code <= 0xDFFF)
+						return SetError("invalid surrogate");
+					if (code >= 0xD800 && code <= 0xDBFF)
+					{
+						if (m_Cur[0] != '\\' || m_Cur[1] != 'u')
+							return SetError("invalid surrogate");
+						m_Cur += 2;
+						unsigned low = 0;
+						if (!ParseHex4(&low)) return false;
+						if (low < 0xDC00 || low > 0xDFFF)
+							return SetError("invalid surrogate");
+						code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					}
+					AppendUtf8(vStr, code);
+					break;
+				}
+				default:
+					return SetError("invalid escape");
+				}
+			}
+			else
+			{
+				*vStr += *m_Cur++;
+			}
+		}
+		++m_Cur; // "
+		return true;
+	}
+
+	bool ParseArray(JsonValue* vValue)
+	{
+		vValue->type = JsonValue::JSON_ARRAY;
+		++m_Cur; // [
+		SkipSpaces();
+		if (*m_Cur == ']')
+		{
+			++m_Cur;
+			return true;
+		}
+		while (true)
+		{
+			vValue->array.push_back(JsonValue());
+			if (!ParseValue(&vValue->array.back()))
+				return false;
+			SkipSpaces();
+			if (*m_Cur == ',') { ++m_Cur; continue; }
+			if (*m_Cur == ']') { ++m_Cur; return true; }
+			return SetError("expected ',' or ']'");
+		}
+	}
+
+	bool ParseObject(JsonValue* vValue)
+	{
+		vValue->type = JsonValue::JSON_OBJECT;
+		++m_Cur; // {
+		SkipSpaces();
+		if (*m_Cur == '}')
+		{
+			++m_Cur;
+			return true;
+		}
+		while (true)
+		{
+			SkipSpaces();
+			if (*m_Cur != '"')
+				return SetError("expected a key");
+			std::string key;
+			if (!ParseString(&key))
+				return false;
+			SkipSpaces();
+			if (*m_Cur != ':')
+				return SetError("expected ':'");
+			++m_Cur;
+			vValue->object.push_back(std::make_pair(key, JsonValue()));
+			if (!ParseValue(&vValue->object.back().second))
+				return false;
+			SkipSpaces();
+			if (*m_Cur == ',') { ++m_Cur; continue; }
+			if (*m_Cur == '}') { ++m_Cur; return true; }
+			return SetError("expected ',' or '}'");
+		}
+	}
+};
+
+static std::string JsonEscape(const std::string& vStr)
+{
+	std::string res = "\"";
+	for (auto c : vStr)
+	{
+		switch (c)
+		{
+		case '"': res += "\\\""; break;
+		case '\\': res += "\\\\"; break;
+		case '\n': res += "\\n"; break;
+		case '\r': res += "\\r"; break;
+		case '\t': res += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				char buf[8];
+				snprintf(buf, 8, "\\u%04x", (unsigned)(unsigned char)c);
+				res += buf;
+			}
+			else
+			{
+				res += c;
+			}
+		}
+	}
+	res += "\"";
+	return res;
+}
+
+// the id is sent back as given (number or string)
+static std::string JsonId(const JsonValue* vId)
+{
+	if (!vId) return "null";
+	if (vId->type == JsonValue::JSON_STRING) return JsonEscape(vId->string);
+	if (vId->type == JsonValue::JSON_NUMBER) return vId->string;
+	return "null";
+}
+
+static std::string ErrorResponse(const std::string& vId, const std::string& vError)
+{
+	return "{\"id\":" + vId + ",\"ok\":false,\"error\":" + JsonEscape(vError) + "}";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static std::string MemoryStatsToJson(const std::vector<GlslConvert::MemoryStats>& vStats)
+{
+	std::string res = "[";
+	char buf[256];
+	for (size_t i = 0; i < vStats.size(); ++i)
+	{
+		const GlslConvert::MemoryStats& s = vStats[i];
+		if (i) res += ",";
+		res += "{\"name\":" + JsonEscape(s.name);
+		snprintf(buf, 256, ",\"calls\":%zu,\"allocs\":%zu,\"peak\":%zu,\"live\":%zu,\"live_count\":%zu}",
+			s.calls, s.allocCount, s.peakBytes, s.liveBytes, s.liveCount);
+		res += buf;
+	}
+	res += "]";
+	return res;
+}
+
+static std::string UnrollStatsToJson(const std::vector<GlslConvert::UnrollStats>& vStats)
+{
+	std::string res = "[";
+	char buf[256];
+	for (size_t i = 0; i < vStats.size(); ++i)
+	{
+		const GlslConvert::UnrollStats& s = vStats[i];
+		if (i) res += ",";
+		res += "{\"function\":" + JsonEscape(s.function);
+		snprintf(buf, 256, ",\"iterations\":%i,\"cost\":%i,\"factor\":%i,\"decision\":",
+			s.iterations, s.bodyCost, s.factor);
+		res += buf;
+		res += JsonEscape(s.decision) + "}";
+	}
+	res += "]";
+	return res;
+}
+
+static std::string NumbersToJson(const std::vector<double>& vValues)
+{
+	std::string res = "[";
+	char buf[64];
+	for (size_t i = 0; i < vValues.size(); ++i)
+	{
+		if (i) res += ",";
+		if (std::isfinite(vValues[i]))
+			snprintf(buf, 64, "%.9g", vValues[i]);
+		else
+			snprintf(buf, 64, "null"); // no nan nor inf in json
+		res += buf;
+	}
+	res += "]";
+	return res;
+}
+
+static std::string PreshaderToJson(const GlslConvert::Preshader& vPreshader)
+{
+	std::string res = "{\"uniforms\":[";
+	for (size_t i = 0; i < vPreshader.uniforms.size(); ++i)
+	{
+		const GlslConvert::PreshaderUniform& u = vPreshader.uniforms[i];
+		if (i) res += ",";
+		res += "{\"name\":" + JsonEscape(u.name) + ",\"type\":" + JsonEscape(u.type) +
+			",\"expression\":" + JsonEscape(u.expression) + "}";
+	}
+	res += "],\"inputs\":[";
+	for (size_t i = 0; i < vPreshader.inputs.size(); ++i)
+	{
+		if (i) res += ",";
+		res += JsonEscape(vPreshader.inputs[i]);
+	}
+	res += "],\"source\":" + JsonEscape(vPreshader.source) + "}";
+	return res;
+}
+
+static bool GetStageFromName(const std::string& vName, GlslConvert::ShaderStage* vStage)
+{
+	if (vName == "vert") *vStage = GlslConvert::ShaderStage::MESA_SHADER_VERTEX;
+	else if (vName == "tesc") *vStage = GlslConvert::ShaderStage::MESA_SHADER_TESS_CTRL;
+	else if (vName == "tese") *vStage = GlslConvert::ShaderStage::MESA_SHADER_TESS_EVAL;
+	else if (vName == "geom") *vStage = GlslConvert::ShaderStage::MESA_SHADER_GEOMETRY;
+	else if (vName == "frag") *vStage = GlslConvert::ShaderStage::MESA_SHADER_FRAGMENT;
+	else if (vName == "comp") *vStage = GlslConvert::ShaderStage::MESA_SHADER_COMPUTE;
+	else return false;
+	return true;
+}
+
+static std::string GetExtension(const std::string& vPath)
+{
+	size_t p = vPath.find_last_of('.');
+	if (p == std::string::npos) return "";
+	return vPath.substr(p + 1);
+}
+
+static std::string GetDirectory(const std::string& vPath)
+{
+	size_t p = vPath.find_last_of("/\\");
+	if (p == std::string::npos) return "";
+	return vPath.substr(0, p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+OptimizerServer::OptimizerServer()
+{
+
+}
+
+OptimizerServer::~OptimizerServer()
+{
+
+}
+
+bool OptimizerServer::IsServerMode(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+		if (strcmp(argv[i], "--server") == 0)
+			return true;
+	return false;
+}
+
+int OptimizerServer::Run(int argc, char** argv)
+{
+	std::string socketPath;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--socket") == 0)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "--socket need a path\n");
+				return 1;
+			}
+			socketPath = argv[i + 1];
+			break;
+		}
+	}
+
+	// the builtins and the types are built once for the session, not by each request
+	GlslConvert::RetainSharedState();
+
+	int res = 0;
+	if (!socketPath.empty())
+		res = RunSocket(socketPath);
+	else
+		res = RunStream(std::cin, std::cout);
+
+	GlslConvert::ReleaseSharedState();
+
+	return res;
+}
+
+int OptimizerServer::RunStream(std::istream& vIn, std::ostream& vOut)
+{
+	std::string line;
+	while (!m_Shutdown && std::getline(vIn, line))
+	{
+		if (line.empty() || line == "\r")
+			continue;
+		vOut << ProcessRequest(line) << "\n";
+		vOut.flush();
+	}
+	return 0;
+}
+
+int OptimizerServer::RunSocket(const std::string& vSocketPath)
+{
+#ifdef UNIX
+	signal(SIGPIPE, SIG_IGN); // a client can leave without reading his responses
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (vSocketPath.size() >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "socket path too long : %s\n", vSocketPath.c_str());
+		return 1;
+	}
+	strncpy(addr.sun_path, vSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0)
+	{
+		perror("socket");
+		return 1;
+	}
+
+	unlink(vSocketPath.c_str());
+	if (bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 8) != 0)
+	{
+		perror("bind");
+		close(server);
+		return 1;
+	}
+
+	while (!m_Shutdown)
+	{
+		int client = accept(server, 0, 0);
+		if (client < 0)
+			continue;
+
+		std::string pending;
+		char buffer[4096];
+		while (!m_Shutdown)
+		{
+			ssize_t count = read(client, buffer, sizeof(buffer));
+			if (count <= 0)
+				break;
+			pending.append(buffer, (size_t)count);
+
+			size_t eol;
+			while (!m_Shutdown && (eol = pending.find('\n')) != std::string::npos)
+			{
+				std::string line = pending.substr(0, eol);
+				pending.erase(0, eol + 1);
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				if (line.empty())
+					continue;
+
+				std::string response = ProcessRequest(line) + "\n";
+				size_t written = 0;
+				while (written < response.size())
+				{
+					ssize_t w = write(client, response.c_str() + written, response.size() - written);
+					if (w <= 0) break;
+					written += (size_t)w;
+				}
+			}
+		}
+
+		close(client);
+	}
+
+	close(server);
+	unlink(vSocketPath.c_str());
+	return 0;
+#else
+	fprintf(stderr, "unix socket not supported on this platform (%s), use stdin/stdout\n", vSocketPath.c_str());
+	return 1;
+#endif
+}
+
+std::string OptimizerServer::ProcessRequest(const std::string& vLine)
+{
+	JsonValue request;
+	std::string error;
+	if (!JsonParser().Parse(vLine, &request, &error))
+		return ErrorResponse("null", "invalid json : " + error);
+	if (request.type != JsonValue::JSON_OBJECT)
+		return ErrorResponse("null", "the request must be an object");
+
+	const std::string id = JsonId(request.Get("id"));
+
+	const std::string cmd = request.GetString("cmd", "optimize");
+	if (cmd == "ping")
+	{
+		return "{\"id\":" + id + ",\"ok\":true}";
+	}
+	else if (cmd == "shutdown")
+	{
+		m_Shutdown = true;
+		return "{\"id\":" + id + ",\"ok\":true}";
+	}
+	else if (cmd == "clear_cache")
+	{
+		GlslConvert::Instance()->ClearIncludeCache();
+		return "{\"id\":" + id + ",\"ok\":true}";
+	}
+	else if (cmd == "add_named_string")
+	{
+		bool ok = GlslConvert::Instance()->AddNamedString(request.GetString("name"), request.GetString("source"));
+		if (!ok) return ErrorResponse(id, "the name must be an absolute path like /lib/file.glsl");
+		return "{\"id\":" + id + ",\"ok\":true}";
+	}
+	else if (cmd == "remove_named_string")
+	{
+		bool ok = GlslConvert::Instance()->RemoveNamedString(request.GetString("name"));
+		return "{\"id\":" + id + ",\"ok\":" + (ok ? "true" : "false") + "}";
+	}
+	else if (cmd == "evaluate_preshader")
+	{
+		std::map<std::string, std::vector<double>> inputs, outputs;
+		const JsonValue* values = request.Get("values");
+		if (!values || values->type != JsonValue::JSON_OBJECT)
+			return ErrorResponse(id, "values must be an object");
+		for (auto &it : values->object)
+		{
+			std::vector<double>& input = inputs[it.first];
+			if (it.second.type == JsonValue::JSON_NUMBER)
+				input.push_back(it.second.number);
+			else if (it.second.type == JsonValue::JSON_BOOL)
+				input.push_back(it.second.boolean ? 1.0 : 0.0);
+			else if (it.second.type == JsonValue::JSON_ARRAY)
+				for (auto &v : it.second.array)
+					input.push_back(v.type == JsonValue::JSON_BOOL ? (v.boolean ? 1.0 : 0.0) : v.number);
+			else
+				return ErrorResponse(id, "bad value for " + it.first);
+		}
+		if (!GlslConvert::Instance()->EvaluatePreshader(inputs, &outputs))
+			return ErrorResponse(id, "cant evaluate the preshader, an input is missing or of a bad size");
+		std::string res = "{\"id\":" + id + ",\"ok\":true,\"values\":{";
+		bool first = true;
+		for (auto &it : outputs)
+		{
+			if (!first) res += ",";
+			res += JsonEscape(it.first) + ":" + NumbersToJson(it.second);
+			first = false;
+		}
+		return res + "}}";
+	}
+	else if (cmd != "optimize")
+	{
+		return ErrorResponse(id, "unknown cmd : " + cmd);
+	}
+
+	// source
+	const std::string path = request.GetString("path");
+	std::string source = request.GetString("source");
+	if (source.empty())
+	{
+		if (path.empty())
+			return ErrorResponse(id, "no source nor path");
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file.is_open())
+			return ErrorResponse(id, "cant open " + path);
+		std::stringstream ss;
+		ss << file.rdbuf();
+		source = ss.str();
+	}
+
+	// stage
+	GlslConvert::ShaderStage stage = GlslConvert::ShaderStage::MESA_SHADER_NONE;
+	std::string stageName = request.GetString("stage");
+	if (stageName.empty())
+		stageName = GetExtension(path);
+	if (!GetStageFromName(stageName, &stage))
+		return ErrorResponse(id, "unknown stage : " + stageName);
+
+	// api
+	GlslConvert::ApiTarget api = GlslConvert::ApiTarget::API_OPENGL_CORE;
+	const std::string apiName = request.GetString("api", "core");
+	if (apiName == "compat") api = GlslConvert::ApiTarget::API_OPENGL_COMPAT;
+	else if (apiName != "core") return ErrorResponse(id, "unknown api : " + apiName);
+
+	// target, the ast target write in stdout so is not available here
+	GlslConvert::LanguageTarget target = GlslConvert::LanguageTarget::LANGUAGE_TARGET_GLSL;
+	const std::string targetName = request.GetString("target", "glsl");
+	if (targetName == "ir") target = GlslConvert::LanguageTarget::LANGUAGE_TARGET_IR;
+	else if (targetName != "glsl") return ErrorResponse(id, "unknown target : " + targetName);
+
+	const int version = request.GetInt("version", 330);
+
+	// options
+	GlslConvert::OptimizationStruct optimizationStruct;
+	const JsonValue* options = request.Get("options");
+	if (options)
+	{
+		if (options->type != JsonValue::JSON_OBJECT)
+			return ErrorResponse(id, "options must be an object");
+		for (auto &it : options->object)
+			ProjectFile::SetOptimizationStructValue(optimizationStruct, it.first, it.second.ToOptionString());
+	}
+	optimizationStruct.shaderPath = GetDirectory(path);
+	optimizationStruct.memoryStats = request.GetBool("stats");
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::string code = GlslConvert::Instance()->Optimize(
+		source, stage, api, target, version, optimizationStruct);
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (!GlslConvert::Instance()->IsLastOptimizeSucceeded())
+		return ErrorResponse(id, code);
+
+	std::string res = "{\"id\":" + id + ",\"ok\":true,\"code\":" + JsonEscape(code);
+
+	res += ",\"dependencies\":[";
+	bool first = true;
+	for (auto &dep : GlslConvert::Instance()->GetDependencies())
+	{
+		if (!first) res += ",";
+		res += "{\"path\":" + JsonEscape(dep.path) + ",\"hash\":" + JsonEscape(dep.hash) + "}";
+		first = false;
+	}
+	res += "]";
+
+	res += ",\"names\":{";
+	first = true;
+	for (auto &name : GlslConvert::Instance()->GetMinifiedNames())
+	{
+		if (!first) res += ",";
+		res += JsonEscape(name.first) + ":" + JsonEscape(name.second);
+		first = false;
+	}
+	res += "}";
+
+	if (!GlslConvert::Instance()->GetPreshader().uniforms.empty())
+		res += ",\"preshader\":" + PreshaderToJson(GlslConvert::Instance()->GetPreshader());
+
+	if (optimizationStruct.budgetOptions.timeMs > 0)
+		res += std::string(",\"budget_exhausted\":") + (GlslConvert::Instance()->IsLastBudgetExhausted() ? "true" : "false");
+
+	if (optimizationStruct.memoryStats)
+	{
+		const GlslConvert::Stats& stats = GlslConvert::Instance()->GetStats();
+		res += ",\"stats\":{\"phases\":" + MemoryStatsToJson(stats.memoryPhases);
+		res += ",\"roots\":" + MemoryStatsToJson(stats.memoryRoots);
+		res += ",\"unroll\":" + UnrollStatsToJson(stats.unrollDecisions) + "}";
+	}
+
+	char buf[64];
+	snprintf(buf, 64, ",\"ms\":%.3f}", ms);
+	res += buf;
+
+	return res;
+}
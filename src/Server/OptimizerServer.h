@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Stephane Cuillerdier (aka Aiekick)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+#include <iostream>
+
+/*
+ * long lived optimizer, for build system integration
+ *
+ * GlslOptimizerV2 --server                  : requests on stdin, responses on stdout
+ * GlslOptimizerV2 --server --socket <path>  : requests on a unix socket (one client at a time)
+ *
+ * one json object per line, the responses are in the order of the requests, so they can be pipelined.
+ * the builtins, the types and the include cache stay warm between the requests.
+ *
+ * request :
+ *	{"id":1, "path":"shaders/a.frag", "stage":"frag", "version":330, "api":"core", "target":"glsl",
+ *	 "options":{"optimization_flags":-1, "include_paths":"inc;lib", "print_minify":true}}
+ *	- "source" can be given instead of "path" (the path is still used for the relative includes)
+ *	- "stage" : vert, tesc, tese, geom, frag, comp. deduced from the path extension if not given
+ *	- "api" : core (default), compat
+ *	- "target" : glsl (default), ir
+ *	- "options" : same names as the tags of the <optimization> node of the project file
+ *	- "stats" : true for add the ralloc accounting of the compile to the response
+ * response :
+ *	{"id":1, "ok":true, "code":"...", "dependencies":[{"path":"...", "hash":"..."}], "names":{"a":"color"}, "ms":1.25}
+ *	{"id":1, "ok":false, "error":"..."}
+ *	with "stats" : "stats":{"phases":[{"name":"hir", "calls":1, "allocs":2233, "peak":3534754, "live":3534178, "live_count":36766}, ...], "roots":[...]}
+ *	(phases are in order of first run, roots are "shader", "program" and "total")
+ *	and "unroll":[{"function":"main", "iterations":16, "cost":6, "factor":4, "decision":"partial"}, ...] (factor 0 => kept rolled)
+ *	with the option "budget_time_ms" : "budget_exhausted":true if the passes was stopped at the budget (the code is still valid)
+ *	with the option "preshader_enabled" : "preshader":{"uniforms":[{"name":"preshader_0", "type":"float", "expression":"pow(exposure, 2.2)"}],
+ *	 "inputs":["exposure"], "source":"..."} if some expressions of the uniforms alone was moved to new uniforms
+ * commands :
+ *	{"cmd":"ping"}, {"cmd":"clear_cache"}, {"cmd":"shutdown"},
+ *	{"cmd":"add_named_string", "name":"/lib/noise.glsl", "source":"..."}, {"cmd":"remove_named_string", "name":"..."}
+ *	{"cmd":"evaluate_preshader", "values":{"exposure":2.0, "color":[1,0.5,0]}} => {"ok":true, "values":{"preshader_0":[4.59]}}
+ *	(the preshader of the last optimize request, the values in the component order, matrices by column)
+ */
+
+class OptimizerServer
+{
+private:
+	bool m_Shutdown = false;
+
+public:
+	static OptimizerServer* Instance()
+	{
+		static OptimizerServer *_instance = new OptimizerServer();
+		return _instance;
+	}
+
+protected:
+	OptimizerServer(); // Prevent construction
+	OptimizerServer(const OptimizerServer&) {}; // Prevent construction by copying
+	OptimizerServer& operator =(const OptimizerServer&) { return *this; }; // Prevent assignment
+	~OptimizerServer(); // Prevent unwanted destruction
+
+public:
+	static bool IsServerMode(int argc, char** argv);
+	int Run(int argc, char** argv);
+
+public:
+	int RunStream(std::istream& vIn, std::ostream& vOut);
+	int RunSocket(const std::string& vSocketPath);
+	std::string ProcessRequest(const std::string& vLine);
+};